@@ -2,4 +2,5 @@
 cd /d %~dp0
 rd /s /q ".vs"
 rd /s /q "x64"
+rd /s /q "cache"
 del OpenGL.vcxproj.user
@@ -0,0 +1,305 @@
+﻿//===========================================================================
+//!	@file	arena.cpp
+//!	@brief	リニアアリーナアロケーター (フレーム一時メモリ・スクラッチメモリ)
+//===========================================================================
+#include <mutex>
+
+//---------------------------------------------------------------------------
+//! デストラクタ
+//---------------------------------------------------------------------------
+LinearArena::~LinearArena()
+{
+    cleanup();
+}
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+void LinearArena::setup(size_t capacity)
+{
+    MEMORY_TAG(MemoryTag::Frame);
+
+    cleanup();
+
+    buffer_ = static_cast<u8*>(::operator new(capacity, std::align_val_t(64)));
+    capacity_.store(capacity, std::memory_order_relaxed);
+    offset_.store(0, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void LinearArena::cleanup()
+{
+    reset();
+
+    if(buffer_) {
+        ::operator delete(buffer_, std::align_val_t(64));
+    }
+    buffer_ = nullptr;
+    capacity_.store(0, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! メモリ確保
+//---------------------------------------------------------------------------
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+    // 書き込むのは所有スレッドのみのため、読み込んだ値を更新して書き戻す
+    size_t used          = offset_.load(std::memory_order_relaxed);
+    size_t overflow_size = overflow_size_.load(std::memory_order_relaxed);
+    size_t offset        = (used + alignment - 1) & ~(alignment - 1);
+
+    void* memory;
+    if(offset + size <= capacity_.load(std::memory_order_relaxed)) {
+        memory = buffer_ + offset;
+        used   = offset + size;
+        offset_.store(used, std::memory_order_relaxed);
+    }
+    else {
+        // 容量不足はヒープから確保してreset()・rewind()で解放する
+        MEMORY_TAG(MemoryTag::Frame);
+        memory = ::operator new(size, std::align_val_t(alignment));
+        overflows_.push_back({memory, size, alignment});
+        overflow_size += size;
+        overflow_size_.store(overflow_size, std::memory_order_relaxed);
+        overflow_count_.store(overflow_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    if(used + overflow_size > high_water_mark_.load(std::memory_order_relaxed)) {
+        high_water_mark_.store(used + overflow_size, std::memory_order_relaxed);
+    }
+    return memory;
+}
+
+//---------------------------------------------------------------------------
+//! 全解放
+//---------------------------------------------------------------------------
+void LinearArena::reset()
+{
+    for(auto& overflow : overflows_) {
+        ::operator delete(overflow.memory_, std::align_val_t(overflow.alignment_));
+    }
+    overflows_.clear();
+    overflow_size_.store(0, std::memory_order_relaxed);
+    offset_.store(0, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! マーカーの位置まで巻き戻す
+//---------------------------------------------------------------------------
+void LinearArena::rewind(const Marker& marker)
+{
+    // 容量超過分はマーカー以降に確保したものだけを解放 (外側のスコープの確保は残す)
+    size_t overflow_size = overflow_size_.load(std::memory_order_relaxed);
+    for(size_t i = marker.overflow_index_; i < overflows_.size(); ++i) {
+        ::operator delete(overflows_[i].memory_, std::align_val_t(overflows_[i].alignment_));
+        overflow_size -= overflows_[i].size_;
+    }
+    overflows_.resize(std::min(marker.overflow_index_, overflows_.size()));
+    overflow_size_.store(overflow_size, std::memory_order_relaxed);
+    offset_.store(std::min(marker.offset_, offset_.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+}
+
+//===========================================================================
+// スレッドごとのアリーナ
+//===========================================================================
+namespace
+{
+constexpr s32 MAX_THREAD_COUNT = 64;   //!< アリーナを利用するスレッドの最大数
+
+//! スレッドごとのアリーナ
+struct ThreadArena
+{
+    LinearArena frame_[2];   //!< フレームアリーナ (2面)
+    LinearArena scratch_;    //!< スクラッチアリーナ
+};
+
+size_t frame_arena_size   = 1024 * 1024;        //!< 1スレッドあたりのフレームアリーナ容量
+size_t scratch_arena_size = 16 * 1024 * 1024;   //!< 1スレッドあたりのスクラッチアリーナ容量
+
+std::unique_ptr<ThreadArena> thread_arenas[MAX_THREAD_COUNT];   //!< スレッドごとのアリーナ
+std::vector<s32>             free_slots;                        //!< 空いているスロット番号
+s32                          slot_count = 0;                    //!< 使用したスロット数
+std::mutex                   slot_mutex;                        //!< スロット割り当て用 (スレッド開始・終了時のみ)
+
+std::atomic<s32> frame_index{0};   //!< 現在のフレームアリーナ番号
+
+//===========================================================================
+//! スレッド終了時にスロットを返却する
+//===========================================================================
+struct ThreadSlot
+{
+    s32 index_ = -1;
+
+    ~ThreadSlot()
+    {
+        if(index_ >= 0) {
+            std::lock_guard lock(slot_mutex);
+            free_slots.push_back(index_);
+        }
+    }
+};
+
+thread_local ThreadSlot thread_slot;   //!< このスレッドのスロット
+
+//---------------------------------------------------------------------------
+//! 呼び出し元スレッドのアリーナを取得
+//---------------------------------------------------------------------------
+ThreadArena& getThreadArena()
+{
+    // スロットのアリーナはこのスレッドしか作成しないため、作成済みならロック不要
+    if(thread_slot.index_ >= 0) {
+        if(ThreadArena* arena = thread_arenas[thread_slot.index_].get()) {
+            return *arena;
+        }
+    }
+
+    // 作成はARENA_endFrame()・集計と同じロックの中で行う (メインスレッドが同じ配列を読むため)
+    std::lock_guard lock(slot_mutex);
+
+    if(thread_slot.index_ < 0) {
+        if(!free_slots.empty()) {
+            thread_slot.index_ = free_slots.back();
+            free_slots.pop_back();
+        }
+        else {
+            if(slot_count >= MAX_THREAD_COUNT) {
+                MessageBox(nullptr, "アリーナを利用するスレッドが多すぎます.", "ARENA", MB_OK);
+                std::abort();
+            }
+            thread_slot.index_ = slot_count++;
+        }
+    }
+
+    // ARENA_cleanup()後の再利用にも対応
+    auto& arena = thread_arenas[thread_slot.index_];
+    if(!arena) {
+        MEMORY_TAG(MemoryTag::Frame);
+        arena = std::make_unique<ThreadArena>();
+    }
+    return *arena;
+}
+
+//---------------------------------------------------------------------------
+//! 使用状況を集計
+//---------------------------------------------------------------------------
+template<typename F>
+ArenaStats collectStats(const F& select)
+{
+    ArenaStats stats;
+
+    std::lock_guard lock(slot_mutex);
+    for(s32 i = 0; i < slot_count; ++i) {
+        if(!thread_arenas[i]) {
+            continue;
+        }
+        select(*thread_arenas[i], [&](const LinearArena& arena) {
+            if(arena.getCapacity() == 0) {
+                return;   // 未使用
+            }
+            stats.capacity_ += arena.getCapacity();
+            stats.used_size_ += arena.getUsedSize();
+            stats.high_water_mark_ += arena.getHighWaterMark();
+            stats.overflow_count_ += arena.getOverflowCount();
+        });
+        stats.thread_count_++;
+    }
+    return stats;
+}
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! アリーナを初期化
+//---------------------------------------------------------------------------
+void ARENA_setup(size_t frame_size, size_t scratch_size)
+{
+    frame_arena_size   = frame_size;
+    scratch_arena_size = scratch_size;
+}
+
+//---------------------------------------------------------------------------
+//! アリーナを解放
+//---------------------------------------------------------------------------
+void ARENA_cleanup()
+{
+    ArenaStats frame   = ARENA_getFrameStats();
+    ArenaStats scratch = ARENA_getScratchStats();
+
+    char text[256];
+    sprintf_s(text,
+              "[ARENA] frame   : high water %zu / %zu bytes, overflow %u\n"
+              "[ARENA] scratch : high water %zu / %zu bytes, overflow %u\n",
+              frame.high_water_mark_,
+              frame.capacity_,
+              frame.overflow_count_,
+              scratch.high_water_mark_,
+              scratch.capacity_,
+              scratch.overflow_count_);
+    OutputDebugStringA(text);
+
+    std::lock_guard lock(slot_mutex);
+    for(auto& arena : thread_arenas) {
+        arena.reset();
+    }
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void ARENA_endFrame()
+{
+    s32 next = frame_index.load(std::memory_order_relaxed) ^ 1;
+
+    // 2フレーム前に確保した面を解放して次のフレームで使う
+    std::lock_guard lock(slot_mutex);
+    for(s32 i = 0; i < slot_count; ++i) {
+        if(thread_arenas[i]) {
+            thread_arenas[i]->frame_[next].reset();
+        }
+    }
+    frame_index.store(next, std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------
+//! 呼び出し元スレッドのフレームアリーナを取得
+//---------------------------------------------------------------------------
+LinearArena& ARENA_getFrameArena()
+{
+    LinearArena& arena = getThreadArena().frame_[frame_index.load(std::memory_order_acquire)];
+    if(arena.getCapacity() == 0) {
+        arena.setup(frame_arena_size);
+    }
+    return arena;
+}
+
+//---------------------------------------------------------------------------
+//! 呼び出し元スレッドのスクラッチアリーナを取得
+//---------------------------------------------------------------------------
+LinearArena& ARENA_getScratchArena()
+{
+    LinearArena& arena = getThreadArena().scratch_;
+    if(arena.getCapacity() == 0) {
+        arena.setup(scratch_arena_size);
+    }
+    return arena;
+}
+
+//---------------------------------------------------------------------------
+//! フレームアリーナの使用状況を取得
+//---------------------------------------------------------------------------
+ArenaStats ARENA_getFrameStats()
+{
+    return collectStats([](const ThreadArena& arena, const auto& add) {
+        add(arena.frame_[0]);
+        add(arena.frame_[1]);
+    });
+}
+
+//---------------------------------------------------------------------------
+//! スクラッチアリーナの使用状況を取得
+//---------------------------------------------------------------------------
+ArenaStats ARENA_getScratchStats()
+{
+    return collectStats([](const ThreadArena& arena, const auto& add) { add(arena.scratch_); });
+}
@@ -0,0 +1,235 @@
+﻿//===========================================================================
+//!	@file	arena.h
+//!	@brief	リニアアリーナアロケーター (フレーム一時メモリ・スクラッチメモリ)
+//!
+//!	- フレームアリーナ  : 1フレームだけ有効な一時メモリ。スレッドごとに分かれているため
+//!	                      ジョブからロックなしで確保可能。ARENA_endFrame()でまとめて解放。
+//!	                      更新と描画が1フレームずれて並行動作するため2面で切り替える。
+//!	- スクラッチアリーナ: 読み込み処理などの作業用メモリ。ArenaScopeで範囲ごとに巻き戻す。
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! リニアアリーナ (バンプアロケーター)
+//!
+//! 確保はポインタを進めるだけで、個別の解放はできません。reset()で全解放します。
+//! 容量を超えた分はヒープから確保し、reset()時に解放します (最大使用量は記録されるため
+//! getHighWaterMark()を見て容量を調整してください)。
+//===========================================================================
+class LinearArena
+{
+public:
+    //! コンストラクタ
+    LinearArena() = default;
+
+    //! デストラクタ
+    ~LinearArena();
+
+    //! 初期化
+    //! @param  [in]    capacity    容量 (単位:byte)
+    void setup(size_t capacity);
+
+    //! 解放
+    void cleanup();
+
+    //! メモリ確保
+    //! @param  [in]    size        サイズ (単位:byte)
+    //! @param  [in]    alignment   アライメント (2のべき乗)
+    [[nodiscard]] void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    //! 全解放
+    void reset();
+
+    //! 巻き戻し位置 (容量超過分はヒープから確保した数で記録する)
+    struct Marker
+    {
+        size_t offset_         = 0;   //!< 使用中の位置
+        size_t overflow_index_ = 0;   //!< 容量超過でヒープから確保したメモリの数
+    };
+
+    //! 現在位置を取得 (rewind()で戻すためのマーカー)
+    Marker getMarker() const { return {offset_.load(std::memory_order_relaxed), overflows_.size()}; }
+
+    //! マーカーの位置まで巻き戻す (マーカー以降に確保したメモリを解放)
+    //! 容量超過分もマーカー以降に確保したものだけを解放するため、入れ子のスコープでも外側の確保は残る
+    //! @param  [in]    marker  getMarker()で取得した位置
+    void rewind(const Marker& marker);
+
+    //----------------------------------------------------------
+    //! @name 参照 (使用状況の集計のため所有スレッド以外からも呼び出せる)
+    //----------------------------------------------------------
+    //!@{
+
+    //! 容量を取得
+    size_t getCapacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    //! 使用中のサイズを取得 (容量超過分を含む)
+    size_t getUsedSize() const { return offset_.load(std::memory_order_relaxed) + overflow_size_.load(std::memory_order_relaxed); }
+
+    //! 最大使用量を取得 (容量超過分を含む)
+    size_t getHighWaterMark() const { return high_water_mark_.load(std::memory_order_relaxed); }
+
+    //! 容量超過でヒープから確保した回数を取得
+    u32 getOverflowCount() const { return overflow_count_.load(std::memory_order_relaxed); }
+
+    //!@}
+
+private:
+    // コピー禁止
+    LinearArena(const LinearArena&)     = delete;
+    void operator=(const LinearArena&) = delete;
+
+    //! 容量超過時のヒープ確保
+    struct Overflow
+    {
+        void*  memory_;
+        size_t size_;
+        size_t alignment_;
+    };
+
+private:
+    // 使用状況はARENA_getFrameStats()などで他のスレッドから読まれるためアトミックにする
+    // (書き込むのは所有スレッドのみのため、読み込み・書き込みともrelaxedで足りる)
+    u8*                 buffer_          = nullptr;   //!< メモリ先頭
+    std::atomic<size_t> capacity_        = 0;         //!< 容量
+    std::atomic<size_t> offset_          = 0;         //!< 使用中の位置
+    std::atomic<size_t> high_water_mark_ = 0;         //!< 最大使用量
+    std::atomic<size_t> overflow_size_   = 0;         //!< 容量超過してヒープから確保したサイズ
+    std::atomic<u32>    overflow_count_  = 0;         //!< 容量超過の累計回数
+
+    std::vector<Overflow> overflows_;   //!< 容量超過でヒープから確保したメモリ
+};
+
+//===========================================================================
+//! アリーナの範囲確保 (スコープを抜けると確保前の位置に巻き戻す)
+//===========================================================================
+class ArenaScope
+{
+public:
+    //! コンストラクタ
+    //! @param  [in]    arena   対象のアリーナ
+    explicit ArenaScope(LinearArena& arena)
+        : arena_(arena)
+        , marker_(arena.getMarker())
+    {
+    }
+
+    //! デストラクタ
+    ~ArenaScope() { arena_.rewind(marker_); }
+
+private:
+    LinearArena&        arena_;    //!< 対象のアリーナ
+    LinearArena::Marker marker_;   //!< 巻き戻し位置
+};
+
+//===========================================================================
+//! STL互換アロケーター
+//!
+//! @code
+//!     ArenaVector<float3> points{ArenaAllocator<float3>(ARENA_getFrameArena())};
+//! @endcode
+//===========================================================================
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    // コンテナのムーブ代入でアロケーターも移動する (アリーナは毎フレーム切り替わるため)
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    //! コンストラクタ
+    //! @param  [in]    arena   確保先のアリーナ
+    explicit ArenaAllocator(LinearArena& arena) noexcept
+        : arena_(&arena)
+    {
+    }
+
+    //! 変換コンストラクタ
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : arena_(other.getArena())
+    {
+    }
+
+    //! 確保
+    [[nodiscard]] T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+
+    //! 解放 (アリーナはまとめて解放するため何もしない)
+    void deallocate(T*, size_t) noexcept {}
+
+    //! 確保先のアリーナを取得
+    LinearArena* getArena() const noexcept { return arena_; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept
+    {
+        return arena_ == other.getArena();
+    }
+
+private:
+    LinearArena* arena_;   //!< 確保先のアリーナ
+};
+
+//! アリーナから確保するvector
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+//===========================================================================
+//! アリーナの使用状況
+//===========================================================================
+struct ArenaStats
+{
+    size_t capacity_        = 0;   //!< 容量合計
+    size_t used_size_       = 0;   //!< 使用中のサイズ合計
+    size_t high_water_mark_ = 0;   //!< 最大使用量 (スレッドごとの最大値の合計)
+    u32    overflow_count_  = 0;   //!< 容量超過の累計回数
+    s32    thread_count_    = 0;   //!< 利用しているスレッド数
+};
+
+//! アリーナを初期化
+//! @param  [in]    frame_size      1スレッドあたりのフレームアリーナ容量 (単位:byte)
+//! @param  [in]    scratch_size    1スレッドあたりのスクラッチアリーナ容量 (単位:byte)
+void ARENA_setup(size_t frame_size = 1024 * 1024, size_t scratch_size = 16 * 1024 * 1024);
+
+//! アリーナを解放 (最大使用量をデバッグ出力)
+void ARENA_cleanup();
+
+//! フレーム終了 (フレームアリーナを切り替え、2フレーム前の内容を解放)
+//! @attention 全スレッドがフレームアリーナを使い終わった時点で呼び出してください。
+void ARENA_endFrame();
+
+//! 呼び出し元スレッドのフレームアリーナを取得 (次フレームの終わりまで有効)
+LinearArena& ARENA_getFrameArena();
+
+//! 呼び出し元スレッドのスクラッチアリーナを取得
+LinearArena& ARENA_getScratchArena();
+
+//! フレームアリーナから確保
+//! @param  [in]    size        サイズ (単位:byte)
+//! @param  [in]    alignment   アライメント
+[[nodiscard]] inline void* ARENA_frameAlloc(size_t size, size_t alignment = alignof(std::max_align_t))
+{
+    return ARENA_getFrameArena().allocate(size, alignment);
+}
+
+//! フレームアリーナから配列を確保 (要素はデフォルト初期化)
+//! @param  [in]    count   要素数
+template<typename T>
+[[nodiscard]] T* ARENA_frameAllocArray(size_t count)
+{
+    // アリーナはデストラクタを呼ばずに解放するため、解放処理が不要な型に限る
+    static_assert(std::is_trivially_destructible_v<T>);
+
+    T* p = static_cast<T*>(ARENA_frameAlloc(sizeof(T) * count, alignof(T)));
+    std::uninitialized_default_construct_n(p, count);
+    return p;
+}
+
+//! フレームアリーナの使用状況を取得
+ArenaStats ARENA_getFrameStats();
+
+//! スクラッチアリーナの使用状況を取得
+ArenaStats ARENA_getScratchStats();
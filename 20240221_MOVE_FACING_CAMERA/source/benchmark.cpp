@@ -0,0 +1,1366 @@
+﻿//===========================================================================
+//!	@file	benchmark.cpp
+//!	@brief	ベンチマーク
+//===========================================================================
+#include <cstdarg>
+#include <random>
+#include <filesystem>
+
+namespace
+{
+FILE* output_file = nullptr;   //!< 結果の出力先ファイル
+bool  failed      = false;     //!< 基準画像との比較などで失敗したかどうか
+
+//---------------------------------------------------------------------------
+//! 処理時間を計測 (複数回実行して最小値を採用)
+//! @param  [in]    repeat      実行回数
+//! @param  [in]    function    計測する処理
+//! @return 最小の処理時間 (単位:ミリ秒)
+//---------------------------------------------------------------------------
+template<typename F>
+f64 measure(s32 repeat, const F& function)
+{
+    f64 best = DBL_MAX;
+    for(s32 i = 0; i < repeat; ++i) {
+        f64 start = TIMER_now();
+        function();
+        best = std::min(best, TIMER_now() - start);
+    }
+    return best * 1000.0;
+}
+
+//===========================================================================
+// ベンチマーク
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! ジョブシステム: スレッド数1～CPUコア数でのスケーリング
+//---------------------------------------------------------------------------
+void benchmarkJob()
+{
+    constexpr s32 COUNT = 1 << 20;   // 変換する座標数
+
+    std::vector<float3> in(COUNT);
+    std::vector<float3> out(COUNT);
+    for(s32 i = 0; i < COUNT; ++i) {
+        f32 f = static_cast<f32>(i);
+        in[i] = float3(f, f * 0.5f, -f);
+    }
+    matrix m = mul(matrix::rotateY(0.5f), matrix::translate(1.0f, 2.0f, 3.0f));
+
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+
+    BENCHMARK_print("[job] transformCoordArray %d points\n", COUNT);
+    BENCHMARK_print("threads, ms, speedup\n");
+
+    f64 base_time = 0.0;
+    for(s32 thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+        JOB_setup(thread_count - 1);
+        f64 time = measure(10, [&] { transformCoordArray(out.data(), in.data(), COUNT, m); });
+        JOB_cleanup();
+
+        if(thread_count == 1) {
+            base_time = time;
+        }
+        BENCHMARK_print("%d, %.3f, %.2f\n", thread_count, time, base_time / time);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! ソフトウェアラスタライザー: ピラミッドを並べたシーンの描画時間
+//! 最後の描画結果を raster.tga に保存し、基準画像 golden/raster.tga と比較する
+//! 基準画像はリポジトリに含めず、ない場合は今回の描画結果から作成する (一致しない場合は失敗)
+//! 描画を意図して変更した場合は golden/raster.tga を削除して再実行すると作り直す
+//---------------------------------------------------------------------------
+void benchmarkRaster()
+{
+    constexpr s32 WIDTH  = 1280;
+    constexpr s32 HEIGHT = 720;
+    constexpr s32 COUNT  = 32;   // ピラミッドの数 (COUNT×COUNT)
+
+    SoftwareRasterizer rasterizer;
+    rasterizer.setup(WIDTH, HEIGHT);
+
+    //---- カメラ (斜め上から見下ろす)
+    float3 eye    = float3(0.0f, 20.0f, 40.0f);
+    float3 axis_z = normalize(eye);
+    float3 axis_x = normalize(cross(float3(0.0f, 1.0f, 0.0f), axis_z));
+    float3 axis_y = cross(axis_z, axis_x);
+    matrix world  = matrix(float4(axis_x, 0.0f), float4(axis_y, 0.0f), float4(axis_z, 0.0f), float4(eye, 1.0f));
+    matrix view_proj =
+        mul(inverse(world), matrix::perspectiveFovRH(std::numbers::pi_v<f32> * 0.25f, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+    auto vertex = [&](const float3& p, const Color& color) {
+        float4 v = mul(float4(p, 1.0f), view_proj);
+        return RasterVertex{v.x, v.y, v.z, v.w, 0.0f, 0.0f, color};
+    };
+
+    auto face = [&](const float3& p0, const float3& p1, const float3& p2, const Color& color) {
+        rasterizer.drawTriangle(vertex(p0, color), vertex(p1, color), vertex(p2, color));
+    };
+
+    //---- 1フレーム分の描画
+    auto draw = [&] {
+        rasterizer.clear(Color(64, 64, 64));
+
+        for(s32 z = 0; z < COUNT; ++z) {
+            for(s32 x = 0; x < COUNT; ++x) {
+                float3 center = float3((x - COUNT / 2) * 2.5f, 0.0f, (z - COUNT / 2) * 2.5f);
+                float3 a      = center + float3(-1.0f, 0.0f, -1.0f);
+                float3 b      = center + float3(+1.0f, 0.0f, -1.0f);
+                float3 c      = center + float3(-1.0f, 0.0f, +1.0f);
+                float3 d      = center + float3(+1.0f, 0.0f, +1.0f);
+                float3 e      = center + float3(0.0f, 1.0f, 0.0f);
+
+                face(a, b, e, Color(255, 255, 255));   // 奥側面
+                face(a, c, e, Color(0, 0, 255));       // 左側面
+                face(d, b, e, Color(0, 255, 0));       // 右側面
+                face(c, d, e, Color(255, 0, 0));       // 手前側面
+            }
+        }
+
+        // グリッド
+        for(s32 i = -64; i <= 64; ++i) {
+            f32 f = static_cast<f32>(i);
+            rasterizer.drawLine(vertex(float3(f, 0.0f, -64.0f), Color(255, 255, 255)),
+                                vertex(float3(f, 0.0f, +64.0f), Color(255, 255, 255)));
+            rasterizer.drawLine(vertex(float3(-64.0f, 0.0f, f), Color(255, 255, 255)),
+                                vertex(float3(+64.0f, 0.0f, f), Color(255, 255, 255)));
+        }
+
+        rasterizer.flush();
+    };
+
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+
+    BENCHMARK_print("[raster] %dx%d, %d pyramids + grid\n", WIDTH, HEIGHT, COUNT * COUNT);
+    BENCHMARK_print("threads, ms, speedup\n");
+
+    f64 base_time = 0.0;
+    for(s32 thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+        JOB_setup(thread_count - 1);
+        f64 time = measure(10, draw);
+        JOB_cleanup();
+
+        if(thread_count == 1) {
+            base_time = time;
+        }
+        BENCHMARK_print("%d, %.3f, %.2f\n", thread_count, time, base_time / time);
+    }
+    BENCHMARK_print("triangles: %d\n", rasterizer.getTriangleCount());
+
+    if(!rasterizer.saveTGA("raster.tga")) {
+        BENCHMARK_print("failed to write raster.tga\n");
+        failed = true;
+    }
+
+    //---- 基準画像との比較 (コンパイラによる浮動小数点の僅かな差は許容する)
+    constexpr const char* GOLDEN_PATH = "golden/raster.tga";
+    constexpr s32         TOLERANCE   = 2;   // 各チャンネルで許容する差
+
+    std::error_code error;
+    if(!std::filesystem::exists(GOLDEN_PATH, error)) {
+        std::filesystem::create_directories("golden", error);
+        if(!rasterizer.saveTGA(GOLDEN_PATH)) {
+            BENCHMARK_print("golden: failed to write %s\n", GOLDEN_PATH);
+            failed = true;
+            return;
+        }
+        BENCHMARK_print("golden: created %s (compared from the next run)\n", GOLDEN_PATH);
+        return;
+    }
+
+    s32 mismatch_count = rasterizer.compareTGA(GOLDEN_PATH, TOLERANCE);
+    if(mismatch_count < 0) {
+        BENCHMARK_print("golden: failed to read %s\n", GOLDEN_PATH);
+        failed = true;
+    }
+    else if(mismatch_count > 0) {
+        BENCHMARK_print("golden: %d pixels differ\n", mismatch_count);
+        failed = true;
+    }
+    else {
+        BENCHMARK_print("golden: match\n");
+    }
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャサンプラー: 1ピクセル版と4ピクセル同時版の比較
+//---------------------------------------------------------------------------
+void benchmarkSampler()
+{
+    constexpr s32 SIZE  = 256;       // テクスチャの大きさ
+    constexpr s32 COUNT = 1 << 20;   // 読み取り数 (4の倍数)
+
+    //---- テスト用の画像とテクスチャ座標 (乱数)
+    std::mt19937 random(12345);
+    std::vector<Color> image(SIZE * SIZE);
+    for(auto& c : image) {
+        c.color_ = static_cast<u32>(random());
+    }
+    SampledTexture texture;
+    texture.build(image.data(), SIZE, SIZE);
+
+    std::uniform_real_distribution<f32> distribution(-2.0f, 2.0f);
+    std::vector<f32> u(COUNT);
+    std::vector<f32> v(COUNT);
+    for(s32 i = 0; i < COUNT; ++i) {
+        u[i] = distribution(random);
+        v[i] = distribution(random);
+    }
+
+    std::vector<Color> scalar_result(COUNT);
+    std::vector<Color> simd_result(COUNT);
+
+    BENCHMARK_print("[sampler] %dx%d bilinear, %d samples\n", SIZE, SIZE, COUNT);
+    BENCHMARK_print("mode, level, scalar ms, simd ms, speedup, max diff\n");
+
+    for(AddressMode mode : {AddressMode::Wrap, AddressMode::Clamp}) {
+        for(s32 level : {0, 4}) {
+            f64 scalar_time = measure(10, [&] {
+                for(s32 i = 0; i < COUNT; ++i) {
+                    scalar_result[i] = texture.sample(u[i], v[i], level, mode);
+                }
+            });
+            f64 simd_time = measure(10, [&] {
+                for(s32 i = 0; i < COUNT; i += 4) {
+                    __m128i texel = texture.sample4(_mm_loadu_ps(&u[i]), _mm_loadu_ps(&v[i]), level, mode);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&simd_result[i]), texel);
+                }
+            });
+
+            // 2つの結果は同じ固定小数点計算のため一致するはず
+            s32 max_diff = 0;
+            for(s32 i = 0; i < COUNT; ++i) {
+                const u8* a = &scalar_result[i].r_;
+                const u8* b = &simd_result[i].r_;
+                for(s32 c = 0; c < 4; ++c) {
+                    max_diff = std::max(max_diff, std::abs(a[c] - b[c]));
+                }
+            }
+
+            BENCHMARK_print("%s, %d, %.3f, %.3f, %.2f, %d\n",
+                            mode == AddressMode::Wrap ? "wrap" : "clamp",
+                            level,
+                            scalar_time,
+                            simd_time,
+                            scalar_time / simd_time,
+                            max_diff);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! オクルージョンカリング: 壁の奥に並べた箱の判定時間とカリング率
+//---------------------------------------------------------------------------
+void benchmarkOcclusion()
+{
+    constexpr s32 WIDTH  = 256;   // 深度バッファの大きさ
+    constexpr s32 HEIGHT = 144;
+    constexpr s32 COUNT  = 128;   // 箱の数 (COUNT×COUNT)
+
+    //---- カメラ (原点から-Z方向を見る)
+    matrix view_proj = mul(matrix::translate(0.0f, -1.5f, 0.0f),
+                           matrix::perspectiveFovRH(std::numbers::pi_v<f32> * 0.25f, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+    //---- 遮蔽物: 手前に並んだ壁 (ドアの隙間あり)
+    std::vector<float3> wall_vertices;
+    std::vector<u16>    wall_indices;
+    auto add_wall = [&](f32 x0, f32 x1, f32 z) {
+        u16 base = static_cast<u16>(wall_vertices.size());
+        wall_vertices.push_back(float3(x0, 0.0f, z));
+        wall_vertices.push_back(float3(x1, 0.0f, z));
+        wall_vertices.push_back(float3(x0, 4.0f, z));
+        wall_vertices.push_back(float3(x1, 4.0f, z));
+        for(u16 i : {0, 1, 2, 1, 3, 2}) {
+            wall_indices.push_back(base + i);
+        }
+    };
+    add_wall(-100.0f, -0.5f, -8.0f);
+    add_wall(+0.5f, +100.0f, -8.0f);
+    add_wall(-100.0f, +100.0f, -30.0f);
+
+    //---- 判定する箱: 床に並べた格子
+    AABBArray boxes;
+    for(s32 z = 0; z < COUNT; ++z) {
+        for(s32 x = 0; x < COUNT; ++x) {
+            float3 p = float3((x - COUNT / 2) * 1.5f, 0.0f, -2.0f - z * 1.5f);
+            boxes.add(AABB{p, p + float3(1.0f, 1.0f, 1.0f)});
+        }
+    }
+    std::vector<u8> visible(boxes.size());
+
+    OcclusionCuller culler;
+    culler.setup(WIDTH, HEIGHT);
+
+    f64 occluder_time = measure(100, [&] {
+        culler.beginFrame(view_proj);
+        culler.drawOccluder(wall_vertices, wall_indices, matrix::identity());
+        culler.buildHiZ();
+    });
+
+    s32 visible_count = 0;
+    f64 batch_time    = measure(10, [&] { visible_count = culler.testAABBs(boxes, visible.data()); });
+
+    // 1個ずつ判定した場合 (結果が一致することも確認)
+    s32 mismatch_count = 0;
+    f64 single_time    = measure(10, [&] {
+        mismatch_count = 0;
+        for(s32 i = 0; i < boxes.size(); ++i) {
+            AABB box{float3(boxes.getMin(0)[i], boxes.getMin(1)[i], boxes.getMin(2)[i]),
+                     float3(boxes.getMax(0)[i], boxes.getMax(1)[i], boxes.getMax(2)[i])};
+            mismatch_count += (culler.testAABB(box) != (visible[i] != 0)) ? 1 : 0;
+        }
+    });
+
+    BENCHMARK_print("[occlusion] %dx%d hi-z (%d levels), %d occluder triangles, %d boxes\n",
+                    WIDTH,
+                    HEIGHT,
+                    culler.getLevelCount(),
+                    culler.getOccluderTriangleCount(),
+                    boxes.size());
+    BENCHMARK_print("occluders + hi-z: %.3f ms\n", occluder_time);
+    BENCHMARK_print("test x4 simd: %.3f ms, single: %.3f ms, speedup %.2f\n", batch_time, single_time, single_time / batch_time);
+    BENCHMARK_print("visible: %d / %d (culled %.1f%%), mismatch: %d\n",
+                    visible_count,
+                    boxes.size(),
+                    100.0 * (boxes.size() - visible_count) / boxes.size(),
+                    mismatch_count);
+}
+
+//---------------------------------------------------------------------------
+//! 視錐台カリング: 10万個の境界球・AABBの判定時間
+//---------------------------------------------------------------------------
+void benchmarkFrustum()
+{
+    constexpr s32 COUNT = 100000;   // 物体数
+    constexpr f32 RANGE = 500.0f;   // 配置する範囲 (±RANGE)
+
+    //---- カメラ (原点から-Z方向を見る)
+    Frustum frustum(matrix::perspectiveFovRH(std::numbers::pi_v<f32> * 0.25f, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+    //---- 物体をランダムに配置
+    std::mt19937                        random(12345);
+    std::uniform_real_distribution<f32> position(-RANGE, RANGE);
+    std::uniform_real_distribution<f32> size(0.5f, 5.0f);
+
+    SphereArray spheres;
+    AABBArray   boxes;
+    for(s32 i = 0; i < COUNT; ++i) {
+        float3 center = float3(position(random), position(random), position(random));
+        f32    radius = size(random);
+        spheres.add(Sphere{center, radius});
+        boxes.add(AABB{center - float3(radius, radius, radius), center + float3(radius, radius, radius)});
+    }
+
+    std::vector<u32> visible_indices(COUNT);
+
+    BENCHMARK_print("[frustum] %d objects\n", COUNT);
+    BENCHMARK_print("type, scalar ms, simd ms, speedup, visible, mismatch\n");
+
+    //---- 境界球
+    {
+        s32 scalar_count = 0;
+        f64 scalar_time  = measure(10, [&] {
+            scalar_count = 0;
+            for(s32 i = 0; i < COUNT; ++i) {
+                Sphere sphere{float3(spheres.getCenter(0)[i], spheres.getCenter(1)[i], spheres.getCenter(2)[i]),
+                              spheres.getRadius()[i]};
+                if(frustum.testSphere(sphere)) {
+                    visible_indices[scalar_count++] = i;
+                }
+            }
+        });
+        std::vector<u32> expected(visible_indices.begin(), visible_indices.begin() + scalar_count);
+
+        s32 simd_count = 0;
+        f64 simd_time  = measure(10, [&] { simd_count = frustum.cullSpheres(spheres, visible_indices.data()); });
+
+        bool mismatch = simd_count != scalar_count || !std::equal(expected.begin(), expected.end(), visible_indices.begin());
+        BENCHMARK_print("sphere, %.3f, %.3f, %.2f, %d, %s\n",
+                        scalar_time,
+                        simd_time,
+                        scalar_time / simd_time,
+                        simd_count,
+                        mismatch ? "yes" : "no");
+    }
+
+    //---- AABB
+    {
+        s32 scalar_count = 0;
+        f64 scalar_time  = measure(10, [&] {
+            scalar_count = 0;
+            for(s32 i = 0; i < COUNT; ++i) {
+                AABB box{float3(boxes.getMin(0)[i], boxes.getMin(1)[i], boxes.getMin(2)[i]),
+                         float3(boxes.getMax(0)[i], boxes.getMax(1)[i], boxes.getMax(2)[i])};
+                if(frustum.testAABB(box)) {
+                    visible_indices[scalar_count++] = i;
+                }
+            }
+        });
+        std::vector<u32> expected(visible_indices.begin(), visible_indices.begin() + scalar_count);
+
+        s32 simd_count = 0;
+        f64 simd_time  = measure(10, [&] { simd_count = frustum.cullAABBs(boxes, visible_indices.data()); });
+
+        bool mismatch = simd_count != scalar_count || !std::equal(expected.begin(), expected.end(), visible_indices.begin());
+        BENCHMARK_print("aabb, %.3f, %.3f, %.2f, %d, %s\n",
+                        scalar_time,
+                        simd_time,
+                        scalar_time / simd_time,
+                        simd_count,
+                        mismatch ? "yes" : "no");
+    }
+}
+
+//---------------------------------------------------------------------------
+//! BVH: 1万～100万個の作成時間と判定のスループット
+//---------------------------------------------------------------------------
+void benchmarkBVH()
+{
+    constexpr s32 QUERY_COUNT = 10000;   // 判定の回数 (レイ・AABB)
+
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+
+    BENCHMARK_print("[bvh] threads %d\n", max_thread_count);
+    BENCHMARK_print(
+        "objects, build 1T ms, build ms, speedup, nodes, depth, refit ms, frustum ms, brute ms, visible, mismatch, ray/s, ray hits, aabb/s\n");
+
+    for(s32 count : {10000, 100000, 1000000}) {
+        // 物体数によらず密度が同程度になるよう配置範囲を広げる
+        f32 range = 5.0f * std::cbrt(static_cast<f32>(count));
+
+        std::mt19937                        random(12345);
+        std::uniform_real_distribution<f32> position(-range, range);
+        std::uniform_real_distribution<f32> size(0.5f, 2.0f);
+
+        AABBArray boxes;
+        for(s32 i = 0; i < count; ++i) {
+            float3 center = float3(position(random), position(random), position(random));
+            float3 extent = float3(size(random), size(random), size(random));
+            boxes.add(AABB{center - extent, center + extent});
+        }
+
+        //---- 作成 (1スレッドと全スレッド)
+        BVH bvh;
+        JOB_setup(0);
+        f64 single_time = measure(3, [&] { bvh.build(boxes); });
+        JOB_cleanup();
+
+        JOB_setup(max_thread_count - 1);
+        f64 build_time = measure(3, [&] { bvh.build(boxes); });
+        JOB_cleanup();
+
+        f64 refit_time = measure(3, [&] { bvh.refit(boxes); });
+
+        //---- 視錐台 (中心から-Z方向を見る) を総当たりと比較
+        Frustum frustum(matrix::perspectiveFovRH(std::numbers::pi_v<f32> * 0.25f, 16.0f / 9.0f, 0.1f, range));
+
+        std::vector<u32> result;
+        f64              frustum_time = measure(10, [&] {
+            result.clear();
+            bvh.queryFrustum(frustum, result);
+        });
+
+        std::vector<u32> expected(count);
+        s32              expected_count = 0;
+        f64 brute_time = measure(10, [&] { expected_count = frustum.cullAABBs(boxes, expected.data()); });
+        expected.resize(expected_count);
+
+        std::sort(result.begin(), result.end());
+        bool mismatch = result != expected;
+
+        //---- レイ (原点付近からランダムな方向)
+        std::uniform_real_distribution<f32> origin(-range * 0.1f, range * 0.1f);
+        std::uniform_real_distribution<f32> direction(-1.0f, 1.0f);
+        std::vector<float3>                 ray_origins(QUERY_COUNT);
+        std::vector<float3>                 ray_directions(QUERY_COUNT);
+        for(s32 i = 0; i < QUERY_COUNT; ++i) {
+            ray_origins[i]    = float3(origin(random), origin(random), origin(random));
+            ray_directions[i] = float3(direction(random), direction(random), direction(random));
+        }
+
+        s32 hit_count = 0;
+        f64 ray_time  = measure(3, [&] {
+            hit_count = 0;
+            for(s32 i = 0; i < QUERY_COUNT; ++i) {
+                RayHit hit;
+                hit_count += bvh.raycast(ray_origins[i], ray_directions[i], range * 2.0f, hit) ? 1 : 0;
+            }
+        });
+
+        //---- AABB (物体数個分程度の大きさ)
+        std::vector<AABB> query_boxes(QUERY_COUNT);
+        for(auto& box : query_boxes) {
+            float3 center = float3(position(random), position(random), position(random));
+            box           = AABB{center - float3(5.0f, 5.0f, 5.0f), center + float3(5.0f, 5.0f, 5.0f)};
+        }
+
+        f64 aabb_time = measure(3, [&] {
+            result.clear();
+            for(const auto& box : query_boxes) {
+                bvh.queryAABB(box, result);
+            }
+        });
+
+        BENCHMARK_print("%d, %.3f, %.3f, %.2f, %d, %d, %.3f, %.3f, %.3f, %d, %s, %.0f, %d, %.0f\n",
+                        count,
+                        single_time,
+                        build_time,
+                        single_time / build_time,
+                        bvh.getNodeCount(),
+                        bvh.getDepth(),
+                        refit_time,
+                        frustum_time,
+                        brute_time,
+                        expected_count,
+                        mismatch ? "yes" : "no",
+                        QUERY_COUNT / (ray_time / 1000.0),
+                        hit_count,
+                        QUERY_COUNT / (aabb_time / 1000.0));
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 空間グリッド: 1万個の一括移動と近傍検索 (総当たりとの比較)
+//---------------------------------------------------------------------------
+void benchmarkGrid()
+{
+    constexpr s32 COUNT         = 10000;   // 物体数
+    constexpr f32 RADIUS        = 0.5f;    // 物体の半径
+    constexpr f32 QUERY_RADIUS  = 2.0f;    // 近傍検索の半径
+    constexpr f32 MOVE_DISTANCE = 0.2f;    // 1フレームの最大移動量
+
+    f32 extent = SpatialGrid::DEFAULT_EXTENT;
+
+    std::mt19937                        random(12345);
+    std::uniform_real_distribution<f32> position(-extent, extent);
+    std::uniform_real_distribution<f32> offset(-MOVE_DISTANCE, MOVE_DISTANCE);
+
+    std::vector<float3> positions(COUNT);
+    for(auto& p : positions) {
+        p = float3(position(random), 0.0f, position(random));
+    }
+
+    SpatialGrid grid;
+    grid.setup();
+
+    BENCHMARK_print("[grid] %d objects, cell %.1fm, query radius %.1fm\n", COUNT, SpatialGrid::DEFAULT_CELL_SIZE, QUERY_RADIUS);
+
+    //---- 登録・削除
+    f64 insert_time = measure(10, [&] {
+        grid.clear();
+        for(s32 i = 0; i < COUNT; ++i) {
+            grid.insert(i, positions[i], RADIUS);
+        }
+    });
+    f64 remove_time = measure(1, [&] {
+        for(s32 i = 0; i < COUNT; ++i) {
+            grid.remove(i);
+        }
+    });
+    for(s32 i = 0; i < COUNT; ++i) {
+        grid.insert(i, positions[i], RADIUS);
+    }
+    BENCHMARK_print("insert ms, remove ms\n");
+    BENCHMARK_print("%.3f, %.3f\n", insert_time, remove_time);
+
+    //---- 一括移動 (スレッド数ごと)
+    std::vector<SpatialMove> moves(COUNT);
+    for(s32 i = 0; i < COUNT; ++i) {
+        moves[i] = SpatialMove{static_cast<u32>(i), positions[i]};
+    }
+
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+
+    BENCHMARK_print("threads, moveBatch ms, move ms\n");
+    for(s32 thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+        JOB_setup(thread_count - 1);
+        f64 batch_time = measure(10, [&] {
+            for(auto& m : moves) {
+                m.position_ += float3(offset(random), 0.0f, offset(random));
+            }
+            grid.moveBatch(moves);
+        });
+        JOB_cleanup();
+
+        f64 move_time = measure(10, [&] {
+            for(auto& m : moves) {
+                m.position_ += float3(offset(random), 0.0f, offset(random));
+                grid.move(m.id_, m.position_);
+            }
+        });
+        BENCHMARK_print("%d, %.3f, %.3f\n", thread_count, batch_time, move_time);
+    }
+
+    //---- 全物体の近傍検索
+    s64              grid_pairs = 0;
+    std::vector<u32> neighbors;
+    f64              grid_time = measure(10, [&] {
+        grid_pairs = 0;
+        for(const auto& m : moves) {
+            neighbors.clear();
+            grid.queryRadius(m.position_, QUERY_RADIUS, neighbors);
+            grid_pairs += neighbors.size();
+        }
+    });
+
+    s64 brute_pairs = 0;
+    f64 brute_time  = measure(1, [&] {
+        brute_pairs = 0;
+        for(const auto& a : moves) {
+            for(const auto& b : moves) {
+                f32 dx       = b.position_.x - a.position_.x;
+                f32 dz       = b.position_.z - a.position_.z;
+                f32 distance = QUERY_RADIUS + RADIUS;
+                brute_pairs += (dx * dx + dz * dz <= distance * distance) ? 1 : 0;
+            }
+        }
+    });
+
+    BENCHMARK_print("query, ms, pairs\n");
+    BENCHMARK_print("brute, %.3f, %lld\n", brute_time, brute_pairs);
+    BENCHMARK_print("grid, %.3f, %lld (%s)\n", grid_time, grid_pairs, grid_pairs == brute_pairs ? "match" : "MISMATCH");
+    BENCHMARK_print("speedup, %.2f\n", brute_time / grid_time);
+}
+
+//---------------------------------------------------------------------------
+//! エンティティ: 1万～10万体の移動・重力・向き・行列の更新 (1体ずつのスカラー処理との比較)
+//---------------------------------------------------------------------------
+void benchmarkEntity()
+{
+    constexpr f32 DELTA_TIME = 1.0f / 60.0f;
+    constexpr f32 MOVE_SPEED = 6.0f;
+    constexpr f32 GRAVITY    = 9.80665f;
+    constexpr f32 TURN_RATE  = 0.1f;
+
+    //! 従来の1体分の状態 (AoS)
+    struct Character
+    {
+        float3 position;
+        float3 velocity;
+        float3 move;
+        float3 dir;
+        float3 appearrance_dir;
+        matrix transform;
+    };
+
+    // 従来のupdateStep()と同じ処理を1体ずつ実行
+    auto update_scalar = [&](std::vector<Character>& characters) {
+        f32 rate = 1.0f - std::pow(1.0f - TURN_RATE, DELTA_TIME * 60.0f);
+        for(auto& c : characters) {
+            if(dot(c.move, c.move) > float1(FLT_EPSILON)) {
+                c.dir = normalize(c.move);
+                c.position += normalize(c.move) * (MOVE_SPEED * DELTA_TIME);
+            }
+
+            c.velocity.y -= GRAVITY * DELTA_TIME;
+            c.position += c.velocity * DELTA_TIME;
+            if(c.position.y < 0.0f) {
+                c.position.y = 0.0f;
+                c.velocity.y = 0.0f;
+            }
+
+            c.dir             = normalize(c.dir);
+            c.appearrance_dir = normalize(c.appearrance_dir);
+
+            f32    cosine = dot(c.dir, c.appearrance_dir);
+            f32    theta  = std::acos(std::clamp(cosine, -1.0f, +1.0f));
+            float3 axis   = float3(0.0f, 1.0f, 0.0f);
+            float3 cr     = cross(c.appearrance_dir, c.dir);
+            if(float1(FLT_EPSILON) < dot(cr, cr)) {
+                axis = normalize(cr);
+            }
+            c.appearrance_dir = mul(float4(c.appearrance_dir, 0.0f), matrix::rotateAxis(axis, theta * rate)).xyz;
+
+            c.transform = ENTITY_makeTransform(c.appearrance_dir, c.position);
+        }
+    };
+
+    auto update_soa = [&](EntityStore& store) {
+        ENTITY_savePrevious(store);
+        ENTITY_updateMovement(store, MOVE_SPEED, DELTA_TIME);
+        ENTITY_updateGravity(store, GRAVITY, DELTA_TIME);
+        ENTITY_updateFacing(store, TURN_RATE, DELTA_TIME);
+        ENTITY_updateTransforms(store);
+    };
+
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+
+    BENCHMARK_print("[entity] movement + gravity + facing + transform\n");
+    BENCHMARK_print("entities, threads, scalar ms, soa ms, speedup, max position error\n");
+
+    for(s32 count : {10000, 100000}) {
+        //---- 同じ初期状態を両方に作成 (半分は移動入力あり、空中から落下)
+        std::mt19937                        random(12345);
+        std::uniform_real_distribution<f32> position(-64.0f, 64.0f);
+        std::uniform_real_distribution<f32> direction(-1.0f, 1.0f);
+
+        std::vector<Character> characters(count);
+        EntityStore            store;
+        for(s32 i = 0; i < count; ++i) {
+            Character& c = characters[i];
+
+            c.position        = float3(position(random), std::abs(position(random)), position(random));
+            c.velocity        = float3(0.0f, 0.0f, 0.0f);
+            c.move            = (i & 1) ? float3(direction(random), 0.0f, direction(random)) : float3(0.0f, 0.0f, 0.0f);
+            c.dir             = normalize(float3(direction(random), 0.0f, direction(random)));
+            c.appearrance_dir = c.dir;
+
+            EntityHandle handle = store.create(c.position, c.dir);
+            store.set(EntityStore::COLUMN_MOVE, store.getIndex(handle), c.move);
+        }
+
+        for(s32 thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+            JOB_setup(thread_count - 1);
+            f64 soa_time = measure(10, [&] { update_soa(store); });
+            JOB_cleanup();
+
+            f64 scalar_time = measure(10, [&] { update_scalar(characters); });
+
+            // 同じ回数だけ更新しているため結果は一致するはず (丸め誤差のみ)
+            f32 max_error = 0.0f;
+            for(s32 i = 0; i < count; ++i) {
+                float3 diff = store.get(EntityStore::COLUMN_POSITION, i) - characters[i].position;
+                max_error   = std::max({max_error, std::abs(diff.x), std::abs(diff.y), std::abs(diff.z)});
+            }
+
+            BENCHMARK_print("%d, %d, %.3f, %.3f, %.2f, %g\n",
+                            count,
+                            thread_count,
+                            scalar_time,
+                            soa_time,
+                            scalar_time / soa_time,
+                            max_error);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 向きの追従: 10万体分を従来のスカラー処理 (acos + rotateAxis) と比較
+//---------------------------------------------------------------------------
+void benchmarkFacing()
+{
+    constexpr s32 COUNT = 100000;   // 要素数
+    constexpr f32 RATE  = 0.1f;     // 追従率
+
+    //---- 見た目の方向と目標の方向 (一部は同じ方向・真逆の方向)
+    std::mt19937                        random(12345);
+    std::uniform_real_distribution<f32> direction(-1.0f, 1.0f);
+
+    std::vector<float3> appearances(COUNT);
+    std::vector<float3> targets(COUNT);
+    for(s32 i = 0; i < COUNT; ++i) {
+        appearances[i] = normalize(float3(direction(random), direction(random) * 0.2f, direction(random)));
+        targets[i]     = normalize(float3(direction(random), direction(random) * 0.2f, direction(random)));
+        if(i % 100 == 0) {
+            targets[i] = appearances[i];
+        }
+        if(i % 100 == 1) {
+            targets[i] = float3(0.0f, 0.0f, 0.0f) - appearances[i];
+        }
+    }
+
+    // 従来のupdateStep()と同じ処理
+    auto turn_scalar = [&](std::vector<float3>& appearance, std::vector<float3>& target) {
+        for(s32 i = 0; i < COUNT; ++i) {
+            float3 dir = normalize(target[i]);
+            float3 app = normalize(appearance[i]);
+
+            f32    cosine = dot(dir, app);
+            f32    theta  = std::acos(std::clamp(cosine, -1.0f, +1.0f));
+            float3 axis   = float3(0.0f, 1.0f, 0.0f);
+            float3 c      = cross(app, dir);
+            if(float1(FLT_EPSILON) < dot(c, c)) {
+                axis = normalize(c);
+            }
+            target[i]     = dir;
+            appearance[i] = mul(float4(app, 0.0f), matrix::rotateAxis(axis, theta * RATE)).xyz;
+        }
+    };
+
+    // SoAに変換 (4の倍数に切り上げ、余りは0)
+    s32              capacity = (COUNT + 3) & ~3;
+    std::vector<f32> soa_appearance[3];
+    std::vector<f32> soa_target[3];
+    auto             to_soa = [&] {
+        for(s32 axis = 0; axis < 3; ++axis) {
+            soa_appearance[axis].assign(capacity, 0.0f);
+            soa_target[axis].assign(capacity, 0.0f);
+            for(s32 i = 0; i < COUNT; ++i) {
+                soa_appearance[axis][i] = (&appearances[i].x)[axis];
+                soa_target[axis][i]     = (&targets[i].x)[axis];
+            }
+        }
+    };
+    f32* appearance_columns[3]{};
+    f32* target_columns[3]{};
+    auto turn_simd = [&] {
+        for(s32 axis = 0; axis < 3; ++axis) {
+            appearance_columns[axis] = soa_appearance[axis].data();
+            target_columns[axis]     = soa_target[axis].data();
+        }
+        ENTITY_turnTowards(appearance_columns, target_columns, COUNT, RATE);
+    };
+
+    //---- 精度 (1回分の結果のなす角の誤差)
+    std::vector<float3> expected_appearance = appearances;
+    std::vector<float3> expected_target     = targets;
+    turn_scalar(expected_appearance, expected_target);
+
+    to_soa();
+    turn_simd();
+
+    f64 max_error = 0.0;
+    f64 sum_error = 0.0;
+    for(s32 i = 0; i < COUNT; ++i) {
+        // 1.0付近のacosはfloatでは分解能が足りないため、外積の長さ(sin)をdoubleで求める
+        f64 a[3]{soa_appearance[0][i], soa_appearance[1][i], soa_appearance[2][i]};
+        f64 b[3]{expected_appearance[i].x, expected_appearance[i].y, expected_appearance[i].z};
+        f64 c[3]{a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+        f64 sine  = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+        f64 error = std::asin(std::min(sine, 1.0)) * 180.0 / std::numbers::pi;
+        if(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] < 0.0) {
+            error = 180.0 - error;
+        }
+        max_error = std::max(max_error, error);
+        sum_error += error;
+    }
+
+    //---- 速度 (同じ配列を繰り返し更新)
+    std::vector<float3> work_appearance = appearances;
+    std::vector<float3> work_target     = targets;
+    f64                 scalar_time     = measure(10, [&] { turn_scalar(work_appearance, work_target); });
+
+    to_soa();
+    f64 simd_time = measure(10, turn_simd);
+
+    BENCHMARK_print("[facing] %d agents, rate %.2f\n", COUNT, RATE);
+    BENCHMARK_print("scalar ms, simd ms, speedup, max error deg, mean error deg\n");
+    BENCHMARK_print("%.3f, %.3f, %.2f, %g, %g\n", scalar_time, simd_time, scalar_time / simd_time, max_error, sum_error / COUNT);
+}
+
+//---------------------------------------------------------------------------
+//! トランスフォーム階層: 1000体×100ボーンのうち1割が動く場合の更新 (毎フレーム全て再計算する場合との比較)
+//---------------------------------------------------------------------------
+void benchmarkTransform()
+{
+    constexpr s32 RIG_COUNT    = 1000;   // リグ数
+    constexpr s32 BONE_COUNT   = 100;    // 1体あたりのボーン数
+    constexpr s32 MOVE_PERIOD  = 10;     // 何フレームに1回動くか (1割のリグが毎フレーム動く)
+    constexpr s32 NODE_COUNT   = RIG_COUNT * BONE_COUNT;
+
+    //---- 同じ階層を両方に作成 (ボーンは二分木状につなぐ)
+    std::mt19937                        random(12345);
+    std::uniform_real_distribution<f32> offset(-1.0f, 1.0f);
+    std::uniform_real_distribution<f32> angle(-0.5f, 0.5f);
+
+    std::vector<s32>             parents(NODE_COUNT);
+    std::vector<float3>          positions(NODE_COUNT);
+    std::vector<float3>          rotations(NODE_COUNT);
+    std::vector<matrix>          locals(NODE_COUNT);
+    std::vector<matrix>          worlds(NODE_COUNT);
+    std::vector<TransformHandle> handles(NODE_COUNT);
+
+    TransformHierarchy hierarchy;
+    for(s32 rig = 0; rig < RIG_COUNT; ++rig) {
+        for(s32 bone = 0; bone < BONE_COUNT; ++bone) {
+            s32 i      = rig * BONE_COUNT + bone;
+            parents[i] = (bone == 0) ? -1 : rig * BONE_COUNT + (bone - 1) / 2;
+
+            positions[i] = float3(offset(random), offset(random), offset(random));
+            rotations[i] = float3(angle(random), angle(random), angle(random));
+
+            handles[i] = hierarchy.create((bone == 0) ? TransformHandle{} : handles[parents[i]]);
+            hierarchy.setPosition(handles[i], positions[i]);
+            hierarchy.setRotation(handles[i], rotations[i]);
+        }
+    }
+
+    // 1割のリグのルートを動かす
+    s32  frame   = 0;
+    auto animate = [&](bool to_hierarchy) {
+        for(s32 rig = frame % MOVE_PERIOD; rig < RIG_COUNT; rig += MOVE_PERIOD) {
+            s32 i        = rig * BONE_COUNT;
+            positions[i] = float3(static_cast<f32>(rig), 0.0f, static_cast<f32>(frame) * 0.01f);
+            if(to_hierarchy) {
+                hierarchy.setPosition(handles[i], positions[i]);
+            }
+        }
+    };
+
+    // 従来の方法: 全ノードのローカル行列とワールド行列を毎回作り直す
+    auto update_full = [&] {
+        for(s32 i = 0; i < NODE_COUNT; ++i) {
+            const float3& r = rotations[i];
+
+            matrix m  = matrix::scale(float3(1.0f, 1.0f, 1.0f));
+            m         = mul(m, matrix::rotateZ(r.z));
+            m         = mul(m, matrix::rotateX(r.x));
+            m         = mul(m, matrix::rotateY(r.y));
+            m         = mul(m, matrix::translate(positions[i]));
+            locals[i] = m;
+            worlds[i] = (parents[i] >= 0) ? mul(m, worlds[parents[i]]) : m;
+        }
+    };
+
+    update_full();
+    hierarchy.update();
+
+    f64 full_time = measure(10, [&] {
+        frame++;
+        animate(false);
+        update_full();
+    });
+    f64 dirty_time = measure(10, [&] {
+        frame++;
+        animate(true);
+        hierarchy.update();
+    });
+    s32 updated_count = hierarchy.getUpdatedCount();
+
+    BENCHMARK_print("[transform] %d rigs x %d bones, %d%% of rigs moved per frame\n", RIG_COUNT, BONE_COUNT, 100 / MOVE_PERIOD);
+    BENCHMARK_print("threads, full ms, dirty ms, speedup, updated nodes, max world error\n");
+
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+    for(s32 thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+        JOB_setup(thread_count - 1);
+        f64 time = (thread_count == 1) ? dirty_time : measure(10, [&] {
+            frame++;
+            animate(true);
+            hierarchy.updateParallel();
+        });
+
+        // 全てのリグが同じフレームの値になるまで両方を更新して比較 (同じ計算順なので一致するはず)
+        for(s32 i = 0; i < MOVE_PERIOD; ++i) {
+            frame++;
+            animate(true);
+            update_full();
+            hierarchy.updateParallel();
+        }
+        JOB_cleanup();
+
+        f32 max_error = 0.0f;
+        for(s32 i = 0; i < NODE_COUNT; ++i) {
+            const auto& a = *reinterpret_cast<const f32(*)[4][4]>(&hierarchy.getWorldMatrix(handles[i]));
+            const auto& b = *reinterpret_cast<const f32(*)[4][4]>(&worlds[i]);
+            for(s32 row = 0; row < 4; ++row) {
+                for(s32 column = 0; column < 4; ++column) {
+                    max_error = std::max(max_error, std::abs(a[row][column] - b[row][column]));
+                }
+            }
+        }
+
+        BENCHMARK_print("%d, %.3f, %.3f, %.2f, %d, %g\n",
+                        thread_count,
+                        full_time,
+                        time,
+                        full_time / time,
+                        updated_count,
+                        max_error);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! LOD: 球メッシュのLODチェーン作成と1万個の段の選択 (描画する三角形数の削減量)
+//---------------------------------------------------------------------------
+void benchmarkLod()
+{
+    constexpr s32 STACKS        = 128;     // 球の縦の分割数
+    constexpr s32 SLICES        = 256;     // 球の横の分割数
+    constexpr s32 LEVEL_COUNT   = 8;       // LODの段数
+    constexpr s32 OBJECT_COUNT  = 10000;   // 物体数
+    constexpr s32 SCREEN_HEIGHT = 720;     // 画面の高さ
+    constexpr f32 FOVY          = std::numbers::pi_v<f32> * 0.25f;
+
+    //---- 半径1mの球 (極は1頂点にまとめる)
+    Mesh sphere;
+    sphere.positions_.push_back(float3(0.0f, 1.0f, 0.0f));
+    for(s32 stack = 1; stack < STACKS; ++stack) {
+        f32 theta = std::numbers::pi_v<f32> * stack / STACKS;
+        for(s32 slice = 0; slice < SLICES; ++slice) {
+            f32 phi = 2.0f * std::numbers::pi_v<f32> * slice / SLICES;
+            sphere.positions_.push_back(float3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    sphere.positions_.push_back(float3(0.0f, -1.0f, 0.0f));
+
+    u32  bottom = static_cast<u32>(sphere.positions_.size() - 1);
+    auto ring   = [&](s32 stack, s32 slice) { return static_cast<u32>(1 + (stack - 1) * SLICES + (slice % SLICES)); };
+    for(s32 slice = 0; slice < SLICES; ++slice) {
+        sphere.indices_.insert(sphere.indices_.end(), {0u, ring(1, slice + 1), ring(1, slice)});
+        sphere.indices_.insert(sphere.indices_.end(), {bottom, ring(STACKS - 1, slice), ring(STACKS - 1, slice + 1)});
+        for(s32 stack = 1; stack < STACKS - 1; ++stack) {
+            u32 a = ring(stack, slice);
+            u32 b = ring(stack, slice + 1);
+            u32 c = ring(stack + 1, slice);
+            u32 d = ring(stack + 1, slice + 1);
+            sphere.indices_.insert(sphere.indices_.end(), {a, b, c, b, d, c});
+        }
+    }
+
+    //---- LODチェーンを作成
+    LodChain chain;
+    f64      generate_time = measure(1, [&] { chain = LOD_generate(sphere, LEVEL_COUNT, 0.5f); });
+
+    BENCHMARK_print("[lod] generate %d triangles -> %d levels: %.3f ms\n",
+                    sphere.getTriangleCount(),
+                    static_cast<s32>(chain.levels_.size()),
+                    generate_time);
+    BENCHMARK_print("level, triangles, error m\n");
+    for(size_t level = 0; level < chain.levels_.size(); ++level) {
+        BENCHMARK_print("%d, %d, %g\n", static_cast<s32>(level), chain.levels_[level].mesh_.getTriangleCount(), chain.levels_[level].error_);
+    }
+
+    //---- 視点の周り2m～400mに物体を配置
+    std::mt19937                        random(12345);
+    std::uniform_real_distribution<f32> distance(2.0f, 400.0f);
+    std::uniform_real_distribution<f32> angle(0.0f, 2.0f * std::numbers::pi_v<f32>);
+
+    SphereArray                  spheres;
+    std::vector<const LodChain*> chains(OBJECT_COUNT, &chain);
+    std::vector<u32>             indices(OBJECT_COUNT);
+    for(s32 i = 0; i < OBJECT_COUNT; ++i) {
+        f32 d = distance(random);
+        f32 a = angle(random);
+        spheres.add(Sphere{float3(d * std::cos(a), 0.0f, d * std::sin(a)), chain.bounds_.radius_});
+        indices[i] = i;
+    }
+
+    LodSelector selector;
+    selector.setProjection(FOVY, SCREEN_HEIGHT);
+
+    //---- 選択時間 (1個ずつ距離を計算する場合との比較)
+    std::vector<u8> batch_levels(OBJECT_COUNT, 0);
+    std::vector<u8> scalar_levels(OBJECT_COUNT, 0);
+    float3          eye = float3(0.0f, 1.7f, 0.0f);
+
+    f64 batch_time = measure(10, [&] {
+        selector.selectBatch(eye, spheres, indices.data(), OBJECT_COUNT, chains.data(), batch_levels.data());
+    });
+    f64 scalar_time = measure(10, [&] {
+        for(s32 i = 0; i < OBJECT_COUNT; ++i) {
+            float3 d        = float3(spheres.getCenter(0)[i], spheres.getCenter(1)[i], spheres.getCenter(2)[i]) - eye;
+            f32    length   = std::sqrt(static_cast<f32>(dot(d, d)));
+            scalar_levels[i] = static_cast<u8>(selector.select(*chains[i], length - spheres.getRadius()[i], scalar_levels[i]));
+        }
+    });
+
+    s32 mismatch_count = 0;
+    s64 full_triangles = 0;
+    s64 lod_triangles  = 0;
+    for(s32 i = 0; i < OBJECT_COUNT; ++i) {
+        mismatch_count += (batch_levels[i] != scalar_levels[i]) ? 1 : 0;
+        full_triangles += chain.levels_[0].mesh_.getTriangleCount();
+        lod_triangles += chain.levels_[batch_levels[i]].mesh_.getTriangleCount();
+    }
+
+    BENCHMARK_print("[lod] select %d objects, %d px, max error 1 px\n", OBJECT_COUNT, SCREEN_HEIGHT);
+    BENCHMARK_print("scalar ms, batch ms, speedup, mismatches, full triangles, lod triangles, ratio\n");
+    BENCHMARK_print("%.3f, %.3f, %.2f, %d, %lld, %lld, %.4f\n",
+                    scalar_time,
+                    batch_time,
+                    scalar_time / batch_time,
+                    mismatch_count,
+                    full_triangles,
+                    lod_triangles,
+                    static_cast<f64>(lod_triangles) / static_cast<f64>(full_triangles));
+
+    //---- 視点を前後に小さく揺らした時の切り替え回数 (切り替えの幅の効果)
+    BENCHMARK_print("hysteresis, level switches in 100 frames (eye moving +-0.5 m)\n");
+    for(f32 hysteresis : {0.0f, 0.25f}) {
+        selector.setHysteresis(hysteresis);
+
+        std::vector<u8> levels(OBJECT_COUNT, 0);
+        selector.selectBatch(eye, spheres, indices.data(), OBJECT_COUNT, chains.data(), levels.data());
+
+        s32 switch_count = 0;
+        for(s32 frame = 0; frame < 100; ++frame) {
+            std::vector<u8> previous = levels;
+            float3          position = eye + float3((frame & 1) ? 0.5f : -0.5f, 0.0f, 0.0f);
+            selector.selectBatch(position, spheres, indices.data(), OBJECT_COUNT, chains.data(), levels.data());
+            for(s32 i = 0; i < OBJECT_COUNT; ++i) {
+                switch_count += (levels[i] != previous[i]) ? 1 : 0;
+            }
+        }
+        BENCHMARK_print("%.2f, %d\n", hysteresis, switch_count);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! プロファイラー: 1ゾーンあたりの計測コスト (1スレッド・全スレッド同時)
+//---------------------------------------------------------------------------
+void benchmarkProfile()
+{
+    constexpr s32 ZONE_COUNT = 10000;   // 1回の計測で記録するゾーン数 (リングバッファに収まる数)
+
+    PROFILE_setup();
+
+    // 空のゾーンを記録してすぐに回収 (回収はメインスレッドのPROFILE_endFrame()と同じ処理)
+    auto record = [] {
+        for(s32 i = 0; i < ZONE_COUNT; ++i) {
+            PROFILE_ZONE("benchmark");
+        }
+    };
+
+    f64 zone_time = measure(10, [&] {
+        record();
+        PROFILE_endFrame();
+    });
+
+    BENCHMARK_print("[profile] %d zones per run\n", ZONE_COUNT);
+    BENCHMARK_print("threads, ns per zone (record + collect)\n");
+    BENCHMARK_print("1, %.1f\n", zone_time * 1.0e6 / ZONE_COUNT);
+
+    // 全ワーカーで同時に記録 (スレッドごとのバッファのため競合しない)
+    s32 max_thread_count = std::max(static_cast<s32>(std::thread::hardware_concurrency()), 1);
+    if(max_thread_count > 1) {
+        JOB_setup(max_thread_count - 1);
+        f64 parallel_time = measure(10, [&] {
+            JOB_parallelFor(max_thread_count, 1, [&](s32 begin, s32 end) {
+                for(s32 i = begin; i < end; ++i) {
+                    record();
+                }
+            });
+            PROFILE_endFrame();
+        });
+        JOB_cleanup();
+
+        BENCHMARK_print("%d, %.1f\n", max_thread_count, parallel_time * 1.0e6 / (static_cast<f64>(ZONE_COUNT) * max_thread_count));
+    }
+
+    // ゾーンの統計 (1回の計測あたりの合計時間)
+    BENCHMARK_print("zone, min ms, avg ms, max ms, calls\n");
+    for(const ProfileStats& stats : PROFILE_getStats()) {
+        BENCHMARK_print("%s, %.3f, %.3f, %.3f, %.0f\n", stats.name_, stats.min_ms_, stats.avg_ms_, stats.max_ms_, stats.calls_);
+    }
+    PROFILE_cleanup();
+}
+
+//---------------------------------------------------------------------------
+//! OpenGL呼び出しの再生: -gllog で記録した gllog.bin をソフトウェアラスタライザーで再生
+//! 最後のフレームを glreplay.tga に保存
+//---------------------------------------------------------------------------
+void benchmarkGlReplay()
+{
+    JOB_setup();
+
+    SoftwareRasterizer rasterizer;
+    std::vector<f64>   frame_times;
+
+    f64 start       = TIMER_now();
+    s32 frame_count = GLTRACE_replay("gllog.bin", rasterizer, [&](s32) {
+        f64 now = TIMER_now();
+        frame_times.push_back((now - start) * 1000.0);   // 命令の解釈・頂点変換・描画
+        start = now;
+    });
+
+    if(frame_count < 0) {
+        BENCHMARK_print("[glreplay] gllog.bin not found (record with -gllog)\n");
+        JOB_cleanup();
+        return;
+    }
+
+    BENCHMARK_print("[glreplay] %d frames, %dx%d\n", frame_count, rasterizer.getWidth(), rasterizer.getHeight());
+    if(frame_count > 0) {
+        std::vector<f64> sorted = frame_times;
+        std::sort(sorted.begin(), sorted.end());
+
+        f64 total = 0.0;
+        for(f64 time : frame_times) {
+            total += time;
+        }
+        BENCHMARK_print("avg ms, p50 ms, p99 ms, max ms\n");
+        BENCHMARK_print("%.3f, %.3f, %.3f, %.3f\n",
+                        total / frame_count,
+                        sorted[(frame_count - 1) / 2],
+                        sorted[(frame_count * 99 + 99) / 100 - 1],
+                        sorted.back());
+        BENCHMARK_print("triangles (last frame): %d\n", rasterizer.getTriangleCount());
+        rasterizer.saveTGA("glreplay.tga");
+    }
+    rasterizer.cleanup();
+    JOB_cleanup();
+}
+
+//---------------------------------------------------------------------------
+//! 計測用シーンの結果を1行で出力
+//---------------------------------------------------------------------------
+void printSceneResult(const SceneResult& result)
+{
+    f64 update_total = 0.0;
+    f64 render_total = 0.0;
+    for(const SceneFrameStats& frame : result.frames_) {
+        update_total += frame.update_ms_;
+        render_total += frame.render_ms_;
+    }
+    f64             frame_count = static_cast<f64>(std::max<size_t>(result.frames_.size(), 1));
+    SceneFrameStats last        = result.frames_.empty() ? SceneFrameStats() : result.frames_.back();
+
+    BENCHMARK_print("%d, %.3f, %.3f, %.3f, %u, %d, %.1f, %u\n",
+                    result.config_.character_count_,
+                    update_total / frame_count,
+                    render_total / frame_count,
+                    result.texture_decode_ms_,
+                    last.draw_count_,
+                    last.visible_count_,
+                    static_cast<f64>(last.arena_bytes_) / 1024.0,
+                    last.heap_allocs_);
+}
+
+//---------------------------------------------------------------------------
+//! 計測用シーン: キャラクターとデバッグ矢印を1～100000に増やしたときのスケーリング
+//! フレームごとの結果を scene.csv、規模と集計を scene.json に保存
+//---------------------------------------------------------------------------
+void benchmarkScene()
+{
+    constexpr s32 MAX_COUNT = 100000;
+
+    JOB_setup();
+    ARENA_setup();
+
+    SceneConfig base;
+    base.texture_count_ = 4;
+    base.frame_count_   = 60;
+
+    BENCHMARK_print("[scene] %dx%d, %d frames, %d textures %dx%d\n",
+                    base.width_,
+                    base.height_,
+                    base.frame_count_,
+                    base.texture_count_,
+                    base.texture_size_,
+                    base.texture_size_);
+    BENCHMARK_print("characters, update ms, render ms, texture decode ms, draw calls, visible, arena KB, heap allocs\n");
+
+    std::vector<SceneResult> results;
+    for(s32 count = 1; count <= MAX_COUNT; count *= 10) {
+        SceneConfig config      = base;
+        config.character_count_ = count;
+        config.arrow_count_     = count;
+
+        SceneResult result;
+        if(!SCENE_run(config, result)) {
+            BENCHMARK_print("%d, failed\n", count);
+            break;
+        }
+        printSceneResult(result);
+        results.push_back(std::move(result));
+    }
+
+    SCENE_writeCSV("scene.csv", results);
+    SCENE_writeJSON("scene.json", results);
+
+    ARENA_cleanup();
+    JOB_cleanup();
+}
+
+//---------------------------------------------------------------------------
+//! ベンチマーク一覧
+//---------------------------------------------------------------------------
+struct BenchmarkEntry
+{
+    const char* name_;         //!< 名前
+    void (*function_)();       //!< 実行関数
+};
+
+constexpr BenchmarkEntry benchmarks[]{
+    {"job", benchmarkJob},
+    {"raster", benchmarkRaster},
+    {"sampler", benchmarkSampler},
+    {"occlusion", benchmarkOcclusion},
+    {"frustum", benchmarkFrustum},
+    {"bvh", benchmarkBVH},
+    {"grid", benchmarkGrid},
+    {"entity", benchmarkEntity},
+    {"facing", benchmarkFacing},
+    {"transform", benchmarkTransform},
+    {"lod", benchmarkLod},
+    {"profile", benchmarkProfile},
+    {"glreplay", benchmarkGlReplay},
+    {"scene", benchmarkScene},
+};
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! ベンチマークを実行
+//---------------------------------------------------------------------------
+bool BENCHMARK_run(const char* name)
+{
+    failed = false;
+
+    if(fopen_s(&output_file, "benchmark.txt", "w") != 0) {
+        output_file = nullptr;
+    }
+
+    s32 count = 0;
+    for(const auto& benchmark : benchmarks) {
+        if(name && name[0] && strcmp(name, benchmark.name_) != 0) {
+            continue;
+        }
+        benchmark.function_();
+        BENCHMARK_print("\n");
+        count++;
+    }
+
+    if(output_file) {
+        fclose(output_file);
+        output_file = nullptr;
+    }
+    return count > 0 && !failed;
+}
+
+//---------------------------------------------------------------------------
+//! 計測用シーンを規模を指定して実行
+//---------------------------------------------------------------------------
+bool BENCHMARK_runScene(const char* options)
+{
+    SceneConfig config;
+    if(!SCENE_parseConfig(options, config)) {
+        OutputDebugStringA("[scene] invalid options\n");
+        return false;
+    }
+
+    if(fopen_s(&output_file, "benchmark.txt", "w") != 0) {
+        output_file = nullptr;
+    }
+    JOB_setup();
+    ARENA_setup();
+
+    BENCHMARK_print("[scene] %s\n", options);
+    BENCHMARK_print("characters, update ms, render ms, texture decode ms, draw calls, visible, arena KB, heap allocs\n");
+
+    SceneResult result;
+    bool        succeeded = SCENE_run(config, result);
+    if(succeeded) {
+        printSceneResult(result);
+        SCENE_writeCSV("scene.csv", {&result, 1});
+        SCENE_writeJSON("scene.json", {&result, 1});
+    }
+
+    ARENA_cleanup();
+    JOB_cleanup();
+    if(output_file) {
+        fclose(output_file);
+        output_file = nullptr;
+    }
+    return succeeded;
+}
+
+//---------------------------------------------------------------------------
+//! ベンチマーク結果を出力
+//---------------------------------------------------------------------------
+void BENCHMARK_print(const char* format, ...)
+{
+    char text[1024];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf_s(text, sizeof(text), _TRUNCATE, format, args);
+    va_end(args);
+
+    OutputDebugStringA(text);
+    if(output_file) {
+        fputs(text, output_file);
+    }
+}
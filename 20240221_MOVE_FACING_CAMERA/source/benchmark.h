@@ -0,0 +1,27 @@
+﻿//===========================================================================
+//!	@file	benchmark.h
+//!	@brief	ベンチマーク
+//!
+//!	コマンドライン引数 "-benchmark [名前]" で起動するとウィンドウを作らずに
+//!	ベンチマークを実行し、結果を benchmark.txt とデバッグ出力に書き出します。
+//!	"raster" は描画結果を基準画像 golden/raster.tga と比較し、一致しなければ終了コード1を返します。
+//!	基準画像がない場合は最初の実行で作成します (作り直す場合は削除して再実行)。
+//!	"-scene [名前=値 ...]" で計測用シーンを規模を指定して実行します (scene.h)。
+//===========================================================================
+#pragma once
+
+//! ベンチマークを実行
+//! @param  [in]    name    実行するベンチマーク名 (nullptrまたは空文字列で全て)
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(該当するベンチマークがない・基準画像と一致しない)
+bool BENCHMARK_run(const char* name);
+
+//! 計測用シーンを規模を指定して実行 (結果は scene.csv・scene.json・benchmark.txt)
+//! @param  [in]    options 空白区切りの 名前=値 (SCENE_parseConfig()の形式)
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(設定の誤り・初期化の失敗)
+bool BENCHMARK_runScene(const char* options);
+
+//! ベンチマーク結果を出力 (printf形式)
+//! @param  [in]    format  書式文字列
+void BENCHMARK_print(const char* format, ...);
@@ -0,0 +1,89 @@
+﻿//===========================================================================
+//!	@file	bounds.cpp
+//!	@brief	境界ボリューム
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! 行列で変換したAABBを取得
+//---------------------------------------------------------------------------
+AABB AABB::transform(const matrix& m) const
+{
+    // 中心は座標変換、半径は各軸ベクトルの絶対値で広げる
+    float3 center = (min_ + max_) * 0.5f;
+    float3 extent = (max_ - min_) * 0.5f;
+
+    float3 new_center = mul(float4(center, 1.0f), m).xyz;
+    float3 new_extent = abs(m[0].xyz) * extent.x + abs(m[1].xyz) * extent.y + abs(m[2].xyz) * extent.z;
+
+    return AABB{new_center - new_extent, new_center + new_extent};
+}
+
+//---------------------------------------------------------------------------
+//! 全て削除
+//---------------------------------------------------------------------------
+void AABBArray::clear()
+{
+    for(s32 axis = 0; axis < 3; ++axis) {
+        min_[axis].clear();
+        max_[axis].clear();
+    }
+    count_ = 0;
+}
+
+//---------------------------------------------------------------------------
+//! 追加
+//---------------------------------------------------------------------------
+s32 AABBArray::add(const AABB& box)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    // 4個単位で確保 (余りは大きさ0の箱)
+    if((count_ & 3) == 0) {
+        for(s32 axis = 0; axis < 3; ++axis) {
+            min_[axis].resize(count_ + 4, 0.0f);
+            max_[axis].resize(count_ + 4, 0.0f);
+        }
+    }
+
+    f32 box_min[3] = {box.min_.x, box.min_.y, box.min_.z};
+    f32 box_max[3] = {box.max_.x, box.max_.y, box.max_.z};
+    for(s32 axis = 0; axis < 3; ++axis) {
+        min_[axis][count_] = box_min[axis];
+        max_[axis][count_] = box_max[axis];
+    }
+    return count_++;
+}
+
+//---------------------------------------------------------------------------
+//! 全て削除
+//---------------------------------------------------------------------------
+void SphereArray::clear()
+{
+    for(s32 axis = 0; axis < 3; ++axis) {
+        center_[axis].clear();
+    }
+    radius_.clear();
+    count_ = 0;
+}
+
+//---------------------------------------------------------------------------
+//! 追加
+//---------------------------------------------------------------------------
+s32 SphereArray::add(const Sphere& sphere)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    // 4個単位で確保 (余りは半径0の球)
+    if((count_ & 3) == 0) {
+        for(s32 axis = 0; axis < 3; ++axis) {
+            center_[axis].resize(count_ + 4, 0.0f);
+        }
+        radius_.resize(count_ + 4, 0.0f);
+    }
+
+    center_[0][count_] = sphere.center_.x;
+    center_[1][count_] = sphere.center_.y;
+    center_[2][count_] = sphere.center_.z;
+    radius_[count_]    = sphere.radius_;
+    return count_++;
+}
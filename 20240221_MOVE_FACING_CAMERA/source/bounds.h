@@ -0,0 +1,99 @@
+﻿//===========================================================================
+//!	@file	bounds.h
+//!	@brief	境界ボリューム
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! 軸平行境界ボックス (AABB)
+//===========================================================================
+struct AABB
+{
+    float3 min_ = float3(0.0f, 0.0f, 0.0f);   //!< 最小座標
+    float3 max_ = float3(0.0f, 0.0f, 0.0f);   //!< 最大座標
+
+    //! 行列で変換したAABBを取得 (変換後の8頂点を包む箱)
+    //! @param  [in]    m   変換行列
+    [[nodiscard]] AABB transform(const matrix& m) const;
+};
+
+//===========================================================================
+//! 境界球
+//===========================================================================
+struct Sphere
+{
+    float3 center_ = float3(0.0f, 0.0f, 0.0f);   //!< 中心
+    f32    radius_ = 0.0f;                       //!< 半径
+};
+
+//===========================================================================
+//! AABBの配列 (SoA)
+//!
+//! SIMDで4個ずつ処理できるように成分ごとに並べます。
+//! 要素数は4の倍数に切り上げて確保し、余りは大きさ0の箱で埋めます。
+//===========================================================================
+class AABBArray
+{
+public:
+    //! コンストラクタ
+    AABBArray() = default;
+
+    //! 全て削除
+    void clear();
+
+    //! 追加
+    //! @param  [in]    box     AABB
+    //! @return 追加した番号
+    s32 add(const AABB& box);
+
+    //! 要素数を取得
+    s32 size() const { return count_; }
+
+    //! 最小座標を取得
+    //! @param  [in]    axis    0:X 1:Y 2:Z
+    const f32* getMin(s32 axis) const { return min_[axis].data(); }
+
+    //! 最大座標を取得
+    //! @param  [in]    axis    0:X 1:Y 2:Z
+    const f32* getMax(s32 axis) const { return max_[axis].data(); }
+
+private:
+    std::vector<f32> min_[3];    //!< 最小座標 (成分ごと)
+    std::vector<f32> max_[3];    //!< 最大座標 (成分ごと)
+    s32              count_ = 0; //!< 要素数
+};
+
+//===========================================================================
+//! 境界球の配列 (SoA)
+//!
+//! AABBArrayと同じく要素数を4の倍数に切り上げて確保します。
+//===========================================================================
+class SphereArray
+{
+public:
+    //! コンストラクタ
+    SphereArray() = default;
+
+    //! 全て削除
+    void clear();
+
+    //! 追加
+    //! @param  [in]    sphere  境界球
+    //! @return 追加した番号
+    s32 add(const Sphere& sphere);
+
+    //! 要素数を取得
+    s32 size() const { return count_; }
+
+    //! 中心座標を取得
+    //! @param  [in]    axis    0:X 1:Y 2:Z
+    const f32* getCenter(s32 axis) const { return center_[axis].data(); }
+
+    //! 半径を取得
+    const f32* getRadius() const { return radius_.data(); }
+
+private:
+    std::vector<f32> center_[3];   //!< 中心座標 (成分ごと)
+    std::vector<f32> radius_;      //!< 半径
+    s32              count_ = 0;   //!< 要素数
+};
@@ -0,0 +1,491 @@
+﻿//===========================================================================
+//!	@file	bvh.cpp
+//!	@brief	BVH (境界ボリューム階層)
+//===========================================================================
+
+namespace
+{
+constexpr s32 BIN_COUNT          = 16;     //!< SAHの分割候補数 (1軸あたり)
+constexpr f32 TRAVERSAL_COST     = 1.0f;   //!< 節ノードをたどるコスト (物体1個の判定コストとの比)
+constexpr u32 PARALLEL_THRESHOLD = 4096;   //!< これより多い物体数の分割は子ジョブにする
+
+//! 範囲
+struct Bounds
+{
+    f32 min_[3]{FLT_MAX, FLT_MAX, FLT_MAX};
+    f32 max_[3]{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    //! 座標を含むように広げる
+    void grow(const f32 box_min[3], const f32 box_max[3])
+    {
+        for(s32 axis = 0; axis < 3; ++axis) {
+            min_[axis] = std::min(min_[axis], box_min[axis]);
+            max_[axis] = std::max(max_[axis], box_max[axis]);
+        }
+    }
+
+    //! 表面積の半分 (比較にしか使わないため1/2を省略)
+    f32 area() const
+    {
+        f32 dx = std::max(max_[0] - min_[0], 0.0f);
+        f32 dy = std::max(max_[1] - min_[1], 0.0f);
+        f32 dz = std::max(max_[2] - min_[2], 0.0f);
+        return dx * dy + dy * dz + dz * dx;
+    }
+};
+
+//! SAHの分割候補
+struct Bin
+{
+    Bounds bounds_;      //!< 範囲
+    u32    count_ = 0;   //!< 物体数
+};
+
+//---------------------------------------------------------------------------
+//! 物体のAABBを取得
+//---------------------------------------------------------------------------
+void getBox(const AABBArray& boxes, u32 index, f32 box_min[3], f32 box_max[3])
+{
+    for(s32 axis = 0; axis < 3; ++axis) {
+        box_min[axis] = boxes.getMin(axis)[index];
+        box_max[axis] = boxes.getMax(axis)[index];
+    }
+}
+
+//---------------------------------------------------------------------------
+//! AABB同士が交差しているかどうか
+//---------------------------------------------------------------------------
+bool overlaps(const f32 a_min[3], const f32 a_max[3], const f32 b_min[3], const f32 b_max[3])
+{
+    return a_min[0] <= b_max[0] && b_min[0] <= a_max[0] && a_min[1] <= b_max[1] && b_min[1] <= a_max[1] &&
+           a_min[2] <= b_max[2] && b_min[2] <= a_max[2];
+}
+
+//---------------------------------------------------------------------------
+//! レイとAABBの交差判定 (スラブ法)
+//! @return 交差する最小距離 (交差しない場合はFLT_MAX)
+//---------------------------------------------------------------------------
+f32 intersectRay(const f32 origin[3], const f32 inv_direction[3], f32 max_distance, const f32 box_min[3], const f32 box_max[3])
+{
+    f32 t_min = 0.0f;
+    f32 t_max = max_distance;
+    for(s32 axis = 0; axis < 3; ++axis) {
+        f32 t0 = (box_min[axis] - origin[axis]) * inv_direction[axis];
+        f32 t1 = (box_max[axis] - origin[axis]) * inv_direction[axis];
+        // NaN(軸に平行で面上)の場合はstd::min/maxが既存の値を残す
+        t_min = std::max(t_min, std::min(t0, t1));
+        t_max = std::min(t_max, std::max(t0, t1));
+    }
+    return (t_min <= t_max) ? t_min : FLT_MAX;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 作成
+//---------------------------------------------------------------------------
+void BVH::build(const AABBArray& boxes)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    clear();
+
+    u32 count = static_cast<u32>(boxes.size());
+    if(count == 0) {
+        return;
+    }
+
+    indices_.resize(count);
+    for(u32 i = 0; i < count; ++i) {
+        indices_[i] = i;
+    }
+
+    // 物体n個の木はノード数が最大2n-1個。部分木ごとに上限分の領域を割り当てると
+    // 左右の部分木を別スレッドで作成できる (未使用のノードは後で詰める)
+    std::vector<Node> nodes(count * 2 - 1);
+
+    BuildTask root{this, &boxes, nodes.data(), 0, count, 0, 0};
+    if(count > PARALLEL_THRESHOLD && JOB_getThreadCount() > 1) {
+        Job* job = JOB_create(&buildJob, &root, sizeof(root));
+        JOB_run(job);
+        JOB_wait(job);
+    }
+    else {
+        buildNode(nullptr, root);
+    }
+
+    nodes_.reserve(count * 2 - 1);
+    compact(nodes.data(), 0, 1);
+    nodes_.shrink_to_fit();
+
+    // 物体のAABBを葉の順に並べて保持 (葉の判定で連続したメモリを読む)
+    objects_.resize(count);
+    for(u32 i = 0; i < count; ++i) {
+        getBox(boxes, indices_[i], objects_[i].min_, objects_[i].max_);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 並列作成のジョブ関数
+//---------------------------------------------------------------------------
+void BVH::buildJob(Job* job, const void* data)
+{
+    const auto& task = *static_cast<const BuildTask*>(data);
+    task.bvh_->buildNode(job, task);
+}
+
+//---------------------------------------------------------------------------
+//! 範囲内の物体でノードを作成
+//---------------------------------------------------------------------------
+void BVH::buildNode(Job* job, const BuildTask& task)
+{
+    const AABBArray& boxes = *task.boxes_;
+    u32*             first = &indices_[task.begin_];
+    u32              count = task.count_;
+
+    //---- 範囲と重心の範囲 (重心は2倍の値のまま扱う)
+    Bounds bounds;
+    Bounds centroid_bounds;
+    for(u32 i = 0; i < count; ++i) {
+        f32 box_min[3];
+        f32 box_max[3];
+        getBox(boxes, first[i], box_min, box_max);
+        bounds.grow(box_min, box_max);
+
+        f32 centroid[3]{box_min[0] + box_max[0], box_min[1] + box_max[1], box_min[2] + box_max[2]};
+        centroid_bounds.grow(centroid, centroid);
+    }
+
+    Node& node = task.nodes_[task.node_index_];
+    std::copy_n(bounds.min_, 3, node.min_);
+    std::copy_n(bounds.max_, 3, node.max_);
+
+    auto make_leaf = [&] {
+        node.first_ = task.begin_;
+        node.count_ = count;
+    };
+
+    // 探索スタックが溢れないよう、最大の深さでは物体数に関係なく葉にする
+    if(count == 1 || task.depth_ + 1 >= MAX_DEPTH) {
+        make_leaf();
+        return;
+    }
+
+    //---- SAHで分割位置を決める (各軸をBIN_COUNT個に区切って評価)
+    s32 best_axis  = -1;
+    s32 best_split = 0;
+    f32 best_cost  = FLT_MAX;
+    for(s32 axis = 0; axis < 3; ++axis) {
+        f32 extent = centroid_bounds.max_[axis] - centroid_bounds.min_[axis];
+        if(!(extent > 0.0f)) {
+            continue;
+        }
+        f32 scale = BIN_COUNT / extent;
+
+        Bin bins[BIN_COUNT];
+        for(u32 i = 0; i < count; ++i) {
+            f32 box_min[3];
+            f32 box_max[3];
+            getBox(boxes, first[i], box_min, box_max);
+
+            s32 bin = static_cast<s32>((box_min[axis] + box_max[axis] - centroid_bounds.min_[axis]) * scale);
+            bin     = std::min(bin, BIN_COUNT - 1);
+            bins[bin].bounds_.grow(box_min, box_max);
+            bins[bin].count_++;
+        }
+
+        // 右側から累積した面積と物体数
+        f32    right_area[BIN_COUNT];
+        u32    right_count[BIN_COUNT];
+        Bounds right;
+        u32    right_total = 0;
+        for(s32 i = BIN_COUNT - 1; i > 0; --i) {
+            right.grow(bins[i].bounds_.min_, bins[i].bounds_.max_);
+            right_total += bins[i].count_;
+            right_area[i]  = right.area();
+            right_count[i] = right_total;
+        }
+
+        // 左側から累積しながら分割位置 i (bin < i が左) を評価
+        Bounds left;
+        u32    left_total = 0;
+        for(s32 i = 1; i < BIN_COUNT; ++i) {
+            left.grow(bins[i - 1].bounds_.min_, bins[i - 1].bounds_.max_);
+            left_total += bins[i - 1].count_;
+            if(left_total == 0 || right_count[i] == 0) {
+                continue;
+            }
+
+            f32 cost = left.area() * left_total + right_area[i] * right_count[i];
+            if(cost < best_cost) {
+                best_cost  = cost;
+                best_axis  = axis;
+                best_split = i;
+            }
+        }
+    }
+
+    //---- 分割するより葉にした方が安ければ葉にする
+    f32 leaf_cost = static_cast<f32>(count);
+    if(best_axis >= 0) {
+        f32 area       = bounds.area();
+        f32 split_cost = (area > 0.0f) ? TRAVERSAL_COST + best_cost / area : FLT_MAX;
+        if(count <= MAX_LEAF_SIZE && leaf_cost <= split_cost) {
+            make_leaf();
+            return;
+        }
+    }
+    else if(count <= MAX_LEAF_SIZE) {
+        make_leaf();   // 重心が全て同じ位置
+        return;
+    }
+
+    //---- 物体を左右に振り分け
+    u32 left_count = 0;
+    if(best_axis >= 0) {
+        f32  scale  = BIN_COUNT / (centroid_bounds.max_[best_axis] - centroid_bounds.min_[best_axis]);
+        u32* middle = std::partition(first, first + count, [&](u32 index) {
+            f32 c   = boxes.getMin(best_axis)[index] + boxes.getMax(best_axis)[index];
+            s32 bin = std::min(static_cast<s32>((c - centroid_bounds.min_[best_axis]) * scale), BIN_COUNT - 1);
+            return bin < best_split;
+        });
+
+        left_count = static_cast<u32>(middle - first);
+    }
+    if(left_count == 0 || left_count == count) {
+        left_count = count / 2;   // 分割できない場合は個数で半分にする
+    }
+
+    //---- 子ノード (左の部分木は最大 2*left_count-1 個のノードを使用)
+    BuildTask left_task{task.bvh_, task.boxes_, task.nodes_, task.begin_, left_count, task.node_index_ + 1, task.depth_ + 1};
+    BuildTask right_task{task.bvh_,
+                         task.boxes_,
+                         task.nodes_,
+                         task.begin_ + left_count,
+                         count - left_count,
+                         task.node_index_ + left_count * 2,
+                         task.depth_ + 1};
+
+    node.first_ = right_task.node_index_;
+    node.count_ = 0;
+
+    if(job && count > PARALLEL_THRESHOLD) {
+        // 親ジョブは子ジョブが全て完了するまで完了しない
+        JOB_run(JOB_create(&buildJob, &left_task, sizeof(left_task), job));
+        JOB_run(JOB_create(&buildJob, &right_task, sizeof(right_task), job));
+    }
+    else {
+        buildNode(job, left_task);
+        buildNode(job, right_task);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 作業用ノード配列から使用したノードだけを深さ優先順に詰める
+//---------------------------------------------------------------------------
+u32 BVH::compact(const Node* nodes, u32 index, s32 depth)
+{
+    const Node& node      = nodes[index];
+    u32         new_index = static_cast<u32>(nodes_.size());
+    nodes_.push_back(node);
+    depth_ = std::max(depth_, depth);
+
+    if(!node.isLeaf()) {
+        compact(nodes, index + 1, depth + 1);   // 左の子は直後に並ぶ
+        u32 right                = compact(nodes, node.first_, depth + 1);
+        nodes_[new_index].first_ = right;
+    }
+    return new_index;
+}
+
+//---------------------------------------------------------------------------
+//! 範囲を更新
+//---------------------------------------------------------------------------
+void BVH::refit(const AABBArray& boxes)
+{
+    for(size_t i = 0; i < objects_.size(); ++i) {
+        getBox(boxes, indices_[i], objects_[i].min_, objects_[i].max_);
+    }
+
+    // 子は必ず親より後ろにあるため、後ろから更新すれば子が先に確定する
+    for(size_t i = nodes_.size(); i-- > 0;) {
+        Node&  node = nodes_[i];
+        Bounds bounds;
+
+        if(node.isLeaf()) {
+            for(u32 k = node.first_; k < node.first_ + node.count_; ++k) {
+                bounds.grow(objects_[k].min_, objects_[k].max_);
+            }
+        }
+        else {
+            const Node& left  = nodes_[i + 1];
+            const Node& right = nodes_[node.first_];
+            bounds.grow(left.min_, left.max_);
+            bounds.grow(right.min_, right.max_);
+        }
+
+        std::copy_n(bounds.min_, 3, node.min_);
+        std::copy_n(bounds.max_, 3, node.max_);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void BVH::clear()
+{
+    nodes_.clear();
+    indices_.clear();
+    objects_.clear();
+    depth_ = 0;
+}
+
+//---------------------------------------------------------------------------
+//! 視錐台と交差する物体を取得
+//---------------------------------------------------------------------------
+void BVH::queryFrustum(const Frustum& frustum, std::vector<u32>& result) const
+{
+    if(nodes_.empty()) {
+        return;
+    }
+
+    u32 stack[MAX_DEPTH + 1];
+    s32 stack_size      = 0;
+    stack[stack_size++] = 0;
+
+    while(stack_size > 0) {
+        const Node& node = nodes_[stack[--stack_size]];
+
+        Frustum::Overlap overlap = frustum.classifyAABB(node.min_, node.max_);
+        if(overlap == Frustum::Overlap::Outside) {
+            continue;
+        }
+
+        if(overlap == Frustum::Overlap::Inside) {
+            // 完全に内側なら部分木の物体は全て見えている (部分木の物体はindices_上で連続)
+            const Node* last = &node;
+            while(!last->isLeaf()) {
+                last = &nodes_[last->first_];   // 右端の葉
+            }
+            const Node* first = &node;
+            while(!first->isLeaf()) {
+                first = first + 1;   // 左端の葉
+            }
+            result.insert(result.end(), &indices_[first->first_], &indices_[last->first_] + last->count_);
+            continue;
+        }
+
+        if(node.isLeaf()) {
+            for(u32 k = node.first_; k < node.first_ + node.count_; ++k) {
+                if(frustum.classifyAABB(objects_[k].min_, objects_[k].max_) != Frustum::Overlap::Outside) {
+                    result.push_back(indices_[k]);
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.first_;
+        stack[stack_size++] = static_cast<u32>(&node - nodes_.data()) + 1;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! AABBと交差する物体を取得
+//---------------------------------------------------------------------------
+void BVH::queryAABB(const AABB& box, std::vector<u32>& result) const
+{
+    if(nodes_.empty()) {
+        return;
+    }
+
+    f32 box_min[3]{box.min_.x, box.min_.y, box.min_.z};
+    f32 box_max[3]{box.max_.x, box.max_.y, box.max_.z};
+
+    u32 stack[MAX_DEPTH + 1];
+    s32 stack_size      = 0;
+    stack[stack_size++] = 0;
+
+    while(stack_size > 0) {
+        u32         index = stack[--stack_size];
+        const Node& node  = nodes_[index];
+        if(!overlaps(node.min_, node.max_, box_min, box_max)) {
+            continue;
+        }
+
+        if(node.isLeaf()) {
+            for(u32 k = node.first_; k < node.first_ + node.count_; ++k) {
+                if(overlaps(objects_[k].min_, objects_[k].max_, box_min, box_max)) {
+                    result.push_back(indices_[k]);
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.first_;
+        stack[stack_size++] = index + 1;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! レイと最初に交差する物体を取得
+//---------------------------------------------------------------------------
+bool BVH::raycast(const float3& origin, const float3& direction, f32 max_distance, RayHit& hit) const
+{
+    hit = RayHit();
+    if(nodes_.empty()) {
+        return false;
+    }
+
+    f32 o[3]{origin.x, origin.y, origin.z};
+    f32 d[3]{direction.x, direction.y, direction.z};
+    f32 inv_d[3]{1.0f / d[0], 1.0f / d[1], 1.0f / d[2]};   // 0の場合は±無限大
+
+    f32 nearest = max_distance;
+
+    u32 stack[MAX_DEPTH + 1];
+    s32 stack_size      = 0;
+    stack[stack_size++] = 0;
+
+    while(stack_size > 0) {
+        u32         index = stack[--stack_size];
+        const Node& node  = nodes_[index];
+        if(intersectRay(o, inv_d, nearest, node.min_, node.max_) == FLT_MAX) {
+            continue;
+        }
+
+        if(node.isLeaf()) {
+            for(u32 k = 0; k < node.count_; ++k) {
+                const ObjectBox& object = objects_[node.first_ + k];
+
+                f32 t = intersectRay(o, inv_d, nearest, object.min_, object.max_);
+                if(t != FLT_MAX && (t < nearest || !hit.isValid())) {
+                    nearest       = t;
+                    hit.index_    = indices_[node.first_ + k];
+                    hit.distance_ = t;
+                }
+            }
+            continue;
+        }
+
+        // 近い方の子を先に調べる (後から積んだ方が先に取り出される)
+        u32 left    = index + 1;
+        u32 right   = node.first_;
+        f32 t_left  = intersectRay(o, inv_d, nearest, nodes_[left].min_, nodes_[left].max_);
+        f32 t_right = intersectRay(o, inv_d, nearest, nodes_[right].min_, nodes_[right].max_);
+        if(t_left <= t_right) {
+            if(t_right != FLT_MAX) {
+                stack[stack_size++] = right;
+            }
+            if(t_left != FLT_MAX) {
+                stack[stack_size++] = left;
+            }
+        }
+        else {
+            if(t_left != FLT_MAX) {
+                stack[stack_size++] = left;
+            }
+            stack[stack_size++] = right;
+        }
+    }
+    return hit.isValid();
+}
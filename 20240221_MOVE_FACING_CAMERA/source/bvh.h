@@ -0,0 +1,146 @@
+﻿//===========================================================================
+//!	@file	bvh.h
+//!	@brief	BVH (境界ボリューム階層)
+//!
+//!	物体のAABBをSAH(表面積ヒューリスティック)で分割した二分木にまとめ、
+//!	視錐台・レイ・AABBとの交差判定を O(log n) 程度で行います。
+//!	ノードは1個32バイトで深さ優先順に並べ、左の子は必ず親の直後に置きます。
+//!	物体が動いた場合は refit() で木の形を保ったまま範囲だけ更新できます。
+//!
+//! @code
+//!     BVH bvh;
+//!     bvh.build(boxes);                             // boxes: AABBArray
+//!     bvh.queryFrustum(camera.getFrustum(), visible);
+//!     ...
+//!     bvh.refit(boxes);                             // 物体が移動した後
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! レイとの交差結果
+struct RayHit
+{
+    u32 index_    = 0xfffffffful;   //!< 物体番号
+    f32 distance_ = FLT_MAX;        //!< 交差位置までの距離 (方向ベクトルの長さ単位)
+
+    //! 交差しているかどうか
+    bool isValid() const { return index_ != 0xfffffffful; }
+};
+
+//===========================================================================
+//! BVH
+//===========================================================================
+class BVH
+{
+public:
+    static constexpr s32 MAX_LEAF_SIZE = 4;    //!< 葉ノードの最大物体数 (分割できない場合は超える)
+    static constexpr s32 MAX_DEPTH     = 48;   //!< 木の最大の深さ (探索スタックの大きさ)
+
+    //! ノード (32バイト)
+    struct alignas(32) Node
+    {
+        f32 min_[3];   //!< 範囲の最小座標
+        u32 first_;    //!< 葉: indices_内の先頭位置 節: 右の子のノード番号 (左の子は直後)
+        f32 max_[3];   //!< 範囲の最大座標
+        u32 count_;    //!< 葉: 物体数 節: 0
+
+        //! 葉ノードかどうか
+        bool isLeaf() const { return count_ != 0; }
+    };
+
+    //! コンストラクタ
+    BVH() = default;
+
+    //! 作成 (JOB_setup()済みなら上位の分割を並列に実行)
+    //! @param  [in]    boxes   物体のAABB
+    void build(const AABBArray& boxes);
+
+    //! 範囲を更新 (木の形は変えない)
+    //! @param  [in]    boxes   物体のAABB (build()時と同じ数・同じ並び)
+    //! @note 物体が大きく移動すると判定効率が落ちるため、その場合は作り直してください
+    void refit(const AABBArray& boxes);
+
+    //! 解放
+    void clear();
+
+    //----------------------------------------------------------
+    //! @name 判定
+    //----------------------------------------------------------
+    //!@{
+
+    //! 視錐台と交差する物体を取得
+    //! @param  [in]    frustum 視錐台
+    //! @param  [out]   result  物体番号 (末尾に追加)
+    void queryFrustum(const Frustum& frustum, std::vector<u32>& result) const;
+
+    //! AABBと交差する物体を取得
+    //! @param  [in]    box     AABB
+    //! @param  [out]   result  物体番号 (末尾に追加)
+    void queryAABB(const AABB& box, std::vector<u32>& result) const;
+
+    //! レイと最初に交差する物体を取得
+    //! @param  [in]    origin          始点
+    //! @param  [in]    direction       方向 (正規化不要)
+    //! @param  [in]    max_distance    最大距離 (direction何個分か)
+    //! @param  [out]   hit             交差結果
+    //!	@retval	true	交差あり
+    //!	@retval	false	交差なし
+    bool raycast(const float3& origin, const float3& direction, f32 max_distance, RayHit& hit) const;
+
+    //!@}
+    //----------------------------------------------------------
+    //! @name 参照
+    //----------------------------------------------------------
+    //!@{
+
+    //! ノード数を取得
+    s32 getNodeCount() const { return static_cast<s32>(nodes_.size()); }
+
+    //! 物体数を取得
+    s32 getObjectCount() const { return static_cast<s32>(indices_.size()); }
+
+    //! 木の深さを取得
+    s32 getDepth() const { return depth_; }
+
+    //! ノードを取得
+    const Node* getNodes() const { return nodes_.data(); }
+
+    //!@}
+
+private:
+    //! 並列作成のジョブ
+    struct BuildTask
+    {
+        BVH*             bvh_;          //!< 作成中のBVH
+        const AABBArray* boxes_;        //!< 物体のAABB
+        Node*            nodes_;        //!< 作業用ノード配列
+        u32              begin_;        //!< indices_内の先頭位置
+        u32              count_;        //!< 物体数
+        u32              node_index_;   //!< 書き込むノード番号
+        s32              depth_;        //!< 深さ
+    };
+
+    //! 並列作成のジョブ関数
+    static void buildJob(Job* job, const void* data);
+
+    //! 範囲内の物体でノードを作成
+    //! @param  [in]    job     実行中のジョブ (nullptrの場合は並列化しない)
+    void buildNode(Job* job, const BuildTask& task);
+
+    //! 作業用ノード配列から使用したノードだけを深さ優先順に詰める
+    //! @return 詰めた後のノード番号
+    u32 compact(const Node* nodes, u32 index, s32 depth);
+
+    //! 物体のAABB
+    struct ObjectBox
+    {
+        f32 min_[3];   //!< 最小座標
+        f32 max_[3];   //!< 最大座標
+    };
+
+private:
+    std::vector<Node>      nodes_;      //!< ノード (nodes_[0]が根)
+    std::vector<u32>       indices_;    //!< 葉ノードが参照する物体番号
+    std::vector<ObjectBox> objects_;    //!< 物体のAABB (indices_と同じ並び)
+    s32                    depth_ = 0;  //!< 木の深さ
+};
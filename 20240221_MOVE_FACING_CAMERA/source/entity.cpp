@@ -0,0 +1,538 @@
+﻿//===========================================================================
+//!	@file	entity.cpp
+//!	@brief	エンティティ (SoAの成分配列)
+//===========================================================================
+#include <emmintrin.h>   // SSE2
+
+namespace
+{
+constexpr u32 HANDLE_INDEX_BITS      = 20;                                     //!< ハンドルのスロット番号のビット数
+constexpr u32 HANDLE_INDEX_MASK      = (1u << HANDLE_INDEX_BITS) - 1;          //!< スロット番号のマスク
+constexpr u32 HANDLE_GENERATION_MASK = (1u << (32 - HANDLE_INDEX_BITS)) - 1;   //!< 世代のマスク
+constexpr u32 INVALID_INDEX          = 0xfffffffful;                           //!< 未使用のスロット
+
+constexpr s32 BLOCK_GRAIN = 1024;   //!< 1ジョブが処理する4個単位のブロック数
+
+constexpr f32 FALLBACK_AXIS_X[3]{1.0f, 0.0f, 0.0f};   //!< 向きが真上・真下の場合のX軸
+constexpr f32 FALLBACK_AXIS_Y[3]{0.0f, 1.0f, 0.0f};   //!< 向きが(0,0,0)の場合のY軸
+
+static_assert(EntityStore::MAX_ENTITY_COUNT == HANDLE_INDEX_MASK + 1);
+
+//---------------------------------------------------------------------------
+//! 4個単位のブロックに分けて並列に処理
+//! @param  [in]    function    処理関数 function(begin, end) (begin, endは4の倍数)
+//---------------------------------------------------------------------------
+template<typename F>
+void forEachBlock(const EntityStore& store, const F& function)
+{
+    s32 block_count = (store.size() + 3) / 4;
+    JOB_parallelFor(block_count, BLOCK_GRAIN, [&](s32 begin, s32 end) { function(begin * 4, end * 4); });
+}
+
+//---------------------------------------------------------------------------
+//! マスクが立っているレーンはa、それ以外はbを選択
+//---------------------------------------------------------------------------
+__m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//---------------------------------------------------------------------------
+//! 長さの逆数 (0の場合は無限大)
+//---------------------------------------------------------------------------
+__m128 reciprocalLength(__m128 x, __m128 y, __m128 z)
+{
+    // 近似命令(rsqrt)だとスカラーのnormalize()と結果がずれるため除算で求める
+    __m128 length_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_sq));
+}
+
+//---------------------------------------------------------------------------
+//! 正規化 (長さが0に近いレーンは指定した軸にする)
+//! @param  [in,out]    v           ベクトル ×4 (成分ごと)
+//! @param  [in]        fallback    長さが0に近い場合の軸 (正規化済)
+//---------------------------------------------------------------------------
+void normalizeOr(__m128 (&v)[3], const f32 (&fallback)[3])
+{
+    __m128 length_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v[0], v[0]), _mm_mul_ps(v[1], v[1])), _mm_mul_ps(v[2], v[2]));
+    __m128 valid     = _mm_cmpgt_ps(length_sq, _mm_set1_ps(FLT_EPSILON));
+    __m128 inv       = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_sq));   // 無効なレーンは無限大になるが選択しない
+
+    for(s32 axis = 0; axis < 3; ++axis) {
+        v[axis] = select(valid, _mm_mul_ps(v[axis], inv), _mm_set1_ps(fallback[axis]));
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 正規化 (長さが0に近い場合は指定した軸にする)
+//---------------------------------------------------------------------------
+float3 normalizeOr(const float3& v, const f32 (&fallback)[3])
+{
+    if(static_cast<f32>(dot(v, v)) > FLT_EPSILON) {
+        return normalize(v);
+    }
+    return float3(fallback[0], fallback[1], fallback[2]);
+}
+
+//---------------------------------------------------------------------------
+//! acosの近似 (floatで計算した場合の実測の最大誤差 5e-7 ラジアン程度)
+//! 多項式自体の誤差は2e-8だが、float演算の丸め誤差の方が大きい
+//! @see Abramowitz & Stegun 4.4.46
+//---------------------------------------------------------------------------
+__m128 acosApprox(__m128 x)
+{
+    // acos(x) = sqrt(1 - |x|) * P(|x|)、負の場合は π - acos(-x)
+    __m128 sign = _mm_cmplt_ps(x, _mm_setzero_ps());
+    __m128 a    = _mm_min_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), _mm_set1_ps(1.0f));
+
+    __m128 p = _mm_set1_ps(-0.0012624911f);
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0066700901f));
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.0170881256f));
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0308918810f));
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.0501743046f));
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0889789874f));
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.2145988016f));
+    p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(1.5707963050f));
+
+    __m128 result = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), a)), p);
+    return select(sign, _mm_sub_ps(_mm_set1_ps(std::numbers::pi_v<f32>), result), result);
+}
+
+//---------------------------------------------------------------------------
+//! sinとcosの近似 (0～πの範囲、最大誤差 1e-7 程度)
+//---------------------------------------------------------------------------
+void sinCosApprox(__m128 x, __m128& out_sin, __m128& out_cos)
+{
+    // u = x - π/2 (-π/2～+π/2) にずらすと sin(x) = cos(u)、cos(x) = -sin(u)
+    __m128 u  = _mm_sub_ps(x, _mm_set1_ps(std::numbers::pi_v<f32> * 0.5f));
+    __m128 u2 = _mm_mul_ps(u, u);
+
+    // テイラー展開 (sinは11次、cosは10次まで)
+    __m128 s = _mm_set1_ps(-1.0f / 39916800.0f);
+    s        = _mm_add_ps(_mm_mul_ps(s, u2), _mm_set1_ps(1.0f / 362880.0f));
+    s        = _mm_add_ps(_mm_mul_ps(s, u2), _mm_set1_ps(-1.0f / 5040.0f));
+    s        = _mm_add_ps(_mm_mul_ps(s, u2), _mm_set1_ps(1.0f / 120.0f));
+    s        = _mm_add_ps(_mm_mul_ps(s, u2), _mm_set1_ps(-1.0f / 6.0f));
+    s        = _mm_add_ps(_mm_mul_ps(s, u2), _mm_set1_ps(1.0f));
+    s        = _mm_mul_ps(s, u);
+
+    __m128 c = _mm_set1_ps(-1.0f / 3628800.0f);
+    c        = _mm_add_ps(_mm_mul_ps(c, u2), _mm_set1_ps(1.0f / 40320.0f));
+    c        = _mm_add_ps(_mm_mul_ps(c, u2), _mm_set1_ps(-1.0f / 720.0f));
+    c        = _mm_add_ps(_mm_mul_ps(c, u2), _mm_set1_ps(1.0f / 24.0f));
+    c        = _mm_add_ps(_mm_mul_ps(c, u2), _mm_set1_ps(-1.0f / 2.0f));
+    c        = _mm_add_ps(_mm_mul_ps(c, u2), _mm_set1_ps(1.0f));
+
+    out_sin = c;
+    out_cos = _mm_sub_ps(_mm_setzero_ps(), s);
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 作成
+//---------------------------------------------------------------------------
+EntityHandle EntityStore::create(const float3& position, const float3& facing)
+{
+    MEMORY_TAG(MemoryTag::Math);
+
+    if(count_ >= MAX_ENTITY_COUNT) {
+        return EntityHandle{};
+    }
+
+    //---- スロットを割り当て (解放済みのスロットを優先して再利用)
+    u32 slot;
+    if(!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    else {
+        slot = static_cast<u32>(generations_.size());
+        generations_.push_back(1);
+        slot_to_dense_.push_back(INVALID_INDEX);
+    }
+
+    //---- 末尾に追加
+    s32 index = count_;
+    resize(count_ + 1);
+
+    dense_to_slot_.push_back(slot);
+    slot_to_dense_[slot] = index;
+
+    set(COLUMN_POSITION, index, position);
+    set(COLUMN_VELOCITY, index, float3(0.0f, 0.0f, 0.0f));
+    set(COLUMN_MOVE, index, float3(0.0f, 0.0f, 0.0f));
+    set(COLUMN_FACING, index, facing);
+    set(COLUMN_APPEARANCE, index, facing);
+    set(COLUMN_PREV_POSITION, index, position);
+    set(COLUMN_PREV_APPEARANCE, index, facing);
+    transforms_[index] = ENTITY_makeTransform(facing, position);
+
+    return EntityHandle{(generations_[slot] << HANDLE_INDEX_BITS) | slot};
+}
+
+//---------------------------------------------------------------------------
+//! 削除
+//---------------------------------------------------------------------------
+void EntityStore::destroy(EntityHandle handle)
+{
+    MEMORY_TAG(MemoryTag::Math);
+
+    s32 index = getIndex(handle);
+    if(index < 0) {
+        return;
+    }
+
+    //---- 末尾の要素を空いた位置に移動して詰める
+    s32 last = count_ - 1;
+    for(auto& column : columns_) {
+        for(auto& values : column) {
+            values[index] = values[last];
+        }
+    }
+    transforms_[index] = transforms_[last];
+
+    u32 last_slot             = dense_to_slot_[last];
+    dense_to_slot_[index]     = last_slot;
+    slot_to_dense_[last_slot] = index;
+    dense_to_slot_.pop_back();
+
+    //---- スロットを解放 (世代を進めて古いハンドルを無効にする)
+    u32 slot             = handle.value_ & HANDLE_INDEX_MASK;
+    slot_to_dense_[slot] = INVALID_INDEX;
+
+    u32& generation = generations_[slot];
+    generation      = (generation + 1) & HANDLE_GENERATION_MASK;
+    if(generation == 0) {
+        generation = 1;
+    }
+    free_slots_.push_back(slot);
+
+    resize(last);
+}
+
+//---------------------------------------------------------------------------
+//! 全て削除
+//---------------------------------------------------------------------------
+void EntityStore::clear()
+{
+    MEMORY_TAG(MemoryTag::Math);
+
+    // 発行済みのハンドルを無効にするため世代は残す
+    for(u32 slot : dense_to_slot_) {
+        slot_to_dense_[slot] = INVALID_INDEX;
+
+        u32& generation = generations_[slot];
+        generation      = (generation + 1) & HANDLE_GENERATION_MASK;
+        if(generation == 0) {
+            generation = 1;
+        }
+        free_slots_.push_back(slot);
+    }
+    dense_to_slot_.clear();
+    resize(0);
+}
+
+//---------------------------------------------------------------------------
+//! 配列上の番号を取得
+//---------------------------------------------------------------------------
+s32 EntityStore::getIndex(EntityHandle handle) const
+{
+    u32 slot       = handle.value_ & HANDLE_INDEX_MASK;
+    u32 generation = handle.value_ >> HANDLE_INDEX_BITS;
+
+    if(slot >= generations_.size() || generations_[slot] != generation) {
+        return -1;
+    }
+    u32 index = slot_to_dense_[slot];
+    return (index == INVALID_INDEX) ? -1 : static_cast<s32>(index);
+}
+
+//---------------------------------------------------------------------------
+//! 配列上の番号からハンドルを取得
+//---------------------------------------------------------------------------
+EntityHandle EntityStore::getHandle(s32 index) const
+{
+    u32 slot = dense_to_slot_[index];
+    return EntityHandle{(generations_[slot] << HANDLE_INDEX_BITS) | slot};
+}
+
+//---------------------------------------------------------------------------
+//! 配列の大きさを変更
+//---------------------------------------------------------------------------
+void EntityStore::resize(s32 count)
+{
+    s32 old_count = count_;
+    count_        = count;
+
+    // 末尾の余りは常に0にしておく (SIMDで余りのレーンも計算するため)
+    size_t capacity = (count + 3) & ~3;
+    for(auto& column : columns_) {
+        for(auto& values : column) {
+            values.resize(capacity, 0.0f);
+            std::fill(values.begin() + std::min(count, old_count), values.end(), 0.0f);
+        }
+    }
+    transforms_.resize(capacity, matrix::identity());
+}
+
+//===========================================================================
+// システム
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! 現在の位置と見た目の方向を前回の値として保存
+//---------------------------------------------------------------------------
+void ENTITY_savePrevious(EntityStore& store)
+{
+    s32 count = store.size();
+    for(s32 axis = 0; axis < 3; ++axis) {
+        std::copy_n(store.getColumn(EntityStore::COLUMN_POSITION, axis),
+                    count,
+                    store.getColumn(EntityStore::COLUMN_PREV_POSITION, axis));
+        std::copy_n(store.getColumn(EntityStore::COLUMN_APPEARANCE, axis),
+                    count,
+                    store.getColumn(EntityStore::COLUMN_PREV_APPEARANCE, axis));
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 移動入力の方向に向きを変えて移動
+//---------------------------------------------------------------------------
+void ENTITY_updateMovement(EntityStore& store, f32 speed, f32 delta_time)
+{
+    f32* move[3];
+    f32* facing[3];
+    f32* position[3];
+    for(s32 axis = 0; axis < 3; ++axis) {
+        move[axis]     = store.getColumn(EntityStore::COLUMN_MOVE, axis);
+        facing[axis]   = store.getColumn(EntityStore::COLUMN_FACING, axis);
+        position[axis] = store.getColumn(EntityStore::COLUMN_POSITION, axis);
+    }
+
+    const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+    const __m128 step    = _mm_set1_ps(speed * delta_time);
+
+    forEachBlock(store, [&](s32 begin, s32 end) {
+        for(s32 i = begin; i < end; i += 4) {
+            __m128 x = _mm_loadu_ps(move[0] + i);
+            __m128 y = _mm_loadu_ps(move[1] + i);
+            __m128 z = _mm_loadu_ps(move[2] + i);
+
+            // 移動入力がある場合のみ、その方向を向いて移動する
+            __m128 length_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+            __m128 moving    = _mm_cmpgt_ps(length_sq, epsilon);
+            __m128 inv       = reciprocalLength(x, y, z);
+
+            __m128 dir[3]{_mm_mul_ps(x, inv), _mm_mul_ps(y, inv), _mm_mul_ps(z, inv)};
+            for(s32 axis = 0; axis < 3; ++axis) {
+                __m128 f = select(moving, dir[axis], _mm_loadu_ps(facing[axis] + i));
+                __m128 p = _mm_add_ps(_mm_loadu_ps(position[axis] + i), _mm_and_ps(moving, _mm_mul_ps(dir[axis], step)));
+                _mm_storeu_ps(facing[axis] + i, f);
+                _mm_storeu_ps(position[axis] + i, p);
+            }
+        }
+    });
+}
+
+//---------------------------------------------------------------------------
+//! 重力で落下
+//---------------------------------------------------------------------------
+void ENTITY_updateGravity(EntityStore& store, f32 gravity, f32 delta_time)
+{
+    f32* velocity[3];
+    f32* position[3];
+    for(s32 axis = 0; axis < 3; ++axis) {
+        velocity[axis] = store.getColumn(EntityStore::COLUMN_VELOCITY, axis);
+        position[axis] = store.getColumn(EntityStore::COLUMN_POSITION, axis);
+    }
+
+    const __m128 dt   = _mm_set1_ps(delta_time);
+    const __m128 fall = _mm_set1_ps(gravity * delta_time);
+
+    forEachBlock(store, [&](s32 begin, s32 end) {
+        for(s32 i = begin; i < end; i += 4) {
+            // 速度を加速してから移動
+            __m128 v[3];
+            __m128 p[3];
+            for(s32 axis = 0; axis < 3; ++axis) {
+                v[axis] = _mm_loadu_ps(velocity[axis] + i);
+            }
+            v[1] = _mm_sub_ps(v[1], fall);
+            for(s32 axis = 0; axis < 3; ++axis) {
+                p[axis] = _mm_add_ps(_mm_loadu_ps(position[axis] + i), _mm_mul_ps(v[axis], dt));
+            }
+
+            // 地面より下に行ったら地面で止める
+            __m128 below = _mm_cmplt_ps(p[1], _mm_setzero_ps());
+            p[1]         = _mm_andnot_ps(below, p[1]);
+            v[1]         = _mm_andnot_ps(below, v[1]);
+
+            for(s32 axis = 0; axis < 3; ++axis) {
+                _mm_storeu_ps(velocity[axis] + i, v[axis]);
+                _mm_storeu_ps(position[axis] + i, p[axis]);
+            }
+        }
+    });
+}
+
+//---------------------------------------------------------------------------
+//! 見た目の方向を向いている方向に追従させる
+//---------------------------------------------------------------------------
+void ENTITY_updateFacing(EntityStore& store, f32 turn_rate, f32 delta_time)
+{
+    PROFILE_FUNCTION();
+
+    // 経過時間に合わせて追従率を補正 (60fpsでturn_rate倍)
+    f32 rate = 1.0f - std::pow(1.0f - turn_rate, delta_time * 60.0f);
+
+    f32* appearance[3];
+    f32* facing[3];
+    for(s32 axis = 0; axis < 3; ++axis) {
+        appearance[axis] = store.getColumn(EntityStore::COLUMN_APPEARANCE, axis);
+        facing[axis]     = store.getColumn(EntityStore::COLUMN_FACING, axis);
+    }
+
+    forEachBlock(store, [&](s32 begin, s32 end) {
+        f32* block_appearance[3]{appearance[0] + begin, appearance[1] + begin, appearance[2] + begin};
+        f32* block_facing[3]{facing[0] + begin, facing[1] + begin, facing[2] + begin};
+        ENTITY_turnTowards(block_appearance, block_facing, end - begin, rate);
+    });
+}
+
+//---------------------------------------------------------------------------
+//! 見た目の方向を目標の方向に近づける
+//---------------------------------------------------------------------------
+void ENTITY_turnTowards(f32* const appearance[3], f32* const target[3], s32 count, f32 rate)
+{
+    const __m128 zero    = _mm_setzero_ps();
+    const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+    const __m128 t       = _mm_set1_ps(rate);
+
+    for(s32 i = 0; i < count; i += 4) {
+        __m128 a[3];
+        __m128 d[3];
+        for(s32 axis = 0; axis < 3; ++axis) {
+            a[axis] = _mm_loadu_ps(appearance[axis] + i);
+            d[axis] = _mm_loadu_ps(target[axis] + i);
+        }
+
+        // 長さ0のレーン (余りの要素など) は変更しない
+        __m128 inv_a = reciprocalLength(a[0], a[1], a[2]);
+        __m128 inv_d = reciprocalLength(d[0], d[1], d[2]);
+        __m128 valid = _mm_and_ps(_mm_cmplt_ps(inv_a, _mm_set1_ps(FLT_MAX)), _mm_cmplt_ps(inv_d, _mm_set1_ps(FLT_MAX)));
+
+        // 長さを1.0にすることで計算を簡略化
+        for(s32 axis = 0; axis < 3; ++axis) {
+            a[axis] = _mm_mul_ps(a[axis], inv_a);
+            d[axis] = _mm_mul_ps(d[axis], inv_d);
+        }
+
+        //---- 両者のベクトルのなす角 θ と、回転させる角度 φ = θ × rate
+        __m128 cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], d[0]), _mm_mul_ps(a[1], d[1])), _mm_mul_ps(a[2], d[2]));
+        __m128 phi    = _mm_mul_ps(acosApprox(cosine), t);
+        __m128 sin_phi;
+        __m128 cos_phi;
+        sinCosApprox(phi, sin_phi, cos_phi);
+
+        //---- 回転軸 n = normalize(a × d) の場合、回転後は a cosφ + (n × a) sinφ
+        // n × a = (d - a cosθ) / sinθ なので角度を使わずに求められる
+        __m128 c[3]{_mm_sub_ps(_mm_mul_ps(a[1], d[2]), _mm_mul_ps(a[2], d[1])),
+                    _mm_sub_ps(_mm_mul_ps(a[2], d[0]), _mm_mul_ps(a[0], d[2])),
+                    _mm_sub_ps(_mm_mul_ps(a[0], d[1]), _mm_mul_ps(a[1], d[0]))};
+        __m128 c_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], c[0]), _mm_mul_ps(c[1], c[1])), _mm_mul_ps(c[2], c[2]));
+
+        __m128 b[3];
+        for(s32 axis = 0; axis < 3; ++axis) {
+            b[axis] = _mm_sub_ps(d[axis], _mm_mul_ps(a[axis], cosine));
+        }
+        __m128 inv_b = reciprocalLength(b[0], b[1], b[2]);
+
+        //---- 同じ方向・真逆の方向 (外積の長さが0) の場合はY軸中心に回転
+        // n = (0, 1, 0) のとき n × a = (a.z, 0, -a.x)、軸方向の成分 a.y は回転で変わらない
+        __m128 parallel = _mm_cmple_ps(c_sq, epsilon);
+
+        __m128 result[3];
+        for(s32 axis = 0; axis < 3; ++axis) {
+            __m128 n_cross_a = _mm_mul_ps(b[axis], inv_b);
+            __m128 rotated   = _mm_add_ps(_mm_mul_ps(a[axis], cos_phi), _mm_mul_ps(n_cross_a, sin_phi));
+
+            __m128 y_cross_a = (axis == 0) ? a[2] : (axis == 1) ? zero : _mm_sub_ps(zero, a[0]);
+            __m128 y_rotated = (axis == 1) ? a[1] : _mm_add_ps(_mm_mul_ps(a[axis], cos_phi), _mm_mul_ps(y_cross_a, sin_phi));
+
+            result[axis] = select(parallel, y_rotated, rotated);
+        }
+
+        for(s32 axis = 0; axis < 3; ++axis) {
+            _mm_storeu_ps(target[axis] + i, select(valid, d[axis], _mm_loadu_ps(target[axis] + i)));
+            _mm_storeu_ps(appearance[axis] + i, select(valid, result[axis], _mm_loadu_ps(appearance[axis] + i)));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 見た目の方向と位置からワールド行列を作成
+//---------------------------------------------------------------------------
+void ENTITY_updateTransforms(EntityStore& store)
+{
+    const f32* appearance[3];
+    const f32* position[3];
+    for(s32 axis = 0; axis < 3; ++axis) {
+        appearance[axis] = store.getColumn(EntityStore::COLUMN_APPEARANCE, axis);
+        position[axis]   = store.getColumn(EntityStore::COLUMN_POSITION, axis);
+    }
+    matrix* transforms = store.getTransforms();
+
+    forEachBlock(store, [&](s32 begin, s32 end) {
+        for(s32 i = begin; i < end; i += 4) {
+            __m128 z[3]{_mm_loadu_ps(appearance[0] + i), _mm_loadu_ps(appearance[1] + i), _mm_loadu_ps(appearance[2] + i)};
+
+            // X軸 = normalize(cross(Z軸, 上方向))、Y軸 = normalize(cross(X軸, Z軸))
+            // 真上・真下を向いている場合や未使用のレーン (0,0,0) は外積が0になるため固定の軸にする
+            // (ENTITY_makeTransform()と同じ。0除算でNaNの行列を書き出さないように)
+            __m128 x[3]{_mm_sub_ps(_mm_setzero_ps(), z[2]), _mm_setzero_ps(), z[0]};
+            normalizeOr(x, FALLBACK_AXIS_X);
+
+            __m128 y[3]{_mm_sub_ps(_mm_mul_ps(x[1], z[2]), _mm_mul_ps(x[2], z[1])),
+                        _mm_sub_ps(_mm_mul_ps(x[2], z[0]), _mm_mul_ps(x[0], z[2])),
+                        _mm_sub_ps(_mm_mul_ps(x[0], z[1]), _mm_mul_ps(x[1], z[0]))};
+            normalizeOr(y, FALLBACK_AXIS_Y);
+
+            //---- 4個分の行列に書き出し (1行 = 1軸)
+            alignas(16) f32 rows[4][3][4];   // [行][成分][レーン]
+            for(s32 axis = 0; axis < 3; ++axis) {
+                _mm_store_ps(rows[0][axis], x[axis]);
+                _mm_store_ps(rows[1][axis], y[axis]);
+                _mm_store_ps(rows[2][axis], z[axis]);
+                _mm_store_ps(rows[3][axis], _mm_loadu_ps(position[axis] + i));
+            }
+            for(s32 lane = 0; lane < 4; ++lane) {
+                f32(&m)[4][4] = *reinterpret_cast<f32(*)[4][4]>(&transforms[i + lane]);
+                for(s32 row = 0; row < 4; ++row) {
+                    m[row][0] = rows[row][0][lane];
+                    m[row][1] = rows[row][1][lane];
+                    m[row][2] = rows[row][2][lane];
+                    m[row][3] = (row == 3) ? 1.0f : 0.0f;
+                }
+            }
+        }
+    });
+}
+
+//---------------------------------------------------------------------------
+//! 向きと位置からワールド行列を作成
+//---------------------------------------------------------------------------
+matrix ENTITY_makeTransform(const float3& facing, const float3& position)
+{
+    float3 axis_z = facing;
+    float3 axis_x = normalizeOr(cross(axis_z, float3(0.0f, 1.0f, 0.0f)), FALLBACK_AXIS_X);
+    float3 axis_y = normalizeOr(cross(axis_x, axis_z), FALLBACK_AXIS_Y);
+
+    // 作成した軸情報と位置情報で行列に直接代入して作成する
+    matrix m       = matrix::identity();
+    m._11_12_13_14 = float4(axis_x, 0.0f);
+    m._21_22_23_24 = float4(axis_y, 0.0f);
+    m._31_32_33_34 = float4(axis_z, 0.0f);
+    m._41_42_43_44 = float4(position, 1.0f);
+    return m;
+}
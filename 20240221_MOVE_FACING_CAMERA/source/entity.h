@@ -0,0 +1,179 @@
+﻿//===========================================================================
+//!	@file	entity.h
+//!	@brief	エンティティ (SoAの成分配列)
+//!
+//!	位置・速度・向きなどを成分ごとの配列(SoA)で保持し、システム関数で
+//!	全エンティティの列をまとめて更新します。配列は詰めて並べるため
+//!	削除すると並びが変わりますが、ハンドル(番号+世代)は変わりません。
+//!
+//! @code
+//!     EntityStore  entities;
+//!     EntityHandle player = entities.create(float3(0.0f, 0.0f, 0.0f));
+//!
+//!     s32 index = entities.getIndex(player);
+//!     entities.set(EntityStore::COLUMN_MOVE, index, move);   // 移動入力
+//!
+//!     ENTITY_updateMovement(entities, MOVE_SPEED, delta_time);   // 全エンティティを更新
+//!     ENTITY_updateGravity(entities, 9.80665f, delta_time);
+//! @endcode
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! エンティティハンドル
+//!
+//! 下位20bitがスロット番号、上位12bitが世代。0は無効なハンドル。
+//===========================================================================
+struct EntityHandle
+{
+    u32 value_ = 0;   //!< ハンドル値
+
+    //! 有効なハンドルかどうか (削除済みかどうかはEntityStore::isAlive()で判定)
+    bool isValid() const { return value_ != 0; }
+
+    explicit operator bool() const { return isValid(); }
+
+    bool operator==(const EntityHandle&) const = default;
+};
+
+//===========================================================================
+//! エンティティの成分配列
+//!
+//! 要素数は4の倍数に切り上げて確保し、余りは0で埋めます (SIMDで4個ずつ処理するため)。
+//===========================================================================
+class EntityStore
+{
+public:
+    static constexpr s32 MAX_ENTITY_COUNT = 1 << 20;   //!< 最大数 (ハンドルのスロット番号のビット数で決まる)
+
+    //! 3成分の列の番号
+    enum Column
+    {
+        COLUMN_POSITION,          //!< 位置
+        COLUMN_VELOCITY,          //!< 速度 (m/s)
+        COLUMN_MOVE,              //!< 移動入力 (長さ0なら移動しない)
+        COLUMN_FACING,            //!< 向いている方向 (内部的)
+        COLUMN_APPEARANCE,        //!< 向いている方向 (見た目、COLUMN_FACINGに追従)
+        COLUMN_PREV_POSITION,     //!< 前回の更新時の位置 (描画補間用)
+        COLUMN_PREV_APPEARANCE,   //!< 前回の更新時の見た目の方向 (描画補間用)
+        COLUMN_COUNT,
+    };
+
+    //! コンストラクタ
+    EntityStore() = default;
+
+    //! 作成
+    //! @param  [in]    position    位置
+    //! @param  [in]    facing      向いている方向
+    //! @return ハンドル (最大数を超えた場合は無効なハンドル)
+    EntityHandle create(const float3& position, const float3& facing = float3(0.0f, 0.0f, 1.0f));
+
+    //! 削除 (末尾のエンティティが空いた位置に移動する)
+    void destroy(EntityHandle handle);
+
+    //! 全て削除
+    void clear();
+
+    //! 生存しているかどうか
+    bool isAlive(EntityHandle handle) const { return getIndex(handle) >= 0; }
+
+    //! 配列上の番号を取得
+    //! @return 番号 (削除済みの場合は-1)
+    s32 getIndex(EntityHandle handle) const;
+
+    //! 配列上の番号からハンドルを取得
+    EntityHandle getHandle(s32 index) const;
+
+    //! エンティティ数を取得
+    s32 size() const { return count_; }
+
+    //----------------------------------------------------------
+    //! @name 成分の参照
+    //----------------------------------------------------------
+    //!@{
+
+    //! 列の先頭を取得
+    //! @param  [in]    column  列の番号
+    //! @param  [in]    axis    0:X 1:Y 2:Z
+    f32*       getColumn(Column column, s32 axis) { return columns_[column][axis].data(); }
+    const f32* getColumn(Column column, s32 axis) const { return columns_[column][axis].data(); }
+
+    //! 値を取得
+    float3 get(Column column, s32 index) const
+    {
+        return float3(columns_[column][0][index], columns_[column][1][index], columns_[column][2][index]);
+    }
+
+    //! 値を設定
+    void set(Column column, s32 index, const float3& value)
+    {
+        columns_[column][0][index] = value.x;
+        columns_[column][1][index] = value.y;
+        columns_[column][2][index] = value.z;
+    }
+
+    //! ワールド行列の配列を取得 (ENTITY_updateTransforms()で更新)
+    matrix*       getTransforms() { return transforms_.data(); }
+    const matrix* getTransforms() const { return transforms_.data(); }
+
+    //!@}
+
+private:
+    //! 配列の大きさを変更 (4の倍数に切り上げ)
+    void resize(s32 count);
+
+private:
+    s32 count_ = 0;   //!< エンティティ数
+
+    std::vector<f32>    columns_[COLUMN_COUNT][3];   //!< 3成分の列 (成分ごと)
+    std::vector<matrix> transforms_;                 //!< ワールド行列
+
+    std::vector<u32> dense_to_slot_;   //!< 配列上の番号 → スロット番号
+    std::vector<u32> slot_to_dense_;   //!< スロット番号 → 配列上の番号
+    std::vector<u32> generations_;     //!< スロットごとの現在の世代 (1～)
+    std::vector<u32> free_slots_;      //!< 空いているスロット番号
+};
+
+//===========================================================================
+//! @name システム (全エンティティの列をまとめて更新、JOB_setup()済みなら並列に実行)
+//===========================================================================
+//!@{
+
+//! 現在の位置と見た目の方向を前回の値として保存
+void ENTITY_savePrevious(EntityStore& store);
+
+//! 移動入力の方向に向きを変えて移動
+//! @param  [in]    speed       移動速度 (m/s)
+//! @param  [in]    delta_time  経過時間 (単位:秒)
+void ENTITY_updateMovement(EntityStore& store, f32 speed, f32 delta_time);
+
+//! 重力で落下 (地面 Y=0 で停止)
+//! @param  [in]    gravity     重力加速度 (m/s^2)
+//! @param  [in]    delta_time  経過時間 (単位:秒)
+void ENTITY_updateGravity(EntityStore& store, f32 gravity, f32 delta_time);
+
+//! 見た目の方向を向いている方向に追従させる
+//! @param  [in]    turn_rate   60fpsの1フレームあたりに追従する角度の割合
+//! @param  [in]    delta_time  経過時間 (単位:秒)
+void ENTITY_updateFacing(EntityStore& store, f32 turn_rate, f32 delta_time);
+
+//! 見た目の方向を目標の方向に近づける (SoAの配列を4個ずつSIMDで処理)
+//!
+//! なす角の rate 倍だけ、両者の外積を軸に回転させます。同じ方向・真逆の方向で
+//! 外積が求まらない場合はY軸中心に回転します。長さ0の要素は変更しません。
+//! @param  [in,out]    appearance  見た目の方向 (成分ごとの配列)
+//! @param  [in,out]    target      目標の方向 (成分ごとの配列、正規化して書き戻す)
+//! @param  [in]        count       要素数 (4の倍数に切り上げた分の領域が必要)
+//! @param  [in]        rate        追従率 (0.0f～1.0f)
+void ENTITY_turnTowards(f32* const appearance[3], f32* const target[3], s32 count, f32 rate);
+
+//! 見た目の方向と位置からワールド行列を作成
+void ENTITY_updateTransforms(EntityStore& store);
+
+//! 向きと位置からワールド行列を作成 (Z軸を向きに合わせ、Y軸を上方向に近づける)
+//! 向きが真上・真下の場合はX軸を(1,0,0)に固定します。
+//! @param  [in]    facing      向いている方向 (正規化済)
+//! @param  [in]    position    位置
+matrix ENTITY_makeTransform(const float3& facing, const float3& position);
+
+//!@}
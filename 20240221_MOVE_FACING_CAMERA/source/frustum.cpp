@@ -0,0 +1,208 @@
+﻿//===========================================================================
+//!	@file	frustum.cpp
+//!	@brief	視錐台カリング
+//===========================================================================
+#include <emmintrin.h>   // SSE2
+
+namespace
+{
+//---------------------------------------------------------------------------
+//! 4個分の判定結果から見えている番号を詰めて書き込み
+//! @param  [in]    base    先頭の番号
+//! @param  [in]    mask    見えているビットマスク (bit0-3)
+//! @param  [in]    count   有効な数 (最大4)
+//! @return 書き込んだ数
+//---------------------------------------------------------------------------
+s32 writeIndices(u32* out, u32 base, u32 mask, s32 count)
+{
+    // 分岐を減らすため常に書き込み、見えている場合だけ書き込み位置を進める
+    s32 written = 0;
+    for(s32 lane = 0; lane < count; ++lane) {
+        out[written] = base + lane;
+        written += (mask >> lane) & 1;
+    }
+    return written;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! コンストラクタ
+//---------------------------------------------------------------------------
+Frustum::Frustum(const matrix& view_proj)
+{
+    // クリップ座標 c = p × M の各成分は M の列ベクトルとの内積になる
+    // -w <= x <= w などの条件を平面の式に並べ替える (Gribb & Hartmann)
+    const f32(&m)[4][4] = *reinterpret_cast<const f32(*)[4][4]>(&view_proj);
+
+    for(s32 i = 0; i < 4; ++i) {
+        f32 x = m[i][0];
+        f32 y = m[i][1];
+        f32 z = m[i][2];
+        f32 w = m[i][3];
+
+        planes_[PLANE_LEFT][i]   = w + x;
+        planes_[PLANE_RIGHT][i]  = w - x;
+        planes_[PLANE_BOTTOM][i] = w + y;
+        planes_[PLANE_TOP][i]    = w - y;
+        planes_[PLANE_NEAR][i]   = w + z;
+        planes_[PLANE_FAR][i]    = w - z;
+    }
+
+    // 距離で比較できるよう法線を正規化
+    for(auto& plane : planes_) {
+        f32 length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if(length > 0.0f) {
+            for(f32& value : plane) {
+                value /= length;
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 境界球が見えるかどうか
+//---------------------------------------------------------------------------
+bool Frustum::testSphere(const Sphere& sphere) const
+{
+    f32 x = sphere.center_.x;
+    f32 y = sphere.center_.y;
+    f32 z = sphere.center_.z;
+
+    for(const auto& plane : planes_) {
+        // 計算順はcullSpheres()とそろえる (丸め誤差で結果が変わらないように)
+        f32 distance = (plane[0] * x + plane[1] * y) + (plane[2] * z + plane[3]);
+        if(distance < -sphere.radius_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! AABBが見えるかどうか
+//---------------------------------------------------------------------------
+bool Frustum::testAABB(const AABB& box) const
+{
+    f32 center[3]{(box.min_.x + box.max_.x) * 0.5f, (box.min_.y + box.max_.y) * 0.5f, (box.min_.z + box.max_.z) * 0.5f};
+    f32 extent[3]{(box.max_.x - box.min_.x) * 0.5f, (box.max_.y - box.min_.y) * 0.5f, (box.max_.z - box.min_.z) * 0.5f};
+
+    for(const auto& plane : planes_) {
+        // 法線方向に最も遠い頂点が平面の外側なら全体が外側
+        f32 distance = (plane[0] * center[0] + plane[1] * center[1]) + (plane[2] * center[2] + plane[3]);
+        f32 radius   = std::abs(plane[0]) * extent[0] + std::abs(plane[1]) * extent[1] + std::abs(plane[2]) * extent[2];
+        if(distance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! AABBと視錐台の関係を取得
+//---------------------------------------------------------------------------
+Frustum::Overlap Frustum::classifyAABB(const f32 box_min[3], const f32 box_max[3]) const
+{
+    f32 center[3]{(box_min[0] + box_max[0]) * 0.5f, (box_min[1] + box_max[1]) * 0.5f, (box_min[2] + box_max[2]) * 0.5f};
+    f32 extent[3]{(box_max[0] - box_min[0]) * 0.5f, (box_max[1] - box_min[1]) * 0.5f, (box_max[2] - box_min[2]) * 0.5f};
+
+    Overlap result = Overlap::Inside;
+    for(const auto& plane : planes_) {
+        f32 distance = (plane[0] * center[0] + plane[1] * center[1]) + (plane[2] * center[2] + plane[3]);
+        f32 radius   = std::abs(plane[0]) * extent[0] + std::abs(plane[1]) * extent[1] + std::abs(plane[2]) * extent[2];
+        if(distance + radius < 0.0f) {
+            return Overlap::Outside;
+        }
+        if(distance - radius < 0.0f) {
+            result = Overlap::Intersect;
+        }
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! 境界球をまとめて判定
+//---------------------------------------------------------------------------
+s32 Frustum::cullSpheres(const SphereArray& spheres, u32* visible_indices) const
+{
+    // 平面を各レーンに展開しておく
+    __m128 plane[PLANE_COUNT][4];
+    for(s32 p = 0; p < PLANE_COUNT; ++p) {
+        for(s32 i = 0; i < 4; ++i) {
+            plane[p][i] = _mm_set1_ps(planes_[p][i]);
+        }
+    }
+
+    const f32* center_x = spheres.getCenter(0);
+    const f32* center_y = spheres.getCenter(1);
+    const f32* center_z = spheres.getCenter(2);
+    const f32* radius   = spheres.getRadius();
+
+    s32 count         = spheres.size();
+    s32 visible_count = 0;
+    for(s32 i = 0; i < count; i += 4) {
+        __m128 x = _mm_loadu_ps(center_x + i);
+        __m128 y = _mm_loadu_ps(center_y + i);
+        __m128 z = _mm_loadu_ps(center_z + i);
+        __m128 r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+        // どれか1枚でも distance < -radius なら外側
+        __m128 outside = _mm_setzero_ps();
+        for(s32 p = 0; p < PLANE_COUNT; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[p][0], x), _mm_mul_ps(plane[p][1], y)),
+                                         _mm_add_ps(_mm_mul_ps(plane[p][2], z), plane[p][3]));
+            outside         = _mm_or_ps(outside, _mm_cmplt_ps(distance, r));
+        }
+
+        u32 mask = static_cast<u32>(_mm_movemask_ps(outside)) ^ 0xf;
+        visible_count += writeIndices(visible_indices + visible_count, i, mask, std::min(count - i, 4));
+    }
+    return visible_count;
+}
+
+//---------------------------------------------------------------------------
+//! AABBをまとめて判定
+//---------------------------------------------------------------------------
+s32 Frustum::cullAABBs(const AABBArray& boxes, u32* visible_indices) const
+{
+    // 平面と法線の絶対値を各レーンに展開しておく
+    __m128 plane[PLANE_COUNT][4];
+    __m128 abs_normal[PLANE_COUNT][3];
+    for(s32 p = 0; p < PLANE_COUNT; ++p) {
+        for(s32 i = 0; i < 4; ++i) {
+            plane[p][i] = _mm_set1_ps(planes_[p][i]);
+        }
+        for(s32 i = 0; i < 3; ++i) {
+            abs_normal[p][i] = _mm_set1_ps(std::abs(planes_[p][i]));
+        }
+    }
+
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    s32 count         = boxes.size();
+    s32 visible_count = 0;
+    for(s32 i = 0; i < count; i += 4) {
+        __m128 center[3];
+        __m128 extent[3];
+        for(s32 axis = 0; axis < 3; ++axis) {
+            __m128 box_min = _mm_loadu_ps(boxes.getMin(axis) + i);
+            __m128 box_max = _mm_loadu_ps(boxes.getMax(axis) + i);
+            center[axis]   = _mm_mul_ps(_mm_add_ps(box_min, box_max), half);
+            extent[axis]   = _mm_mul_ps(_mm_sub_ps(box_max, box_min), half);
+        }
+
+        // どれか1枚でも distance + radius < 0 なら外側
+        __m128 outside = _mm_setzero_ps();
+        for(s32 p = 0; p < PLANE_COUNT; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[p][0], center[0]), _mm_mul_ps(plane[p][1], center[1])),
+                                         _mm_add_ps(_mm_mul_ps(plane[p][2], center[2]), plane[p][3]));
+            __m128 radius   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_normal[p][0], extent[0]), _mm_mul_ps(abs_normal[p][1], extent[1])),
+                                         _mm_mul_ps(abs_normal[p][2], extent[2]));
+            outside         = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        u32 mask = static_cast<u32>(_mm_movemask_ps(outside)) ^ 0xf;
+        visible_count += writeIndices(visible_indices + visible_count, i, mask, std::min(count - i, 4));
+    }
+    return visible_count;
+}
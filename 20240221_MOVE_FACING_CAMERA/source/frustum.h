@@ -0,0 +1,89 @@
+﻿//===========================================================================
+//!	@file	frustum.h
+//!	@brief	視錐台カリング
+//!
+//!	ビュー行列×投影行列から視錐台の6平面を取り出し、境界球やAABBが
+//!	視錐台の外にあるかを判定します。まとめて判定する場合はSoAの配列を
+//!	4個ずつSIMDで判定し、見えている番号だけを詰めて返します。
+//!
+//! @code
+//!     Frustum frustum(mul(camera.getViewMatrix(), camera.getProjMatrix()));
+//!     s32 count = frustum.cullSpheres(spheres, visible_indices);
+//!     for(s32 i = 0; i < count; ++i) {
+//!         draw(objects[visible_indices[i]]);
+//!     }
+//! @endcode
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! 視錐台
+//!
+//! 投影行列はOpenGL互換 (変換後のZ値が-1.0～+1.0) を想定
+//===========================================================================
+class Frustum
+{
+public:
+    //! 平面の番号
+    enum Plane
+    {
+        PLANE_LEFT,     //!< 左
+        PLANE_RIGHT,    //!< 右
+        PLANE_BOTTOM,   //!< 下
+        PLANE_TOP,      //!< 上
+        PLANE_NEAR,     //!< 近クリップ面
+        PLANE_FAR,      //!< 遠クリップ面
+        PLANE_COUNT,
+    };
+
+    //! AABBと視錐台の関係
+    enum class Overlap
+    {
+        Outside,     //!< 完全に外側
+        Intersect,   //!< 境界と交差
+        Inside,      //!< 完全に内側
+    };
+
+    //! コンストラクタ (全てを含む視錐台)
+    Frustum() = default;
+
+    //! コンストラクタ
+    //! @param  [in]    view_proj   ビュー行列×投影行列
+    explicit Frustum(const matrix& view_proj);
+
+    //! 境界球が見えるかどうか
+    //!	@retval	true	見えている可能性がある
+    //!	@retval	false	視錐台の外
+    bool testSphere(const Sphere& sphere) const;
+
+    //! AABBが見えるかどうか
+    //!	@retval	true	見えている可能性がある
+    //!	@retval	false	視錐台の外
+    bool testAABB(const AABB& box) const;
+
+    //! AABBと視錐台の関係を取得 (階層構造の探索用)
+    //! @param  [in]    box_min 最小座標 (x, y, z)
+    //! @param  [in]    box_max 最大座標 (x, y, z)
+    Overlap classifyAABB(const f32 box_min[3], const f32 box_max[3]) const;
+
+    //! 境界球をまとめて判定 (4個ずつSIMDで計算)
+    //! @param  [in]    spheres         境界球の配列
+    //! @param  [out]   visible_indices 見えている番号 (spheres.size()個分の領域が必要)
+    //! @return 見えている数
+    s32 cullSpheres(const SphereArray& spheres, u32* visible_indices) const;
+
+    //! AABBをまとめて判定 (4個ずつSIMDで計算)
+    //! @param  [in]    boxes           AABBの配列
+    //! @param  [out]   visible_indices 見えている番号 (boxes.size()個分の領域が必要)
+    //! @return 見えている数
+    s32 cullAABBs(const AABBArray& boxes, u32* visible_indices) const;
+
+    //! 平面を取得 (xyz:法線 w:距離、dot(plane, float4(p, 1)) >= 0 が内側)
+    float4 getPlane(s32 index) const
+    {
+        return float4(planes_[index][0], planes_[index][1], planes_[index][2], planes_[index][3]);
+    }
+
+private:
+    f32 planes_[PLANE_COUNT][4] = {};   //!< 平面 (法線は正規化済)
+};
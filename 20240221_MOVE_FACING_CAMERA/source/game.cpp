@@ -3,7 +3,7 @@
 //!	@brief	ゲームメインループ
 //===========================================================================
 
-std::shared_ptr<Texture> texture;   //!< テクスチャ
+TextureHandle texture;   //!< テクスチャ
 
 constexpr float PI = 3.141592f;   //!< 円周率
 
@@ -21,22 +21,17 @@ float GetAngleBetweenVector(float3 a, float3 b)
     return acosf(cosine);
 }
 
-void SetMatrix(const matrix& m)
-{
-    glLoadMatrixf((GLfloat*)&m);
-}
-
 void drawArrow(const float3& p0, const float3& p1, const Color& c)
 {
-    glBegin(GL_LINES);
+    RENDER_begin(PrimitiveType::Lines);
 
-    glColor4ubv((GLubyte*)&c);
+    RENDER_color(c);
     {
         //------------------------------------------------------
         // 中心軸
         //------------------------------------------------------
-        glVertex3fv((GLfloat*)&p0);
-        glVertex3fv((GLfloat*)&p1);
+        RENDER_vertex(p0);
+        RENDER_vertex(p1);
 
         //------------------------------------------------------
         // 四角錐
@@ -65,32 +60,32 @@ void drawArrow(const float3& p0, const float3& p1, const Color& c)
             base - up       //
         };
 
-        glVertex3fv((GLfloat*)&v[0]);
-        glVertex3fv((GLfloat*)&v[1]);
+        RENDER_vertex(v[0]);
+        RENDER_vertex(v[1]);
 
-        glVertex3fv((GLfloat*)&v[1]);
-        glVertex3fv((GLfloat*)&v[2]);
+        RENDER_vertex(v[1]);
+        RENDER_vertex(v[2]);
 
-        glVertex3fv((GLfloat*)&v[2]);
-        glVertex3fv((GLfloat*)&v[3]);
+        RENDER_vertex(v[2]);
+        RENDER_vertex(v[3]);
 
-        glVertex3fv((GLfloat*)&v[3]);
-        glVertex3fv((GLfloat*)&v[0]);
+        RENDER_vertex(v[3]);
+        RENDER_vertex(v[0]);
 
         // 斜めの部分
-        glVertex3fv((GLfloat*)&v[0]);
-        glVertex3fv((GLfloat*)&p1);
+        RENDER_vertex(v[0]);
+        RENDER_vertex(p1);
 
-        glVertex3fv((GLfloat*)&v[1]);
-        glVertex3fv((GLfloat*)&p1);
+        RENDER_vertex(v[1]);
+        RENDER_vertex(p1);
 
-        glVertex3fv((GLfloat*)&v[2]);
-        glVertex3fv((GLfloat*)&p1);
+        RENDER_vertex(v[2]);
+        RENDER_vertex(p1);
 
-        glVertex3fv((GLfloat*)&v[3]);
-        glVertex3fv((GLfloat*)&p1);
+        RENDER_vertex(v[3]);
+        RENDER_vertex(p1);
     }
-    glEnd();
+    RENDER_end();
 }
 
 class Camera
@@ -114,6 +109,18 @@ public:
     //!注視点を設定
     //! @param [in] look_at 注視点
     void setLookAt(const float3& look_at) { look_at_ = look_at; }
+    //!投影を設定
+    //! @param [in] fovy         画角(単位:radian)
+    //! @param [in] aspect_ratio アスペクト比
+    //! @param [in] near_z       近クリップZ値
+    //! @param [in] far_z        遠クリップZ値
+    void setPerspective(f32 fovy, f32 aspect_ratio, f32 near_z, f32 far_z)
+    {
+        fovy_         = fovy;
+        aspect_ratio_ = aspect_ratio;
+        near_z_       = near_z;
+        far_z_        = far_z;
+    }
 
     //!@}
     //! @name 参照
@@ -133,12 +140,20 @@ public:
     //!投影行列を取得
     const matrix& getProjMatrix() const { return mat_proj_; }
 
+    //!視錐台を取得
+    Frustum getFrustum() const { return Frustum(mul(mat_view_, mat_proj_)); }
+
     //!@}
 
 private:
     float3 position_ = float3(0.0f, 1.0f, 5.0f);   //!位置
     float3 look_at_  = float3(0.0f, 0.0f, 0.0f);   //!注視点
 
+    f32 fovy_         = PI * 0.25f;      //!画角 (45度)
+    f32 aspect_ratio_ = 16.0f / 9.0f;   //!アスペクト比
+    f32 near_z_       = 0.1f;           //!近クリップZ値
+    f32 far_z_        = 1000.0f;        //!遠クリップZ値
+
     //Ctrl K + D to organize document
     matrix mat_world_ = matrix::identity();   //!ワールド行列 World Matrix
     matrix mat_view_  = matrix::identity();   //!ビュー行列 View Matrix
@@ -172,31 +187,8 @@ void Camera::update()
     //ビュー行列 = カメラのワールド行列の逆行列
     mat_view_ = inverse(mat_world_);
 
-    //投影行列
-    // 一時に未使用
-    // mat_projection_ = matrix::
-}
-
-//---------------------------------------------------------------------------
-//	初期化
-//!	@retval	true	正常終了    	(成功)
-//!	@retval	false	エラー終了	(失敗)
-//---------------------------------------------------------------------------
-bool GAME_setup()
-{
-    glClearColor(0.25f, 0.25f, 0.25f, 1.0f);   // 画面クリアカラーの設定
-    glClearDepth(1.0f);                        // Ｚバッファの初期化値
-    glEnable(GL_DEPTH_TEST);                   // Ｚバッファを有効にする
-
-    //----------------------------------------------------------
-    // テクスチャを読み込む
-    //----------------------------------------------------------
-    texture = LoadTexture("data/sample.tga");
-    if(texture == nullptr) {
-        return false;
-    }
-
-    return true;
+    //投影行列 (OpenGL互換)
+    mat_proj_ = matrix::perspectiveFovRH(fovy_, aspect_ratio_, near_z_, far_z_);
 }
 
 //--------------------------------------------------------------
@@ -213,56 +205,167 @@ float  camera_distance = 10.0f;                                // カメラの
 //--------------------------------------------------------------
 // プレイヤー情報
 //--------------------------------------------------------------
-float3 position = float3(0.0f, 0.0f, 0.0f);
+// 位置・速度・向き (内部的/見た目)・描画補間用の前回の値はエンティティの列で保持する
+EntityStore  entities;   // エンティティ
+EntityHandle player;     // プレイヤー
+
+constexpr float MOVE_SPEED = 6.0f;   // 移動速度 (m/s) ※従来の60fpsで0.1m/フレーム相当
+constexpr float TURN_RATE  = 0.1f;   // 60fpsの1フレームあたりに追従する角度の割合
+
+//===========================================================================
+//! 入力情報
+//! Win32の入力状態はメインスレッドで取得し、更新スレッドへ渡す
+//===========================================================================
+struct GameInput
+{
+    f32  mouse_dx = 0.0f;    //!< マウスX移動量 (感度適用済)
+    f32  mouse_dy = 0.0f;    //!< マウスY移動量 (感度適用済)
+    bool right    = false;   //!< →キー
+    bool left     = false;   //!< ←キー
+    bool up       = false;   //!< ↑キー
+    bool down     = false;   //!< ↓キー
+};
+
+//===========================================================================
+//! デバッグ表示用の矢印
+//===========================================================================
+struct DebugArrow
+{
+    float3 p0;      //!< 始点
+    float3 p1;      //!< 終点
+    Color  color;   //!< 色
+};
+
+//===========================================================================
+//! 描画スナップショット
+//!
+//! 更新フェーズの結果を描画に必要な分だけ書き出したもの。
+//! 描画フェーズはこの内容だけを参照するため、更新スレッドと並行して描画できる。
+//! 補間のため前回[0]と今回[1]の2時点の値と、その更新を行ったフレームの補間係数を持つ。
+//! (描画は1フレーム遅れるため、描画時点のフレームの補間係数では前回・今回と対応しない)
+//===========================================================================
+struct RenderSnapshot
+{
+    float3 camera_dir      = float3(0.0f, 0.0f, 1.0f);   //!< カメラがある方向
+    f32    camera_distance = 10.0f;                      //!< カメラの距離
+    f32    alpha           = 0.0f;                       //!< 前回[0]から今回[1]への補間係数
+
+    float3 player_position[2];   //!< プレイヤー位置
+    float3 player_facing[2];     //!< プレイヤーの向き (見た目)
+
+    std::span<const DebugArrow> debug_arrows;   //!< デバッグ矢印 (ワールド座標、フレームアリーナ上)
+};
+
+//--------------------------------------------------------------
+// 更新スレッド
+//--------------------------------------------------------------
+namespace
+{
+std::thread           update_thread;         //!< 更新スレッド
+std::binary_semaphore update_start{0};       //!< 更新開始の通知
+std::binary_semaphore update_done{0};        //!< 更新完了の通知
+bool                  update_quit = false;   //!< 更新スレッド終了リクエスト
+
+GameInput update_input;               //!< 更新スレッドへ渡す入力
+f32       update_delta_time = 0.0f;   //!< 1回の更新時間
+s32       update_step_count = 0;      //!< 今フレームの更新回数
+f32       update_alpha      = 0.0f;   //!< 今フレームの補間係数 (描画スナップショットに書き出す)
+
+// 描画スナップショット (ダブルバッファ)
+// 更新スレッドは [write_index] に書き込み、描画は [write_index ^ 1] を参照する
+RenderSnapshot snapshots[2];
+s32            write_index = 0;
+}   // namespace
+
+//--------------------------------------------------------------
+// オクルージョンカリング
+//--------------------------------------------------------------
+namespace
+{
+OcclusionCuller occlusion_culler;   //!< オクルージョンカリング (描画フェーズで使用)
+
+u32 leak_check_sequence = 0;   //!< GAME_setup()開始時の確保の通し番号 (解放漏れの確認用)
+
+//! テクスチャつき四角形 (遮蔽物として登録)
+const float3 quad_vertices[]{
+    float3(-1.0f, +1.0f, 0.0f),   // 左上
+    float3(+1.0f, +1.0f, 0.0f),   // 右上
+    float3(-1.0f, -1.0f, 0.0f),   // 左下
+    float3(+1.0f, -1.0f, 0.0f),   // 右下
+};
+constexpr u16 quad_indices[]{0, 2, 1, 1, 2, 3};
+
+//! ピラミッドのAABB (ローカル座標)
+const AABB pyramid_bounds{float3(-1.0f, 0.0f, -1.0f), float3(+1.0f, 1.0f, +1.0f)};
+}   // namespace
 
 //---------------------------------------------------------------------------
-//	更新
+//	入力をゲーム用に変換 (メインスレッド)
+//!	@param	[in]	frame	1フレーム分の入力 (Win32または入力ログ)
 //---------------------------------------------------------------------------
-void GAME_update()
+GameInput toGameInput(const InputFrame& frame)
 {
-    // カメラの操作
+    GameInput input;
 
-    // マウスの現在位置を取得(Win32 API) ※デスクトップ画面の現在位置
-    static bool initialized = false;   // 初回の初期化済かどうか
+    // マウスの移動量を計算
+    constexpr float mouse_sensitivity = 0.01f;   // マウス感度
 
-    POINT cursor_pos;
-    GetCursorPos(&cursor_pos);
-    static POINT last_pos = cursor_pos;
-    {
-        // 初回の初期化
-        if(!initialized) {
-            last_pos = cursor_pos;
+    //only gets camera position when left clicked
+    if(frame.isDown(InputButton::MouseLeft)) {
+        input.mouse_dx = float(frame.mouse_dx_) * mouse_sensitivity;
+        input.mouse_dy = float(frame.mouse_dy_) * mouse_sensitivity;
+    }
 
-            initialized = true;   // 初期化済
-        }
+    input.right = frame.isDown(InputButton::Right);
+    input.left  = frame.isDown(InputButton::Left);
+    input.up    = frame.isDown(InputButton::Up);
+    input.down  = frame.isDown(InputButton::Down);
 
-        // マウスの移動量を計算
-        constexpr float mouse_sensitivity = 0.01f;   // マウス感度
+    // 終了はメインスレッドから通知する
+    if(frame.isDown(InputButton::Quit)) {
+        PostQuitMessage(0);
+    }
+    return input;
+}
 
-        float dx = 0.0f;
-        float dy = 0.0f;
+//---------------------------------------------------------------------------
+//	カメラを回転
+//!	@param	[in]	input	入力
+//---------------------------------------------------------------------------
+void updateCamera(const GameInput& input)
+{
+    PROFILE_FUNCTION();
 
-        //only gets camera position when left clicked
-        if(GetKeyState(VK_LBUTTON) & 0x8000)   //0x8000 only takes significant bit
-        {
-            dx = float(cursor_pos.x - last_pos.x) * mouse_sensitivity;
-            dy = float(cursor_pos.y - last_pos.y) * mouse_sensitivity;
-        }
+    float dx = input.mouse_dx;
+    float dy = input.mouse_dy;
 
-        //------------------------------------------------------
-        // カメラを回転
-        //------------------------------------------------------
+    //------------------------------------------------------
+    // カメラを回転
+    //------------------------------------------------------
 
-        // 左右首振り
-        matrix rotY = matrix::rotateY(-dx);
-        camera_dir  = mul(float4(camera_dir, 0.0f), rotY).xyz;
+    // 左右首振り
+    matrix rotY = matrix::rotateY(-dx);
+    camera_dir  = mul(float4(camera_dir, 0.0f), rotY).xyz;
 
-        // 上下
-        float3 axisX = normalize(cross(camera_dir, float3(0, 1, 0)));   // カメラの方向に合わせた真横方向
-        matrix rotX  = matrix::rotateAxis(axisX, -dy);
-        camera_dir   = mul(float4(camera_dir, 0.0f), rotX).xyz;
-    }
-    last_pos = cursor_pos;   // 次のフレームのために保存
+    // 上下
+    float3 axisX = normalize(cross(camera_dir, float3(0, 1, 0)));   // カメラの方向に合わせた真横方向
+    matrix rotX  = matrix::rotateAxis(axisX, -dy);
+    camera_dir   = mul(float4(camera_dir, 0.0f), rotX).xyz;
+}
+
+//---------------------------------------------------------------------------
+//	更新 (固定タイムステップ1回分)
+//!	@param	[in]	input		入力
+//!	@param	[in]	delta_time	1回の更新時間 (単位:秒)
+//---------------------------------------------------------------------------
+void updateStep(const GameInput& input, f32 delta_time)
+{
+    PROFILE_FUNCTION();
+
+    ENTITY_savePrevious(entities);
+
+    s32    player_index = entities.getIndex(player);
+    float3 position     = entities.get(EntityStore::COLUMN_POSITION, player_index);
 
     // カメラ設定
     look_at      = position;   // プレイヤーを見る
@@ -272,35 +375,239 @@ void GAME_update()
     camera.setLookAt(look_at);
     camera.update();
 
+    //カメラの向きを取得, moving based on camera look
+
+    matrix mat_camera_world = camera.getWorldMatrix();
+    float3 dir_right        = mat_camera_world[0].xyz;   //base matrix conversion to xyz
+    float3 dir_up           = mat_camera_world[1].xyz;   //base matrix conversion to xyz
+    float3 dir_backward     = mat_camera_world[2].xyz;   //base matrix conversion to xyz
+
+    dir_backward.y = 0.0f;   //spaceship movement if y is not restricted
+    dir_backward   = normalize(dir_backward);
+
+    dir_up = cross(dir_backward, dir_right);   //get cross data, recalculate
+
+    // 移動量
+    float3 move = float3(0.0f, 0.0f, 0.0f);
+
+    if(input.right) {
+        //move.x += 1.0f; //move to world movement
+        move += dir_right;   //move to camera pos
+    }
+    if(input.left) {
+        move -= dir_right;
+    }
+    if(input.up) {
+        move -= dir_backward;
+    }
+    if(input.down) {
+        move += dir_backward;
+    }
+
+    // 移動 puts move to position
+    // 移動入力があるエンティティ (dot(v, v) = 距離の2乗 > FLT_EPSILON) はその方向を向いて移動
+    entities.set(EntityStore::COLUMN_MOVE, player_index, move);
+    ENTITY_updateMovement(entities, MOVE_SPEED, delta_time);
+
+    //Jump
+    //9.80665 Gravity
+
+    //Fall speed
+    // gravity acceleration
+    //
+    float G = 9.80665f;   //(m/s ''2) -> m/(s*s)
+
+    // acceleration (m/s)
+    ENTITY_updateGravity(entities, G, delta_time);
+
     //----------------------------------------------------------
-    // 座標更新
+    // キャラクターの回転補間 Character interpolate rotation
+    //----------------------------------------------------------
+    // 見た目の方向 → 向いている方向 に追従させる
+    ENTITY_updateFacing(entities, TURN_RATE, delta_time);
+}
+
+//---------------------------------------------------------------------------
+//	描画スナップショットを作成
+//!	@param	[out]	snapshot	書き込み先
+//---------------------------------------------------------------------------
+void writeSnapshot(RenderSnapshot& snapshot)
+{
+    PROFILE_FUNCTION();
+
+    snapshot.camera_dir      = camera_dir;
+    snapshot.camera_distance = camera_distance;
+    snapshot.alpha           = update_alpha;
+
+    s32    player_index    = entities.getIndex(player);
+    float3 position        = entities.get(EntityStore::COLUMN_POSITION, player_index);
+    float3 dir             = entities.get(EntityStore::COLUMN_FACING, player_index);
+    float3 appearrance_dir = entities.get(EntityStore::COLUMN_APPEARANCE, player_index);
+
+    snapshot.player_position[0] = entities.get(EntityStore::COLUMN_PREV_POSITION, player_index);
+    snapshot.player_position[1] = position;
+    snapshot.player_facing[0]   = entities.get(EntityStore::COLUMN_PREV_APPEARANCE, player_index);
+    snapshot.player_facing[1]   = appearrance_dir;
+
+    // 可変長のデータはフレームアリーナに書き出す (描画される次フレームの終わりまで有効)
+    constexpr s32 DEBUG_ARROW_COUNT = 2;
+
+    DebugArrow* arrows = ARENA_frameAllocArray<DebugArrow>(DEBUG_ARROW_COUNT);
+    arrows[0] = {position, position + dir * 5.0f, Color(255, 255, 255)};               // dir=白
+    arrows[1] = {position, position + appearrance_dir * 5.0f, Color(255, 0, 255)};   // appearrance_dir=マゼンタ
+    snapshot.debug_arrows = {arrows, DEBUG_ARROW_COUNT};
+}
+
+//---------------------------------------------------------------------------
+//	更新スレッド
+//---------------------------------------------------------------------------
+void updateThread()
+{
+    PROFILE_setThreadName("update");
+
+    for(;;) {
+        update_start.acquire();   // 更新開始待ち
+        if(update_quit) {
+            break;
+        }
+        PROFILE_ZONE("update");
+
+        // カメラ回転はフレームに1回 (マウス移動量はフレーム単位のため)
+        updateCamera(update_input);
+
+        for(s32 i = 0; i < update_step_count; ++i) {
+            updateStep(update_input, update_delta_time);
+        }
+        writeSnapshot(snapshots[write_index]);
+
+        update_done.release();   // 更新完了を通知
+    }
+}
+
+//---------------------------------------------------------------------------
+//	初期化
+//!	@retval	true	正常終了    	(成功)
+//!	@retval	false	エラー終了	(失敗)
+//---------------------------------------------------------------------------
+bool GAME_setup()
+{
+    // ここから確保したメモリが解放されているかをGAME_cleanup()で確認する
+    leak_check_sequence = MEMORY_getSequence();
+
+    //----------------------------------------------------------
+    // テクスチャを読み込む
     //----------------------------------------------------------
-    glLoadIdentity();
-
-    if constexpr(true) {
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
-        glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
-
-        // 投影行列（画角 (FOV)、アスペクト比、nearZ, farZ)
-        gluPerspective(45.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
-
-        glMultMatrixf((GLfloat*)&camera.getViewMatrix());
-
-        //gluLookAt(eye_position.x,   // x    カメラの位置(eye position)
-        //          eye_position.y,   // y
-        //          eye_position.z,   // z
-        //          look_at.x,        // x    注視点(look at)
-        //          look_at.y,        // y
-        //          look_at.z,        // z
-        //          0.0f,             // x    世界の上方向のベクトル(up)
-        //          1.0f,             // y
-        //          0.0f);            // z
-
-        // もとに戻す
-        glMatrixMode(GL_MODELVIEW);
+    texture = LoadTexture("data/sample.tga");
+    if(!texture) {
+        return false;
+    }
+
+    //----------------------------------------------------------
+    // オクルージョンカリング (画面の1/5程度の解像度で十分)
+    //----------------------------------------------------------
+    if(!occlusion_culler.setup(256, 144)) {
+        return false;
+    }
+
+    //----------------------------------------------------------
+    // プレイヤーを作成
+    //----------------------------------------------------------
+    player = entities.create(float3(0.0f, 0.0f, 0.0f));
+
+    //----------------------------------------------------------
+    // 更新スレッドを開始
+    //----------------------------------------------------------
+    // 最初のフレームは両方のバッファに初期状態を書き込んでおく
+    writeSnapshot(snapshots[0]);
+    writeSnapshot(snapshots[1]);
+
+    update_quit   = false;
+    update_thread = std::thread(updateThread);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//	更新開始
+//!	@param	[in]	input	1フレーム分の入力 (1回の更新時間と更新回数を含む)
+//---------------------------------------------------------------------------
+void GAME_beginUpdate(const InputFrame& input)
+{
+    update_input      = toGameInput(input);
+    update_delta_time = input.delta_time_;
+    update_step_count = input.step_count_;
+    update_alpha      = input.alpha_;
+
+    update_start.release();   // 更新スレッドを起動
+}
+
+//---------------------------------------------------------------------------
+//	更新完了待ち
+//---------------------------------------------------------------------------
+void GAME_endUpdate()
+{
+    PROFILE_FUNCTION();   // 更新スレッドの完了待ちの時間
+
+    update_done.acquire();
+
+    // 書き込みが終わったバッファを次フレームの描画対象にする
+    write_index ^= 1;
+}
+
+//---------------------------------------------------------------------------
+//	更新結果のハッシュ値を取得
+//---------------------------------------------------------------------------
+u32 GAME_getStateHash()
+{
+    s32 player_index = entities.getIndex(player);
+
+    float3 values[]{
+        camera_dir,
+        entities.get(EntityStore::COLUMN_POSITION, player_index),
+        entities.get(EntityStore::COLUMN_VELOCITY, player_index),
+        entities.get(EntityStore::COLUMN_APPEARANCE, player_index),
+    };
+
+    // FNV-1a (浮動小数点数はビット列のまま比較する)
+    u32 hash = 2166136261u;
+    for(const float3& value : values) {
+        f32 xyz[3]{value.x, value.y, value.z};
+
+        const u8* bytes = reinterpret_cast<const u8*>(xyz);
+        for(size_t i = 0; i < sizeof(xyz); ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
     }
+    return hash;
+}
+
+//---------------------------------------------------------------------------
+//	描画
+//---------------------------------------------------------------------------
+void GAME_render()
+{
+    PROFILE_FUNCTION();
+
+    const RenderSnapshot& snapshot = snapshots[write_index ^ 1];
+
+    // 前回と今回の更新結果を、その更新を行ったフレームの補間係数で補間して描画する
+    float3 draw_position        = lerp(snapshot.player_position[0], snapshot.player_position[1], snapshot.alpha);
+    float3 draw_appearrance_dir = normalize(lerp(snapshot.player_facing[0], snapshot.player_facing[1], snapshot.alpha));
+
+    // カメラ設定 (更新スレッドのカメラとは別インスタンス)
+    Camera render_camera;
+    render_camera.setPosition(draw_position + snapshot.camera_dir * snapshot.camera_distance);
+    render_camera.setLookAt(draw_position);
+    render_camera.update();
+
+    Frustum render_frustum = render_camera.getFrustum();   // 視錐台カリング用
+    //----------------------------------------------------------
+    // 座標更新
+    //----------------------------------------------------------
+    // 投影行列（画角 (FOV)、アスペクト比、nearZ, farZ) はカメラで設定
+    RENDER_setProjectionMatrix(render_camera.getProjMatrix());
+    RENDER_setViewMatrix(render_camera.getViewMatrix());
+    RENDER_setWorldMatrix(matrix::identity());
 
     //-------------------------------------------------------------
     // 描画
@@ -308,7 +615,15 @@ void GAME_update()
 
     //---- 画面クリア
     // 描画の開始のためにバックバッファとＺバッファを初期化します
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    RENDER_clear(Color(64, 64, 64));
+
+    //---- 遮蔽物を描画してHi-Zを作成 (以降の描画前に判定するため)
+    {
+        PROFILE_ZONE("occlusion");
+        occlusion_culler.beginFrame(mul(render_camera.getViewMatrix(), render_camera.getProjMatrix()));
+        occlusion_culler.drawOccluder(quad_vertices, quad_indices, matrix::identity());
+        occlusion_culler.buildHiZ();
+    }
 
 #if 0
     //---- 三角形を描画
@@ -354,82 +669,13 @@ void GAME_update()
     glEnd();
 #endif
 
-    static float3 dir = float3(0.0f, 0.0f, 1.0f);   // プレイヤーが向いている方向（内部的）
-    static float3 appearrance_dir = float3(0.0f, 0.0f, 1.0f);   // プレイヤーが向いている方向 (見た目)
-
-    //カメラの向きを取得, moving based on camera look
-
-    matrix mat_camera_world = camera.getWorldMatrix();
-    float3 dir_right        = mat_camera_world[0].xyz;   //base matrix conversion to xyz
-    float3 dir_up           = mat_camera_world[1].xyz;   //base matrix conversion to xyz
-    float3 dir_backward     = mat_camera_world[2].xyz;   //base matrix conversion to xyz
-
-    dir_backward.y = 0.0f;   //spaceship movement if y is not restricted
-    dir_backward   = normalize(dir_backward);
-
-    dir_up = cross(dir_backward, dir_right);   //get cross data, recalculate
-
-    // 移動量
-    float3 move     = float3(0.0f, 0.0f, 0.0f);
-    float3 velocity = float3(0.0f, 0.0f, 0.0f);
-
-    if(GetKeyState(VK_RIGHT) & 0x8000) {
-        //move.x += 1.0f; //move to world movement
-        move += dir_right;   //move to camera pos
-    }
-    if(GetKeyState(VK_LEFT) & 0x8000) {
-        move -= dir_right;
-    }
-    if(GetKeyState(VK_UP) & 0x8000) {
-        move -= dir_backward;
-    }
-    if(GetKeyState(VK_DOWN) & 0x8000) {
-        move += dir_backward;
-    }
-
-    // 移動 puts move to position
-    //  if(!(move.x == 0.0f && move.y == 0.0f && move.z == 0.0f)) {
-    if(dot(move, move) > float1(FLT_EPSILON))   // dot(v, v) = 距離の2乗
-    {
-        dir = normalize(move);
-        position += normalize(move) * 0.1f;
-    }
-
-    //Jump
-    //9.80665 Gravity
-
-    if(GetKeyState(VK_SPACE) & 0x8000) 
-    {
-        exit(0);
-    }
-
-    //Fall speed
-    // gravity acceleration
-    //
-    float G = 9.80665f;   //(m/s ''2) -> m/(s*s)
-
-    // acceleration (m/s)
-    //float delta_t = 1.0f / 60.0f; //過去時間
-    //velocity.y -= G * delta_t;
-
-    velocity.y -= 0.01f;
-
-    position += velocity;
-
-    if(position.y < 0.0f) {
-        position.y = 0.0f;
-        velocity.y = 0.0f;
-    }
-
     //----------------------------------------------------------
     // 四角形をテクスチャつきで描画
     //----------------------------------------------------------
-    glLoadIdentity();   // 元に戻す
-
-    SetTexture(texture);   // glBegin()の外側でのみ変更可
-    glBegin(GL_TRIANGLE_STRIP);
+    RENDER_setTexture(texture);   // RENDER_begin()の外側でのみ変更可
+    RENDER_begin(PrimitiveType::TriangleStrip);
     {
-        glColor3ub(255, 255, 255);
+        RENDER_color(Color(255, 255, 255));
 
         // [0]    [1]
         // +--------+
@@ -438,48 +684,20 @@ void GAME_update()
         // |／      |
         // +--------+
         // [2]    [3]
-        glTexCoord2f(0.0f, 0.0f);
-        glVertex3f(-1, +1, 0);   // 左上
-
-        glTexCoord2f(1.0f, 0.0f);
-        glVertex3f(+1, +1, 0);   // 右上
-
-        glTexCoord2f(0.0f, 1.0f);
-        glVertex3f(-1, -1, 0);   // 左下
-
-        glTexCoord2f(1.0f, 1.0f);
-        glVertex3f(+1, -1, 0);   // 右下
-    }
-    glEnd();
-    SetTexture(nullptr);   // 描画が終わったら元に戻す
-
-    //----------------------------------------------------------
-    // キャラクターの回転補間 Character interpolate rotation
-    //----------------------------------------------------------
-    {
-        // 長さを1.0にすることで計算を簡略化
-        dir             = normalize(dir);
-        appearrance_dir = normalize(appearrance_dir);
+        RENDER_texCoord(0.0f, 0.0f);
+        RENDER_vertex(-1, +1, 0);   // 左上
 
-        // appearrance_dir → dir に追従させる
+        RENDER_texCoord(1.0f, 0.0f);
+        RENDER_vertex(+1, +1, 0);   // 右上
 
-        // 両者のベクトルのなす角を求める
-        float theta = GetAngleBetweenVector(dir, appearrance_dir);
+        RENDER_texCoord(0.0f, 1.0f);
+        RENDER_vertex(-1, -1, 0);   // 左下
 
-        // 回転軸を求める
-        // 両者のベクトルで外積を求めると、180度の方向を起点にベクトルの向きが変わる
-        // この軸ベクトルを中心に回転すると最短方向で回転できる
-        float3 axis = float3(0.0f, 1.0f, 0.0f);
-
-        float3 c = cross(appearrance_dir, dir);
-        if(float1(FLT_EPSILON) < dot(c, c)) {   // cの長さが0.0になった場合は適用しないようにする
-            axis = normalize(c);
-        }
-
-        // 軸中心に回転させる
-        matrix rotY     = matrix::rotateAxis(axis, theta * 0.1f);
-        appearrance_dir = mul(float4(appearrance_dir, 0.0f), rotY).xyz;
+        RENDER_texCoord(1.0f, 1.0f);
+        RENDER_vertex(+1, -1, 0);   // 右下
     }
+    RENDER_end();
+    RENDER_setTexture(TextureHandle{});   // 描画が終わったら元に戻す
 
     //----------------------------------------------------------
     // ピラミッドの位置やスケール回転を指定
@@ -489,17 +707,15 @@ void GAME_update()
     //m = mul(m, matrix::rotateZ(PI * 0.25f));    // Z軸中心に45度
     //m = mul(m, matrix::translate(position));   // 5m右へ移動
 
-    float3 axisZ = appearrance_dir;   // 表示用方向
-    float3 axisX = normalize(cross(axisZ, float3(0.0f, 1.0f, 0.0f)));
-    float3 axisY = normalize(cross(axisX, axisZ));
+    // 表示用方向をZ軸にした行列 (エンティティのワールド行列と同じ作り方)
+    m = ENTITY_makeTransform(draw_appearrance_dir, draw_position);
 
-    // 作成した軸情報と位置情報で行列に直接代入して作成する
-    m._11_12_13_14 = float4(axisX, 0.0f);
-    m._21_22_23_24 = float4(axisY, 0.0f);
-    m._31_32_33_34 = float4(axisZ, 0.0f);
-    m._41_42_43_44 = float4(position, 1.0f);
+    RENDER_setWorldMatrix(m);
 
-    SetMatrix(m);
+    // 画面外か、四角形の裏に完全に隠れている場合は描画しない
+    AABB pyramid_world_bounds = pyramid_bounds.transform(m);
+    bool pyramid_visible =
+        render_frustum.testAABB(pyramid_world_bounds) && occlusion_culler.testAABB(pyramid_world_bounds);
 
     //---- ピラミッド(Pylamid)を描画
     //     頂上(0, 1, 0)
@@ -510,50 +726,56 @@ void GAME_update()
     //  ---/ - - + - - /---
     //    C-----/-----D
     // (-1, 0, +1)     (+1, 0, +1)
-    glBegin(GL_TRIANGLES);
-    {
-        // 底面
-        glColor3ub(255, 255, 0);
-        glVertex3f(-1, 0, -1);   // A
-        glVertex3f(+1, 0, -1);   // B
-        glVertex3f(-1, 0, +1);   // C
-        glVertex3f(+1, 0, -1);   // B
-        glVertex3f(-1, 0, +1);   // C
-        glVertex3f(+1, 0, +1);   // D
-
-        // 奥側面
-        glColor3ub(255, 255, 255);
-        glVertex3f(-1, 0, -1);   // A
-        glVertex3f(+1, 0, -1);   // B
-        glVertex3f(0, 1, 0);     // E
-
-        // 左側面
-        glColor3ub(0, 0, 255);
-        glVertex3f(-1, 0, -1);   // A
-        glVertex3f(-1, 0, +1);   // C
-        glVertex3f(0, 1, 0);     // E
+    if(pyramid_visible) {
+        PROFILE_ZONE("draw pyramid");
 
-        // 右側面
-        glColor3ub(0, 255, 0);
-        glVertex3f(+1, 0, +1);   // D
-        glVertex3f(+1, 0, -1);   // B
-        glVertex3f(0, 1, 0);     // E
-
-        // 手前側面
-        glColor3ub(255, 0, 0);
-        glVertex3f(-1, 0, +1);   // C
-        glVertex3f(+1, 0, +1);   // D
-        glVertex3f(0, 1, 0);     // E
+        RENDER_begin(PrimitiveType::Triangles);
+        {
+            // 底面
+            RENDER_color(Color(255, 255, 0));
+            RENDER_vertex(-1, 0, -1);   // A
+            RENDER_vertex(+1, 0, -1);   // B
+            RENDER_vertex(-1, 0, +1);   // C
+            RENDER_vertex(+1, 0, -1);   // B
+            RENDER_vertex(-1, 0, +1);   // C
+            RENDER_vertex(+1, 0, +1);   // D
+
+            // 奥側面
+            RENDER_color(Color(255, 255, 255));
+            RENDER_vertex(-1, 0, -1);   // A
+            RENDER_vertex(+1, 0, -1);   // B
+            RENDER_vertex(0, 1, 0);     // E
+
+            // 左側面
+            RENDER_color(Color(0, 0, 255));
+            RENDER_vertex(-1, 0, -1);   // A
+            RENDER_vertex(-1, 0, +1);   // C
+            RENDER_vertex(0, 1, 0);     // E
+
+            // 右側面
+            RENDER_color(Color(0, 255, 0));
+            RENDER_vertex(+1, 0, +1);   // D
+            RENDER_vertex(+1, 0, -1);   // B
+            RENDER_vertex(0, 1, 0);     // E
+
+            // 手前側面
+            RENDER_color(Color(255, 0, 0));
+            RENDER_vertex(-1, 0, +1);   // C
+            RENDER_vertex(+1, 0, +1);   // D
+            RENDER_vertex(0, 1, 0);     // E
+        }
+        RENDER_end();
     }
-    glEnd();
 
-    glLoadIdentity();   // 元に戻す
+    RENDER_setWorldMatrix(matrix::identity());   // 元に戻す
 
     //drawArrow(float3(0, 0, 0), float3(5, 5, -5), Color(255, 0, 0));
     //drawArrow(float3(0, 0, 0), float3(0, 5, 0), Color(255, 0, 255));
 
     // キャラクターの表示行列の軸を表示
     {
+        PROFILE_ZONE("draw arrows");
+
         float3 axis_x = m._11_12_13;
         float3 axis_y = m._21_22_23;
         float3 axis_z = m._31_32_33;
@@ -562,9 +784,11 @@ void GAME_update()
         drawArrow(p, p + axis_x * 2.5f, Color(255, 0, 0));
         drawArrow(p, p + axis_y * 2.5f, Color(0, 255, 0));
         drawArrow(p, p + axis_z * 2.5f, Color(0, 0, 255));
+    }
 
-        drawArrow(p, p + dir * 5.0f, Color(255, 255, 255));             // dir=白
-        drawArrow(p, p + appearrance_dir * 5.0f, Color(255, 0, 255));   // appearrance_dir=マゼンタ
+    // 更新フェーズで登録されたデバッグ矢印
+    for(const DebugArrow& arrow : snapshot.debug_arrows) {
+        drawArrow(arrow.p0, arrow.p1, arrow.color);
     }
 
     // static float t = 0.0f;
@@ -574,35 +798,37 @@ void GAME_update()
     //----------------------------------------------------------
     // グリッドを描画
     //----------------------------------------------------------
+    PROFILE_ZONE("draw grid");
+
     constexpr float SIZE = 64.0f;
 
-    glBegin(GL_LINES);
+    RENDER_begin(PrimitiveType::Lines);
     {
         // X軸
-        glColor3ub(255, 0, 0);
-        glVertex3f(-SIZE, 0.0f, 0.0f);
-        glVertex3f(+SIZE, 0.0f, 0.0f);
+        RENDER_color(Color(255, 0, 0));
+        RENDER_vertex(-SIZE, 0.0f, 0.0f);
+        RENDER_vertex(+SIZE, 0.0f, 0.0f);
 
         // Y軸
-        glColor3ub(0, 255, 0);
-        glVertex3f(0.0f, -SIZE, 0.0f);
-        glVertex3f(0.0f, +SIZE, 0.0f);
+        RENDER_color(Color(0, 255, 0));
+        RENDER_vertex(0.0f, -SIZE, 0.0f);
+        RENDER_vertex(0.0f, +SIZE, 0.0f);
 
         // Z軸
-        glColor3ub(0, 0, 255);
-        glVertex3f(0.0f, 0.0f, -SIZE);
-        glVertex3f(0.0f, 0.0f, +SIZE);
+        RENDER_color(Color(0, 0, 255));
+        RENDER_vertex(0.0f, 0.0f, -SIZE);
+        RENDER_vertex(0.0f, 0.0f, +SIZE);
 
-        glColor3ub(255, 255, 255);   // 白色
+        RENDER_color(Color(255, 255, 255));   // 白色
         for(int i = -64; i <= 64; ++i) {
-            glVertex3f(i, 0.0f, -SIZE);
-            glVertex3f(i, 0.0f, +SIZE);
+            RENDER_vertex(i, 0.0f, -SIZE);
+            RENDER_vertex(i, 0.0f, +SIZE);
 
-            glVertex3f(-SIZE, 0.0f, i);
-            glVertex3f(+SIZE, 0.0f, i);
+            RENDER_vertex(-SIZE, 0.0f, i);
+            RENDER_vertex(+SIZE, 0.0f, i);
         }
     }
-    glEnd();
+    RENDER_end();
 }
 
 //---------------------------------------------------------------------------
@@ -610,5 +836,19 @@ void GAME_update()
 //---------------------------------------------------------------------------
 void GAME_cleanup()
 {
-    texture.reset();   // テクスチャを解放(手動)
+    //---- 更新スレッドを終了
+    if(update_thread.joinable()) {
+        update_quit = true;
+        update_start.release();
+        update_thread.join();
+    }
+
+    occlusion_culler.cleanup();
+    entities = EntityStore();   // clear()は配列の容量を残すため作り直して解放
+
+    ReleaseTexture(texture);   // テクスチャを解放(手動)
+
+    //---- 解放漏れを出力 (General・Frameは各システムが自身の解放まで保持するため対象外)
+    MEMORY_reportLeaks(leak_check_sequence,
+                       MEMORY_tagMask(MemoryTag::Texture) | MEMORY_tagMask(MemoryTag::Geometry) | MEMORY_tagMask(MemoryTag::Math));
 }
@@ -9,8 +9,23 @@
 //!	@retval	false	エラー終了	（失敗）
 bool GAME_setup();
 
-//!	更新
-void GAME_update();
+//!	更新開始
+//!	入力を渡し、更新スレッドで固定タイムステップの更新を開始します。
+//!	@param	[in]	input	1フレーム分の入力 (1回の更新時間と更新回数を含む)
+void GAME_beginUpdate(const InputFrame& input);
+
+//!	更新完了待ち
+//!	更新結果の描画スナップショットを次フレームの描画対象にします。
+void GAME_endUpdate();
+
+//!	更新結果のハッシュ値を取得 (入力の再生が記録時と同じ結果になったかの確認用)
+//!	GAME_endUpdate()の後に呼び出します。
+u32 GAME_getStateHash();
+
+//!	描画
+//!	前フレームの更新結果 (描画スナップショット) を描画します。更新と並行して呼び出し可能です。
+//!	補間係数はその更新を開始したフレームの入力の値 (スナップショットに保存) を使用します。
+void GAME_render();
 
 //!	解放
 void GAME_cleanup();
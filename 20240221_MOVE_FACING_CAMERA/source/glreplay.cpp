@@ -0,0 +1,488 @@
+﻿//===========================================================================
+//!	@file	glreplay.cpp
+//!	@brief	OpenGLのコマンドログをソフトウェアラスタライザーで再生
+//!
+//!	OpenGLとWin32の関数は呼び出しません (GL_*の定数と標準ライブラリのみ使用)。
+//===========================================================================
+#include <type_traits>
+#include <unordered_map>
+
+namespace
+{
+//===========================================================================
+//! コマンドログの読み出し
+//===========================================================================
+class LogReader
+{
+public:
+    //! コンストラクタ
+    LogReader(const u8* data, size_t size)
+        : data_(data)
+        , end_(data + size)
+    {
+    }
+
+    //! 値を読み出し
+    template<typename T>
+    T read()
+    {
+        T value{};
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    //! データを読み出し
+    void readBytes(void* out, size_t size)
+    {
+        if(size == 0) {
+            return;
+        }
+        if(size > static_cast<size_t>(end_ - data_)) {
+            failed_ = true;
+            data_   = end_;
+            return;
+        }
+        memcpy(out, data_, size);
+        data_ += size;
+    }
+
+    //! 要素数を読み出し
+    //! 負の値や残りのデータに収まらない値は、確保する前に失敗として扱う (壊れたログで巨大な確保をしないため)
+    //! @param  [in]    element_size    1要素のバイト数
+    //! @return 要素数 (失敗時は0)
+    template<typename T>
+    size_t readCount(size_t element_size)
+    {
+        T    count = read<T>();
+        bool valid = !failed_;
+        if constexpr(std::is_signed_v<T>) {
+            valid = valid && count >= 0;
+        }
+        if(!valid || static_cast<size_t>(count) > static_cast<size_t>(end_ - data_) / element_size) {
+            failed_ = true;
+            data_   = end_;
+            return 0;
+        }
+        return static_cast<size_t>(count);
+    }
+
+    //! 可変長のデータ (バイト数 + 内容) を読み出し
+    std::vector<u8> readData()
+    {
+        std::vector<u8> data(readCount<u32>(1));
+        readBytes(data.data(), data.size());
+        return data;
+    }
+
+    //! 最後まで読んだかどうか
+    bool isEnd() const { return data_ >= end_; }
+
+    //! 途中で終わっていたかどうか
+    bool isFailed() const { return failed_; }
+
+private:
+    const u8* data_;             //!< 読み出し位置
+    const u8* end_;              //!< 終端
+    bool      failed_ = false;   //!< データが足りなかったかどうか
+};
+
+//===========================================================================
+//! 固定機能の状態を再現して描画
+//===========================================================================
+class Replayer
+{
+public:
+    //! コンストラクタ
+    explicit Replayer(SoftwareRasterizer& rasterizer)
+        : rasterizer_(rasterizer)
+    {
+    }
+
+    //! 1命令を実行
+    //! @retval true    実行した
+    //! @retval false   不明な命令
+    bool execute(GlCall call, LogReader& reader);
+
+private:
+    //! 現在の行列スタック
+    std::vector<matrix>& getMatrixStack() { return (matrix_mode_ == GL_PROJECTION) ? projection_stack_ : modelview_stack_; }
+
+    //! 現在の行列に掛ける (glMultMatrix()と同じく後から掛けた行列が先に頂点に適用される)
+    void multiply(const matrix& m) { getMatrixStack().back() = mul(m, getMatrixStack().back()); }
+
+    //! 頂点を登録
+    void addVertex(const float3& position);
+
+    //! glEnd()までの頂点をプリミティブに組み立てて描画
+    void drawPrimitive();
+
+private:
+    //! glPushAttrib()で保存する状態
+    struct Attrib
+    {
+        bool  texture_enabled_;   //!< テクスチャが有効かどうか
+        Color color_;             //!< 頂点カラー
+    };
+
+    SoftwareRasterizer& rasterizer_;   //!< 描画先
+
+    std::vector<matrix> projection_stack_{matrix::identity()};   //!< 投影行列のスタック
+    std::vector<matrix> modelview_stack_{matrix::identity()};    //!< モデルビュー行列のスタック
+    GLenum              matrix_mode_ = GL_MODELVIEW;             //!< 変更する行列
+    matrix              mat_mvp_     = matrix::identity();       //!< glBegin()時のモデルビュー×投影
+
+    GLenum                    primitive_ = GL_TRIANGLES;               //!< 組み立て中のプリミティブ
+    std::vector<RasterVertex> vertices_;                               //!< 組み立て中の頂点
+    Color                     color_       = Color(255, 255, 255);   //!< 頂点カラー
+    f32                       u_           = 0.0f;                   //!< テクスチャ座標U
+    f32                       v_           = 0.0f;                   //!< テクスチャ座標V
+    Color                     clear_color_ = Color(0, 0, 0);         //!< クリアカラー
+
+    std::unordered_map<GLuint, SampledTexture> textures_;                  //!< テクスチャ (IDで参照)
+    GLuint                                     bound_texture_   = 0;       //!< 設定中のテクスチャID
+    bool                                       texture_enabled_ = false;   //!< テクスチャが有効かどうか
+
+    std::vector<Attrib> attrib_stack_;   //!< glPushAttrib()で保存した状態
+};
+
+//---------------------------------------------------------------------------
+//! 頂点を登録
+//---------------------------------------------------------------------------
+void Replayer::addVertex(const float3& position)
+{
+    float4 p = mul(float4(position, 1.0f), mat_mvp_);
+    vertices_.push_back(RasterVertex{p.x, p.y, p.z, p.w, u_, v_, color_});
+}
+
+//---------------------------------------------------------------------------
+//! glEnd()までの頂点をプリミティブに組み立てて描画
+//---------------------------------------------------------------------------
+void Replayer::drawPrimitive()
+{
+    const SampledTexture* texture = nullptr;
+    if(texture_enabled_) {
+        auto it = textures_.find(bound_texture_);
+        if(it != textures_.end() && !it->second.empty()) {
+            texture = &it->second;
+        }
+    }
+    rasterizer_.setTexture(texture);
+
+    const std::vector<RasterVertex>& v     = vertices_;
+    s32                              count = static_cast<s32>(v.size());
+    switch(primitive_) {
+    case GL_LINES:
+        for(s32 i = 0; i + 1 < count; i += 2) {
+            rasterizer_.drawLine(v[i], v[i + 1]);
+        }
+        break;
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+        for(s32 i = 0; i + 1 < count; ++i) {
+            rasterizer_.drawLine(v[i], v[i + 1]);
+        }
+        if(primitive_ == GL_LINE_LOOP && count > 2) {
+            rasterizer_.drawLine(v[count - 1], v[0]);
+        }
+        break;
+    case GL_TRIANGLES:
+        for(s32 i = 0; i + 2 < count; i += 3) {
+            rasterizer_.drawTriangle(v[i], v[i + 1], v[i + 2]);
+        }
+        break;
+    case GL_TRIANGLE_STRIP:
+        // 奇数番目の三角形は頂点順を入れ替えて向きをそろえる (render.cppと同じ)
+        for(s32 i = 0; i + 2 < count; ++i) {
+            if(i & 1) {
+                rasterizer_.drawTriangle(v[i + 1], v[i], v[i + 2]);
+            }
+            else {
+                rasterizer_.drawTriangle(v[i], v[i + 1], v[i + 2]);
+            }
+        }
+        break;
+    case GL_TRIANGLE_FAN:
+    case GL_POLYGON:
+        for(s32 i = 1; i + 1 < count; ++i) {
+            rasterizer_.drawTriangle(v[0], v[i], v[i + 1]);
+        }
+        break;
+    case GL_QUADS:
+        for(s32 i = 0; i + 3 < count; i += 4) {
+            rasterizer_.drawTriangle(v[i], v[i + 1], v[i + 2]);
+            rasterizer_.drawTriangle(v[i], v[i + 2], v[i + 3]);
+        }
+        break;
+    default:   // 点などは描画しない
+        break;
+    }
+    vertices_.clear();
+}
+
+//---------------------------------------------------------------------------
+//! 1命令を実行
+//---------------------------------------------------------------------------
+bool Replayer::execute(GlCall call, LogReader& reader)
+{
+    switch(call) {
+    //---- 頂点
+    case GlCall::Begin:
+        primitive_ = reader.read<GLenum>();
+        mat_mvp_   = mul(modelview_stack_.back(), projection_stack_.back());
+        vertices_.clear();
+        break;
+    case GlCall::End:
+        drawPrimitive();
+        break;
+    case GlCall::Vertex2f:
+        {
+            f32 x = reader.read<f32>();
+            f32 y = reader.read<f32>();
+            addVertex(float3(x, y, 0.0f));
+        }
+        break;
+    case GlCall::Vertex3fv:
+        {
+            f32 x = reader.read<f32>();
+            f32 y = reader.read<f32>();
+            f32 z = reader.read<f32>();
+            addVertex(float3(x, y, z));
+        }
+        break;
+    case GlCall::Color3ub:
+    case GlCall::Color4ub:
+    case GlCall::Color4ubv:
+        color_.r_ = reader.read<u8>();
+        color_.g_ = reader.read<u8>();
+        color_.b_ = reader.read<u8>();
+        color_.a_ = (call == GlCall::Color3ub) ? 255 : reader.read<u8>();
+        break;
+    case GlCall::TexCoord2f:
+        u_ = reader.read<f32>();
+        v_ = reader.read<f32>();
+        break;
+
+    //---- 行列
+    case GlCall::MatrixMode:
+        matrix_mode_ = reader.read<GLenum>();
+        break;
+    case GlCall::LoadIdentity:
+        getMatrixStack().back() = matrix::identity();
+        break;
+    case GlCall::LoadMatrixf:
+        {
+            f32 m[16];
+            reader.readBytes(m, sizeof(m));
+            getMatrixStack().back() = matrix(float4(m[0], m[1], m[2], m[3]),
+                                             float4(m[4], m[5], m[6], m[7]),
+                                             float4(m[8], m[9], m[10], m[11]),
+                                             float4(m[12], m[13], m[14], m[15]));
+        }
+        break;
+    case GlCall::PushMatrix:
+        getMatrixStack().push_back(getMatrixStack().back());
+        break;
+    case GlCall::PopMatrix:
+        if(getMatrixStack().size() > 1) {
+            getMatrixStack().pop_back();
+        }
+        break;
+    case GlCall::Ortho:
+        {
+            f32 l = static_cast<f32>(reader.read<f64>());
+            f32 r = static_cast<f32>(reader.read<f64>());
+            f32 b = static_cast<f32>(reader.read<f64>());
+            f32 t = static_cast<f32>(reader.read<f64>());
+            f32 n = static_cast<f32>(reader.read<f64>());
+            f32 f = static_cast<f32>(reader.read<f64>());
+            multiply(matrix(float4(2.0f / (r - l), 0.0f, 0.0f, 0.0f),
+                            float4(0.0f, 2.0f / (t - b), 0.0f, 0.0f),
+                            float4(0.0f, 0.0f, -2.0f / (f - n), 0.0f),
+                            float4(-(r + l) / (r - l), -(t + b) / (t - b), -(f + n) / (f - n), 1.0f)));
+        }
+        break;
+
+    //---- 状態 (深度テストとブレンドはラスタライザーに設定がないため無視)
+    case GlCall::Enable:
+    case GlCall::Disable:
+        if(reader.read<GLenum>() == GL_TEXTURE_2D) {
+            texture_enabled_ = (call == GlCall::Enable);
+        }
+        break;
+    case GlCall::BlendFunc:
+        reader.read<GLenum>();
+        reader.read<GLenum>();
+        break;
+    case GlCall::PushAttrib:
+        reader.read<GLbitfield>();
+        attrib_stack_.push_back({texture_enabled_, color_});
+        break;
+    case GlCall::PopAttrib:
+        if(!attrib_stack_.empty()) {
+            texture_enabled_ = attrib_stack_.back().texture_enabled_;
+            color_           = attrib_stack_.back().color_;
+            attrib_stack_.pop_back();
+        }
+        break;
+
+    //---- 画面クリア
+    case GlCall::Clear:
+        if(reader.read<GLbitfield>() & GL_COLOR_BUFFER_BIT) {
+            rasterizer_.clear(clear_color_);
+        }
+        break;
+    case GlCall::ClearColor:
+        {
+            auto toU8 = [](f32 c) { return static_cast<u8>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f); };
+
+            f32 r        = reader.read<f32>();
+            f32 g        = reader.read<f32>();
+            f32 b        = reader.read<f32>();
+            f32 a        = reader.read<f32>();
+            clear_color_ = Color(toU8(r), toU8(g), toU8(b), toU8(a));
+        }
+        break;
+    case GlCall::ClearDepth:
+        reader.read<f64>();   // 常に1.0fでクリア
+        break;
+
+    //---- テクスチャ
+    case GlCall::GenTextures:
+        {
+            std::vector<GLuint> ids(reader.readCount<GLsizei>(sizeof(GLuint)));
+            reader.readBytes(ids.data(), ids.size() * sizeof(GLuint));
+        }
+        break;
+    case GlCall::DeleteTextures:
+        {
+            std::vector<GLuint> ids(reader.readCount<GLsizei>(sizeof(GLuint)));
+            reader.readBytes(ids.data(), ids.size() * sizeof(GLuint));
+            for(GLuint id : ids) {
+                textures_.erase(id);
+            }
+        }
+        break;
+    case GlCall::BindTexture:
+        reader.read<GLenum>();
+        bound_texture_ = reader.read<GLuint>();
+        break;
+    case GlCall::TexParameteri:
+        reader.read<GLenum>();
+        reader.read<GLenum>();
+        reader.read<GLint>();
+        break;
+    case GlCall::TexImage2D:
+        {
+            // target, level, internal_format, width, height, border, format, type, 画像
+            reader.read<GLenum>();
+            GLint level = reader.read<GLint>();
+            reader.read<GLint>();
+            GLsizei width  = reader.read<GLsizei>();
+            GLsizei height = reader.read<GLsizei>();
+            reader.read<GLint>();
+            reader.read<GLenum>();
+            reader.read<GLenum>();
+            std::vector<u8> pixels = reader.readData();
+
+            // RGBA8の0段目のみ (ミップマップはSampledTextureが作成する)
+            // 負の大きさは積が折り返して画像の大きさと一致しうるため先に除外する
+            if(level == 0 && width > 0 && height > 0 && pixels.size() == static_cast<size_t>(width) * height * sizeof(Color)) {
+                std::vector<Color> image(static_cast<size_t>(width) * height);
+                memcpy(image.data(), pixels.data(), pixels.size());
+                textures_[bound_texture_].build(image.data(), width, height);
+            }
+        }
+        break;
+
+    //---- 画像・文字 (ウィンドウへの転送とディスプレイリストは再生しない)
+    case GlCall::PixelStorei:
+        reader.read<GLenum>();
+        reader.read<GLint>();
+        break;
+    case GlCall::RasterPos2f:
+        reader.read<f32>();
+        reader.read<f32>();
+        break;
+    case GlCall::RasterPos2i:
+        reader.read<GLint>();
+        reader.read<GLint>();
+        break;
+    case GlCall::DrawPixels:
+        reader.read<GLsizei>();
+        reader.read<GLsizei>();
+        reader.read<GLenum>();
+        reader.read<GLenum>();
+        break;
+    case GlCall::GenLists:
+        reader.read<GLsizei>();
+        reader.read<GLuint>();
+        break;
+    case GlCall::DeleteLists:
+        reader.read<GLuint>();
+        reader.read<GLsizei>();
+        break;
+    case GlCall::ListBase:
+        reader.read<GLuint>();
+        break;
+    case GlCall::CallLists:
+        reader.read<GLsizei>();
+        reader.read<GLenum>();
+        reader.readData();
+        break;
+
+    default:
+        return false;
+    }
+    return true;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! コマンドログをソフトウェアラスタライザーで再生
+//---------------------------------------------------------------------------
+s32 GLTRACE_replay(const char* path, SoftwareRasterizer& rasterizer, const std::function<void(s32)>& on_frame)
+{
+    //---- ファイルを読み込み
+    FILE* file = fopen(path, "rb");   // Win32に依存しないよう標準のfopen()を使う
+    if(file == nullptr) {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    std::vector<u8> data(std::max(size, 0l));
+    bool            read_ok = fread(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+
+    GlTraceHeader header;
+    if(!read_ok || data.size() < sizeof(header)) {
+        return -1;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if(memcmp(header.magic_, GlTraceHeader().magic_, sizeof(header.magic_)) != 0 || header.version_ != GlTraceHeader::VERSION) {
+        return -1;
+    }
+    if(!rasterizer.setup(header.width_, header.height_)) {
+        return -1;
+    }
+
+    //---- 1命令ずつ再生 (不明な命令や途中で終わっている場合はそこまで)
+    LogReader reader(data.data() + sizeof(header), data.size() - sizeof(header));
+    Replayer  replayer(rasterizer);
+
+    s32 frame_count = 0;
+    while(!reader.isEnd()) {
+        GlCall call = static_cast<GlCall>(reader.read<u8>());
+        if(call == GlCall::FrameEnd) {
+            rasterizer.flush();
+            on_frame(frame_count++);
+            continue;
+        }
+        if(!replayer.execute(call, reader) || reader.isFailed()) {
+            break;
+        }
+    }
+    return frame_count;
+}
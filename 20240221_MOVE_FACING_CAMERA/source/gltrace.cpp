@@ -0,0 +1,535 @@
+﻿//===========================================================================
+//!	@file	gltrace.cpp
+//!	@brief	OpenGL呼び出しの計測・記録
+//!
+//!	gl*()はgltrace.hのマクロで置き換わるため、本来の関数は
+//!	(glBegin)(mode) のように関数名を括弧で囲んで呼び出します。
+//!
+//!	テクスチャとディスプレイリストの番号はドライバーが決めるため、
+//!	コマンドログには記録開始からの連番に置き換えて書き込みます。
+//===========================================================================
+#include <unordered_map>
+
+namespace
+{
+constexpr s32 CALL_COUNT   = static_cast<s32>(GlCall::Count);   //!< 計測する関数の数
+constexpr u64 MAX_LOG_SIZE = 512ull << 20;                      //!< コマンドログの上限 (これを超えたフレームで記録を止める)
+
+//! 関数名
+constexpr const char* call_names[CALL_COUNT]{
+#define GLTRACE_NAME(name) "gl" #name,
+    GLTRACE_CALLS(GLTRACE_NAME)
+#undef GLTRACE_NAME
+};
+
+u32 frame_counts[CALL_COUNT] = {};   //!< 集計中のフレームの呼び出し回数
+u64 frame_ticks[CALL_COUNT]  = {};   //!< 集計中のフレームの処理時間 (TSC)
+u32 last_counts[CALL_COUNT]  = {};   //!< 直前のフレームの呼び出し回数
+u64 last_ticks[CALL_COUNT]   = {};   //!< 直前のフレームの処理時間 (TSC)
+
+std::vector<u8> log_data;               //!< コマンドログ
+bool            recording     = false;   //!< コマンドを書き込み中かどうか
+bool            record_opened = false;   //!< GLTRACE_beginRecord()～GLTRACE_endRecord()の間かどうか
+
+std::unordered_map<GLuint, GLuint> texture_ids;      //!< テクスチャIDとコマンドログでの番号
+GLuint                             first_list = 0;   //!< 記録開始後に最初に作成したディスプレイリスト
+
+//---------------------------------------------------------------------------
+//! 本来の関数を呼び出して回数と時間を集計
+//---------------------------------------------------------------------------
+template<typename F>
+void invoke(GlCall call, const F& function)
+{
+    u64 begin = PROFILE_now();
+    function();
+    u64 end = PROFILE_now();
+
+    s32 index = static_cast<s32>(call);
+    frame_counts[index]++;
+    frame_ticks[index] += end - begin;
+}
+
+//---------------------------------------------------------------------------
+//! コマンドログにデータを追加
+//---------------------------------------------------------------------------
+void writeBytes(const void* data, size_t size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    log_data.insert(log_data.end(), bytes, bytes + size);
+}
+
+//---------------------------------------------------------------------------
+//! コマンドログに命令番号と引数を追加
+//---------------------------------------------------------------------------
+template<typename... Args>
+void record(GlCall call, const Args&... args)
+{
+    log_data.push_back(static_cast<u8>(call));
+    (writeBytes(&args, sizeof(args)), ...);
+}
+
+//---------------------------------------------------------------------------
+//! コマンドログに可変長のデータ (バイト数 + 内容) を追加
+//---------------------------------------------------------------------------
+void recordData(const void* data, u32 size)
+{
+    writeBytes(&size, sizeof(size));
+    if(size > 0) {
+        writeBytes(data, size);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャIDをコマンドログでの番号に変換 (初めて現れた順に1から)
+//---------------------------------------------------------------------------
+GLuint toLogTexture(GLuint id)
+{
+    if(id == 0) {
+        return 0;
+    }
+    auto [it, inserted] = texture_ids.try_emplace(id, static_cast<GLuint>(texture_ids.size() + 1));
+    return it->second;
+}
+
+//---------------------------------------------------------------------------
+//! ディスプレイリストの番号をコマンドログでの番号に変換 (記録開始後に最初に作成したものを1)
+//---------------------------------------------------------------------------
+GLuint toLogList(GLuint list)
+{
+    return list - first_list + 1;
+}
+
+//---------------------------------------------------------------------------
+//! RGBA8の画像のバイト数 (それ以外の形式は記録しないため0)
+//---------------------------------------------------------------------------
+u32 getImageSize(GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels)
+{
+    if(pixels == nullptr || format != GL_RGBA || type != GL_UNSIGNED_BYTE) {
+        return 0;
+    }
+    return static_cast<u32>(width) * static_cast<u32>(height) * 4;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void GLTRACE_endFrame()
+{
+    std::copy(std::begin(frame_counts), std::end(frame_counts), last_counts);
+    std::copy(std::begin(frame_ticks), std::end(frame_ticks), last_ticks);
+    std::fill(std::begin(frame_counts), std::end(frame_counts), 0);
+    std::fill(std::begin(frame_ticks), std::end(frame_ticks), 0);
+
+    if(recording) {
+        log_data.push_back(static_cast<u8>(GlCall::FrameEnd));
+
+        // フレームの区切りで止めるため再生側は途中のフレームを扱わなくてよい
+        if(log_data.size() >= MAX_LOG_SIZE) {
+            recording = false;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 関数ごとの統計を取得
+//---------------------------------------------------------------------------
+std::vector<GlCallStats> GLTRACE_getStats()
+{
+    std::vector<GlCallStats> result;
+    for(s32 i = 0; i < CALL_COUNT; ++i) {
+        if(last_counts[i] == 0) {
+            continue;
+        }
+        GlCallStats stats;
+        stats.name_    = call_names[i];
+        stats.count_   = last_counts[i];
+        stats.time_ms_ = PROFILE_toMilliseconds(last_ticks[i]);
+        result.push_back(stats);
+    }
+    std::sort(result.begin(), result.end(), [](const GlCallStats& a, const GlCallStats& b) { return a.count_ > b.count_; });
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! 直前のフレームの全関数の呼び出し回数を取得
+//---------------------------------------------------------------------------
+u32 GLTRACE_getCallCount()
+{
+    u32 count = 0;
+    for(u32 calls : last_counts) {
+        count += calls;
+    }
+    return count;
+}
+
+//---------------------------------------------------------------------------
+//! 統計を表形式のテキストで出力
+//---------------------------------------------------------------------------
+void GLTRACE_printStats(FILE* file)
+{
+    fprintf(file, "%-20s %9s %9s\n", "gl call", "count", "ms");
+    for(const GlCallStats& stats : GLTRACE_getStats()) {
+        fprintf(file, "%-20s %9u %9.3f\n", stats.name_, stats.count_, stats.time_ms_);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! コマンドログの記録を開始
+//---------------------------------------------------------------------------
+void GLTRACE_beginRecord(s32 width, s32 height)
+{
+    GlTraceHeader header;
+    header.width_  = width;
+    header.height_ = height;
+
+    log_data.clear();
+    texture_ids.clear();
+    first_list = 0;
+    writeBytes(&header, sizeof(header));
+    recording     = true;
+    record_opened = true;
+}
+
+//---------------------------------------------------------------------------
+//! コマンドログの記録を終了してファイルに保存
+//---------------------------------------------------------------------------
+bool GLTRACE_endRecord(const char* path)
+{
+    recording     = false;
+    record_opened = false;
+
+    FILE* file = nullptr;
+    fopen_s(&file, path, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+    bool result = fwrite(log_data.data(), 1, log_data.size(), file) == log_data.size();
+    fclose(file);
+
+    log_data.clear();
+    log_data.shrink_to_fit();
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! 記録中かどうか
+//---------------------------------------------------------------------------
+bool GLTRACE_isRecording()
+{
+    return record_opened;
+}
+
+//===========================================================================
+// 計測用の関数
+//===========================================================================
+
+void GLTRACE_glBegin(GLenum mode)
+{
+    invoke(GlCall::Begin, [&] { (glBegin)(mode); });
+    if(recording) {
+        record(GlCall::Begin, mode);
+    }
+}
+
+void GLTRACE_glEnd()
+{
+    invoke(GlCall::End, [&] { (glEnd)(); });
+    if(recording) {
+        record(GlCall::End);
+    }
+}
+
+void GLTRACE_glVertex2f(GLfloat x, GLfloat y)
+{
+    invoke(GlCall::Vertex2f, [&] { (glVertex2f)(x, y); });
+    if(recording) {
+        record(GlCall::Vertex2f, x, y);
+    }
+}
+
+void GLTRACE_glVertex3fv(const GLfloat* v)
+{
+    invoke(GlCall::Vertex3fv, [&] { (glVertex3fv)(v); });
+    if(recording) {
+        record(GlCall::Vertex3fv, v[0], v[1], v[2]);
+    }
+}
+
+void GLTRACE_glColor3ub(GLubyte red, GLubyte green, GLubyte blue)
+{
+    invoke(GlCall::Color3ub, [&] { (glColor3ub)(red, green, blue); });
+    if(recording) {
+        record(GlCall::Color3ub, red, green, blue);
+    }
+}
+
+void GLTRACE_glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+{
+    invoke(GlCall::Color4ub, [&] { (glColor4ub)(red, green, blue, alpha); });
+    if(recording) {
+        record(GlCall::Color4ub, red, green, blue, alpha);
+    }
+}
+
+void GLTRACE_glColor4ubv(const GLubyte* v)
+{
+    invoke(GlCall::Color4ubv, [&] { (glColor4ubv)(v); });
+    if(recording) {
+        record(GlCall::Color4ubv, v[0], v[1], v[2], v[3]);
+    }
+}
+
+void GLTRACE_glTexCoord2f(GLfloat s, GLfloat t)
+{
+    invoke(GlCall::TexCoord2f, [&] { (glTexCoord2f)(s, t); });
+    if(recording) {
+        record(GlCall::TexCoord2f, s, t);
+    }
+}
+
+void GLTRACE_glMatrixMode(GLenum mode)
+{
+    invoke(GlCall::MatrixMode, [&] { (glMatrixMode)(mode); });
+    if(recording) {
+        record(GlCall::MatrixMode, mode);
+    }
+}
+
+void GLTRACE_glLoadIdentity()
+{
+    invoke(GlCall::LoadIdentity, [&] { (glLoadIdentity)(); });
+    if(recording) {
+        record(GlCall::LoadIdentity);
+    }
+}
+
+void GLTRACE_glLoadMatrixf(const GLfloat* m)
+{
+    invoke(GlCall::LoadMatrixf, [&] { (glLoadMatrixf)(m); });
+    if(recording) {
+        record(GlCall::LoadMatrixf);
+        writeBytes(m, sizeof(GLfloat) * 16);
+    }
+}
+
+void GLTRACE_glPushMatrix()
+{
+    invoke(GlCall::PushMatrix, [&] { (glPushMatrix)(); });
+    if(recording) {
+        record(GlCall::PushMatrix);
+    }
+}
+
+void GLTRACE_glPopMatrix()
+{
+    invoke(GlCall::PopMatrix, [&] { (glPopMatrix)(); });
+    if(recording) {
+        record(GlCall::PopMatrix);
+    }
+}
+
+void GLTRACE_glOrtho(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_z, GLdouble far_z)
+{
+    invoke(GlCall::Ortho, [&] { (glOrtho)(left, right, bottom, top, near_z, far_z); });
+    if(recording) {
+        record(GlCall::Ortho, left, right, bottom, top, near_z, far_z);
+    }
+}
+
+void GLTRACE_glEnable(GLenum cap)
+{
+    invoke(GlCall::Enable, [&] { (glEnable)(cap); });
+    if(recording) {
+        record(GlCall::Enable, cap);
+    }
+}
+
+void GLTRACE_glDisable(GLenum cap)
+{
+    invoke(GlCall::Disable, [&] { (glDisable)(cap); });
+    if(recording) {
+        record(GlCall::Disable, cap);
+    }
+}
+
+void GLTRACE_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    invoke(GlCall::BlendFunc, [&] { (glBlendFunc)(sfactor, dfactor); });
+    if(recording) {
+        record(GlCall::BlendFunc, sfactor, dfactor);
+    }
+}
+
+void GLTRACE_glClear(GLbitfield mask)
+{
+    invoke(GlCall::Clear, [&] { (glClear)(mask); });
+    if(recording) {
+        record(GlCall::Clear, mask);
+    }
+}
+
+void GLTRACE_glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+    invoke(GlCall::ClearColor, [&] { (glClearColor)(red, green, blue, alpha); });
+    if(recording) {
+        record(GlCall::ClearColor, red, green, blue, alpha);
+    }
+}
+
+void GLTRACE_glClearDepth(GLclampd depth)
+{
+    invoke(GlCall::ClearDepth, [&] { (glClearDepth)(depth); });
+    if(recording) {
+        record(GlCall::ClearDepth, depth);
+    }
+}
+
+void GLTRACE_glGenTextures(GLsizei n, GLuint* textures)
+{
+    invoke(GlCall::GenTextures, [&] { (glGenTextures)(n, textures); });
+    if(recording) {
+        // 作成されたIDも記録 (再生時のテクスチャの対応付け用)
+        record(GlCall::GenTextures, n);
+        for(GLsizei i = 0; i < n; ++i) {
+            GLuint id = toLogTexture(textures[i]);
+            writeBytes(&id, sizeof(id));
+        }
+    }
+}
+
+void GLTRACE_glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    invoke(GlCall::DeleteTextures, [&] { (glDeleteTextures)(n, textures); });
+    if(recording) {
+        // 削除したIDは再利用されるため対応を解除 (次に現れた時は新しい番号)
+        record(GlCall::DeleteTextures, n);
+        for(GLsizei i = 0; i < n; ++i) {
+            GLuint id = toLogTexture(textures[i]);
+            writeBytes(&id, sizeof(id));
+            texture_ids.erase(textures[i]);
+        }
+    }
+}
+
+void GLTRACE_glBindTexture(GLenum target, GLuint texture)
+{
+    invoke(GlCall::BindTexture, [&] { (glBindTexture)(target, texture); });
+    if(recording) {
+        record(GlCall::BindTexture, target, toLogTexture(texture));
+    }
+}
+
+void GLTRACE_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+    invoke(GlCall::TexParameteri, [&] { (glTexParameteri)(target, pname, param); });
+    if(recording) {
+        record(GlCall::TexParameteri, target, pname, param);
+    }
+}
+
+void GLTRACE_glTexImage2D(GLenum        target,
+                          GLint         level,
+                          GLint         internal_format,
+                          GLsizei       width,
+                          GLsizei       height,
+                          GLint         border,
+                          GLenum        format,
+                          GLenum        type,
+                          const GLvoid* pixels)
+{
+    invoke(GlCall::TexImage2D,
+           [&] { (glTexImage2D)(target, level, internal_format, width, height, border, format, type, pixels); });
+    if(recording) {
+        record(GlCall::TexImage2D, target, level, internal_format, width, height, border, format, type);
+        recordData(pixels, getImageSize(width, height, format, type, pixels));
+    }
+}
+
+void GLTRACE_glPixelStorei(GLenum pname, GLint param)
+{
+    invoke(GlCall::PixelStorei, [&] { (glPixelStorei)(pname, param); });
+    if(recording) {
+        record(GlCall::PixelStorei, pname, param);
+    }
+}
+
+void GLTRACE_glRasterPos2f(GLfloat x, GLfloat y)
+{
+    invoke(GlCall::RasterPos2f, [&] { (glRasterPos2f)(x, y); });
+    if(recording) {
+        record(GlCall::RasterPos2f, x, y);
+    }
+}
+
+void GLTRACE_glRasterPos2i(GLint x, GLint y)
+{
+    invoke(GlCall::RasterPos2i, [&] { (glRasterPos2i)(x, y); });
+    if(recording) {
+        record(GlCall::RasterPos2i, x, y);
+    }
+}
+
+void GLTRACE_glDrawPixels(GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels)
+{
+    invoke(GlCall::DrawPixels, [&] { (glDrawPixels)(width, height, format, type, pixels); });
+    if(recording) {
+        // ソフトウェア描画の転送は毎フレーム画面全体になるため画像は記録しない
+        record(GlCall::DrawPixels, width, height, format, type);
+    }
+}
+
+GLuint GLTRACE_glGenLists(GLsizei range)
+{
+    GLuint list = 0;
+    invoke(GlCall::GenLists, [&] { list = (glGenLists)(range); });
+    if(recording) {
+        if(first_list == 0) {
+            first_list = list;
+        }
+        record(GlCall::GenLists, range, toLogList(list));
+    }
+    return list;
+}
+
+void GLTRACE_glDeleteLists(GLuint list, GLsizei range)
+{
+    invoke(GlCall::DeleteLists, [&] { (glDeleteLists)(list, range); });
+    if(recording) {
+        record(GlCall::DeleteLists, toLogList(list), range);
+    }
+}
+
+void GLTRACE_glListBase(GLuint base)
+{
+    invoke(GlCall::ListBase, [&] { (glListBase)(base); });
+    if(recording) {
+        record(GlCall::ListBase, toLogList(base));
+    }
+}
+
+void GLTRACE_glCallLists(GLsizei n, GLenum type, const GLvoid* lists)
+{
+    invoke(GlCall::CallLists, [&] { (glCallLists)(n, type, lists); });
+    if(recording) {
+        record(GlCall::CallLists, n, type);
+        recordData(lists, (type == GL_UNSIGNED_BYTE) ? static_cast<u32>(n) : 0);
+    }
+}
+
+void GLTRACE_glPushAttrib(GLbitfield mask)
+{
+    invoke(GlCall::PushAttrib, [&] { (glPushAttrib)(mask); });
+    if(recording) {
+        record(GlCall::PushAttrib, mask);
+    }
+}
+
+void GLTRACE_glPopAttrib()
+{
+    invoke(GlCall::PopAttrib, [&] { (glPopAttrib)(); });
+    if(recording) {
+        record(GlCall::PopAttrib);
+    }
+}
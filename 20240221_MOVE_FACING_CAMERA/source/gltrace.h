@@ -0,0 +1,240 @@
+﻿//===========================================================================
+//!	@file	gltrace.h
+//!	@brief	OpenGL呼び出しの計測・記録・再生
+//!
+//!	このヘッダー以降のgl*()の呼び出しをマクロで計測用の関数に置き換え、
+//!	関数ごとの1フレームあたりの呼び出し回数と処理時間を集計します。
+//!	記録中は引数をコマンドログに書き出します。コマンドログにはポインタや
+//!	時刻を含めないため、同じ呼び出しからは同じ内容になります。
+//!	記録したコマンドログはソフトウェアラスタライザーで再生できます。
+//!	再生側はOpenGLとWin32を使わないため、他の環境でも解析できます。
+//!
+//! @code
+//!     GLTRACE_beginRecord(width, height);    // OpenGL初期化後 (テクスチャの転送も記録するため)
+//!     for(;;) {
+//!         ...
+//!         OpenGL_swapBuffer();
+//!         GLTRACE_endFrame();                 // 1フレーム分の集計
+//!     }
+//!     GLTRACE_endRecord("gllog.bin");
+//!
+//!     SoftwareRasterizer rasterizer;
+//!     GLTRACE_replay("gllog.bin", rasterizer, [&](s32 frame) { ... });
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! 0にするとgl*()を置き換えない (計測・記録のコードを通らない)
+#ifndef GLTRACE_ENABLE
+#define GLTRACE_ENABLE 1
+#endif
+
+class SoftwareRasterizer;
+
+//! 計測するOpenGLの関数 (X(名前) の形で列挙)
+#define GLTRACE_CALLS(X) \
+    X(Begin)             \
+    X(End)               \
+    X(Vertex2f)          \
+    X(Vertex3fv)         \
+    X(Color3ub)          \
+    X(Color4ub)          \
+    X(Color4ubv)         \
+    X(TexCoord2f)        \
+    X(MatrixMode)        \
+    X(LoadIdentity)      \
+    X(LoadMatrixf)       \
+    X(PushMatrix)        \
+    X(PopMatrix)         \
+    X(Ortho)             \
+    X(Enable)            \
+    X(Disable)           \
+    X(BlendFunc)         \
+    X(Clear)             \
+    X(ClearColor)        \
+    X(ClearDepth)        \
+    X(GenTextures)       \
+    X(DeleteTextures)    \
+    X(BindTexture)       \
+    X(TexParameteri)     \
+    X(TexImage2D)        \
+    X(PixelStorei)       \
+    X(RasterPos2f)       \
+    X(RasterPos2i)       \
+    X(DrawPixels)        \
+    X(GenLists)          \
+    X(DeleteLists)       \
+    X(ListBase)          \
+    X(CallLists)         \
+    X(PushAttrib)        \
+    X(PopAttrib)
+
+//! OpenGLの関数の番号 (コマンドログの命令番号)
+enum class GlCall : u8
+{
+#define GLTRACE_ENUM(name) name,
+    GLTRACE_CALLS(GLTRACE_ENUM)
+#undef GLTRACE_ENUM
+    Count,
+
+    FrameEnd = 0xff,   //!< フレームの区切り (コマンドログのみ)
+};
+
+//! コマンドログのファイルヘッダー (以降は命令番号と引数が続く)
+struct GlTraceHeader
+{
+    static constexpr u32 VERSION = 1;   //!< 形式のバージョン
+
+    char magic_[4] = {'G', 'L', 'T', 'R'};   //!< 識別子
+    u32  version_  = VERSION;                //!< バージョン
+    s32  width_    = 0;                      //!< 画面の幅
+    s32  height_   = 0;                      //!< 画面の高さ
+};
+
+//! 関数ごとの統計 (1フレーム分)
+struct GlCallStats
+{
+    const char* name_    = nullptr;   //!< 関数名
+    u32         count_   = 0;         //!< 呼び出し回数
+    f64         time_ms_ = 0.0;       //!< 処理時間の合計 (単位:ミリ秒)
+};
+
+//===========================================================================
+//! @name 計測
+//===========================================================================
+//!@{
+
+//! フレーム終了 (1フレーム分の集計を確定、画面更新後に呼び出す)
+void GLTRACE_endFrame();
+
+//! 関数ごとの統計を取得 (直前のフレームで呼び出した関数のみ、回数の多い順)
+std::vector<GlCallStats> GLTRACE_getStats();
+
+//! 直前のフレームの全関数の呼び出し回数を取得
+u32 GLTRACE_getCallCount();
+
+//! 統計を表形式のテキストで出力
+//! @param  [in]    file    出力先 (stdoutなど)
+void GLTRACE_printStats(FILE* file);
+
+//!@}
+//===========================================================================
+//! @name 記録・再生
+//===========================================================================
+//!@{
+
+//! コマンドログの記録を開始
+//! @param  [in]    width   画面の幅 (再生時の画面サイズ)
+//! @param  [in]    height  画面の高さ
+void GLTRACE_beginRecord(s32 width, s32 height);
+
+//! コマンドログの記録を終了してファイルに保存
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool GLTRACE_endRecord(const char* path);
+
+//! 記録中かどうか (上限の大きさに達して記録を止めた後も含む)
+bool GLTRACE_isRecording();
+
+//! コマンドログをソフトウェアラスタライザーで再生
+//!
+//! 固定機能の頂点変換・プリミティブの組み立て・テクスチャを再現します。
+//! ブレンド・深度テストの切り替え・文字(ディスプレイリスト)は再生しません。
+//! @param  [in]    path        ファイル名
+//! @param  [in]    rasterizer  再生先 (コマンドログの画面サイズで初期化します)
+//! @param  [in]    on_frame    1フレーム描画するたびに呼び出す関数 (引数はフレーム番号)
+//! @return 再生したフレーム数 (ファイルを読めない場合は-1、不明な命令があればその直前まで再生)
+s32 GLTRACE_replay(const char* path, SoftwareRasterizer& rasterizer, const std::function<void(s32)>& on_frame);
+
+//!@}
+//===========================================================================
+//! @name 計測用の関数 (直接呼び出さずにgl*()を使用)
+//===========================================================================
+//!@{
+
+void   GLTRACE_glBegin(GLenum mode);
+void   GLTRACE_glEnd();
+void   GLTRACE_glVertex2f(GLfloat x, GLfloat y);
+void   GLTRACE_glVertex3fv(const GLfloat* v);
+void   GLTRACE_glColor3ub(GLubyte red, GLubyte green, GLubyte blue);
+void   GLTRACE_glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha);
+void   GLTRACE_glColor4ubv(const GLubyte* v);
+void   GLTRACE_glTexCoord2f(GLfloat s, GLfloat t);
+void   GLTRACE_glMatrixMode(GLenum mode);
+void   GLTRACE_glLoadIdentity();
+void   GLTRACE_glLoadMatrixf(const GLfloat* m);
+void   GLTRACE_glPushMatrix();
+void   GLTRACE_glPopMatrix();
+void   GLTRACE_glOrtho(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_z, GLdouble far_z);
+void   GLTRACE_glEnable(GLenum cap);
+void   GLTRACE_glDisable(GLenum cap);
+void   GLTRACE_glBlendFunc(GLenum sfactor, GLenum dfactor);
+void   GLTRACE_glClear(GLbitfield mask);
+void   GLTRACE_glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+void   GLTRACE_glClearDepth(GLclampd depth);
+void   GLTRACE_glGenTextures(GLsizei n, GLuint* textures);
+void   GLTRACE_glDeleteTextures(GLsizei n, const GLuint* textures);
+void   GLTRACE_glBindTexture(GLenum target, GLuint texture);
+void   GLTRACE_glTexParameteri(GLenum target, GLenum pname, GLint param);
+void   GLTRACE_glTexImage2D(GLenum        target,
+                            GLint         level,
+                            GLint         internal_format,
+                            GLsizei       width,
+                            GLsizei       height,
+                            GLint         border,
+                            GLenum        format,
+                            GLenum        type,
+                            const GLvoid* pixels);
+void   GLTRACE_glPixelStorei(GLenum pname, GLint param);
+void   GLTRACE_glRasterPos2f(GLfloat x, GLfloat y);
+void   GLTRACE_glRasterPos2i(GLint x, GLint y);
+void   GLTRACE_glDrawPixels(GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels);
+GLuint GLTRACE_glGenLists(GLsizei range);
+void   GLTRACE_glDeleteLists(GLuint list, GLsizei range);
+void   GLTRACE_glListBase(GLuint base);
+void   GLTRACE_glCallLists(GLsizei n, GLenum type, const GLvoid* lists);
+void   GLTRACE_glPushAttrib(GLbitfield mask);
+void   GLTRACE_glPopAttrib();
+
+//!@}
+
+#if GLTRACE_ENABLE
+// gltrace.cpp では (glBegin)(mode) のように括弧で囲んで本来の関数を呼び出す
+#define glBegin(mode)                           GLTRACE_glBegin(mode)
+#define glEnd()                                 GLTRACE_glEnd()
+#define glVertex2f(x, y)                        GLTRACE_glVertex2f(x, y)
+#define glVertex3fv(v)                          GLTRACE_glVertex3fv(v)
+#define glColor3ub(r, g, b)                     GLTRACE_glColor3ub(r, g, b)
+#define glColor4ub(r, g, b, a)                  GLTRACE_glColor4ub(r, g, b, a)
+#define glColor4ubv(v)                          GLTRACE_glColor4ubv(v)
+#define glTexCoord2f(s, t)                      GLTRACE_glTexCoord2f(s, t)
+#define glMatrixMode(mode)                      GLTRACE_glMatrixMode(mode)
+#define glLoadIdentity()                        GLTRACE_glLoadIdentity()
+#define glLoadMatrixf(m)                        GLTRACE_glLoadMatrixf(m)
+#define glPushMatrix()                          GLTRACE_glPushMatrix()
+#define glPopMatrix()                           GLTRACE_glPopMatrix()
+#define glOrtho(l, r, b, t, n, f)               GLTRACE_glOrtho(l, r, b, t, n, f)
+#define glEnable(cap)                           GLTRACE_glEnable(cap)
+#define glDisable(cap)                          GLTRACE_glDisable(cap)
+#define glBlendFunc(s, d)                       GLTRACE_glBlendFunc(s, d)
+#define glClear(mask)                           GLTRACE_glClear(mask)
+#define glClearColor(r, g, b, a)                GLTRACE_glClearColor(r, g, b, a)
+#define glClearDepth(depth)                     GLTRACE_glClearDepth(depth)
+#define glGenTextures(n, textures)              GLTRACE_glGenTextures(n, textures)
+#define glDeleteTextures(n, textures)           GLTRACE_glDeleteTextures(n, textures)
+#define glBindTexture(target, texture)          GLTRACE_glBindTexture(target, texture)
+#define glTexParameteri(target, pname, param)   GLTRACE_glTexParameteri(target, pname, param)
+#define glTexImage2D(target, level, internal, w, h, border, format, type, p) \
+    GLTRACE_glTexImage2D(target, level, internal, w, h, border, format, type, p)
+#define glPixelStorei(pname, param)             GLTRACE_glPixelStorei(pname, param)
+#define glRasterPos2f(x, y)                     GLTRACE_glRasterPos2f(x, y)
+#define glRasterPos2i(x, y)                     GLTRACE_glRasterPos2i(x, y)
+#define glDrawPixels(w, h, format, type, p)     GLTRACE_glDrawPixels(w, h, format, type, p)
+#define glGenLists(range)                       GLTRACE_glGenLists(range)
+#define glDeleteLists(list, range)              GLTRACE_glDeleteLists(list, range)
+#define glListBase(base)                        GLTRACE_glListBase(base)
+#define glCallLists(n, type, lists)             GLTRACE_glCallLists(n, type, lists)
+#define glPushAttrib(mask)                      GLTRACE_glPushAttrib(mask)
+#define glPopAttrib()                           GLTRACE_glPopAttrib()
+#endif
@@ -0,0 +1,266 @@
+﻿//===========================================================================
+//!	@file	grid.cpp
+//!	@brief	空間グリッド (動的な物体の近傍検索)
+//===========================================================================
+
+namespace
+{
+constexpr s32 MAX_CELL_COUNT = 1024;   //!< 1辺の最大セル数
+constexpr s32 BATCH_GRAIN    = 1024;   //!< 一括移動で1ジョブが処理する物体数
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+bool SpatialGrid::setup(f32 extent, f32 cell_size)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    cleanup();
+    if(!(extent > 0.0f) || !(cell_size > 0.0f)) {
+        return false;
+    }
+
+    s32 cell_count = static_cast<s32>(std::ceil(extent * 2.0f / cell_size));
+    if(cell_count > MAX_CELL_COUNT) {
+        return false;
+    }
+
+    extent_        = extent;
+    cell_size_     = cell_size;
+    inv_cell_size_ = 1.0f / cell_size;
+    cell_count_    = std::max(cell_count, 1);
+    cells_.resize(cell_count_ * cell_count_);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void SpatialGrid::cleanup()
+{
+    cells_.clear();
+    cells_.shrink_to_fit();
+    objects_.clear();
+    objects_.shrink_to_fit();
+    crossed_.clear();
+    crossed_.shrink_to_fit();
+
+    extent_        = 0.0f;
+    cell_size_     = 0.0f;
+    inv_cell_size_ = 0.0f;
+    cell_count_    = 0;
+    object_count_  = 0;
+    max_radius_    = 0.0f;
+}
+
+//---------------------------------------------------------------------------
+//! 全ての物体を削除
+//---------------------------------------------------------------------------
+void SpatialGrid::clear()
+{
+    for(auto& cell : cells_) {
+        cell.clear();   // 確保済みの領域は次の登録で再利用
+    }
+    objects_.clear();
+    object_count_ = 0;
+    max_radius_   = 0.0f;
+}
+
+//---------------------------------------------------------------------------
+//! 登録
+//---------------------------------------------------------------------------
+void SpatialGrid::insert(u32 id, const float3& position, f32 radius)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    assert(!cells_.empty() && "SpatialGrid::setup() が呼ばれていません");
+    assert(!contains(id) && "登録済みの物体番号です");
+
+    if(id >= objects_.size()) {
+        objects_.resize(id + 1);
+    }
+
+    f32 x = position.x;
+    f32 z = position.z;
+    link(id, getCell(x, z), Entry{x, z, radius, id});
+
+    max_radius_ = std::max(max_radius_, radius);
+    object_count_++;
+}
+
+//---------------------------------------------------------------------------
+//! 移動
+//---------------------------------------------------------------------------
+void SpatialGrid::move(u32 id, const float3& position)
+{
+    assert(contains(id) && "登録されていない物体番号です");
+
+    f32     x      = position.x;
+    f32     z      = position.z;
+    s32     cell   = getCell(x, z);
+    Object& object = objects_[id];
+
+    Entry& entry = cells_[object.cell_][object.slot_];
+    if(cell == object.cell_) {
+        entry.x_ = x;
+        entry.z_ = z;
+        return;
+    }
+
+    f32 radius = entry.radius_;
+    unlink(id);
+    link(id, cell, Entry{x, z, radius, id});
+}
+
+//---------------------------------------------------------------------------
+//! 一括移動
+//---------------------------------------------------------------------------
+void SpatialGrid::moveBatch(std::span<const SpatialMove> moves)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    s32 count = static_cast<s32>(moves.size());
+    crossed_.resize(count);
+
+    //---- セル内の位置を更新 (物体ごとに書き込み先が異なるため並列に実行できる)
+    std::atomic<s32> crossed_count = 0;
+    JOB_parallelFor(count, BATCH_GRAIN, [&](s32 begin, s32 end) {
+        for(s32 i = begin; i < end; ++i) {
+            const SpatialMove& m = moves[i];
+            assert(contains(m.id_) && "登録されていない物体番号です");
+
+            const Object& object = objects_[m.id_];
+
+            f32 x = m.position_.x;
+            f32 z = m.position_.z;
+            if(getCell(x, z) == object.cell_) {
+                Entry& entry = cells_[object.cell_][object.slot_];
+                entry.x_     = x;
+                entry.z_     = z;
+            }
+            else {
+                crossed_[crossed_count.fetch_add(1, std::memory_order_relaxed)] = i;
+            }
+        }
+    });
+
+    //---- セルをまたいだ物体を付け替え (セルの配列を変更するため1スレッドで実行)
+    // 実行順で検索結果の並びが変わらないよう番号順に処理する
+    auto crossed = std::span(crossed_.data(), crossed_count.load());
+    std::sort(crossed.begin(), crossed.end());
+    for(u32 i : crossed) {
+        move(moves[i].id_, moves[i].position_);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 削除
+//---------------------------------------------------------------------------
+void SpatialGrid::remove(u32 id)
+{
+    assert(contains(id) && "登録されていない物体番号です");
+
+    unlink(id);
+    objects_[id].cell_ = -1;
+    object_count_--;
+}
+
+//---------------------------------------------------------------------------
+//! 円と重なる物体を取得
+//---------------------------------------------------------------------------
+void SpatialGrid::queryRadius(const float3& center, f32 radius, std::vector<u32>& result) const
+{
+    f32 x = center.x;
+    f32 z = center.z;
+    forEachEntry(x - radius, z - radius, x + radius, z + radius, [&](const Entry& entry) {
+        f32 dx       = entry.x_ - x;
+        f32 dz       = entry.z_ - z;
+        f32 distance = radius + entry.radius_;
+        if(dx * dx + dz * dz <= distance * distance) {
+            result.push_back(entry.id_);
+        }
+    });
+}
+
+//---------------------------------------------------------------------------
+//! 矩形と重なる物体を取得
+//---------------------------------------------------------------------------
+void SpatialGrid::queryBox(const float3& box_min, const float3& box_max, std::vector<u32>& result) const
+{
+    f32 min_x = box_min.x;
+    f32 min_z = box_min.z;
+    f32 max_x = box_max.x;
+    f32 max_z = box_max.z;
+    forEachEntry(min_x, min_z, max_x, max_z, [&](const Entry& entry) {
+        // 物体は半径を持つ正方形として扱う
+        if(entry.x_ + entry.radius_ >= min_x && entry.x_ - entry.radius_ <= max_x &&   //
+           entry.z_ + entry.radius_ >= min_z && entry.z_ - entry.radius_ <= max_z) {
+            result.push_back(entry.id_);
+        }
+    });
+}
+
+//---------------------------------------------------------------------------
+//! 座標からセルの列・行番号を取得
+//---------------------------------------------------------------------------
+s32 SpatialGrid::getColumn(f32 x) const
+{
+    // 極端に大きな値でも整数変換が溢れないよう、先に範囲を制限する
+    f32 column = std::clamp((x + extent_) * inv_cell_size_, 0.0f, static_cast<f32>(cell_count_ - 1));
+    return static_cast<s32>(column);
+}
+
+//---------------------------------------------------------------------------
+//! セルから取り除く
+//---------------------------------------------------------------------------
+void SpatialGrid::unlink(u32 id)
+{
+    Object&             object = objects_[id];
+    std::vector<Entry>& cell   = cells_[object.cell_];
+
+    // 末尾の要素を空いた位置に移動して、移動した物体の位置を書き換える
+    const Entry& last = cell.back();
+    objects_[last.id_].slot_ = object.slot_;
+    cell[object.slot_]       = last;
+    cell.pop_back();
+}
+
+//---------------------------------------------------------------------------
+//! セルの末尾に追加
+//---------------------------------------------------------------------------
+void SpatialGrid::link(u32 id, s32 cell, const Entry& entry)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    Object& object = objects_[id];
+    object.cell_   = cell;
+    object.slot_   = static_cast<u32>(cells_[cell].size());
+    cells_[cell].push_back(entry);
+}
+
+//---------------------------------------------------------------------------
+//! 範囲内のセルの要素を列挙
+//---------------------------------------------------------------------------
+template<typename F>
+void SpatialGrid::forEachEntry(f32 min_x, f32 min_z, f32 max_x, f32 max_z, const F& function) const
+{
+    if(cells_.empty() || object_count_ == 0) {
+        return;
+    }
+
+    // 物体はセルから最大半径だけはみ出している可能性がある
+    s32 begin_x = getColumn(min_x - max_radius_);
+    s32 begin_z = getColumn(min_z - max_radius_);
+    s32 end_x   = getColumn(max_x + max_radius_);
+    s32 end_z   = getColumn(max_z + max_radius_);
+
+    for(s32 cell_z = begin_z; cell_z <= end_z; ++cell_z) {
+        for(s32 cell_x = begin_x; cell_x <= end_x; ++cell_x) {
+            for(const Entry& entry : cells_[cell_z * cell_count_ + cell_x]) {
+                function(entry);
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+﻿//===========================================================================
+//!	@file	grid.h
+//!	@brief	空間グリッド (動的な物体の近傍検索)
+//!
+//!	XZ平面を等間隔のセルに区切り、物体を中心位置のセルに登録します。
+//!	物体の大きさはセルをはみ出してよい「ルーズ」なグリッドで、検索範囲を
+//!	登録済みの最大半径だけ広げて判定します。高さ(Y)は無視します。
+//!	登録・移動・削除はセル内の配列への追加と末尾との入れ替えだけで O(1) です。
+//!
+//! @code
+//!     SpatialGrid grid;
+//!     grid.setup();                                 // ±64m を 4m 間隔
+//!     grid.insert(id, position, radius);            // id: 呼び出し側の物体番号
+//!     grid.move(id, new_position);
+//!     grid.queryRadius(position, 5.0f, neighbors);  // 半径5m以内の物体番号
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! 一括移動の要素
+struct SpatialMove
+{
+    u32    id_;         //!< 物体番号
+    float3 position_;   //!< 移動先の位置
+};
+
+//===========================================================================
+//! 空間グリッド
+//!
+//! 範囲外の位置は端のセルに登録されるため、範囲外でも検索結果は正しく得られます
+//! (端のセルに集中すると遅くなります)。
+//===========================================================================
+class SpatialGrid
+{
+public:
+    static constexpr f32 DEFAULT_EXTENT    = 64.0f;   //!< 既定の範囲 (±64m、描画しているグリッドと同じ)
+    static constexpr f32 DEFAULT_CELL_SIZE = 4.0f;    //!< 既定のセルの大きさ
+
+    //! コンストラクタ
+    SpatialGrid() = default;
+
+    //! 初期化
+    //! @param  [in]    extent      範囲 (XZそれぞれ -extent～+extent)
+    //! @param  [in]    cell_size   セルの大きさ (検索半径と同程度が目安)
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(失敗)
+    bool setup(f32 extent = DEFAULT_EXTENT, f32 cell_size = DEFAULT_CELL_SIZE);
+
+    //! 解放
+    void cleanup();
+
+    //! 全ての物体を削除 (セルの構成はそのまま)
+    void clear();
+
+    //----------------------------------------------------------
+    //! @name 登録
+    //----------------------------------------------------------
+    //!@{
+
+    //! 登録
+    //! @param  [in]    id          物体番号 (未登録の番号)
+    //! @param  [in]    position    位置
+    //! @param  [in]    radius      半径
+    void insert(u32 id, const float3& position, f32 radius);
+
+    //! 移動
+    //! @param  [in]    id          物体番号 (登録済みの番号)
+    //! @param  [in]    position    移動先の位置
+    void move(u32 id, const float3& position);
+
+    //! 一括移動 (JOB_setup()済みなら並列に実行)
+    //! @param  [in]    moves   移動する物体と位置 (同じ物体番号を重複させないこと)
+    //! @note セルが変わらない物体は並列に更新し、セルをまたいだ物体だけ後でまとめて付け替えます
+    void moveBatch(std::span<const SpatialMove> moves);
+
+    //! 削除
+    //! @param  [in]    id          物体番号 (登録済みの番号)
+    void remove(u32 id);
+
+    //! 登録されているかどうか
+    bool contains(u32 id) const { return id < objects_.size() && objects_[id].cell_ >= 0; }
+
+    //!@}
+    //----------------------------------------------------------
+    //! @name 検索 (XZ平面上で判定)
+    //----------------------------------------------------------
+    //!@{
+
+    //! 円と重なる物体を取得
+    //! @param  [in]    center  中心
+    //! @param  [in]    radius  半径
+    //! @param  [out]   result  物体番号 (末尾に追加)
+    void queryRadius(const float3& center, f32 radius, std::vector<u32>& result) const;
+
+    //! 矩形と重なる物体を取得
+    //! @param  [in]    box_min 最小座標 (Yは無視)
+    //! @param  [in]    box_max 最大座標 (Yは無視)
+    //! @param  [out]   result  物体番号 (末尾に追加)
+    void queryBox(const float3& box_min, const float3& box_max, std::vector<u32>& result) const;
+
+    //!@}
+
+    //! 登録されている物体数を取得
+    s32 getObjectCount() const { return object_count_; }
+
+    //! 1辺のセル数を取得
+    s32 getCellCount() const { return cell_count_; }
+
+private:
+    //! セル内の要素 (検索で連続して読めるよう位置も持つ)
+    struct Entry
+    {
+        f32 x_;        //!< X座標
+        f32 z_;        //!< Z座標
+        f32 radius_;   //!< 半径
+        u32 id_;       //!< 物体番号
+    };
+
+    //! 物体ごとの登録先
+    struct Object
+    {
+        s32 cell_ = -1;   //!< セル番号 (-1:未登録)
+        u32 slot_ = 0;    //!< セル内の位置
+    };
+
+    //! 座標からセルの列・行番号を取得 (範囲外は端に丸める)
+    s32 getColumn(f32 x) const;
+
+    //! 座標からセル番号を取得
+    s32 getCell(f32 x, f32 z) const { return getColumn(z) * cell_count_ + getColumn(x); }
+
+    //! セルから取り除く (末尾の要素を空いた位置に移動)
+    void unlink(u32 id);
+
+    //! セルの末尾に追加
+    void link(u32 id, s32 cell, const Entry& entry);
+
+    //! 範囲内のセルの要素を列挙
+    template<typename F>
+    void forEachEntry(f32 min_x, f32 min_z, f32 max_x, f32 max_z, const F& function) const;
+
+private:
+    f32 extent_        = 0.0f;   //!< 範囲
+    f32 cell_size_     = 0.0f;   //!< セルの大きさ
+    f32 inv_cell_size_ = 0.0f;   //!< セルの大きさの逆数
+    s32 cell_count_    = 0;      //!< 1辺のセル数
+    s32 object_count_  = 0;      //!< 登録されている物体数
+    f32 max_radius_    = 0.0f;   //!< 登録された最大の半径 (検索範囲をこの分だけ広げる)
+
+    std::vector<std::vector<Entry>> cells_;     //!< セル (cell_count_ × cell_count_)
+    std::vector<Object>             objects_;   //!< 物体ごとの登録先 (物体番号で参照)
+    std::vector<u32>                crossed_;   //!< 一括移動でセルをまたいだ要素番号 (作業用)
+};
@@ -0,0 +1,382 @@
+﻿//===========================================================================
+//!	@file	hud.cpp
+//!	@brief	フレーム時間のHUD (グラフ・パーセンタイル・描画統計)
+//===========================================================================
+
+namespace
+{
+constexpr s32 WINDOW_FRAME_COUNT = 300;   //!< 統計を取るフレーム数 (60fpsで5秒)
+
+constexpr f32 BUDGET_MS    = 1000.0f / 60.0f;   //!< 1フレームの目標時間 (単位:ミリ秒)
+constexpr f32 GRAPH_MAX_MS = 50.0f;             //!< グラフの上端 (単位:ミリ秒)
+
+constexpr s32 FONT_FIRST  = 32;   //!< フォントの先頭の文字 (空白)
+constexpr s32 FONT_COUNT  = 96;   //!< フォントの文字数 (ASCIIの表示可能な文字)
+constexpr s32 LINE_HEIGHT = 16;   //!< 1行の高さ (ピクセル数)
+
+constexpr s32 PANEL_X       = 8;     //!< 表示位置X (ピクセル数)
+constexpr s32 PANEL_Y       = 8;     //!< 表示位置Y (ピクセル数)
+constexpr s32 PANEL_WIDTH   = 480;   //!< 表示の幅 (ピクセル数)
+constexpr s32 PANEL_PADDING = 6;     //!< 表示の余白 (ピクセル数)
+constexpr s32 GRAPH_HEIGHT  = 100;   //!< グラフの高さ (ピクセル数)
+
+constexpr s32 TEXT_LINE_COUNT  = 7;     //!< 統計の行数
+constexpr s32 TEXT_LINE_LENGTH = 128;   //!< 1行の最大文字数
+
+bool visible = false;   //!< 表示中かどうか
+
+f32 frame_times[WINDOW_FRAME_COUNT];   //!< フレーム時間のリングバッファ (単位:ミリ秒)
+s32 write_index       = 0;             //!< 次に書き込む位置
+s32 frame_count       = 0;             //!< 記録済みのフレーム数 (最大WINDOW_FRAME_COUNT)
+u64 total_frame_count = 0;             //!< 起動からのフレーム数
+f64 last_time         = 0.0;           //!< 前回のHUD_endFrame()の時刻 (0.0で未計測)
+
+GLuint font_base = 0;   //!< フォントのディスプレイリストの先頭 (0で未作成)
+
+//---------------------------------------------------------------------------
+//! 古い順にi番目のフレーム時間を取得
+//---------------------------------------------------------------------------
+f32 getFrameTime(s32 i)
+{
+    return frame_times[(write_index - frame_count + i + WINDOW_FRAME_COUNT) % WINDOW_FRAME_COUNT];
+}
+
+//---------------------------------------------------------------------------
+//! ソート済みの配列からパーセンタイルを取得 (nearest-rank法)
+//---------------------------------------------------------------------------
+f64 percentile(const f32* sorted, s32 count, f64 p)
+{
+    s32 rank = static_cast<s32>(std::ceil(p * count)) - 1;
+    return sorted[std::clamp(rank, 0, count - 1)];
+}
+
+//---------------------------------------------------------------------------
+//! 統計をテキストに整形
+//---------------------------------------------------------------------------
+void formatStats(char lines[TEXT_LINE_COUNT][TEXT_LINE_LENGTH])
+{
+    FrameTimeStats     frame   = HUD_getFrameTimeStats();
+    const RenderStats& render  = RENDER_getStats();
+    TextureMemoryStats texture = TEXTURE_getMemoryStats();
+
+    f64 fps = (frame.avg_ms_ > 0.0) ? 1000.0 / frame.avg_ms_ : 0.0;
+
+    sprintf_s(lines[0], "frame %6.2f ms   avg %6.2f ms (%5.1f fps)", frame.last_ms_, frame.avg_ms_, fps);
+    sprintf_s(lines[1], "p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f ms", frame.p50_ms_, frame.p95_ms_, frame.p99_ms_, frame.max_ms_);
+    sprintf_s(lines[2], "hitches %d / %d frames (> 2x p50)", frame.hitch_count_, frame.frame_count_);
+    sprintf_s(lines[3],
+              "draws %u  vertices %u  state changes %u  gl calls %u",
+              render.draw_count_,
+              render.vertex_count_,
+              render.state_change_count_,
+              GLTRACE_getCallCount());
+    sprintf_s(lines[4],
+              "textures %d  gpu %.2f MB  cpu %.2f MB",
+              texture.texture_count_,
+              texture.gpu_bytes_ / (1024.0 * 1024.0),
+              texture.cpu_bytes_ / (1024.0 * 1024.0));
+
+    MemoryStats heap = MEMORY_getTotalStats();
+    sprintf_s(lines[5],
+              "heap %.2f MB  peak %.2f MB  allocs %u/frame",
+              heap.live_bytes_ / (1024.0 * 1024.0),
+              heap.peak_bytes_ / (1024.0 * 1024.0),
+              heap.frame_count_);
+
+    // 用途ごとの使用中のサイズ (上限を超えたことがあれば!をつける)
+    constexpr std::pair<MemoryTag, const char*> tags[]{
+        {MemoryTag::Texture, "tex"},
+        {MemoryTag::Geometry, "geo"},
+        {MemoryTag::Frame, "frame"},
+        {MemoryTag::Math, "math"},
+        {MemoryTag::General, "other"},
+    };
+    s32 length = sprintf_s(lines[6], "MB");
+    for(auto [tag, name] : tags) {
+        length += sprintf_s(lines[6] + length,
+                            TEXT_LINE_LENGTH - length,
+                            "  %s %.1f%s",
+                            name,
+                            MEMORY_getStats(tag).live_bytes_ / (1024.0 * 1024.0),
+                            MEMORY_isOverBudget(tag) ? "!" : "");
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 文字列を描画 (y はベースラインの位置)
+//---------------------------------------------------------------------------
+void drawText(s32 x, s32 y, const char* text)
+{
+    if(font_base == 0) {
+        return;
+    }
+    glRasterPos2i(x, y);
+    glListBase(font_base - FONT_FIRST);
+    glCallLists(static_cast<GLsizei>(strlen(text)), GL_UNSIGNED_BYTE, text);
+}
+
+//---------------------------------------------------------------------------
+//! 矩形を描画
+//---------------------------------------------------------------------------
+void drawRect(f32 x0, f32 y0, f32 x1, f32 y1)
+{
+    glVertex2f(x0, y0);
+    glVertex2f(x1, y0);
+    glVertex2f(x1, y1);
+    glVertex2f(x0, y1);
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+void HUD_setup()
+{
+    // GDIの固定幅フォントからASCII文字のビットマップをディスプレイリストに作成
+    HDC hdc = wglGetCurrentDC();
+    if(hdc == nullptr) {
+        return;
+    }
+    SelectObject(hdc, GetStockObject(SYSTEM_FIXED_FONT));
+
+    font_base = glGenLists(FONT_COUNT);
+    if(font_base != 0 && !wglUseFontBitmaps(hdc, FONT_FIRST, FONT_COUNT, font_base)) {
+        glDeleteLists(font_base, FONT_COUNT);
+        font_base = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void HUD_cleanup()
+{
+    if(font_base != 0) {
+        glDeleteLists(font_base, FONT_COUNT);
+        font_base = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void HUD_endFrame()
+{
+    // FrameTimerの経過時間は上限で切り詰められるため独自に計測する
+    f64 now = TIMER_now();
+    if(last_time != 0.0) {
+        frame_times[write_index] = static_cast<f32>((now - last_time) * 1000.0);
+        write_index              = (write_index + 1) % WINDOW_FRAME_COUNT;
+        frame_count              = std::min(frame_count + 1, WINDOW_FRAME_COUNT);
+        total_frame_count++;
+    }
+    last_time = now;
+}
+
+//---------------------------------------------------------------------------
+//! 表示を設定
+//---------------------------------------------------------------------------
+void HUD_setVisible(bool is_visible)
+{
+    visible = is_visible;
+}
+
+//---------------------------------------------------------------------------
+//! 表示中かどうか
+//---------------------------------------------------------------------------
+bool HUD_isVisible()
+{
+    return visible;
+}
+
+//---------------------------------------------------------------------------
+//! 表示を切り替え
+//---------------------------------------------------------------------------
+void HUD_toggle()
+{
+    visible = !visible;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム時間の統計を取得
+//---------------------------------------------------------------------------
+FrameTimeStats HUD_getFrameTimeStats()
+{
+    FrameTimeStats stats;
+    stats.frame_count_ = frame_count;
+    if(frame_count == 0) {
+        return stats;
+    }
+
+    std::array<f32, WINDOW_FRAME_COUNT> sorted;
+    f64                                 total = 0.0;
+    for(s32 i = 0; i < frame_count; ++i) {
+        sorted[i] = getFrameTime(i);
+        total += sorted[i];
+    }
+    std::sort(sorted.begin(), sorted.begin() + frame_count);
+
+    stats.last_ms_ = getFrameTime(frame_count - 1);
+    stats.avg_ms_  = total / frame_count;
+    stats.p50_ms_  = percentile(sorted.data(), frame_count, 0.50);
+    stats.p95_ms_  = percentile(sorted.data(), frame_count, 0.95);
+    stats.p99_ms_  = percentile(sorted.data(), frame_count, 0.99);
+    stats.max_ms_  = sorted[frame_count - 1];
+
+    // 中央値の2倍を超えたフレームを引っかかりとして数える
+    f32 hitch_ms = static_cast<f32>(stats.p50_ms_ * 2.0);
+    auto first   = std::upper_bound(sorted.begin(), sorted.begin() + frame_count, hitch_ms);
+
+    stats.hitch_count_ = static_cast<s32>((sorted.begin() + frame_count) - first);
+    return stats;
+}
+
+//---------------------------------------------------------------------------
+//! 画面に描画
+//---------------------------------------------------------------------------
+void HUD_draw(s32 width, s32 height)
+{
+    if(!visible) {
+        return;
+    }
+    PROFILE_FUNCTION();
+
+    char lines[TEXT_LINE_COUNT][TEXT_LINE_LENGTH];
+    formatStats(lines);
+
+    //---- 画面座標(左上原点・ピクセル単位)で描画 (描画の設定は最後に元に戻す)
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_LIST_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0, width, height, 0.0, -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    f32 left         = static_cast<f32>(PANEL_X);
+    f32 right        = static_cast<f32>(PANEL_X + PANEL_WIDTH);
+    f32 graph_top    = static_cast<f32>(PANEL_Y + PANEL_PADDING);
+    f32 graph_bottom = graph_top + GRAPH_HEIGHT;
+    s32 text_top     = PANEL_Y + PANEL_PADDING * 2 + GRAPH_HEIGHT;
+    f32 panel_bottom = static_cast<f32>(text_top + LINE_HEIGHT * (TEXT_LINE_COUNT + 1) + PANEL_PADDING);
+
+    auto toGraphY = [&](f32 ms) { return graph_bottom - std::min(ms / GRAPH_MAX_MS, 1.0f) * GRAPH_HEIGHT; };
+
+    glBegin(GL_QUADS);
+    {
+        //---- 背景
+        glColor4ub(0, 0, 0, 160);
+        drawRect(left, static_cast<f32>(PANEL_Y), right, panel_bottom);
+
+        //---- フレーム時間のグラフ (古い順に左から、目標時間を超えると黄、2倍を超えると赤)
+        f32 graph_left  = left + PANEL_PADDING;
+        f32 graph_width = static_cast<f32>(PANEL_WIDTH - PANEL_PADDING * 2);
+        f32 bar_width   = graph_width / WINDOW_FRAME_COUNT;
+        f32 x           = graph_left + (WINDOW_FRAME_COUNT - frame_count) * bar_width;
+        for(s32 i = 0; i < frame_count; ++i, x += bar_width) {
+            f32 ms = getFrameTime(i);
+            if(ms <= BUDGET_MS * 1.05f) {
+                glColor4ub(64, 220, 64, 220);
+            }
+            else if(ms <= BUDGET_MS * 2.0f) {
+                glColor4ub(240, 200, 40, 220);
+            }
+            else {
+                glColor4ub(240, 64, 48, 220);
+            }
+            drawRect(x, toGraphY(ms), x + bar_width, graph_bottom);
+        }
+    }
+    glEnd();
+
+    //---- 目標時間とその2倍の目盛り
+    glBegin(GL_LINES);
+    {
+        glColor4ub(255, 255, 255, 128);
+        for(f32 ms : {BUDGET_MS, BUDGET_MS * 2.0f}) {
+            glVertex2f(left, toGraphY(ms));
+            glVertex2f(right, toGraphY(ms));
+        }
+    }
+    glEnd();
+
+    //---- 統計
+    glColor4ub(255, 255, 255, 255);   // glRasterPos()の時点の色で描画される
+    s32 y = text_top + LINE_HEIGHT - 4;
+    for(s32 i = 0; i < TEXT_LINE_COUNT; ++i, y += LINE_HEIGHT) {
+        drawText(PANEL_X + PANEL_PADDING, y, lines[i]);
+    }
+    glColor4ub(160, 160, 160, 255);
+    drawText(PANEL_X + PANEL_PADDING, y, "F1: hide HUD   F2: append stats to hud.txt");
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glPopAttrib();
+}
+
+//---------------------------------------------------------------------------
+//! 統計をテキストで出力
+//---------------------------------------------------------------------------
+void HUD_printStats(FILE* file)
+{
+    char lines[TEXT_LINE_COUNT][TEXT_LINE_LENGTH];
+    formatStats(lines);
+
+    for(s32 i = 0; i < TEXT_LINE_COUNT; ++i) {
+        fprintf(file, "%s\n", lines[i]);
+    }
+
+    //---- 引っかかりのフレーム番号 (起動からの通し番号) と時間
+    FrameTimeStats stats    = HUD_getFrameTimeStats();
+    f32            hitch_ms = static_cast<f32>(stats.p50_ms_ * 2.0);
+    u64            first    = total_frame_count - frame_count;
+    for(s32 i = 0; i < frame_count; ++i) {
+        f32 ms = getFrameTime(i);
+        if(ms > hitch_ms) {
+            fprintf(file, "  hitch: frame %llu  %.2f ms\n", static_cast<unsigned long long>(first + i), ms);
+        }
+    }
+
+    //---- ヒープの用途ごとの使用量
+    MEMORY_printStats(file);
+
+    //---- 直前のフレームのOpenGL呼び出し
+    GLTRACE_printStats(file);
+}
+
+//---------------------------------------------------------------------------
+//! 統計をファイルに追記
+//---------------------------------------------------------------------------
+bool HUD_dump(const char* path)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, path, "a");
+    if(file == nullptr) {
+        return false;
+    }
+
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    fprintf(file,
+            "---- %04d-%02d-%02d %02d:%02d:%02d  frame %llu\n",
+            time.wYear,
+            time.wMonth,
+            time.wDay,
+            time.wHour,
+            time.wMinute,
+            time.wSecond,
+            static_cast<unsigned long long>(total_frame_count));
+    HUD_printStats(file);
+
+    fclose(file);
+    return true;
+}
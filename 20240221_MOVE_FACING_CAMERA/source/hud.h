@@ -0,0 +1,73 @@
+﻿//===========================================================================
+//!	@file	hud.h
+//!	@brief	フレーム時間のHUD (グラフ・パーセンタイル・描画統計)
+//!
+//!	フレームごとの経過時間を直近のフレーム数分保持し、グラフと
+//!	p50/p95/p99などの統計を画面に重ねて表示します。描画数・頂点数・
+//!	設定変更数とテクスチャのメモリ使用量、ヒープの用途ごとの使用量も
+//!	合わせて表示します。
+//!	同じ内容をテキストで出力でき、画面を見ずに数値で報告できます。
+//!
+//! @code
+//!     HUD_setup();                    // OpenGL初期化後
+//!     for(;;) {
+//!         HUD_endFrame();             // フレームの先頭で前回からの経過時間を記録
+//!         ...
+//!         RENDER_present();
+//!         HUD_draw(width, height);    // 画面更新の直前
+//!         OpenGL_swapBuffer();
+//!     }
+//!     HUD_dump("hud.txt");            // テキストで追記
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! フレーム時間の統計 (直近のフレーム)
+struct FrameTimeStats
+{
+    f64 last_ms_     = 0.0;   //!< 直前のフレーム (単位:ミリ秒)
+    f64 avg_ms_      = 0.0;   //!< 平均 (単位:ミリ秒)
+    f64 p50_ms_      = 0.0;   //!< 50パーセンタイル (単位:ミリ秒)
+    f64 p95_ms_      = 0.0;   //!< 95パーセンタイル (単位:ミリ秒)
+    f64 p99_ms_      = 0.0;   //!< 99パーセンタイル (単位:ミリ秒)
+    f64 max_ms_      = 0.0;   //!< 最大 (単位:ミリ秒)
+    s32 frame_count_ = 0;     //!< 集計したフレーム数
+    s32 hitch_count_ = 0;     //!< p50の2倍を超えたフレーム数
+};
+
+//! 初期化 (表示用フォントを作成、OpenGL初期化後に呼び出す)
+void HUD_setup();
+
+//! 解放 (OpenGL解放前に呼び出す)
+void HUD_cleanup();
+
+//! フレーム終了 (前回の呼び出しからの経過時間を記録、毎フレーム1回呼び出す)
+void HUD_endFrame();
+
+//! 表示を設定
+//! @param  [in]    visible true:表示 false:非表示
+void HUD_setVisible(bool visible);
+
+//! 表示中かどうか
+bool HUD_isVisible();
+
+//! 表示を切り替え
+void HUD_toggle();
+
+//! フレーム時間の統計を取得
+FrameTimeStats HUD_getFrameTimeStats();
+
+//! 画面に描画 (描画結果の上に重ねる、RENDER_present()の後に呼び出す)
+//! @param  [in]    width   画面の幅
+//! @param  [in]    height  画面の高さ
+void HUD_draw(s32 width, s32 height);
+
+//! 統計をテキストで出力 (p50の2倍を超えたフレームの一覧を含む)
+//! @param  [in]    file    出力先 (stdoutなど)
+void HUD_printStats(FILE* file);
+
+//! 統計をファイルに追記 (日時付き)
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool HUD_dump(const char* path);
@@ -0,0 +1,267 @@
+﻿//===========================================================================
+//!	@file	input.cpp
+//!	@brief	入力の取得・記録・再生
+//!
+//!	入力ログの1フレーム分のレコードは以下の固定長です (リトルエンディアン、詰め物なし)。
+//!	    u8  更新回数
+//!	    f32 補間係数
+//!	    s16 マウスX移動量
+//!	    s16 マウスY移動量
+//!	    u8  ボタン
+//!	    u32 更新結果のハッシュ値
+//===========================================================================
+
+namespace
+{
+constexpr size_t RECORD_SIZE = sizeof(u8) + sizeof(f32) + sizeof(s16) * 2 + sizeof(u8) + sizeof(u32);   //!< 1フレームのバイト数
+
+POINT last_cursor_pos{};   //!< 前フレームのマウス位置
+
+std::vector<u8>  log_data;                 //!< 入力ログ (ヘッダーを除く)
+bool             recording      = false;   //!< 記録中かどうか
+bool             replaying      = false;   //!< 再生中かどうか
+bool             frame_sampled  = false;   //!< INPUT_sample()からINPUT_endFrame()までの間かどうか
+f32              log_delta_time = 0.0f;    //!< 入力ログの1回の更新時間
+InputFrame       record_frame;             //!< 記録中のフレーム (INPUT_endFrame()で書き込む)
+size_t           read_offset    = 0;       //!< 再生中の読み込み位置
+size_t           hash_offset    = 0;       //!< 再生中のフレームのハッシュ値の位置
+InputReplayStats replay_stats;             //!< 再生結果
+
+//---------------------------------------------------------------------------
+//! 入力ログにデータを追加
+//---------------------------------------------------------------------------
+template<typename T>
+void write(const T& value)
+{
+    const u8* bytes = reinterpret_cast<const u8*>(&value);
+    log_data.insert(log_data.end(), bytes, bytes + sizeof(T));
+}
+
+//---------------------------------------------------------------------------
+//! 入力ログからデータを読み込み
+//---------------------------------------------------------------------------
+template<typename T>
+T read()
+{
+    T value;
+    memcpy(&value, log_data.data() + read_offset, sizeof(T));
+    read_offset += sizeof(T);
+    return value;
+}
+
+//---------------------------------------------------------------------------
+//! キーが押されているかどうか (Win32)
+//---------------------------------------------------------------------------
+bool isKeyDown(int key)
+{
+    return (GetKeyState(key) & 0x8000) != 0;   // 最上位ビットが押下状態
+}
+
+//---------------------------------------------------------------------------
+//! Win32の入力状態を取得
+//---------------------------------------------------------------------------
+void sampleWin32(InputFrame& frame)
+{
+    // マウスの現在位置 (デスクトップ画面の座標)
+    POINT cursor_pos;
+    GetCursorPos(&cursor_pos);
+
+    // 移動量は整数のまま保持する (感度の適用は使用側で行う)
+    frame.mouse_dx_ = static_cast<s16>(std::clamp<LONG>(cursor_pos.x - last_cursor_pos.x, INT16_MIN, INT16_MAX));
+    frame.mouse_dy_ = static_cast<s16>(std::clamp<LONG>(cursor_pos.y - last_cursor_pos.y, INT16_MIN, INT16_MAX));
+    last_cursor_pos = cursor_pos;   // 次のフレームのために保存
+
+    constexpr std::pair<InputButton, int> keys[]{
+        {InputButton::MouseLeft, VK_LBUTTON},
+        {InputButton::Right, VK_RIGHT},
+        {InputButton::Left, VK_LEFT},
+        {InputButton::Up, VK_UP},
+        {InputButton::Down, VK_DOWN},
+        {InputButton::Quit, VK_SPACE},
+    };
+    frame.buttons_ = 0;
+    for(auto [button, key] : keys) {
+        if(isKeyDown(key)) {
+            frame.buttons_ |= static_cast<u8>(1u << static_cast<u32>(button));
+        }
+    }
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+void INPUT_setup()
+{
+    GetCursorPos(&last_cursor_pos);
+}
+
+//---------------------------------------------------------------------------
+//! 1フレーム分の入力を取得
+//---------------------------------------------------------------------------
+bool INPUT_sample(InputFrame& frame, f32 delta_time, s32 step_count, f32 alpha)
+{
+    if(replaying) {
+        if(log_data.size() - read_offset < RECORD_SIZE) {
+            return false;
+        }
+        frame.delta_time_ = log_delta_time;
+        frame.step_count_ = read<u8>();
+        frame.alpha_      = read<f32>();
+        frame.mouse_dx_   = read<s16>();
+        frame.mouse_dy_   = read<s16>();
+        frame.buttons_    = read<u8>();
+        hash_offset       = read_offset;
+        read_offset += sizeof(u32);
+        frame_sampled = true;
+        return true;
+    }
+
+    frame.delta_time_ = delta_time;
+    frame.step_count_ = std::clamp(step_count, 0, 255);   // 入力ログでは1バイト (FrameTimerの上限は8回)
+    frame.alpha_      = alpha;
+    sampleWin32(frame);
+
+    if(recording) {
+        log_delta_time = delta_time;
+        record_frame   = frame;
+        frame_sampled  = true;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void INPUT_endFrame(u32 state_hash)
+{
+    if(!frame_sampled) {
+        return;
+    }
+    frame_sampled = false;
+
+    if(recording) {
+        write(static_cast<u8>(record_frame.step_count_));
+        write(record_frame.alpha_);
+        write(record_frame.mouse_dx_);
+        write(record_frame.mouse_dy_);
+        write(record_frame.buttons_);
+        write(state_hash);
+    }
+    else if(replaying) {
+        u32 recorded_hash;
+        memcpy(&recorded_hash, log_data.data() + hash_offset, sizeof(recorded_hash));
+
+        if(state_hash != recorded_hash) {
+            if(replay_stats.mismatch_count_ == 0) {
+                replay_stats.first_mismatch_frame_ = replay_stats.frame_count_;
+            }
+            replay_stats.mismatch_count_++;
+        }
+        replay_stats.frame_count_++;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 記録を開始
+//---------------------------------------------------------------------------
+void INPUT_beginRecord()
+{
+    log_data.clear();
+    recording     = true;
+    replaying     = false;
+    frame_sampled = false;
+}
+
+//---------------------------------------------------------------------------
+//! 記録を終了してファイルに保存
+//---------------------------------------------------------------------------
+bool INPUT_endRecord(const char* path)
+{
+    recording     = false;
+    frame_sampled = false;
+
+    InputLogHeader header;
+    header.delta_time_  = log_delta_time;
+    header.frame_count_ = static_cast<u32>(log_data.size() / RECORD_SIZE);
+
+    FILE* file = nullptr;
+    fopen_s(&file, path, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+    bool result = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(log_data.data(), 1, log_data.size(), file) == log_data.size();
+    fclose(file);
+
+    log_data.clear();
+    log_data.shrink_to_fit();
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! 記録中かどうか
+//---------------------------------------------------------------------------
+bool INPUT_isRecording()
+{
+    return recording;
+}
+
+//---------------------------------------------------------------------------
+//! 再生を開始
+//---------------------------------------------------------------------------
+bool INPUT_beginReplay(const char* path)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, path, "rb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    InputLogHeader header;
+    InputLogHeader expected;
+
+    bool result = fread(&header, sizeof(header), 1, file) == 1;
+    result      = result && memcmp(header.magic_, expected.magic_, sizeof(header.magic_)) == 0;
+    result      = result && header.version_ == InputLogHeader::VERSION;
+    if(result) {
+        log_data.resize(size_t(header.frame_count_) * RECORD_SIZE);
+        result = fread(log_data.data(), 1, log_data.size(), file) == log_data.size();
+    }
+    fclose(file);
+
+    if(!result) {
+        log_data.clear();
+        return false;
+    }
+
+    log_delta_time = header.delta_time_;
+    read_offset    = 0;
+    replay_stats   = {};
+    recording      = false;
+    replaying      = true;
+    frame_sampled  = false;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 再生を終了
+//---------------------------------------------------------------------------
+InputReplayStats INPUT_endReplay()
+{
+    replaying     = false;
+    frame_sampled = false;
+
+    log_data.clear();
+    log_data.shrink_to_fit();
+    return replay_stats;
+}
+
+//---------------------------------------------------------------------------
+//! 再生中かどうか
+//---------------------------------------------------------------------------
+bool INPUT_isReplaying()
+{
+    return replaying;
+}
@@ -0,0 +1,117 @@
+﻿//===========================================================================
+//!	@file	input.h
+//!	@brief	入力の取得・記録・再生
+//!
+//!	Win32の入力状態 (マウス移動量・キー) を1フレーム分の入力にまとめます。
+//!	記録中は入力とそのフレームの更新回数・補間係数をログに書き出し、
+//!	再生中はWin32の代わりにログの内容を返します。更新回数と補間係数も
+//!	記録した値に置き換わるため、固定タイムステップの更新と合わせて
+//!	実行速度に関係なく毎回同じフレームを再現できます。
+//!	更新結果のハッシュ値も記録し、再生時に一致するかどうかを確認します。
+//!
+//! @code
+//!     INPUT_beginRecord();                        // または INPUT_beginReplay("input.bin")
+//!     for(;;) {
+//!         InputFrame input;
+//!         if(!INPUT_sample(input, delta_time, step_count, alpha)) {
+//!             break;                              // 再生終了
+//!         }
+//!         update(input);
+//!         INPUT_endFrame(hash);                   // 更新結果のハッシュ値
+//!     }
+//!     INPUT_endRecord("input.bin");               // または INPUT_endReplay()
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! ボタン (InputFrame::buttons_ のビット番号)
+enum class InputButton : u8
+{
+    MouseLeft,   //!< マウス左ボタン
+    Right,       //!< →キー
+    Left,        //!< ←キー
+    Up,          //!< ↑キー
+    Down,        //!< ↓キー
+    Quit,        //!< 終了 (スペースキー)
+};
+
+//! 1フレーム分の入力
+struct InputFrame
+{
+    f32 delta_time_ = 0.0f;   //!< 1回の更新時間 (単位:秒)
+    s32 step_count_ = 0;      //!< 今フレームの更新回数
+    f32 alpha_      = 0.0f;   //!< 描画用の補間係数
+    s16 mouse_dx_   = 0;      //!< マウスX移動量 (単位:ピクセル)
+    s16 mouse_dy_   = 0;      //!< マウスY移動量 (単位:ピクセル)
+    u8  buttons_    = 0;      //!< 押されているボタン (InputButtonのビット)
+
+    //! ボタンが押されているかどうか
+    bool isDown(InputButton button) const { return (buttons_ >> static_cast<u32>(button)) & 1; }
+};
+
+//! 入力ログのファイルヘッダー (以降は1フレームごとの固定長のレコードが続く)
+struct InputLogHeader
+{
+    static constexpr u32 VERSION = 1;   //!< 形式のバージョン
+
+    char magic_[4]    = {'I', 'N', 'P', 'T'};   //!< 識別子
+    u32  version_     = VERSION;                //!< バージョン
+    f32  delta_time_  = 0.0f;                   //!< 1回の更新時間 (単位:秒)
+    u32  frame_count_ = 0;                      //!< フレーム数
+};
+
+//! 再生結果
+struct InputReplayStats
+{
+    s32 frame_count_          = 0;    //!< 再生したフレーム数
+    s32 mismatch_count_       = 0;    //!< 更新結果のハッシュ値が一致しなかったフレーム数
+    s32 first_mismatch_frame_ = -1;   //!< 最初に一致しなかったフレーム (-1で全て一致)
+};
+
+//! 初期化 (マウス位置の基準を取得)
+void INPUT_setup();
+
+//! 1フレーム分の入力を取得 (メインスレッド、毎フレーム1回呼び出す)
+//! @param  [out]   frame       入力 (再生中はログの内容)
+//! @param  [in]    delta_time  1回の更新時間 (単位:秒)
+//! @param  [in]    step_count  今フレームの更新回数
+//! @param  [in]    alpha       描画用の補間係数
+//!	@retval	true	取得した
+//!	@retval	false	再生が終了した (ログの最後に達した)
+bool INPUT_sample(InputFrame& frame, f32 delta_time, s32 step_count, f32 alpha);
+
+//! フレーム終了 (更新完了後に呼び出す)
+//! @param  [in]    state_hash  更新結果のハッシュ値 (記録中は保存、再生中は記録した値と比較)
+void INPUT_endFrame(u32 state_hash);
+
+//===========================================================================
+//! @name 記録・再生
+//===========================================================================
+//!@{
+
+//! 記録を開始
+void INPUT_beginRecord();
+
+//! 記録を終了してファイルに保存
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool INPUT_endRecord(const char* path);
+
+//! 記録中かどうか
+bool INPUT_isRecording();
+
+//! 再生を開始
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(ファイルを読めない・形式が違う)
+bool INPUT_beginReplay(const char* path);
+
+//! 再生を終了
+//! @return 再生結果
+InputReplayStats INPUT_endReplay();
+
+//! 再生中かどうか
+bool INPUT_isReplaying();
+
+//!@}
@@ -0,0 +1,522 @@
+﻿//===========================================================================
+//!	@file	job.cpp
+//!	@brief	ジョブシステム (ワークスティーリング)
+//===========================================================================
+#include <mutex>
+
+//===========================================================================
+//! ジョブ
+//===========================================================================
+struct alignas(64) Job
+{
+    JobFunction      function_;          //!< ジョブ関数
+    Job*             parent_;            //!< 親ジョブ
+    std::atomic<s32> unfinished_jobs_{0};   //!< 未完了ジョブ数 (自分自身 + 子ジョブ、0なら再利用可能)
+    alignas(8) u8    data_[JOB_DATA_SIZE];   //!< ジョブ関数に渡すデータ
+};
+static_assert(sizeof(Job) == 64, "ジョブはキャッシュライン1本に収める");
+
+namespace
+{
+constexpr s32 MAX_WORKER_COUNT = 32;    //!< ワーカースレッドの最大数
+constexpr s32 MAX_THREAD_COUNT = 48;    //!< ジョブを利用するスレッドの最大数 (ワーカー + 外部スレッド)
+constexpr u32 MAX_JOB_COUNT    = 4096;  //!< 1スレッドが同時に保持できるジョブ数 (2のべき乗)
+
+//===========================================================================
+//! ワークスティーリングキュー (Chase-Lev)
+//!
+//! 所有スレッドは末尾(bottom)からpush/popし、他スレッドは先頭(top)からstealする。
+//! 所有スレッドのpush/popはロックフリーで、競合するのは最後の1個だけ。
+//===========================================================================
+class WorkStealingQueue
+{
+public:
+    //! 末尾に追加 (所有スレッドのみ)
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(満杯。盗まれていない先頭を上書きするため追加しない)
+    bool push(Job* job)
+    {
+        // topは増えるだけなので、古い値で判定しても満杯側に倒れるだけで安全
+        s64 b = bottom_.load(std::memory_order_relaxed);
+        s64 t = top_.load(std::memory_order_acquire);
+        if(b - t >= static_cast<s64>(MAX_JOB_COUNT)) {
+            return false;
+        }
+        jobs_[b & (MAX_JOB_COUNT - 1)].store(job, std::memory_order_relaxed);
+        bottom_.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! 末尾から取り出し (所有スレッドのみ)
+    Job* pop()
+    {
+        s64 b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        s64 t = top_.load(std::memory_order_relaxed);
+
+        if(t > b) {
+            // 空だった
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = jobs_[b & (MAX_JOB_COUNT - 1)].load(std::memory_order_relaxed);
+        if(t != b) {
+            // 2個以上残っているのでstealと競合しない
+            return job;
+        }
+
+        // 最後の1個はstealと取り合いになる
+        if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return job;
+    }
+
+    //! 先頭から盗む (他スレッドから呼び出し)
+    Job* steal()
+    {
+        s64 t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        s64 b = bottom_.load(std::memory_order_acquire);
+
+        if(t >= b) {
+            return nullptr;
+        }
+
+        Job* job = jobs_[t & (MAX_JOB_COUNT - 1)].load(std::memory_order_relaxed);
+        if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;   // 他のスレッドに先を越された
+        }
+        return job;
+    }
+
+private:
+    alignas(64) std::atomic<s64> top_{0};      //!< 先頭 (steal側)
+    alignas(64) std::atomic<s64> bottom_{0};   //!< 末尾 (所有スレッド側)
+    std::atomic<Job*> jobs_[MAX_JOB_COUNT]{};   //!< ジョブのリングバッファ
+};
+
+//===========================================================================
+//! スレッドごとのジョブ実行コンテキスト
+//===========================================================================
+struct ThreadContext
+{
+    WorkStealingQueue queue_;                   //!< ジョブキュー
+    Job               jobs_[MAX_JOB_COUNT];     //!< ジョブの確保用リングバッファ
+    u32               allocated_count_ = 0;     //!< 確保したジョブ数 (リングバッファの位置)
+    u32               random_          = 1;     //!< steal対象を選ぶ乱数の状態
+};
+
+std::atomic<ThreadContext*> contexts[MAX_THREAD_COUNT];           //!< スレッドごとのコンテキスト
+std::atomic<s32>            external_thread_count{0};             //!< ワーカー以外に割り当てたコンテキスト数 (返却されても減らない)
+std::unique_ptr<ThreadContext> context_storage[MAX_THREAD_COUNT];  //!< コンテキストの実体
+std::vector<s32>            free_external_slots;                  //!< 終了したスレッドから返却されたコンテキスト番号
+std::mutex                  slot_mutex;                           //!< コンテキスト番号の割り当て用 (スレッド開始・終了時のみ)
+
+std::vector<std::thread> workers;                //!< ワーカースレッド
+std::atomic<s32>         worker_count{0};        //!< ワーカースレッド数
+std::atomic<bool>        quit{false};            //!< ワーカー終了リクエスト
+std::atomic<u32>         job_signal{0};          //!< ジョブ追加の通知 (待機中のワーカーを起こす)
+
+//===========================================================================
+//! スレッド終了時にコンテキスト番号を返却する
+//! ワーカー以外のスレッドは短命なもの (監視スレッドなど) もあるため、番号を使い切らないように再利用する
+//! (キューに残ったジョブは次に割り当てられたスレッドが引き継ぐ)
+//===========================================================================
+struct ThreadSlot
+{
+    s32 index_ = -1;
+
+    ~ThreadSlot()
+    {
+        if(index_ >= MAX_WORKER_COUNT) {
+            std::lock_guard lock(slot_mutex);
+            free_external_slots.push_back(index_);
+        }
+    }
+};
+
+thread_local ThreadSlot thread_slot;   //!< このスレッドのコンテキスト番号
+
+//---------------------------------------------------------------------------
+//! コンテキスト番号のスレッド用コンテキストを作成
+//---------------------------------------------------------------------------
+ThreadContext* createContext(s32 index)
+{
+    ThreadContext* context = contexts[index].load(std::memory_order_acquire);
+    if(context == nullptr) {
+        context_storage[index] = std::make_unique<ThreadContext>();
+        context                = context_storage[index].get();
+        context->random_       = static_cast<u32>(index) * 2654435761u + 1;
+        contexts[index].store(context, std::memory_order_release);
+    }
+    return context;
+}
+
+//---------------------------------------------------------------------------
+//! 呼び出し元スレッドのコンテキストを取得
+//! ワーカー以外のスレッド(メインスレッドなど)は初回呼び出し時に登録される
+//---------------------------------------------------------------------------
+ThreadContext* getContext()
+{
+    if(thread_slot.index_ < 0) {
+        std::lock_guard lock(slot_mutex);
+
+        s32 index;
+        if(!free_external_slots.empty()) {
+            index = free_external_slots.back();
+            free_external_slots.pop_back();
+        }
+        else {
+            index = MAX_WORKER_COUNT + external_thread_count.load(std::memory_order_relaxed);
+            if(index >= MAX_THREAD_COUNT) {
+                MessageBox(nullptr, "ジョブシステムを利用するスレッドが多すぎます.", "JOB", MB_OK);
+                std::abort();
+            }
+            createContext(index);
+            external_thread_count.fetch_add(1, std::memory_order_release);
+        }
+        thread_slot.index_ = index;
+    }
+    return contexts[thread_slot.index_].load(std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! 実行可能なジョブを取得 (自分のキュー → 他スレッドから盗む)
+//---------------------------------------------------------------------------
+Job* getJob(ThreadContext* context)
+{
+    if(Job* job = context->queue_.pop()) {
+        return job;
+    }
+
+    // xorshiftで盗む相手を選ぶ
+    u32& r = context->random_;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+
+    s32 workers_count  = worker_count.load(std::memory_order_relaxed);
+    s32 external_count = external_thread_count.load(std::memory_order_acquire);
+    s32 victim_count   = workers_count + external_count;
+    if(victim_count == 0) {
+        return nullptr;
+    }
+
+    // 全スレッドを一巡して盗めるジョブを探す
+    for(s32 i = 0; i < victim_count; ++i) {
+        s32 n     = static_cast<s32>((r + static_cast<u32>(i)) % static_cast<u32>(victim_count));
+        s32 index = (n < workers_count) ? n : MAX_WORKER_COUNT + (n - workers_count);
+
+        ThreadContext* victim = contexts[index].load(std::memory_order_acquire);
+        if(victim == nullptr || victim == context) {
+            continue;
+        }
+        if(Job* job = victim->queue_.steal()) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------
+//! ジョブの完了処理 (親へ伝搬)
+//---------------------------------------------------------------------------
+void finish(Job* job)
+{
+    // 完了した瞬間に待機側がジョブを再利用する可能性があるため、親は先に読んでおく
+    Job* parent = job->parent_;
+
+    s32 unfinished = job->unfinished_jobs_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    if(unfinished == 0 && parent) {
+        finish(parent);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! ジョブを実行
+//---------------------------------------------------------------------------
+void execute(Job* job)
+{
+    job->function_(job, job->data_);
+    finish(job);
+}
+
+//---------------------------------------------------------------------------
+//! ワーカースレッド
+//---------------------------------------------------------------------------
+void workerThread(s32 index)
+{
+    thread_slot.index_     = index;
+    ThreadContext* context = createContext(index);
+
+    char name[32];
+    sprintf_s(name, "worker %d", index);
+    PROFILE_setThreadName(name);
+
+    constexpr s32 SPIN_COUNT = 64;   // 待機状態に入るまでの空回り回数
+
+    s32 spin = 0;
+    while(!quit.load(std::memory_order_relaxed)) {
+        // ジョブを探す前に通知カウンタを読んでおくことで、通知の取りこぼしを防ぐ
+        u32 signal = job_signal.load(std::memory_order_acquire);
+
+        if(Job* job = getJob(context)) {
+            execute(job);
+            spin = 0;
+            continue;
+        }
+
+        if(++spin < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // ジョブが無い間はCPUを解放して待機
+        job_signal.wait(signal, std::memory_order_acquire);
+        spin = 0;
+    }
+}
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! ジョブシステムを初期化
+//---------------------------------------------------------------------------
+bool JOB_setup(s32 count)
+{
+    if(!workers.empty()) {
+        return false;   // 初期化済
+    }
+
+    if(count < 0) {
+        count = static_cast<s32>(std::thread::hardware_concurrency()) - 1;
+    }
+    count = std::clamp(count, 0, MAX_WORKER_COUNT);
+
+    // コンテキストを先に作成してからスレッドを起動する (起動直後からstealできるように)
+    quit = false;
+    for(s32 i = 0; i < count; ++i) {
+        createContext(i);
+    }
+    worker_count = count;
+
+    workers.reserve(count);
+    for(s32 i = 0; i < count; ++i) {
+        workers.emplace_back(workerThread, i);
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! ジョブシステムを解放
+//---------------------------------------------------------------------------
+void JOB_cleanup()
+{
+    quit = true;
+    job_signal.fetch_add(1, std::memory_order_release);
+    job_signal.notify_all();
+
+    for(auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    worker_count = 0;
+}
+
+//---------------------------------------------------------------------------
+//! ジョブを実行するスレッド数を取得
+//---------------------------------------------------------------------------
+s32 JOB_getThreadCount()
+{
+    return worker_count.load(std::memory_order_relaxed) + 1;
+}
+
+//---------------------------------------------------------------------------
+//! ジョブを作成
+//---------------------------------------------------------------------------
+Job* JOB_create(JobFunction function, const void* data, size_t size, Job* parent)
+{
+    ThreadContext* context = getContext();
+
+    // リングバッファを一周して未完了のジョブ (子の完了を待っている親など) に戻った場合は
+    // 上書きせずに次のスロットを探す。全て未完了の場合は他のジョブを実行して空くのを待つ
+    Job* job = nullptr;
+    for(;;) {
+        for(u32 i = 0; i < MAX_JOB_COUNT && job == nullptr; ++i) {
+            Job* candidate = &context->jobs_[context->allocated_count_++ & (MAX_JOB_COUNT - 1)];
+            if(candidate->unfinished_jobs_.load(std::memory_order_acquire) == 0) {
+                job = candidate;
+            }
+        }
+        if(job) {
+            break;
+        }
+        if(Job* next = getJob(context)) {
+            execute(next);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    job->function_ = function;
+    job->parent_   = parent;
+    job->unfinished_jobs_.store(1, std::memory_order_relaxed);
+
+    if(data && size) {
+        memcpy(job->data_, data, std::min(size, JOB_DATA_SIZE));
+    }
+
+    // 親は子ジョブが全て完了するまで完了しない
+    if(parent) {
+        parent->unfinished_jobs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+//---------------------------------------------------------------------------
+//! ジョブを作成 (データなし)
+//---------------------------------------------------------------------------
+Job* JOB_create(JobFunction function, Job* parent)
+{
+    return JOB_create(function, nullptr, 0, parent);
+}
+
+//---------------------------------------------------------------------------
+//! ジョブを実行キューに登録
+//---------------------------------------------------------------------------
+void JOB_run(Job* job)
+{
+    // キューが満杯の場合はその場で実行
+    if(!getContext()->queue_.push(job)) {
+        execute(job);
+        return;
+    }
+
+    // 待機中のワーカーを起こす
+    job_signal.fetch_add(1, std::memory_order_release);
+    job_signal.notify_one();
+}
+
+//---------------------------------------------------------------------------
+//! ジョブの完了を待つ
+//---------------------------------------------------------------------------
+void JOB_wait(const Job* job)
+{
+    ThreadContext* context = getContext();
+
+    while(job->unfinished_jobs_.load(std::memory_order_acquire) > 0) {
+        // 待っている間も他のジョブを実行して手伝う
+        if(Job* next = getJob(context)) {
+            execute(next);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+//===========================================================================
+// フレームグラフ
+//===========================================================================
+
+namespace
+{
+//! タスク実行ジョブに渡すデータ
+struct FrameGraphTaskData
+{
+    FrameGraph* graph_;
+    s32         index_;
+};
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! タスクを追加
+//---------------------------------------------------------------------------
+s32 FrameGraph::addTask(const char* name, std::function<void()> function, std::initializer_list<s32> dependencies)
+{
+    s32 index = static_cast<s32>(tasks_.size());
+
+    Task task;
+    task.name_             = name;
+    task.function_         = std::move(function);
+    task.dependency_count_ = static_cast<s32>(dependencies.size());
+    tasks_.push_back(std::move(task));
+
+    for(s32 dependency : dependencies) {
+        // 依存先は追加済のタスクのみ (循環しないことを保証)
+        assert(0 <= dependency && dependency < index);
+        tasks_[dependency].dependents_.push_back(index);
+    }
+
+    remain_counts_.reset();   // タスク構成が変わったので実行用カウンタを作り直す
+    return index;
+}
+
+//---------------------------------------------------------------------------
+//! 全タスクを依存関係の順に実行して完了を待つ
+//---------------------------------------------------------------------------
+void FrameGraph::execute()
+{
+    s32 task_count = getTaskCount();
+    if(task_count == 0) {
+        return;
+    }
+
+    if(!remain_counts_) {
+        remain_counts_ = std::make_unique<std::atomic<s32>[]>(task_count);
+    }
+    for(s32 i = 0; i < task_count; ++i) {
+        remain_counts_[i].store(tasks_[i].dependency_count_, std::memory_order_relaxed);
+    }
+
+    // 全タスクはルートジョブの子として実行する
+    root_ = JOB_create([](Job*, const void*) {});
+
+    for(s32 i = 0; i < task_count; ++i) {
+        if(tasks_[i].dependency_count_ == 0) {
+            FrameGraphTaskData data{this, i};
+            JOB_run(JOB_create(&FrameGraph::executeTask, &data, sizeof(data), root_));
+        }
+    }
+
+    JOB_run(root_);
+    JOB_wait(root_);
+    root_ = nullptr;
+}
+
+//---------------------------------------------------------------------------
+//! 全タスクを削除
+//---------------------------------------------------------------------------
+void FrameGraph::clear()
+{
+    tasks_.clear();
+    remain_counts_.reset();
+}
+
+//---------------------------------------------------------------------------
+//! タスクを実行するジョブ関数
+//---------------------------------------------------------------------------
+void FrameGraph::executeTask(Job*, const void* data)
+{
+    const auto& task_data = *static_cast<const FrameGraphTaskData*>(data);
+    FrameGraph* graph     = task_data.graph_;
+    const Task& task      = graph->tasks_[task_data.index_];
+
+    {
+        PROFILE_ZONE(task.name_);   // タスク名はトレースに残るため文字列リテラルで登録すること
+        task.function_();
+    }
+
+    // 依存が全て解決したタスクを起動
+    // (このジョブが完了する前に子ジョブを作るため、ルートジョブが先に完了することはない)
+    for(s32 dependent : task.dependents_) {
+        if(graph->remain_counts_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            FrameGraphTaskData next{graph, dependent};
+            JOB_run(JOB_create(&FrameGraph::executeTask, &next, sizeof(next), graph->root_));
+        }
+    }
+}
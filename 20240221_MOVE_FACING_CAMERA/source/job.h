@@ -0,0 +1,188 @@
+﻿//===========================================================================
+//!	@file	job.h
+//!	@brief	ジョブシステム (ワークスティーリング)
+//!
+//!	各スレッドが自分専用のジョブキューを持ち、空になったスレッドは
+//!	他スレッドのキューからジョブを盗んで実行します。
+//!	ジョブは親子関係を持ち、子ジョブが全て終わるまで親ジョブは完了しません。
+//!
+//! @code
+//!     Job* root = JOB_create(rootFunction);
+//!     for(...) {
+//!         JOB_run(JOB_create(childFunction, &data, sizeof(data), root));
+//!     }
+//!     JOB_run(root);
+//!     JOB_wait(root);   // 待っている間もジョブを実行する
+//! @endcode
+//===========================================================================
+#pragma once
+
+struct Job;
+
+//! ジョブ関数
+//! @param  [in]    job     実行中のジョブ (子ジョブの親に指定可能)
+//! @param  [in]    data    ジョブ作成時に渡したデータのコピー
+using JobFunction = void (*)(Job* job, const void* data);
+
+//! ジョブに保持できるデータの最大サイズ (ジョブ1個を64バイトに収めるため)
+constexpr size_t JOB_DATA_SIZE = 40;
+
+//! ジョブシステムを初期化
+//! @param  [in]    worker_count    ワーカースレッド数 (-1でCPUコア数-1)
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool JOB_setup(s32 worker_count = -1);
+
+//! ジョブシステムを解放
+void JOB_cleanup();
+
+//! ジョブを実行するスレッド数を取得 (呼び出し元スレッドを含む)
+s32 JOB_getThreadCount();
+
+//! ジョブを作成
+//! @param  [in]    function    ジョブ関数
+//! @param  [in]    data        ジョブに渡すデータ (JOB_DATA_SIZEバイト以下、コピーして保持)
+//! @param  [in]    size        データサイズ
+//! @param  [in]    parent      親ジョブ (nullptrで親なし)
+//! @attention ジョブはスレッドごとのリングバッファ (4096個) から確保され、未完了のジョブは飛ばします。
+//!            全て未完了の場合は空くまで他のジョブを実行して待つため、
+//!            JOB_run()していないジョブを大量に残さないでください。
+Job* JOB_create(JobFunction function, const void* data, size_t size, Job* parent = nullptr);
+
+//! ジョブを作成 (データなし)
+//! @param  [in]    function    ジョブ関数
+//! @param  [in]    parent      親ジョブ (nullptrで親なし)
+Job* JOB_create(JobFunction function, Job* parent = nullptr);
+
+//! ジョブを実行キューに登録
+//! @param  [in]    job     ジョブ
+void JOB_run(Job* job);
+
+//! ジョブの完了を待つ (待機中は他のジョブを実行)
+//! @param  [in]    job     ジョブ
+void JOB_wait(const Job* job);
+
+//! ラムダ式からジョブを作成
+//! @param  [in]    function    関数オブジェクト (キャプチャはJOB_DATA_SIZEバイト以下)
+//! @param  [in]    parent      親ジョブ (nullptrで親なし)
+template<typename F>
+Job* JOB_createLambda(const F& function, Job* parent = nullptr)
+{
+    static_assert(sizeof(F) <= JOB_DATA_SIZE, "キャプチャが大きすぎます。ポインタ経由で渡してください。");
+    static_assert(std::is_trivially_copyable_v<F>, "キャプチャはコピー可能な値のみ使用できます。");
+
+    JobFunction invoke = [](Job*, const void* data) { (*static_cast<const F*>(data))(); };
+    return JOB_create(invoke, &function, sizeof(F), parent);
+}
+
+namespace job_detail
+{
+//! 並列forの分割範囲
+template<typename F>
+struct ParallelForRange
+{
+    const F* function_;
+    s32      begin_;
+    s32      end_;
+    s32      grain_size_;
+
+    //! 範囲がgrain_size以下になるまで二分割して子ジョブを作成
+    static void execute(Job* job, const void* data)
+    {
+        const auto& range = *static_cast<const ParallelForRange*>(data);
+
+        if(range.end_ - range.begin_ > range.grain_size_) {
+            s32 middle = range.begin_ + (range.end_ - range.begin_) / 2;
+
+            ParallelForRange left{range.function_, range.begin_, middle, range.grain_size_};
+            ParallelForRange right{range.function_, middle, range.end_, range.grain_size_};
+            JOB_run(JOB_create(&execute, &left, sizeof(left), job));
+            JOB_run(JOB_create(&execute, &right, sizeof(right), job));
+        }
+        else {
+            (*range.function_)(range.begin_, range.end_);
+        }
+    }
+};
+}   // namespace job_detail
+
+//! 範囲を分割して並列実行
+//! @param  [in]    count       要素数 [0, count)
+//! @param  [in]    grain_size  1ジョブで処理する最小要素数
+//! @param  [in]    function    処理関数 void(s32 begin, s32 end)
+template<typename F>
+void JOB_parallelFor(s32 count, s32 grain_size, const F& function)
+{
+    if(count <= 0) {
+        return;
+    }
+    grain_size = std::max(grain_size, 1);
+
+    // 分割しても意味がない場合はその場で実行
+    if(count <= grain_size || JOB_getThreadCount() <= 1) {
+        function(0, count);
+        return;
+    }
+
+    using Range = job_detail::ParallelForRange<F>;
+    Range range{&function, 0, count, grain_size};
+
+    Job* root = JOB_create(&Range::execute, &range, sizeof(range));
+    JOB_run(root);
+    JOB_wait(root);
+}
+
+//===========================================================================
+//! フレームグラフ
+//!
+//! 1フレームの更新処理をタスクと依存関係で記述し、ジョブシステムで実行します。
+//! 依存するタスクが全て完了したタスクから順に並列実行されます。
+//!
+//! @code
+//!     FrameGraph graph;
+//!     s32 input   = graph.addTask("input", [] { ... });
+//!     s32 physics = graph.addTask("physics", [] { ... }, {input});
+//!     s32 anim    = graph.addTask("animation", [] { ... }, {input});
+//!     graph.addTask("culling", [] { ... }, {physics, anim});
+//!     graph.execute();   // 毎フレーム呼び出し
+//! @endcode
+//===========================================================================
+class FrameGraph
+{
+public:
+    //! コンストラクタ
+    FrameGraph() = default;
+
+    //! タスクを追加
+    //! @param  [in]    name            タスク名
+    //! @param  [in]    function        処理関数
+    //! @param  [in]    dependencies    先に完了している必要があるタスク番号
+    //! @return タスク番号
+    s32 addTask(const char* name, std::function<void()> function, std::initializer_list<s32> dependencies = {});
+
+    //! 全タスクを依存関係の順に実行して完了を待つ
+    void execute();
+
+    //! 全タスクを削除
+    void clear();
+
+    //! タスク数を取得
+    s32 getTaskCount() const { return static_cast<s32>(tasks_.size()); }
+
+private:
+    //! タスクを実行するジョブ関数
+    static void executeTask(Job* job, const void* data);
+
+    //! タスク
+    struct Task
+    {
+        const char*           name_;                   //!< タスク名
+        std::function<void()> function_;               //!< 処理関数
+        std::vector<s32>      dependents_;             //!< このタスクの完了を待っているタスク番号
+        s32                   dependency_count_ = 0;   //!< 依存しているタスク数
+    };
+
+    std::vector<Task>                    tasks_;           //!< タスク一覧
+    std::unique_ptr<std::atomic<s32>[]> remain_counts_;   //!< 実行時の未完了依存タスク数
+    Job*                                 root_ = nullptr;  //!< 実行中のルートジョブ
+};
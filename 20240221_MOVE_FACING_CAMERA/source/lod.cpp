@@ -0,0 +1,609 @@
+﻿//===========================================================================
+//!	@file	lod.cpp
+//!	@brief	LOD (詳細度) の作成と選択
+//===========================================================================
+#include <emmintrin.h>   // SSE2
+#include <queue>
+
+namespace
+{
+constexpr f32 MIN_DISTANCE    = 1.0e-4f;   //!< 選択に使う最小距離 (境界球の内側に視点がある場合)
+constexpr f32 MIN_SCALE       = 1.0e-6f;   //!< 選択に使う最小スケール (0除算を避ける)
+constexpr f64 BOUNDARY_WEIGHT = 10.0;      //!< 境界の辺に加える平面の重み
+
+//===========================================================================
+//! 二次誤差 (平面までの距離の2乗の和を表す対称4x4行列)
+//===========================================================================
+struct Quadric
+{
+    f64 a2_ = 0.0, ab_ = 0.0, ac_ = 0.0, ad_ = 0.0;
+    f64 b2_ = 0.0, bc_ = 0.0, bd_ = 0.0;
+    f64 c2_ = 0.0, cd_ = 0.0;
+    f64 d2_ = 0.0;
+
+    //! 平面 ax + by + cz + d = 0 を追加 (法線は正規化済)
+    void addPlane(f64 a, f64 b, f64 c, f64 d, f64 weight)
+    {
+        a2_ += weight * a * a;
+        ab_ += weight * a * b;
+        ac_ += weight * a * c;
+        ad_ += weight * a * d;
+        b2_ += weight * b * b;
+        bc_ += weight * b * c;
+        bd_ += weight * b * d;
+        c2_ += weight * c * c;
+        cd_ += weight * c * d;
+        d2_ += weight * d * d;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a2_ += q.a2_;
+        ab_ += q.ab_;
+        ac_ += q.ac_;
+        ad_ += q.ad_;
+        b2_ += q.b2_;
+        bc_ += q.bc_;
+        bd_ += q.bd_;
+        c2_ += q.c2_;
+        cd_ += q.cd_;
+        d2_ += q.d2_;
+        return *this;
+    }
+
+    //! 点での誤差を計算
+    f64 evaluate(const f64 p[3]) const
+    {
+        f64 x = p[0];
+        f64 y = p[1];
+        f64 z = p[2];
+        f64 e = a2_ * x * x + 2.0 * ab_ * x * y + 2.0 * ac_ * x * z + 2.0 * ad_ * x +   //
+                b2_ * y * y + 2.0 * bc_ * y * z + 2.0 * bd_ * y +                       //
+                c2_ * z * z + 2.0 * cd_ * z + d2_;
+        return std::max(e, 0.0);
+    }
+
+    //! 誤差が最小になる点を計算
+    //! @retval true    求まった
+    //! @retval false   行列が特異 (平面上など、点が1つに決まらない)
+    bool optimize(f64 p[3]) const
+    {
+        f64 det = a2_ * (b2_ * c2_ - bc_ * bc_) - ab_ * (ab_ * c2_ - bc_ * ac_) + ac_ * (ab_ * bc_ - b2_ * ac_);
+        if(std::abs(det) < 1.0e-12) {
+            return false;
+        }
+
+        // クラメルの公式で A p = -b を解く
+        f64 inv = -1.0 / det;
+        p[0]    = inv * (ad_ * (b2_ * c2_ - bc_ * bc_) - ab_ * (bd_ * c2_ - bc_ * cd_) + ac_ * (bd_ * bc_ - b2_ * cd_));
+        p[1]    = inv * (a2_ * (bd_ * c2_ - cd_ * bc_) - ad_ * (ab_ * c2_ - bc_ * ac_) + ac_ * (ab_ * cd_ - bd_ * ac_));
+        p[2]    = inv * (a2_ * (b2_ * cd_ - bc_ * bd_) - ab_ * (ab_ * cd_ - bd_ * ac_) + ad_ * (ab_ * bc_ - b2_ * ac_));
+        return true;
+    }
+};
+
+//===========================================================================
+//! 辺の縮約によるメッシュの簡略化
+//===========================================================================
+class Simplifier
+{
+public:
+    //! コンストラクタ
+    explicit Simplifier(const Mesh& mesh);
+
+    //! 目標の三角形数まで縮約
+    void simplify(s32 target_count);
+
+    //! 現在のメッシュを取得 (未使用の頂点は詰める)
+    Mesh extract() const;
+
+    //! これまでの最大誤差を取得
+    f32 getError() const { return static_cast<f32>(std::sqrt(max_cost_)); }
+
+private:
+    //! 頂点
+    struct Vertex
+    {
+        f64              p_[3];              //!< 座標
+        Quadric          quadric_;           //!< 二次誤差
+        u32              version_ = 0;       //!< 変更されるたびに進める (古い候補の判定用)
+        bool             removed_ = false;   //!< 縮約で削除された
+        std::vector<u32> triangles_;         //!< この頂点を使う三角形
+    };
+
+    //! 三角形
+    struct Triangle
+    {
+        u32  v_[3];              //!< 頂点番号
+        bool removed_ = false;   //!< 縮約でつぶれた
+    };
+
+    //! 縮約の候補 (v1をv0に統合してp_に移動)
+    struct Candidate
+    {
+        f64 cost_;          //!< 誤差
+        f64 p_[3];          //!< 統合後の座標
+        u32 v0_, v1_;       //!< 頂点番号
+        u32 version0_;      //!< 作成時のv0の版
+        u32 version1_;      //!< 作成時のv1の版
+
+        bool operator>(const Candidate& other) const { return cost_ > other.cost_; }
+    };
+
+    //! 候補を追加
+    void pushCandidate(u32 v0, u32 v1);
+
+    //! 縮約すると面が裏返るかどうか
+    bool flips(u32 v, u32 other, const f64 p[3]) const;
+
+    //! 縮約
+    void collapse(const Candidate& candidate);
+
+private:
+    std::vector<Vertex>   vertices_;               //!< 頂点
+    std::vector<Triangle> triangles_;              //!< 三角形
+    s32                   triangle_count_ = 0;     //!< 残っている三角形数
+    f64                   max_cost_       = 0.0;   //!< これまでの最大誤差 (2乗)
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates_;   //!< 縮約の候補 (誤差の小さい順)
+};
+
+//---------------------------------------------------------------------------
+//! 三角形の法線 (正規化なし)
+//---------------------------------------------------------------------------
+void triangleNormal(const f64 p0[3], const f64 p1[3], const f64 p2[3], f64 n[3])
+{
+    f64 e1[3]{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    f64 e2[3]{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+//---------------------------------------------------------------------------
+//! コンストラクタ
+//---------------------------------------------------------------------------
+Simplifier::Simplifier(const Mesh& mesh)
+{
+    vertices_.resize(mesh.positions_.size());
+    for(size_t i = 0; i < vertices_.size(); ++i) {
+        const float3& p    = mesh.positions_[i];
+        vertices_[i].p_[0] = p.x;
+        vertices_[i].p_[1] = p.y;
+        vertices_[i].p_[2] = p.z;
+    }
+
+    //---- 三角形の平面を頂点の二次誤差に加える
+    std::vector<u64> edges;   // (小さい番号 << 32 | 大きい番号)
+    triangles_.reserve(mesh.indices_.size() / 3);
+    for(size_t i = 0; i + 2 < mesh.indices_.size(); i += 3) {
+        Triangle t{{mesh.indices_[i + 0], mesh.indices_[i + 1], mesh.indices_[i + 2]}};
+        if(t.v_[0] == t.v_[1] || t.v_[1] == t.v_[2] || t.v_[2] == t.v_[0]) {
+            continue;   // つぶれた三角形は無視
+        }
+
+        f64 n[3];
+        triangleNormal(vertices_[t.v_[0]].p_, vertices_[t.v_[1]].p_, vertices_[t.v_[2]].p_, n);
+        f64 length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if(length > 0.0) {
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+            f64 d = -(n[0] * vertices_[t.v_[0]].p_[0] + n[1] * vertices_[t.v_[0]].p_[1] + n[2] * vertices_[t.v_[0]].p_[2]);
+            for(u32 v : t.v_) {
+                vertices_[v].quadric_.addPlane(n[0], n[1], n[2], d, 1.0);
+            }
+        }
+
+        u32 index = static_cast<u32>(triangles_.size());
+        for(s32 k = 0; k < 3; ++k) {
+            u32 a = t.v_[k];
+            u32 b = t.v_[(k + 1) % 3];
+            vertices_[a].triangles_.push_back(index);
+            edges.push_back((static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b));
+        }
+        triangles_.push_back(t);
+    }
+    triangle_count_ = static_cast<s32>(triangles_.size());
+
+    //---- 1つの三角形にしか使われない辺(境界)は、辺を含み面に垂直な平面を加えて動きにくくする
+    std::sort(edges.begin(), edges.end());
+    for(size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while(j < edges.size() && edges[j] == edges[i]) {
+            ++j;
+        }
+
+        u32 a = static_cast<u32>(edges[i] >> 32);
+        u32 b = static_cast<u32>(edges[i] & 0xffffffffull);
+        if(j - i == 1) {
+            // 辺を含む三角形を探して面の法線を求める
+            for(u32 t : vertices_[a].triangles_) {
+                const Triangle& triangle = triangles_[t];
+                if(triangle.v_[0] != b && triangle.v_[1] != b && triangle.v_[2] != b) {
+                    continue;
+                }
+                const f64* pa = vertices_[a].p_;
+                const f64* pb = vertices_[b].p_;
+                f64        n[3];
+                triangleNormal(vertices_[triangle.v_[0]].p_, vertices_[triangle.v_[1]].p_, vertices_[triangle.v_[2]].p_, n);
+
+                f64 e[3]{pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+                f64 m[3]{e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0]};
+                f64 length = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+                if(length > 0.0) {
+                    Quadric q;
+                    q.addPlane(m[0] / length,
+                               m[1] / length,
+                               m[2] / length,
+                               -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]) / length,
+                               BOUNDARY_WEIGHT);
+                    vertices_[a].quadric_ += q;
+                    vertices_[b].quadric_ += q;
+                }
+                break;
+            }
+        }
+        i = j;
+    }
+
+    //---- 全ての辺を縮約の候補にする
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    for(u64 edge : edges) {
+        pushCandidate(static_cast<u32>(edge >> 32), static_cast<u32>(edge & 0xffffffffull));
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 目標の三角形数まで縮約
+//---------------------------------------------------------------------------
+void Simplifier::simplify(s32 target_count)
+{
+    while(triangle_count_ > target_count && !candidates_.empty()) {
+        Candidate candidate = candidates_.top();
+        candidates_.pop();
+
+        // 作成後にどちらかの頂点が変わった候補は捨てる (変更時に新しい候補を追加済み)
+        const Vertex& v0 = vertices_[candidate.v0_];
+        const Vertex& v1 = vertices_[candidate.v1_];
+        if(v0.removed_ || v1.removed_ || v0.version_ != candidate.version0_ || v1.version_ != candidate.version1_) {
+            continue;
+        }
+        if(flips(candidate.v0_, candidate.v1_, candidate.p_) || flips(candidate.v1_, candidate.v0_, candidate.p_)) {
+            continue;
+        }
+        collapse(candidate);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 現在のメッシュを取得
+//---------------------------------------------------------------------------
+Mesh Simplifier::extract() const
+{
+    Mesh             mesh;
+    std::vector<u32> remap(vertices_.size(), UINT32_MAX);
+
+    mesh.indices_.reserve(triangle_count_ * 3);
+    for(const Triangle& t : triangles_) {
+        if(t.removed_) {
+            continue;
+        }
+        for(u32 v : t.v_) {
+            if(remap[v] == UINT32_MAX) {
+                remap[v]     = static_cast<u32>(mesh.positions_.size());
+                const f64* p = vertices_[v].p_;
+                mesh.positions_.push_back(float3(static_cast<f32>(p[0]), static_cast<f32>(p[1]), static_cast<f32>(p[2])));
+            }
+            mesh.indices_.push_back(remap[v]);
+        }
+    }
+    return mesh;
+}
+
+//---------------------------------------------------------------------------
+//! 候補を追加
+//---------------------------------------------------------------------------
+void Simplifier::pushCandidate(u32 v0, u32 v1)
+{
+    const Vertex& a = vertices_[v0];
+    const Vertex& b = vertices_[v1];
+
+    Quadric q = a.quadric_;
+    q += b.quadric_;
+
+    Candidate candidate{};
+    candidate.v0_       = v0;
+    candidate.v1_       = v1;
+    candidate.version0_ = a.version_;
+    candidate.version1_ = b.version_;
+
+    // 最適な点が求まらない場合は両端と中点から誤差が最小のものを選ぶ
+    if(q.optimize(candidate.p_)) {
+        candidate.cost_ = q.evaluate(candidate.p_);
+    }
+    else {
+        f64 midpoint[3]{(a.p_[0] + b.p_[0]) * 0.5, (a.p_[1] + b.p_[1]) * 0.5, (a.p_[2] + b.p_[2]) * 0.5};
+
+        candidate.cost_ = DBL_MAX;
+        for(const f64* p : {a.p_, b.p_, static_cast<const f64*>(midpoint)}) {
+            f64 cost = q.evaluate(p);
+            if(cost < candidate.cost_) {
+                candidate.cost_ = cost;
+                std::copy(p, p + 3, candidate.p_);
+            }
+        }
+    }
+    candidates_.push(candidate);
+}
+
+//---------------------------------------------------------------------------
+//! 縮約すると面が裏返るかどうか
+//! @param  [in]    v       移動する頂点
+//! @param  [in]    other   統合する相手 (両方を含む三角形はつぶれるので判定しない)
+//! @param  [in]    p       移動先
+//---------------------------------------------------------------------------
+bool Simplifier::flips(u32 v, u32 other, const f64 p[3]) const
+{
+    for(u32 t : vertices_[v].triangles_) {
+        const Triangle& triangle = triangles_[t];
+        if(triangle.removed_ || triangle.v_[0] == other || triangle.v_[1] == other || triangle.v_[2] == other) {
+            continue;
+        }
+
+        const f64* before[3];
+        const f64* after[3];
+        for(s32 k = 0; k < 3; ++k) {
+            before[k] = vertices_[triangle.v_[k]].p_;
+            after[k]  = (triangle.v_[k] == v) ? p : before[k];
+        }
+
+        f64 n0[3];
+        f64 n1[3];
+        triangleNormal(before[0], before[1], before[2], n0);
+        triangleNormal(after[0], after[1], after[2], n1);
+        if(n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------
+//! 縮約 (v1をv0に統合)
+//---------------------------------------------------------------------------
+void Simplifier::collapse(const Candidate& candidate)
+{
+    u32     v0 = candidate.v0_;
+    u32     v1 = candidate.v1_;
+    Vertex& a  = vertices_[v0];
+    Vertex& b  = vertices_[v1];
+
+    std::copy(candidate.p_, candidate.p_ + 3, a.p_);
+    a.quadric_ += b.quadric_;
+    a.version_++;
+    b.version_++;
+    b.removed_ = true;
+    max_cost_  = std::max(max_cost_, candidate.cost_);
+
+    //---- v1の三角形をv0に付け替え (両方を含む三角形はつぶれる)
+    for(u32 t : b.triangles_) {
+        Triangle& triangle = triangles_[t];
+        if(triangle.removed_) {
+            continue;
+        }
+        if(triangle.v_[0] == v0 || triangle.v_[1] == v0 || triangle.v_[2] == v0) {
+            triangle.removed_ = true;
+            triangle_count_--;
+            continue;
+        }
+        for(u32& v : triangle.v_) {
+            if(v == v1) {
+                v = v0;
+            }
+        }
+        a.triangles_.push_back(t);
+    }
+    b.triangles_.clear();
+    b.triangles_.shrink_to_fit();
+
+    std::erase_if(a.triangles_, [&](u32 t) { return triangles_[t].removed_; });
+
+    //---- 周囲の頂点も版を進めて、新しい位置での候補を作り直す
+    std::vector<u32> neighbors;
+    for(u32 t : a.triangles_) {
+        for(u32 v : triangles_[t].v_) {
+            if(v != v0 && std::find(neighbors.begin(), neighbors.end(), v) == neighbors.end()) {
+                neighbors.push_back(v);
+            }
+        }
+    }
+    for(u32 v : neighbors) {
+        pushCandidate(v0, v);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 境界球を計算 (AABBの中心を中心にする)
+//---------------------------------------------------------------------------
+Sphere computeBounds(const Mesh& mesh)
+{
+    if(mesh.positions_.empty()) {
+        return Sphere{};
+    }
+
+    float3 box_min = mesh.positions_[0];
+    float3 box_max = mesh.positions_[0];
+    for(const float3& p : mesh.positions_) {
+        box_min = min(box_min, p);
+        box_max = max(box_max, p);
+    }
+
+    Sphere sphere;
+    sphere.center_ = (box_min + box_max) * 0.5f;
+    for(const float3& p : mesh.positions_) {
+        float3 d              = p - sphere.center_;
+        f32    length_squared = dot(d, d);
+        sphere.radius_        = std::max(sphere.radius_, std::sqrt(length_squared));
+    }
+    return sphere;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 投影を設定
+//---------------------------------------------------------------------------
+void LodSelector::setProjection(f32 fovy, s32 screen_height)
+{
+    screen_scale_ = static_cast<f32>(screen_height) / (2.0f * std::tan(fovy * 0.5f));
+}
+
+//---------------------------------------------------------------------------
+//! 段を選択
+//---------------------------------------------------------------------------
+s32 LodSelector::select(const LodChain& chain, f32 distance, s32 current_level, f32 world_scale) const
+{
+    const std::vector<LodLevel>& levels = chain.levels_;
+    if(levels.empty()) {
+        return 0;
+    }
+
+    // この距離で許容できるワールド空間の誤差を、スケールで割ってオブジェクト空間の誤差に換算
+    f32 allowed = std::max(distance, MIN_DISTANCE) * max_pixel_error_ / (screen_scale_ * std::max(world_scale, MIN_SCALE));
+
+    s32 last  = static_cast<s32>(levels.size()) - 1;
+    s32 level = std::clamp(current_level, 0, last);
+
+    //---- 粗くする場合は許容誤差より幅の分だけ小さくなってから切り替える
+    f32 coarse_limit = allowed * (1.0f - hysteresis_);
+    while(level < last && levels[level + 1].error_ <= coarse_limit) {
+        level++;
+    }
+    if(level != current_level) {
+        return level;
+    }
+
+    //---- 細かくする場合は許容誤差を幅の分だけ超えてから、許容誤差に収まる段まで戻す
+    if(levels[level].error_ > allowed * (1.0f + hysteresis_)) {
+        while(level > 0 && levels[level].error_ > allowed) {
+            level--;
+        }
+    }
+    return level;
+}
+
+//---------------------------------------------------------------------------
+//! 見えている物体の段をまとめて選択
+//---------------------------------------------------------------------------
+void LodSelector::selectBatch(const float3&          eye,
+                              const SphereArray&     spheres,
+                              const u32*             indices,
+                              s32                    count,
+                              const LodChain* const* chains,
+                              u8*                    levels,
+                              const f32*             world_scales) const
+{
+    const f32* center_x = spheres.getCenter(0);
+    const f32* center_y = spheres.getCenter(1);
+    const f32* center_z = spheres.getCenter(2);
+    const f32* radius   = spheres.getRadius();
+
+    __m128 eye_x        = _mm_set1_ps(eye.x);
+    __m128 eye_y        = _mm_set1_ps(eye.y);
+    __m128 eye_z        = _mm_set1_ps(eye.z);
+    __m128 min_distance = _mm_set1_ps(MIN_DISTANCE);
+
+    for(s32 i = 0; i < count; i += 4) {
+        // 端数は最後の番号で埋める
+        u32 index[4];
+        for(s32 k = 0; k < 4; ++k) {
+            index[k] = indices[std::min(i + k, count - 1)];
+        }
+
+        //---- 視点から境界球の表面までの距離を4個ずつ計算
+        __m128 dx = _mm_sub_ps(_mm_set_ps(center_x[index[3]], center_x[index[2]], center_x[index[1]], center_x[index[0]]), eye_x);
+        __m128 dy = _mm_sub_ps(_mm_set_ps(center_y[index[3]], center_y[index[2]], center_y[index[1]], center_y[index[0]]), eye_y);
+        __m128 dz = _mm_sub_ps(_mm_set_ps(center_z[index[3]], center_z[index[2]], center_z[index[1]], center_z[index[0]]), eye_z);
+        __m128 r  = _mm_set_ps(radius[index[3]], radius[index[2]], radius[index[1]], radius[index[0]]);
+
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        alignas(16) f32 distance[4];
+        _mm_store_ps(distance, _mm_max_ps(_mm_sub_ps(length, r), min_distance));
+
+        //---- 段の選択は物体ごとにチェーンが異なるため1個ずつ
+        s32 lane_count = std::min(count - i, 4);
+        for(s32 k = 0; k < lane_count; ++k) {
+            f32 world_scale  = world_scales ? world_scales[index[k]] : 1.0f;
+            levels[index[k]] = static_cast<u8>(select(*chains[index[k]], distance[k], levels[index[k]], world_scale));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! メッシュを簡略化
+//---------------------------------------------------------------------------
+Mesh LOD_simplify(const Mesh& mesh, s32 target_count, f32* error)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    Simplifier simplifier(mesh);
+    simplifier.simplify(target_count);
+    if(error) {
+        *error = simplifier.getError();
+    }
+    return simplifier.extract();
+}
+
+//---------------------------------------------------------------------------
+//! LODチェーンを作成
+//---------------------------------------------------------------------------
+LodChain LOD_generate(const Mesh& mesh, s32 level_count, f32 ratio)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    LodChain chain;
+    chain.bounds_ = computeBounds(mesh);
+    chain.levels_.push_back(LodLevel{mesh, 0.0f});
+
+    // 1回の縮約を続けながら各段を取り出す (誤差が元のメッシュからの累積になる)
+    Simplifier simplifier(mesh);
+    s32        triangle_count = mesh.getTriangleCount();
+    for(s32 level = 1; level < level_count; ++level) {
+        s32 target_count = static_cast<s32>(static_cast<f32>(chain.levels_.back().mesh_.getTriangleCount()) * ratio);
+        simplifier.simplify(target_count);
+
+        LodLevel lod{simplifier.extract(), simplifier.getError()};
+        if(lod.mesh_.getTriangleCount() >= triangle_count) {
+            break;   // これ以上簡略化できない
+        }
+        triangle_count = lod.mesh_.getTriangleCount();
+        chain.levels_.push_back(std::move(lod));
+    }
+    return chain;
+}
+
+//---------------------------------------------------------------------------
+//! ワールド行列の最大スケールを取得
+//---------------------------------------------------------------------------
+f32 LOD_getMaxScale(const matrix& world)
+{
+    float3 x              = world.axisX();
+    float3 y              = world.axisY();
+    float3 z              = world.axisZ();
+    f32    length_squared = std::max({static_cast<f32>(dot(x, x)), static_cast<f32>(dot(y, y)), static_cast<f32>(dot(z, z))});
+    return std::sqrt(length_squared);
+}
+
+//---------------------------------------------------------------------------
+//! メッシュを描画
+//---------------------------------------------------------------------------
+void LOD_draw(const Mesh& mesh, const Color& color)
+{
+    RENDER_begin(PrimitiveType::Triangles);
+    RENDER_color(color);
+    for(u32 index : mesh.indices_) {
+        RENDER_vertex(mesh.positions_[index]);
+    }
+    RENDER_end();
+}
@@ -0,0 +1,147 @@
+﻿//===========================================================================
+//!	@file	lod.h
+//!	@brief	LOD (詳細度) の作成と選択
+//!
+//!	メッシュを二次誤差(Quadric Error Metrics)による辺の縮約で段階的に
+//!	簡略化してLODチェーンを作成します。描画時は各段の幾何誤差を画面上の
+//!	ピクセル数に換算し、許容値以下になる最も粗い段を選びます。
+//!	段の切り替えには幅を持たせ、境界付近で段が行き来しないようにします。
+//!
+//!	@note	現時点ではベンチマーク (-benchmark lod) からのみ使用しています。
+//!			ゲームの描画 (GAME_render()) のピラミッドは6三角形で面ごとに色が異なり、
+//!			LOD_draw()は単色のため組み込んでいません。メッシュを読み込むようになった時点で
+//!			Frustum::cullSpheres() → LodSelector::selectBatch() → LOD_draw() の順に組み込みます。
+//!
+//! @code
+//!     LodChain chain = LOD_generate(mesh, 5, 0.5f);   // 読み込み時に作成
+//!
+//!     LodSelector selector;
+//!     selector.setProjection(fovy, screen_height);    // 投影行列と同じ画角
+//!     s32 count = frustum.cullSpheres(spheres, visible_indices);
+//!     selector.selectBatch(camera.getPosition(), spheres, visible_indices, count, chains, levels);
+//!     for(s32 i = 0; i < count; ++i) {
+//!         u32 index = visible_indices[i];
+//!         LOD_draw(chains[index]->levels_[levels[index]].mesh_, color);
+//!     }
+//! @endcode
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! メッシュ (インデックス付きの三角形リスト)
+//===========================================================================
+struct Mesh
+{
+    std::vector<float3> positions_;   //!< 頂点座標
+    std::vector<u32>    indices_;     //!< 三角形ごとの頂点番号 (3個ずつ)
+
+    //! 三角形数を取得
+    s32 getTriangleCount() const { return static_cast<s32>(indices_.size() / 3); }
+};
+
+//===========================================================================
+//! LODの1段
+//===========================================================================
+struct LodLevel
+{
+    Mesh mesh_;           //!< メッシュ
+    f32  error_ = 0.0f;   //!< 元のメッシュからの最大誤差 (オブジェクト空間の距離、ワールド空間ではスケール倍)
+};
+
+//===========================================================================
+//! LODチェーン (0段目が元のメッシュ、段が進むほど粗くなる)
+//===========================================================================
+struct LodChain
+{
+    std::vector<LodLevel> levels_;   //!< 段 (誤差の小さい順)
+    Sphere                bounds_;   //!< 境界球 (オブジェクト空間)
+};
+
+//===========================================================================
+//! LODの選択
+//!
+//! 誤差 e の段をワールド行列の最大スケール s で配置し、距離 d から見た時の画面上の大きさは
+//! e × s × 画面の高さ / (2 × tan(画角 / 2) × d) ピクセルになります。
+//! (誤差はオブジェクト空間の距離のため、拡大した物体ほど誤差が大きく見える)
+//===========================================================================
+class LodSelector
+{
+public:
+    //! コンストラクタ
+    LodSelector() = default;
+
+    //! 投影を設定 (gluPerspective()・perspectiveFovRH()と同じ画角)
+    //! @param  [in]    fovy            縦の画角 (単位:radian)
+    //! @param  [in]    screen_height   画面の高さ (ピクセル数)
+    void setProjection(f32 fovy, s32 screen_height);
+
+    //! 画面上の許容誤差を設定
+    //! @param  [in]    pixels  ピクセル数 (既定値:1.0f)
+    void setMaxPixelError(f32 pixels) { max_pixel_error_ = pixels; }
+
+    //! 切り替えの幅を設定
+    //! @param  [in]    ratio   許容誤差に対する割合 (0.0fで幅なし、既定値:0.25f)
+    void setHysteresis(f32 ratio) { hysteresis_ = ratio; }
+
+    //! 誤差を画面上のピクセル数に換算
+    //! @param  [in]    error       誤差 (ワールド空間の距離)
+    //! @param  [in]    distance    視点からの距離
+    f32 getPixelError(f32 error, f32 distance) const { return error * screen_scale_ / distance; }
+
+    //! 段を選択
+    //! @param  [in]    chain           LODチェーン
+    //! @param  [in]    distance        視点から境界球の表面までの距離
+    //! @param  [in]    current_level   現在の段 (切り替えの幅の判定に使用)
+    //! @param  [in]    world_scale     ワールド行列の最大スケール (LOD_getMaxScale())
+    //! @return 選択した段
+    s32 select(const LodChain& chain, f32 distance, s32 current_level, f32 world_scale = 1.0f) const;
+
+    //! 見えている物体の段をまとめて選択 (距離は4個ずつSIMDで計算)
+    //! @param  [in]        eye         視点の位置 (Camera::getPosition())
+    //! @param  [in]        spheres     ワールド空間の境界球の配列
+    //! @param  [in]        indices     選択する番号 (Frustum::cullSpheres()の結果など)
+    //! @param  [in]        count       選択する数
+    //! @param  [in]        chains      物体ごとのLODチェーン (spheresと同じ番号)
+    //! @param  [in,out]    levels      物体ごとの段 (前回の値を参照して更新)
+    //! @param  [in]        world_scales 物体ごとのワールド行列の最大スケール (nullptrで全て1.0f)
+    void selectBatch(const float3&          eye,
+                     const SphereArray&     spheres,
+                     const u32*             indices,
+                     s32                    count,
+                     const LodChain* const* chains,
+                     u8*                    levels,
+                     const f32*             world_scales = nullptr) const;
+
+private:
+    f32 screen_scale_    = 1.0f;    //!< 画面の高さ / (2 × tan(画角 / 2))
+    f32 max_pixel_error_ = 1.0f;    //!< 画面上の許容誤差 (ピクセル数)
+    f32 hysteresis_      = 0.25f;   //!< 切り替えの幅 (許容誤差に対する割合)
+};
+
+//===========================================================================
+//! @name LODの作成
+//===========================================================================
+//!@{
+
+//! メッシュを簡略化 (二次誤差が最小になる辺から縮約)
+//!
+//! 境界の辺は垂直な平面の誤差を加えて形を保ちます。縮約で面が裏返る場合は縮約しません。
+//! @param  [in]    mesh            元のメッシュ
+//! @param  [in]    target_count    目標の三角形数
+//! @param  [out]   error           最大誤差 (nullptr可)
+//! @return 簡略化したメッシュ (未使用の頂点は詰める)
+Mesh LOD_simplify(const Mesh& mesh, s32 target_count, f32* error = nullptr);
+
+//! LODチェーンを作成 (オフラインまたは読み込み時)
+//! @param  [in]    mesh            元のメッシュ
+//! @param  [in]    level_count     段数 (元のメッシュを含む)
+//! @param  [in]    ratio           1段ごとの三角形数の割合
+LodChain LOD_generate(const Mesh& mesh, s32 level_count, f32 ratio = 0.5f);
+
+//! ワールド行列の最大スケールを取得 (各軸の長さの最大値、LodSelectorで誤差をワールド空間に換算)
+f32 LOD_getMaxScale(const matrix& world);
+
+//! メッシュを描画 (現在のワールド行列で単色の三角形として描画)
+void LOD_draw(const Mesh& mesh, const Color& color);
+
+//!@}
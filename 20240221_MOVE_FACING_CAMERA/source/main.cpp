@@ -3,6 +3,12 @@
 //!	@brief	アプリケーション開始
 //===========================================================================
 
+namespace
+{
+constexpr const char* ASSET_PACK_PATH         = "data/assets.pak";   //!< アセットパックのファイル名 (-packで作成)
+constexpr const char* TEXTURE_CACHE_DIRECTORY = "cache/texture";     //!< 展開済みのテクスチャのキャッシュ
+}   // namespace
+
 //---------------------------------------------------------------------------
 //!	ウィンドウプロシージャ
 //!	@param	[in]	hwnd	対象のウィンドウハンドル
@@ -21,6 +27,16 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam)
             EndPaint(hwnd, &ps);
         }
         return 0;
+    case WM_KEYDOWN:   //---- キー入力 (押しっぱなしのリピートは無視)
+        if((lparam & (1 << 30)) == 0) {
+            if(wparam == VK_F1) {
+                HUD_toggle();   // フレーム時間のHUD表示切り替え
+            }
+            else if(wparam == VK_F2) {
+                HUD_dump("hud.txt");   // フレーム時間の統計をファイルに追記
+            }
+        }
+        break;
     case WM_DESTROY:   //---- ウィンドウ破棄
         PostQuitMessage(0);
         return 0;
@@ -34,8 +50,47 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam)
 //---------------------------------------------------------------------------
 //!	アプリケーション開始関数
 //---------------------------------------------------------------------------
-int APIENTRY WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
+int APIENTRY WinMain(HINSTANCE, HINSTANCE, LPSTR cmd_line, int)
 {
+    //-------------------------------------------------------------
+    // ベンチマークモード (コマンドライン: -benchmark [名前])
+    //-------------------------------------------------------------
+    if(const char* option = strstr(cmd_line, "-benchmark")) {
+        const char* name = option + strlen("-benchmark");
+        while(*name == ' ') {
+            name++;
+        }
+        return BENCHMARK_run(name) ? 0 : 1;
+    }
+
+    //-------------------------------------------------------------
+    // 計測用シーン (コマンドライン: -scene characters=1000 textures=8 ...)
+    //-------------------------------------------------------------
+    if(const char* option = strstr(cmd_line, "-scene")) {
+        return BENCHMARK_runScene(option + strlen("-scene")) ? 0 : 1;
+    }
+
+    //-------------------------------------------------------------
+    // アセットパック作成 (コマンドライン: -pack でdata以下の画像を展開してまとめる)
+    //-------------------------------------------------------------
+    if(strstr(cmd_line, "-pack")) {
+        JOB_setup();     // 拡大の並列化
+        ARENA_setup();   // 展開の作業用メモリ
+        bool result = PACK_build(ASSET_PACK_PATH, "data");
+        ARENA_cleanup();
+        JOB_cleanup();
+        return result ? 0 : 1;
+    }
+
+    //-------------------------------------------------------------
+    // プロファイラー (コマンドライン: -trace で終了時にtrace.jsonを出力)
+    //-------------------------------------------------------------
+    PROFILE_setup();
+    PROFILE_setThreadName("main");
+    if(strstr(cmd_line, "-trace")) {
+        PROFILE_beginCapture();
+    }
+
     const char* titleName = "OpenGL 3D";   // タイトルバーのテキスト
     const char* className = "OpenGL";      // メインウィンドウクラス名
 
@@ -111,9 +166,87 @@ int APIENTRY WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
         return 0;
     }
 
+    //---- OpenGL呼び出しの記録 (コマンドライン: -gllog で終了時にgllog.binを出力)
+    //     テクスチャの転送も再生に必要なため読み込みより前に開始する
+    if(strstr(cmd_line, "-gllog")) {
+        GLTRACE_beginRecord(windowSize.cx, windowSize.cy);
+    }
+
+    //---- ジョブシステム初期化 (ワーカースレッド数 = CPUコア数 - 1)
+    JOB_setup();
+
+    //---- アリーナ初期化 (フレーム一時メモリ・スクラッチメモリ)
+    ARENA_setup();
+
+    //---- ヒープの用途ごとの上限 (超えるとデバッグ出力・HUDに!を表示)
+    //     フレーム一時メモリの大きさはARENA_setup()で決まるため上限なし
+    MEMORY_setBudget(MemoryTag::Texture, 64 * 1024 * 1024);
+    MEMORY_setBudget(MemoryTag::Geometry, 32 * 1024 * 1024);
+    MEMORY_setBudget(MemoryTag::Math, 16 * 1024 * 1024);
+
+    //---- 描画初期化 (コマンドライン: -software でソフトウェアラスタライザー)
+    RenderBackend backend = strstr(cmd_line, "-software") ? RenderBackend::Software : RenderBackend::OpenGL;
+    if(RENDER_setup(backend, windowSize.cx, windowSize.cy) == false) {
+        // ワーカースレッドが残ったまま終了するとstd::terminate()になるため、初期化済みのものを解放する
+        ARENA_cleanup();
+        JOB_cleanup();
+        OpenGL_cleanup();
+        PROFILE_cleanup();
+        return 0;
+    }
+
+    //---- フレーム時間のHUD (F1で表示切り替え、コマンドライン: -hud で最初から表示)
+    HUD_setup();
+    HUD_setVisible(strstr(cmd_line, "-hud") != nullptr);
+
+    //---- 入力 (コマンドライン: -inputrecord で終了時にinput.binを出力、-inputreplay でinput.binを再生)
+    INPUT_setup();
+    if(strstr(cmd_line, "-inputrecord")) {
+        INPUT_beginRecord();
+    }
+    else if(strstr(cmd_line, "-inputreplay")) {
+        if(INPUT_beginReplay("input.bin") == false) {
+            MessageBox(nullptr, "input.binを読み込めませんでした.", "INPUT", MB_OK);
+
+            // ジョブシステムのワーカースレッドを終了させてから終了する (残っているとstd::terminate())
+            HUD_cleanup();
+            RENDER_cleanup();
+            ARENA_cleanup();
+            JOB_cleanup();
+            OpenGL_cleanup();
+            PROFILE_cleanup();
+            return 0;
+        }
+    }
+
+    //---- フレームタイマー
+    //     垂直同期が使えない環境ではSleep()によるフレームレート制限で代用
+    //     再生中は更新回数が入力ログで決まるため、待機せずに最速で描画する
+    FrameTimer timer;
+    if(INPUT_isReplaying()) {
+        OpenGL_setVSync(false);
+    }
+    else if(OpenGL_setVSync(true) == false) {
+        timer.setFrameLimit(60);
+    }
+
+    //---- アセットパック (なければ各ファイルから読み込む)
+    PACK_open(ASSET_PACK_PATH);
+
+    //---- パックにないテクスチャは展開結果をキャッシュ (内容が変わっていなければ次回から展開を省略)
+    TEXTURE_setCacheDirectory(TEXTURE_CACHE_DIRECTORY);
+
     //---- 【ゲーム】初期化
     MSG message{};
     if(GAME_setup() == true) {
+        //---- テクスチャ読み込みの工程別の時間を出力 (I/O・展開・転送のどこが遅いかの確認用)
+        TEXTURE_dumpLoadStats("texture_load.txt");
+
+        //---- テクスチャの元ファイルを監視 (保存すると実行中に差し替わる)
+        TEXTURE_beginWatch("data");
+
+        timer.reset();
+
         //-------------------------------------------------------------
         // メインメッセージループ:
         //-------------------------------------------------------------
@@ -126,24 +259,118 @@ int APIENTRY WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
                 DispatchMessage(&message);
             }
             else {
-                //---- 【ゲーム】更新処理
-                GAME_update();
+                //---- 前フレームまでの計測結果を回収 (前フレームのゾーンは終了済み)
+                PROFILE_endFrame();
+                PROFILE_ZONE("frame");
+                HUD_endFrame();
+
+                timer.beginFrame();
+
+                //---- 【ゲーム】更新処理 (固定タイムステップ)
+                //     更新スレッドで次フレームを更新している間に前フレームの結果を描画する
+                s32 step_count = 0;
+                while(timer.step()) {
+                    step_count++;
+                }
+
+                //---- 入力 (再生中は更新回数・補間係数も入力ログの値になる)
+                InputFrame input;
+                if(INPUT_sample(input, timer.getFixedDeltaTime(), step_count, timer.getAlpha()) == false) {
+                    PostQuitMessage(0);   // 再生終了
+                    continue;
+                }
+                GAME_beginUpdate(input);
+
+                //---- 【ゲーム】描画処理 (更新結果を補間)
+                GAME_render();
+                RENDER_present();
+                HUD_draw(windowSize.cx, windowSize.cy);   // 描画結果の上に重ねる
+
+                //---- 【ゲーム】更新完了待ち
+                GAME_endUpdate();
+                INPUT_endFrame(GAME_getStateHash());
+
+                //---- フレームアリーナ切り替え (更新・描画とも完了済み)
+                ARENA_endFrame();
+                MEMORY_endFrame();   // ヒープ確保回数の集計
 
                 //=============================================================
                 // [OpenGL]	画面更新
                 //=============================================================
-                OpenGL_swapBuffer();
+                {
+                    PROFILE_ZONE("OpenGL_swapBuffer");
+                    OpenGL_swapBuffer();
+                }
+                GLTRACE_endFrame();   // OpenGL呼び出しの回数と時間を集計
+
+                //---- 解放待ちのテクスチャを削除
+                TEXTURE_endFrame();
+
+                {
+                    PROFILE_ZONE("FrameTimer::endFrame");   // フレームレート制限の待機
+                    timer.endFrame();
+                }
             }
         }
     }
 
+    //---- 入力の記録を保存・再生結果を出力 (フレーム時間の統計はhud.txtに追記)
+    if(INPUT_isRecording()) {
+        INPUT_endRecord("input.bin");
+    }
+    if(INPUT_isReplaying()) {
+        InputReplayStats stats = INPUT_endReplay();
+
+        char text[256];
+        sprintf_s(text,
+                  "[INPUT] replay : %d frames, mismatch %d (first frame %d)\n",
+                  stats.frame_count_,
+                  stats.mismatch_count_,
+                  stats.first_mismatch_frame_);
+        OutputDebugStringA(text);
+        HUD_dump("hud.txt");
+    }
+
+    //---- テクスチャの監視を終了 (読み込み直し中のデータを破棄)
+    TEXTURE_endWatch();
+
     //---- 【ゲーム】解放
     GAME_cleanup();
 
+    //---- テクスチャ解放 (OpenGL解放前)
+    TEXTURE_cleanup();
+
+    //---- アセットパックを閉じる
+    PACK_close();
+
+    //---- ジョブシステム解放
+    JOB_cleanup();
+
+    //---- HUD解放 (OpenGL解放前)
+    HUD_cleanup();
+
+    //---- 描画解放
+    RENDER_cleanup();
+
+    //---- アリーナ解放
+    ARENA_cleanup();
+
     //=============================================================
     // [OpenGL]	解放
     //=============================================================
     OpenGL_cleanup();   // OpenGLを解放
 
+    //---- プロファイラー解放 (全スレッド終了後)
+    PROFILE_endFrame();
+    if(PROFILE_isCapturing()) {
+        PROFILE_endCapture("trace.json");
+    }
+    PROFILE_cleanup();
+
+    //---- OpenGL呼び出しの記録を保存
+    if(GLTRACE_isRecording()) {
+        GLTRACE_endRecord("gllog.bin");
+    }
+
     return (int)message.wParam;
 }
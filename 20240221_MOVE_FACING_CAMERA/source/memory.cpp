@@ -0,0 +1,378 @@
+﻿//===========================================================================
+//!	@file	memory.cpp
+//!	@brief	ヒープ確保の追跡 (用途別の使用量・上限・リーク検出)
+//!
+//!	確保ごとに以下のヘッダーをユーザー領域の直前に置き、使用中の確保を
+//!	双方向リストでつなぎます。
+//!	    前後の確保へのポインタ・サイズ・通し番号・先頭からのオフセット・タグ
+//!	operator newはプログラム開始前から呼ばれるため、ここでの変数は全て
+//!	定数で初期化できるもの (コンストラクタの実行を必要としないもの) に限ります。
+//===========================================================================
+#include <new>
+
+namespace
+{
+constexpr s32    TAG_COUNT         = static_cast<s32>(MemoryTag::Count);   //!< タグ数
+constexpr size_t DEFAULT_ALIGNMENT = __STDCPP_DEFAULT_NEW_ALIGNMENT__;    //!< malloc()が保証するアライメント
+constexpr size_t MAX_ALIGNMENT     = 32768;                               //!< 対応するアライメントの上限 (オフセットを16bitで保持するため)
+constexpr s32    LEAK_PRINT_COUNT  = 32;                                  //!< リークを個別に出力する最大数
+
+//! 確保ごとのヘッダー (サイズはDEFAULT_ALIGNMENTの倍数)
+struct alignas(DEFAULT_ALIGNMENT) Header
+{
+    Header*   prev_;       //!< 前の確保
+    Header*   next_;       //!< 次の確保
+    size_t    size_;       //!< 要求されたサイズ (単位:byte)
+    u32       sequence_;   //!< 通し番号
+    u16       offset_;     //!< malloc()した先頭からユーザー領域までのバイト数
+    MemoryTag tag_;        //!< タグ
+};
+
+//! タグごとの集計 (更新はロック中、参照はロックなし)
+struct TagCounter
+{
+    std::atomic<size_t> live_bytes_       = 0;       //!< 使用中のバイト数
+    std::atomic<size_t> peak_bytes_       = 0;       //!< 最大使用量
+    std::atomic<size_t> budget_bytes_     = 0;       //!< 上限 (0で上限なし)
+    std::atomic<u32>    live_count_       = 0;       //!< 使用中の確保数
+    std::atomic<u32>    frame_count_      = 0;       //!< 今フレームの確保回数
+    std::atomic<u64>    total_count_      = 0;       //!< 起動からの確保回数
+    u32                 last_frame_count_ = 0;       //!< 直前のフレームの確保回数 (MEMORY_endFrame()で更新)
+    bool                reported_         = false;   //!< 上限超過を出力済みかどうか
+};
+
+constexpr const char* TAG_NAMES[TAG_COUNT]{"general", "texture", "geometry", "frame", "math"};   //!< タグ名
+
+thread_local MemoryTag current_tag = MemoryTag::General;   //!< 現在のスレッドのタグ
+
+SRWLOCK    lock          = SRWLOCK_INIT;   //!< リストと集計の更新
+Header*    first         = nullptr;        //!< 使用中の確保の先頭 (新しい順)
+u32        next_sequence = 0;              //!< 次の確保の通し番号
+TagCounter counters[TAG_COUNT];            //!< タグごとの集計
+TagCounter total;                          //!< 全体の集計
+
+//---------------------------------------------------------------------------
+//! 集計に確保を加算
+//---------------------------------------------------------------------------
+void addAllocation(TagCounter& counter, size_t size)
+{
+    size_t live = counter.live_bytes_.load(std::memory_order_relaxed) + size;
+    counter.live_bytes_.store(live, std::memory_order_relaxed);
+    if(live > counter.peak_bytes_.load(std::memory_order_relaxed)) {
+        counter.peak_bytes_.store(live, std::memory_order_relaxed);
+    }
+    counter.live_count_.fetch_add(1, std::memory_order_relaxed);
+    counter.frame_count_.fetch_add(1, std::memory_order_relaxed);
+    counter.total_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! 集計から解放を減算
+//---------------------------------------------------------------------------
+void removeAllocation(TagCounter& counter, size_t size)
+{
+    counter.live_bytes_.fetch_sub(size, std::memory_order_relaxed);
+    counter.live_count_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! 集計を取得
+//---------------------------------------------------------------------------
+MemoryStats getStats(const TagCounter& counter)
+{
+    MemoryStats stats;
+    stats.live_bytes_   = counter.live_bytes_.load(std::memory_order_relaxed);
+    stats.peak_bytes_   = counter.peak_bytes_.load(std::memory_order_relaxed);
+    stats.budget_bytes_ = counter.budget_bytes_.load(std::memory_order_relaxed);
+    stats.live_count_   = counter.live_count_.load(std::memory_order_relaxed);
+    stats.frame_count_  = counter.last_frame_count_;
+    stats.total_count_  = counter.total_count_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+//---------------------------------------------------------------------------
+//! メモリ確保
+//! @return 確保したユーザー領域 (失敗時はnullptr)
+//---------------------------------------------------------------------------
+void* allocate(size_t size, size_t alignment)
+{
+    // malloc()の先頭はDEFAULT_ALIGNMENT単位のため、それを超える分だけ余分に確保してずらす
+    size_t padding = (alignment > DEFAULT_ALIGNMENT) ? alignment - DEFAULT_ALIGNMENT : 0;
+    if(alignment > MAX_ALIGNMENT || size > SIZE_MAX - sizeof(Header) - padding) {
+        return nullptr;
+    }
+
+    u8* raw = static_cast<u8*>(malloc(sizeof(Header) + padding + size));
+    if(raw == nullptr) {
+        return nullptr;
+    }
+    uintptr_t user = (reinterpret_cast<uintptr_t>(raw) + sizeof(Header) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+
+    Header* header  = reinterpret_cast<Header*>(user) - 1;
+    header->size_   = size;
+    header->offset_ = static_cast<u16>(user - reinterpret_cast<uintptr_t>(raw));
+    header->tag_    = current_tag;
+    header->prev_   = nullptr;
+
+    AcquireSRWLockExclusive(&lock);
+    {
+        header->sequence_ = next_sequence++;
+        header->next_     = first;
+        if(first) {
+            first->prev_ = header;
+        }
+        first = header;
+
+        addAllocation(counters[static_cast<s32>(header->tag_)], size);
+        addAllocation(total, size);
+    }
+    ReleaseSRWLockExclusive(&lock);
+
+    return reinterpret_cast<void*>(user);
+}
+
+//---------------------------------------------------------------------------
+//! メモリ解放
+//---------------------------------------------------------------------------
+void deallocate(void* p)
+{
+    if(p == nullptr) {
+        return;
+    }
+    Header* header = static_cast<Header*>(p) - 1;
+
+    AcquireSRWLockExclusive(&lock);
+    {
+        if(header->prev_) {
+            header->prev_->next_ = header->next_;
+        }
+        else {
+            first = header->next_;
+        }
+        if(header->next_) {
+            header->next_->prev_ = header->prev_;
+        }
+
+        removeAllocation(counters[static_cast<s32>(header->tag_)], header->size_);
+        removeAllocation(total, header->size_);
+    }
+    ReleaseSRWLockExclusive(&lock);
+
+    free(static_cast<u8*>(p) - header->offset_);
+}
+
+//---------------------------------------------------------------------------
+//! メモリ確保 (失敗時は例外)
+//---------------------------------------------------------------------------
+void* allocateOrThrow(size_t size, size_t alignment)
+{
+    void* p = allocate(size, alignment);
+    if(p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+//---------------------------------------------------------------------------
+//! バイト数をMB単位に変換
+//---------------------------------------------------------------------------
+f64 toMB(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+}   // namespace
+
+//===========================================================================
+// グローバルなoperator new/deleteの置き換え
+//===========================================================================
+#if MEMORY_TRACKING
+
+// clang-format off
+void* operator new(size_t size)                                                               { return allocateOrThrow(size, DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size)                                                             { return allocateOrThrow(size, DEFAULT_ALIGNMENT); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept                               { return allocate(size, DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept                             { return allocate(size, DEFAULT_ALIGNMENT); }
+void* operator new(size_t size, std::align_val_t alignment)                                   { return allocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment)                                 { return allocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept   { return allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* p) noexcept                                                        { deallocate(p); }
+void operator delete[](void* p) noexcept                                                      { deallocate(p); }
+void operator delete(void* p, size_t) noexcept                                                { deallocate(p); }
+void operator delete[](void* p, size_t) noexcept                                              { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept                                 { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                               { deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept                                      { deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                                    { deallocate(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept                              { deallocate(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept                            { deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept               { deallocate(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept             { deallocate(p); }
+// clang-format on
+
+#endif   // MEMORY_TRACKING
+
+//---------------------------------------------------------------------------
+//! 現在のスレッドの確保のタグを設定
+//---------------------------------------------------------------------------
+MemoryTag MEMORY_setTag(MemoryTag tag)
+{
+    MemoryTag previous = current_tag;
+    current_tag        = tag;
+    return previous;
+}
+
+//---------------------------------------------------------------------------
+//! タグ名を取得
+//---------------------------------------------------------------------------
+const char* MEMORY_getTagName(MemoryTag tag)
+{
+    return TAG_NAMES[static_cast<s32>(tag)];
+}
+
+//---------------------------------------------------------------------------
+//! 用途ごとの上限を設定
+//---------------------------------------------------------------------------
+void MEMORY_setBudget(MemoryTag tag, size_t bytes)
+{
+    TagCounter& counter = counters[static_cast<s32>(tag)];
+    counter.budget_bytes_.store(bytes, std::memory_order_relaxed);
+    counter.reported_ = false;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void MEMORY_endFrame()
+{
+    for(s32 i = 0; i < TAG_COUNT; ++i) {
+        TagCounter& counter       = counters[i];
+        counter.last_frame_count_ = counter.frame_count_.exchange(0, std::memory_order_relaxed);
+
+        // 上限超過は読み込み中に起きることが多いため、最大使用量で判定して1回だけ出力
+        MemoryStats stats = getStats(counter);
+        if(stats.budget_bytes_ != 0 && stats.peak_bytes_ > stats.budget_bytes_ && !counter.reported_) {
+            counter.reported_ = true;
+
+            char text[256];
+            sprintf_s(text,
+                      "[MEMORY] %s : over budget (peak %.2f MB / budget %.2f MB, live %.2f MB)\n",
+                      TAG_NAMES[i],
+                      toMB(stats.peak_bytes_),
+                      toMB(stats.budget_bytes_),
+                      toMB(stats.live_bytes_));
+            OutputDebugStringA(text);
+        }
+    }
+    total.last_frame_count_ = total.frame_count_.exchange(0, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+//! 用途ごとの使用状況を取得
+//---------------------------------------------------------------------------
+MemoryStats MEMORY_getStats(MemoryTag tag)
+{
+    return getStats(counters[static_cast<s32>(tag)]);
+}
+
+//---------------------------------------------------------------------------
+//! 全体の使用状況を取得
+//---------------------------------------------------------------------------
+MemoryStats MEMORY_getTotalStats()
+{
+    return getStats(total);
+}
+
+//---------------------------------------------------------------------------
+//! 上限を超えたことがあるかどうか
+//---------------------------------------------------------------------------
+bool MEMORY_isOverBudget(MemoryTag tag)
+{
+    MemoryStats stats = MEMORY_getStats(tag);
+    return stats.budget_bytes_ != 0 && stats.peak_bytes_ > stats.budget_bytes_;
+}
+
+//---------------------------------------------------------------------------
+//! 用途ごとの使用状況をテキストで出力
+//---------------------------------------------------------------------------
+void MEMORY_printStats(FILE* file)
+{
+    fprintf(file, "  %-10s %10s %10s %10s %8s %8s\n", "memory", "live MB", "peak MB", "budget MB", "allocs", "/frame");
+
+    auto print = [&](const char* name, const MemoryStats& stats, bool over_budget) {
+        char budget[32] = "-";
+        if(stats.budget_bytes_ != 0) {
+            sprintf_s(budget, "%.2f%s", toMB(stats.budget_bytes_), over_budget ? "!" : "");
+        }
+        fprintf(file,
+                "  %-10s %10.2f %10.2f %10s %8u %8u\n",
+                name,
+                toMB(stats.live_bytes_),
+                toMB(stats.peak_bytes_),
+                budget,
+                stats.live_count_,
+                stats.frame_count_);
+    };
+    for(s32 i = 0; i < TAG_COUNT; ++i) {
+        MemoryTag tag = static_cast<MemoryTag>(i);
+        print(TAG_NAMES[i], MEMORY_getStats(tag), MEMORY_isOverBudget(tag));
+    }
+    print("total", MEMORY_getTotalStats(), false);
+}
+
+//---------------------------------------------------------------------------
+//! 次の確保の通し番号を取得
+//---------------------------------------------------------------------------
+u32 MEMORY_getSequence()
+{
+    AcquireSRWLockShared(&lock);
+    u32 sequence = next_sequence;
+    ReleaseSRWLockShared(&lock);
+    return sequence;
+}
+
+//---------------------------------------------------------------------------
+//! 指定した通し番号以降に確保して解放されていないものをデバッグ出力
+//---------------------------------------------------------------------------
+s32 MEMORY_reportLeaks(u32 sequence, u32 tag_mask)
+{
+    s32    leak_count            = 0;
+    size_t leak_bytes            = 0;
+    s32    tag_counts[TAG_COUNT] = {};
+    size_t tag_bytes[TAG_COUNT]  = {};
+    char   text[256];
+
+    // 出力中に確保が起きないよう、文字列は全てスタック上で作成する
+    AcquireSRWLockShared(&lock);
+    for(Header* header = first; header; header = header->next_) {
+        if(header->sequence_ < sequence || !(tag_mask & MEMORY_tagMask(header->tag_))) {
+            continue;
+        }
+        if(leak_count < LEAK_PRINT_COUNT) {
+            sprintf_s(text,
+                      "[MEMORY] leak #%u : %s %zu bytes at %p\n",
+                      header->sequence_,
+                      TAG_NAMES[static_cast<s32>(header->tag_)],
+                      header->size_,
+                      static_cast<void*>(header + 1));
+            OutputDebugStringA(text);
+        }
+        leak_count++;
+        leak_bytes += header->size_;
+        tag_counts[static_cast<s32>(header->tag_)]++;
+        tag_bytes[static_cast<s32>(header->tag_)] += header->size_;
+    }
+    ReleaseSRWLockShared(&lock);
+
+    for(s32 i = 0; i < TAG_COUNT; ++i) {
+        if(tag_counts[i] != 0) {
+            sprintf_s(text, "[MEMORY] leak %-10s : %d allocations, %zu bytes\n", TAG_NAMES[i], tag_counts[i], tag_bytes[i]);
+            OutputDebugStringA(text);
+        }
+    }
+    sprintf_s(text, "[MEMORY] leak total : %d allocations, %zu bytes\n", leak_count, leak_bytes);
+    OutputDebugStringA(text);
+    return leak_count;
+}
@@ -0,0 +1,139 @@
+﻿//===========================================================================
+//!	@file	memory.h
+//!	@brief	ヒープ確保の追跡 (用途別の使用量・上限・リーク検出)
+//!
+//!	グローバルなoperator new/deleteを置き換え、全てのヒープ確保に用途のタグを
+//!	付けて記録します。タグはスレッドごとの現在値で、MEMORY_TAG()を置いたスコープの
+//!	間だけ切り替わります (std::vectorの拡張などもそのタグで記録されます)。
+//!	タグごとに使用中・最大のバイト数と1フレームあたりの確保回数を集計し、
+//!	上限を超えたタグはMEMORY_endFrame()でデバッグ出力します。
+//!	確保には通し番号が付き、指定した番号以降に確保して解放されていないものを
+//!	リークとして一覧できます。
+//!	GDI+などのoperator newを通らない確保は記録されません。
+//!
+//! @code
+//!     TextureHandle load(const char* path)
+//!     {
+//!         MEMORY_TAG(MemoryTag::Texture);     // スコープ内の確保はTextureに記録
+//!         ...
+//!     }
+//!
+//!     u32 sequence = MEMORY_getSequence();
+//!     ...
+//!     MEMORY_reportLeaks(sequence, MEMORY_tagMask(MemoryTag::Texture));
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! 0にするとoperator new/deleteを置き換えない (集計は全て0になる)
+#ifndef MEMORY_TRACKING
+#define MEMORY_TRACKING 1
+#endif
+
+//! 確保の用途
+enum class MemoryTag : u8
+{
+    General,    //!< 一般 (タグ指定なし)
+    Texture,    //!< テクスチャ (画像・ミップマップ)
+    Geometry,   //!< 形状 (BVH・空間グリッド・バウンディング・LOD・オクルージョン)
+    Frame,      //!< 一時メモリ (フレームアリーナ・スクラッチアリーナ・ラスタライザーの三角形リスト)
+    Math,       //!< 数学データ (エンティティの列・トランスフォーム)
+    Count,
+};
+
+//! 用途ごとの使用状況
+struct MemoryStats
+{
+    size_t live_bytes_   = 0;   //!< 使用中のバイト数
+    size_t peak_bytes_   = 0;   //!< 最大使用量 (単位:byte)
+    size_t budget_bytes_ = 0;   //!< 上限 (単位:byte、0で上限なし)
+    u32    live_count_   = 0;   //!< 使用中の確保数
+    u32    frame_count_  = 0;   //!< 直前のフレームの確保回数
+    u64    total_count_  = 0;   //!< 起動からの確保回数
+};
+
+//! タグのビット (MEMORY_reportLeaks()の対象指定用)
+constexpr u32 MEMORY_tagMask(MemoryTag tag)
+{
+    return 1u << static_cast<u32>(tag);
+}
+
+//! 現在のスレッドの確保のタグを設定
+//! @param  [in]    tag     タグ
+//! @return 設定前のタグ
+MemoryTag MEMORY_setTag(MemoryTag tag);
+
+//! タグ名を取得
+const char* MEMORY_getTagName(MemoryTag tag);
+
+//===========================================================================
+//! 確保のタグの範囲指定 (スコープを抜けると元のタグに戻す)
+//===========================================================================
+class MemoryTagScope
+{
+public:
+    //! コンストラクタ
+    //! @param  [in]    tag     スコープ内の確保のタグ
+    explicit MemoryTagScope(MemoryTag tag)
+        : previous_(MEMORY_setTag(tag))
+    {
+    }
+
+    //! デストラクタ
+    ~MemoryTagScope() { MEMORY_setTag(previous_); }
+
+    MemoryTagScope(const MemoryTagScope&)            = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+    MemoryTag previous_;   //!< 設定前のタグ
+};
+
+#define MEMORY_CONCAT_(a, b) a##b
+#define MEMORY_CONCAT(a, b)  MEMORY_CONCAT_(a, b)
+
+//! スコープ内の確保のタグを設定
+#define MEMORY_TAG(tag) MemoryTagScope MEMORY_CONCAT(memory_tag_, __LINE__)(tag)
+
+//===========================================================================
+//! @name 集計
+//===========================================================================
+//!@{
+
+//! 用途ごとの上限を設定 (超えるとMEMORY_endFrame()でデバッグ出力)
+//! @param  [in]    tag     タグ
+//! @param  [in]    bytes   上限 (単位:byte、0で上限なし)
+void MEMORY_setBudget(MemoryTag tag, size_t bytes);
+
+//! フレーム終了 (確保回数を締めて、上限を超えたタグを出力)
+void MEMORY_endFrame();
+
+//! 用途ごとの使用状況を取得
+MemoryStats MEMORY_getStats(MemoryTag tag);
+
+//! 全体の使用状況を取得 (上限は常に0)
+MemoryStats MEMORY_getTotalStats();
+
+//! 上限を超えたことがあるかどうか (最大使用量が上限を超えている)
+bool MEMORY_isOverBudget(MemoryTag tag);
+
+//! 用途ごとの使用状況をテキストで出力
+//! @param  [in]    file    出力先
+void MEMORY_printStats(FILE* file);
+
+//!@}
+//===========================================================================
+//! @name リーク検出
+//===========================================================================
+//!@{
+
+//! 次の確保の通し番号を取得 (MEMORY_reportLeaks()の開始位置)
+u32 MEMORY_getSequence();
+
+//! 指定した通し番号以降に確保して解放されていないものをデバッグ出力
+//! @param  [in]    sequence    開始位置 (MEMORY_getSequence()の値)
+//! @param  [in]    tag_mask    対象のタグ (MEMORY_tagMask()の論理和)
+//! @return リークした確保数
+s32 MEMORY_reportLeaks(u32 sequence, u32 tag_mask);
+
+//!@}
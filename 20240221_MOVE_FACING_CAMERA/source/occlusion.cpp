@@ -0,0 +1,454 @@
+﻿//===========================================================================
+//!	@file	occlusion.cpp
+//!	@brief	オクルージョンカリング (CPUの低解像度深度バッファ + 階層Z)
+//===========================================================================
+#include <emmintrin.h>   // SSE2
+
+namespace
+{
+constexpr s32 MAX_CLIP_VERTEX = 8;   //!< クリッピング後の最大頂点数
+
+//! ガードバンド (画面の何倍の範囲までクリッピングしないか)
+constexpr f32 GUARD_BAND = 2.0f;
+
+//! クリッピング平面 (dot(plane, position) >= 0 が内側)
+//! 遠クリップ面より奥は深度1.0以上になり書き込まれないため省略
+constexpr f32 CLIP_PLANES[][4]{
+    { 0.0f,  0.0f, +1.0f,       1.0f},   // 近クリップ面
+    {+1.0f,  0.0f,  0.0f, GUARD_BAND},   // 左
+    {-1.0f,  0.0f,  0.0f, GUARD_BAND},   // 右
+    { 0.0f, +1.0f,  0.0f, GUARD_BAND},   // 下
+    { 0.0f, -1.0f,  0.0f, GUARD_BAND},   // 上
+};
+
+//! クリップ座標
+struct ClipPosition
+{
+    f32 v_[4];   //!< x, y, z, w
+};
+
+//---------------------------------------------------------------------------
+//! 多角形を1枚の平面でクリッピング (Sutherland-Hodgman)
+//! @return クリッピング後の頂点数
+//---------------------------------------------------------------------------
+s32 clipPolygon(const ClipPosition* in, s32 count, ClipPosition* out, const f32 plane[4])
+{
+    auto distance = [&](const ClipPosition& p) {
+        return plane[0] * p.v_[0] + plane[1] * p.v_[1] + plane[2] * p.v_[2] + plane[3] * p.v_[3];
+    };
+
+    s32 out_count = 0;
+    for(s32 i = 0; i < count; ++i) {
+        const ClipPosition& a = in[i];
+        const ClipPosition& b = in[(i + 1) % count];
+
+        f32 da = distance(a);
+        f32 db = distance(b);
+
+        if(da >= 0.0f) {
+            out[out_count++] = a;
+        }
+        if((da >= 0.0f) != (db >= 0.0f)) {
+            f32           t = da / (da - db);
+            ClipPosition& p = out[out_count++];
+            for(s32 k = 0; k < 4; ++k) {
+                p.v_[k] = a.v_[k] + (b.v_[k] - a.v_[k]) * t;
+            }
+        }
+    }
+    return out_count;
+}
+
+//---------------------------------------------------------------------------
+//! スクリーン座標の三角形で深度バッファを更新 (4ピクセル単位)
+//! @param  [in]    x   X座標 (ピクセル) ×3
+//! @param  [in]    y   Y座標 (ピクセル) ×3
+//! @param  [in]    z   深度 ×3
+//---------------------------------------------------------------------------
+void fillTriangle(f32* depth_buffer, s32 width, s32 height, s32 pitch, const f32 x[3], const f32 y[3], const f32 z[3])
+{
+    f32 area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if(!(std::abs(area) > 0.0f)) {
+        return;   // 縮退
+    }
+
+    // 両面描画のため反時計回りにそろえる
+    s32 order[3]{0, 1, 2};
+    if(area < 0.0f) {
+        std::swap(order[1], order[2]);
+        area = -area;
+    }
+
+    //---- 範囲 (画面内に制限、4ピクセル単位に揃える)
+    s32 min_x = std::max(static_cast<s32>(std::floor(std::min({x[0], x[1], x[2]}))), 0) & ~3;
+    s32 min_y = std::max(static_cast<s32>(std::floor(std::min({y[0], y[1], y[2]}))), 0);
+    s32 max_x = std::min(static_cast<s32>(std::ceil(std::max({x[0], x[1], x[2]}))), width);
+    s32 max_y = std::min(static_cast<s32>(std::ceil(std::max({y[0], y[1], y[2]}))), height);
+    if(min_x >= max_x || min_y >= max_y) {
+        return;   // 画面外
+    }
+
+    //---- エッジ関数 (辺 a→b の左側が正、左上の辺は辺上のピクセルを含む)
+    f32  edges[3][3];
+    bool top_left[3];
+    for(s32 i = 0; i < 3; ++i) {
+        s32 a = order[(i + 1) % 3];
+        s32 b = order[(i + 2) % 3];
+
+        f32 ea = y[a] - y[b];
+        f32 eb = x[b] - x[a];
+
+        edges[i][0] = ea;
+        edges[i][1] = eb;
+        edges[i][2] = -(ea * x[a] + eb * y[a]);
+        top_left[i] = ea > 0.0f || (ea == 0.0f && eb > 0.0f);
+    }
+
+    //---- 深度の補間平面 (スクリーン座標で線形)
+    f32 x10 = x[order[1]] - x[order[0]];
+    f32 y10 = y[order[1]] - y[order[0]];
+    f32 x20 = x[order[2]] - x[order[0]];
+    f32 y20 = y[order[2]] - y[order[0]];
+    f32 z10 = z[order[1]] - z[order[0]];
+    f32 z20 = z[order[2]] - z[order[0]];
+    f32 dzdx = (z10 * y20 - z20 * y10) / area;
+    f32 dzdy = (z20 * x10 - z10 * x20) / area;
+    f32 z0   = z[order[0]] - dzdx * x[order[0]] - dzdy * y[order[0]];
+
+    //---- 4ピクセルずつ塗りつぶし
+    const __m128 lane_offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);   // ピクセル中心
+    const __m128 zero        = _mm_setzero_ps();
+
+    for(s32 py = min_y; py < max_y; ++py) {
+        f32  fy  = static_cast<f32>(py) + 0.5f;
+        f32* row = &depth_buffer[py * pitch];
+
+        for(s32 px = min_x; px < max_x; px += 4) {
+            __m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<f32>(px)), lane_offset);
+
+            __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(s32 e = 0; e < 3; ++e) {
+                __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edges[e][0]), fx),
+                                          _mm_set1_ps(edges[e][1] * fy + edges[e][2]));
+                mask         = _mm_and_ps(mask, top_left[e] ? _mm_cmpge_ps(value, zero) : _mm_cmpgt_ps(value, zero));
+            }
+            if(_mm_movemask_ps(mask) == 0) {
+                continue;
+            }
+
+            // 近い方を残す
+            __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), fx), _mm_set1_ps(dzdy * fy + z0));
+            __m128 old   = _mm_loadu_ps(&row[px]);
+            __m128 nearest = _mm_min_ps(depth, old);
+            _mm_storeu_ps(&row[px], _mm_or_ps(_mm_and_ps(mask, nearest), _mm_andnot_ps(mask, old)));
+        }
+    }
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+bool OcclusionCuller::setup(s32 width, s32 height)
+{
+    MEMORY_TAG(MemoryTag::Geometry);
+
+    cleanup();
+    if(width <= 0 || height <= 0) {
+        return false;
+    }
+
+    //---- 各段の大きさと配置を決める
+    // 奇数の場合は切り上げて、上の段の1要素が必ず下の段の2x2を含むようにする
+    s32 total = 0;
+    for(s32 w = width, h = height; level_count_ < MAX_LEVEL_COUNT; w = (w + 1) / 2, h = (h + 1) / 2) {
+        Level& level  = levels_[level_count_++];
+        level.offset_ = total;
+        level.width_  = w;
+        level.height_ = h;
+        level.pitch_  = (level_count_ == 1) ? (w + 3) & ~3 : w;   // 0段目は4ピクセル単位で書き込むため
+        total += level.pitch_ * h;
+
+        if(w == 1 && h == 1) {
+            break;
+        }
+    }
+    depth_.assign(total, 1.0f);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void OcclusionCuller::cleanup()
+{
+    depth_ = {};
+    for(auto& level : levels_) {
+        level = Level();
+    }
+    level_count_    = 0;
+    triangle_count_ = 0;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム開始
+//---------------------------------------------------------------------------
+void OcclusionCuller::beginFrame(const matrix& view_proj)
+{
+    view_proj_      = view_proj;
+    triangle_count_ = 0;
+
+    std::fill(depth_.begin(), depth_.end(), 1.0f);
+}
+
+//---------------------------------------------------------------------------
+//! 遮蔽物を描画
+//---------------------------------------------------------------------------
+void OcclusionCuller::drawOccluder(std::span<const float3> vertices, std::span<const u16> indices, const matrix& world)
+{
+    if(level_count_ == 0) {
+        return;
+    }
+
+    //---- 頂点をクリップ座標に変換 (作業用メモリ)
+    LinearArena& scratch = ARENA_getScratchArena();
+    ArenaScope   scratch_scope(scratch);
+
+    matrix                    world_view_proj = mul(world, view_proj_);
+    ArenaVector<ClipPosition> positions(vertices.size(), ArenaAllocator<ClipPosition>(scratch));
+    for(size_t i = 0; i < vertices.size(); ++i) {
+        float4 p        = mul(float4(vertices[i], 1.0f), world_view_proj);
+        positions[i].v_[0] = p.x;
+        positions[i].v_[1] = p.y;
+        positions[i].v_[2] = p.z;
+        positions[i].v_[3] = p.w;
+    }
+
+    for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+        rasterizeTriangle(positions[indices[i + 0]].v_, positions[indices[i + 1]].v_, positions[indices[i + 2]].v_);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! クリップ座標の三角形を描画
+//---------------------------------------------------------------------------
+void OcclusionCuller::rasterizeTriangle(const f32 v0[4], const f32 v1[4], const f32 v2[4])
+{
+    //---- クリッピング
+    ClipPosition polygon[2][MAX_CLIP_VERTEX];
+    std::copy_n(v0, 4, polygon[0][0].v_);
+    std::copy_n(v1, 4, polygon[0][1].v_);
+    std::copy_n(v2, 4, polygon[0][2].v_);
+
+    s32 count = 3;
+    s32 src   = 0;
+    for(const auto& plane : CLIP_PLANES) {
+        count = clipPolygon(polygon[src], count, polygon[src ^ 1], plane);
+        src ^= 1;
+        if(count < 3) {
+            return;
+        }
+    }
+
+    //---- スクリーン座標に変換して扇形に分割
+    const Level& level = levels_[0];
+    f32          x[MAX_CLIP_VERTEX];
+    f32          y[MAX_CLIP_VERTEX];
+    f32          z[MAX_CLIP_VERTEX];
+    for(s32 i = 0; i < count; ++i) {
+        const f32* p  = polygon[src][i].v_;
+        f32        rw = 1.0f / p[3];
+        x[i]          = (p[0] * rw * 0.5f + 0.5f) * static_cast<f32>(level.width_);
+        y[i]          = (p[1] * rw * 0.5f + 0.5f) * static_cast<f32>(level.height_);
+        z[i]          = p[2] * rw * 0.5f + 0.5f;
+    }
+
+    f32* depth_buffer = &depth_[level.offset_];
+    for(s32 i = 1; i + 1 < count; ++i) {
+        f32 tx[3]{x[0], x[i], x[i + 1]};
+        f32 ty[3]{y[0], y[i], y[i + 1]};
+        f32 tz[3]{z[0], z[i], z[i + 1]};
+        fillTriangle(depth_buffer, level.width_, level.height_, level.pitch_, tx, ty, tz);
+    }
+    triangle_count_++;
+}
+
+//---------------------------------------------------------------------------
+//! 階層Zバッファを作成
+//---------------------------------------------------------------------------
+void OcclusionCuller::buildHiZ()
+{
+    // 2x2の最も遠い深度を上の段に書き込む
+    for(s32 i = 1; i < level_count_; ++i) {
+        const Level& src = levels_[i - 1];
+        const Level& dst = levels_[i];
+
+        for(s32 y = 0; y < dst.height_; ++y) {
+            const f32* row0 = &depth_[src.offset_ + std::min(y * 2, src.height_ - 1) * src.pitch_];
+            const f32* row1 = &depth_[src.offset_ + std::min(y * 2 + 1, src.height_ - 1) * src.pitch_];
+            f32*       out  = &depth_[dst.offset_ + y * dst.pitch_];
+
+            for(s32 x = 0; x < dst.width_; ++x) {
+                s32 x0 = x * 2;
+                s32 x1 = std::min(x * 2 + 1, src.width_ - 1);
+                out[x] = std::max({row0[x0], row0[x1], row1[x0], row1[x1]});
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 深度を取得
+//---------------------------------------------------------------------------
+f32 OcclusionCuller::getDepth(s32 level_index, s32 x, s32 y) const
+{
+    const Level& level = levels_[level_index];
+    return depth_[level.offset_ + y * level.pitch_ + x];
+}
+
+//---------------------------------------------------------------------------
+//! AABBが見えるかどうか
+//---------------------------------------------------------------------------
+bool OcclusionCuller::testAABB(const AABB& box) const
+{
+    // 4レーン全てに同じ箱を入れて先頭の結果を使う
+    __m128 box_min[3]{_mm_set1_ps(box.min_.x), _mm_set1_ps(box.min_.y), _mm_set1_ps(box.min_.z)};
+    __m128 box_max[3]{_mm_set1_ps(box.max_.x), _mm_set1_ps(box.max_.y), _mm_set1_ps(box.max_.z)};
+    return (testBoxes(box_min, box_max) & 1) != 0;
+}
+
+//---------------------------------------------------------------------------
+//! AABBをまとめて判定
+//---------------------------------------------------------------------------
+s32 OcclusionCuller::testAABBs(const AABBArray& boxes, u8* visible) const
+{
+    s32 count         = boxes.size();
+    s32 visible_count = 0;
+
+    for(s32 i = 0; i < count; i += 4) {
+        __m128 box_min[3];
+        __m128 box_max[3];
+        for(s32 axis = 0; axis < 3; ++axis) {
+            box_min[axis] = _mm_loadu_ps(boxes.getMin(axis) + i);
+            box_max[axis] = _mm_loadu_ps(boxes.getMax(axis) + i);
+        }
+
+        u32 mask = testBoxes(box_min, box_max);
+        for(s32 lane = 0; lane < 4 && i + lane < count; ++lane) {
+            u8 result         = static_cast<u8>((mask >> lane) & 1);
+            visible[i + lane] = result;
+            visible_count += result;
+        }
+    }
+    return visible_count;
+}
+
+//---------------------------------------------------------------------------
+//! 4個のAABBを判定
+//---------------------------------------------------------------------------
+u32 OcclusionCuller::testBoxes(const __m128 box_min[3], const __m128 box_max[3]) const
+{
+    if(level_count_ == 0) {
+        return 0xf;   // 未初期化の場合は全て見えている扱い
+    }
+
+    const f32(&m)[4][4] = *reinterpret_cast<const f32(*)[4][4]>(&view_proj_);
+
+    //---- 8頂点を投影して画面上の矩形と最も近い深度を求める (4個同時)
+    const __m128 inf        = _mm_set1_ps(FLT_MAX);
+    __m128       rect_min_x = inf;
+    __m128       rect_min_y = inf;
+    __m128       rect_max_x = _mm_set1_ps(-FLT_MAX);
+    __m128       rect_max_y = _mm_set1_ps(-FLT_MAX);
+    __m128       min_depth  = inf;
+    __m128       near_cross = _mm_setzero_ps();
+
+    for(s32 corner = 0; corner < 8; ++corner) {
+        __m128 x = (corner & 1) ? box_max[0] : box_min[0];
+        __m128 y = (corner & 2) ? box_max[1] : box_min[1];
+        __m128 z = (corner & 4) ? box_max[2] : box_min[2];
+
+        __m128 clip[4];
+        for(s32 i = 0; i < 4; ++i) {
+            clip[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[0][i])), _mm_mul_ps(y, _mm_set1_ps(m[1][i]))),
+                                 _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m[2][i])), _mm_set1_ps(m[3][i])));
+        }
+
+        // 近クリップ面より手前の頂点があると投影できないため見えている扱い
+        near_cross = _mm_or_ps(near_cross, _mm_cmplt_ps(clip[2], _mm_sub_ps(_mm_setzero_ps(), clip[3])));
+
+        __m128 rw = _mm_div_ps(_mm_set1_ps(1.0f), clip[3]);
+        __m128 nx = _mm_mul_ps(clip[0], rw);
+        __m128 ny = _mm_mul_ps(clip[1], rw);
+        __m128 nz = _mm_mul_ps(clip[2], rw);
+
+        rect_min_x = _mm_min_ps(rect_min_x, nx);
+        rect_min_y = _mm_min_ps(rect_min_y, ny);
+        rect_max_x = _mm_max_ps(rect_max_x, nx);
+        rect_max_y = _mm_max_ps(rect_max_y, ny);
+        min_depth  = _mm_min_ps(min_depth, nz);
+    }
+
+    //---- 正規化デバイス座標 → ピクセル座標
+    const Level& level  = levels_[0];
+    const __m128 half   = _mm_set1_ps(0.5f);
+    const __m128 width  = _mm_set1_ps(static_cast<f32>(level.width_));
+    const __m128 height = _mm_set1_ps(static_cast<f32>(level.height_));
+
+    alignas(16) f32 x0[4];
+    alignas(16) f32 y0[4];
+    alignas(16) f32 x1[4];
+    alignas(16) f32 y1[4];
+    alignas(16) f32 depth[4];
+    _mm_store_ps(x0, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rect_min_x, half), half), width));
+    _mm_store_ps(y0, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rect_min_y, half), half), height));
+    _mm_store_ps(x1, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rect_max_x, half), half), width));
+    _mm_store_ps(y1, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rect_max_y, half), half), height));
+    _mm_store_ps(depth, _mm_add_ps(_mm_mul_ps(min_depth, half), half));
+
+    //---- Hi-Zと比較 (1個ずつ)
+    u32 result = static_cast<u32>(_mm_movemask_ps(near_cross));
+    for(s32 lane = 0; lane < 4; ++lane) {
+        if(result & (1u << lane)) {
+            continue;
+        }
+
+        // 画面外・遠クリップ面より奥は遮蔽物と関係なく見えない扱い (testAABB()の仕様)
+        if(!(x1[lane] >= 0.0f && y1[lane] >= 0.0f && x0[lane] < static_cast<f32>(level.width_) &&
+             y0[lane] < static_cast<f32>(level.height_) && depth[lane] <= 1.0f)) {
+            continue;
+        }
+
+        s32 px0 = std::max(static_cast<s32>(std::floor(x0[lane])), 0);
+        s32 py0 = std::max(static_cast<s32>(std::floor(y0[lane])), 0);
+        s32 px1 = std::min(static_cast<s32>(std::floor(x1[lane])), level.width_ - 1);
+        s32 py1 = std::min(static_cast<s32>(std::floor(y1[lane])), level.height_ - 1);
+        if(testRect(px0, py0, px1, py1, depth[lane])) {
+            result |= 1u << lane;
+        }
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! 画面上の矩形の範囲で最も遠い深度と比較
+//---------------------------------------------------------------------------
+bool OcclusionCuller::testRect(s32 x0, s32 y0, s32 x1, s32 y1, f32 depth) const
+{
+    // 矩形が2x2要素以内に収まる段を選ぶ
+    s32 level_index = 0;
+    while(level_index + 1 < level_count_ &&
+          ((x1 >> level_index) - (x0 >> level_index) > 1 || (y1 >> level_index) - (y0 >> level_index) > 1)) {
+        level_index++;
+    }
+
+    const Level& level = levels_[level_index];
+    f32          far_depth = 0.0f;
+    for(s32 y = y0 >> level_index; y <= (y1 >> level_index); ++y) {
+        for(s32 x = x0 >> level_index; x <= (x1 >> level_index); ++x) {
+            far_depth = std::max(far_depth, depth_[level.offset_ + y * level.pitch_ + x]);
+        }
+    }
+    return depth <= far_depth;
+}
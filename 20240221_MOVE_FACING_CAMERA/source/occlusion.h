@@ -0,0 +1,129 @@
+﻿//===========================================================================
+//!	@file	occlusion.h
+//!	@brief	オクルージョンカリング (CPUの低解像度深度バッファ + 階層Z)
+//!
+//!	遮蔽物に指定したメッシュを低解像度の深度バッファに描画し、2x2の最大値で
+//!	縮小した階層Zバッファ(Hi-Z)を作成します。物体のAABBを画面に投影し、
+//!	投影範囲で最も遠い遮蔽物よりもさらに奥にあれば描画を省略できます。
+//!	画面外・遠クリップ面より奥のAABBも見えないと判定するため、視錐台カリングの
+//!	結果と区別する必要がある場合は先に視錐台で判定してください。
+//!	AABBの投影は4個ずつSIMDで計算します。
+//!
+//! @code
+//!     culler.beginFrame(mul(camera.getViewMatrix(), camera.getProjMatrix()));
+//!     culler.drawOccluder(vertices, indices, world);   // 遮蔽物を全て描画
+//!     culler.buildHiZ();
+//!     if(culler.testAABB(box)) {
+//!         ...   // 見えている場合のみ描画 (隠れている・画面外の場合は省略)
+//!     }
+//! @endcode
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! オクルージョンカリング
+//!
+//! 深度は0.0(近)～1.0(遠)。投影行列はOpenGL互換 (変換後のZ値が-1.0～+1.0)
+//===========================================================================
+class OcclusionCuller
+{
+public:
+    static constexpr s32 MAX_LEVEL_COUNT = 16;   //!< Hi-Zの最大段数
+
+    //! コンストラクタ
+    OcclusionCuller() = default;
+
+    //! 初期化
+    //! @param  [in]    width   深度バッファの幅 (画面より小さくてよい)
+    //! @param  [in]    height  深度バッファの高さ
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(失敗)
+    bool setup(s32 width, s32 height);
+
+    //! 解放
+    void cleanup();
+
+    //! フレーム開始 (深度バッファをクリア)
+    //! @param  [in]    view_proj   ビュー行列×投影行列
+    void beginFrame(const matrix& view_proj);
+
+    //! 遮蔽物を描画 (両面、三角形リスト)
+    //! @param  [in]    vertices    頂点座標
+    //! @param  [in]    indices     インデックス (3個で三角形1個)
+    //! @param  [in]    world       ワールド行列
+    void drawOccluder(std::span<const float3> vertices, std::span<const u16> indices, const matrix& world);
+
+    //! 階層Zバッファを作成 (遮蔽物を全て描画した後に呼ぶ)
+    void buildHiZ();
+
+    //! AABBが見えるかどうか
+    //! 遮蔽の判定に加えて、画面外と遠クリップ面より奥も見えないと判定します。
+    //! 近クリップ面をまたぐAABBと、初期化前 (setup()前) は常に見えている扱いです。
+    //! @param  [in]    box     AABB (ワールド座標)
+    //!	@retval	true	見えている可能性がある
+    //!	@retval	false	見えない (遮蔽物に完全に隠れている・画面外・遠クリップ面より奥のいずれか)
+    bool testAABB(const AABB& box) const;
+
+    //! AABBをまとめて判定 (4個ずつSIMDで計算、判定の意味はtestAABB()と同じ)
+    //! @param  [in]    boxes   AABBの配列 (ワールド座標)
+    //! @param  [out]   visible 判定結果 (1:見えている可能性がある 0:見えない) boxes.size()個
+    //! @return 見えているAABBの数
+    s32 testAABBs(const AABBArray& boxes, u8* visible) const;
+
+    //----------------------------------------------------------
+    //! @name 参照
+    //----------------------------------------------------------
+    //!@{
+
+    //! 幅を取得
+    s32 getWidth() const { return levels_[0].width_; }
+
+    //! 高さを取得
+    s32 getHeight() const { return levels_[0].height_; }
+
+    //! Hi-Zの段数を取得
+    s32 getLevelCount() const { return level_count_; }
+
+    //! 深度を取得
+    //! @param  [in]    level   Hi-Zの段数 (0が最も詳細)
+    //! @param  [in]    x       X座標 (範囲内であること)
+    //! @param  [in]    y       Y座標 (範囲内であること、最下行が0)
+    f32 getDepth(s32 level, s32 x, s32 y) const;
+
+    //! このフレームで描画した遮蔽物の三角形数を取得
+    s32 getOccluderTriangleCount() const { return triangle_count_; }
+
+    //!@}
+
+private:
+    // コピー禁止
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    void operator=(const OcclusionCuller&)  = delete;
+
+    //! Hi-Z 1段分
+    struct Level
+    {
+        s32 offset_ = 0;   //!< depth_内の先頭位置
+        s32 width_  = 0;   //!< 幅
+        s32 height_ = 0;   //!< 高さ
+        s32 pitch_  = 0;   //!< 1行の要素数
+    };
+
+    //! クリップ座標の三角形を描画
+    void rasterizeTriangle(const f32 v0[4], const f32 v1[4], const f32 v2[4]);
+
+    //! 4個のAABBを判定 (判定の意味はtestAABB()と同じ)
+    //! @return 見えている可能性があるAABBのビットマスク (bit0-3)
+    u32 testBoxes(const __m128 box_min[3], const __m128 box_max[3]) const;
+
+    //! 画面上の矩形の範囲で最も遠い深度と比較
+    //!	@retval	true	見えている可能性がある
+    bool testRect(s32 x0, s32 y0, s32 x1, s32 y1, f32 depth) const;
+
+private:
+    matrix           view_proj_ = matrix::identity();   //!< ビュー行列×投影行列
+    Level            levels_[MAX_LEVEL_COUNT];          //!< Hi-Zの各段
+    s32              level_count_    = 0;               //!< Hi-Zの段数
+    std::vector<f32> depth_;                            //!< 全段の深度
+    s32              triangle_count_ = 0;               //!< 描画した遮蔽物の三角形数
+};
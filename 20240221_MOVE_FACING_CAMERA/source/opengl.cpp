@@ -127,6 +127,24 @@ void OpenGL_swapBuffer()
     SwapBuffers(gHdc);
 }
 
+//---------------------------------------------------------------------------
+//! 垂直同期を設定
+//!	@param	[in]	enable	true:垂直同期ON false:垂直同期OFF
+//!	@retval	true	正常終了		(成功)
+//!	@retval	false	エラー終了	(非対応のドライバー)
+//---------------------------------------------------------------------------
+bool OpenGL_setVSync(bool enable)
+{
+    // WGL_EXT_swap_control 拡張機能 (コンテキスト作成後に取得する必要がある)
+    using PFNWGLSWAPINTERVALEXTPROC = BOOL(WINAPI*)(int interval);
+
+    auto wglSwapIntervalEXT = reinterpret_cast<PFNWGLSWAPINTERVALEXTPROC>(wglGetProcAddress("wglSwapIntervalEXT"));
+    if(wglSwapIntervalEXT == nullptr) {
+        return false;
+    }
+    return wglSwapIntervalEXT(enable ? 1 : 0) != FALSE;
+}
+
 //---------------------------------------------------------------------------
 //!	OpenGLを解放
 //!	@retval	true	正常終了		(成功)
@@ -13,6 +13,12 @@ bool OpenGL_setup(HWND hwnd);
 //! OpenGL画面更新
 void OpenGL_swapBuffer();
 
+//! 垂直同期を設定
+//!	@param	[in]	enable	true:垂直同期ON false:垂直同期OFF
+//!	@retval	true	正常終了		(成功)
+//!	@retval	false	エラー終了	(非対応のドライバー)
+bool OpenGL_setVSync(bool enable);
+
 //!	OpenGLを解放
 //!	@retval	true	正常終了		(成功)
 //!	@retval	false	エラー終了	(失敗)
@@ -0,0 +1,391 @@
+﻿//===========================================================================
+//!	@file	pack.cpp
+//!	@brief	アセットパック
+//!
+//!	ファイルの構成は以下の通りです (リトルエンディアン)。
+//!	    PackHeader
+//!	    PackEntry × 項目数 (項目名の順)
+//!	    データ (各項目はPACK_ALIGNMENT境界から開始、間は0で埋める)
+//===========================================================================
+#include <filesystem>
+
+namespace
+{
+constexpr u32 PACK_VERSION = 2;     //!< ファイル形式のバージョン
+constexpr s32 NAME_SIZE    = 104;   //!< 項目名の最大バイト数 (終端の0を含む)
+
+//! ファイルヘッダー
+struct PackHeader
+{
+    char magic_[4]    = {'P', 'A', 'C', 'K'};   //!< 識別子
+    u32  version_     = PACK_VERSION;           //!< バージョン
+    u32  entry_count_ = 0;                      //!< 項目数
+    u32  reserved_    = 0;
+};
+
+//! 目次の項目
+struct PackEntry
+{
+    char name_[NAME_SIZE] = {};   //!< 項目名 (英字は小文字、'/'区切り)
+    u32  type_            = 0;    //!< 種類 (PackType)
+    u32  reserved_        = 0;
+    u64  offset_          = 0;    //!< データの位置 (PACK_ALIGNMENT境界)
+    u64  size_            = 0;    //!< データのバイト数
+    u64  source_size_     = 0;    //!< 作成時の元ファイルのバイト数
+    u64  source_time_     = 0;    //!< 作成時の元ファイルの更新日時
+};
+static_assert(sizeof(PackEntry) == 144);
+
+HANDLE                 file    = INVALID_HANDLE_VALUE;   //!< 開いているパック
+HANDLE                 mapping = nullptr;                //!< パック全体のファイルマッピング
+std::vector<PackEntry> entries;                          //!< 目次 (項目名の順)
+
+//---------------------------------------------------------------------------
+//! 項目名を正規化 (英字を小文字、'\\'を'/'に変換)
+//! マルチバイト文字の2バイト目を変えないようにASCIIの英字だけを変換する
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(長すぎる)
+//---------------------------------------------------------------------------
+bool normalizeName(const char* name, char (&out)[NAME_SIZE])
+{
+    size_t length = strlen(name);
+    if(length >= NAME_SIZE) {
+        return false;
+    }
+    for(size_t i = 0; i <= length; ++i) {
+        char c = name[i];
+        if(c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        out[i] = (c == '\\') ? '/' : c;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 配置単位に切り上げ
+//---------------------------------------------------------------------------
+u64 alignUp(u64 value)
+{
+    return (value + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+}
+
+//---------------------------------------------------------------------------
+//! 0で埋める
+//---------------------------------------------------------------------------
+bool writeZeros(FILE* out, u64 size)
+{
+    static const u8 zeros[4096] = {};
+
+    while(size > 0) {
+        size_t count = static_cast<size_t>(std::min<u64>(size, sizeof(zeros)));
+        if(fwrite(zeros, 1, count, out) != count) {
+            return false;
+        }
+        size -= count;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 元ファイルのサイズと更新日時を取得
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(ファイルがない)
+//---------------------------------------------------------------------------
+bool getSourceStamp(const char* path, u64& size, u64& time)
+{
+    std::error_code error;
+    u64             file_size = std::filesystem::file_size(path, error);
+    if(error) {
+        return false;
+    }
+    auto write_time = std::filesystem::last_write_time(path, error);
+    if(error) {
+        return false;
+    }
+    size = file_size;
+    time = static_cast<u64>(write_time.time_since_epoch().count());
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャとして読み込める拡張子かどうか (LoadTexture()・GDI+の対応形式)
+//---------------------------------------------------------------------------
+bool isTextureFile(const std::filesystem::path& path)
+{
+    constexpr const char* extensions[]{".tga", ".bmp", ".png", ".jpg", ".jpeg", ".gif", ".tif", ".tiff"};
+
+    std::string extension = path.extension().string();
+    for(const char* candidate : extensions) {
+        if(_stricmp(extension.c_str(), candidate) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! マップを解除
+//---------------------------------------------------------------------------
+void PackView::reset()
+{
+    if(data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! アセットパックを作成
+//---------------------------------------------------------------------------
+bool PACK_build(const char* path, const char* directory)
+{
+    char text[256];
+
+    //-------------------------------------------------------------
+    // 画像ファイルを列挙して項目名の順に並べる
+    //-------------------------------------------------------------
+    struct Source
+    {
+        PackEntry   entry_;   //!< 目次の項目
+        std::string path_;    //!< 画像ファイル名
+    };
+    std::vector<Source> sources;
+
+    std::error_code error;
+    for(const auto& item : std::filesystem::recursive_directory_iterator(directory, error)) {
+        if(!item.is_regular_file() || !isTextureFile(item.path())) {
+            continue;
+        }
+        Source source;
+        source.path_ = item.path().generic_string();
+        if(!normalizeName(source.path_.c_str(), source.entry_.name_)) {
+            sprintf_s(text, "[PACK] name too long : %s\n", source.path_.c_str());
+            OutputDebugStringA(text);
+            return false;
+        }
+        source.entry_.type_ = static_cast<u32>(PackType::Texture);
+        sources.push_back(std::move(source));
+    }
+    if(error) {
+        return false;
+    }
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) {
+        return strcmp(a.entry_.name_, b.entry_.name_) < 0;
+    });
+
+    //-------------------------------------------------------------
+    // データを書き込む (目次は位置が決まってから最後に書き込む)
+    //-------------------------------------------------------------
+    FILE* out = nullptr;
+    fopen_s(&out, path, "wb");
+    if(out == nullptr) {
+        return false;
+    }
+
+    u64             offset = alignUp(sizeof(PackHeader) + sizeof(PackEntry) * sources.size());
+    std::vector<u8> data;
+
+    bool result = writeZeros(out, offset);
+    for(auto& source : sources) {
+        if(!result) {
+            break;
+        }
+        // 展開前に記録する (展開中に更新された場合は次回の読み込みで古いと判定される)
+        if(!getSourceStamp(source.path_.c_str(), source.entry_.source_size_, source.entry_.source_time_) ||
+           !TEXTURE_cook(source.path_.c_str(), data)) {
+            sprintf_s(text, "[PACK] failed to cook : %s\n", source.path_.c_str());
+            OutputDebugStringA(text);
+            result = false;
+            break;
+        }
+        source.entry_.offset_ = offset;
+        source.entry_.size_   = data.size();
+
+        u64 padded = alignUp(data.size());
+        result     = fwrite(data.data(), 1, data.size(), out) == data.size() && writeZeros(out, padded - data.size());
+        offset += padded;
+
+        sprintf_s(text, "[PACK] %-48s %8.1f KB\n", source.entry_.name_, static_cast<f64>(data.size()) / 1024.0);
+        OutputDebugStringA(text);
+    }
+
+    PackHeader header;
+    header.entry_count_ = static_cast<u32>(sources.size());
+
+    result = result && _fseeki64(out, 0, SEEK_SET) == 0;
+    result = result && fwrite(&header, sizeof(header), 1, out) == 1;
+    for(const auto& source : sources) {
+        result = result && fwrite(&source.entry_, sizeof(source.entry_), 1, out) == 1;
+    }
+    fclose(out);
+
+    // 途中で失敗したパックは読み込まれないように削除
+    if(!result) {
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    sprintf_s(text, "[PACK] %s : %zu entries, %.1f MB\n", path, sources.size(), static_cast<f64>(offset) / (1024.0 * 1024.0));
+    OutputDebugStringA(text);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! アセットパックを開く
+//---------------------------------------------------------------------------
+bool PACK_open(const char* path)
+{
+    PACK_close();
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    //-------------------------------------------------------------
+    // ヘッダーと目次を読み込む (データはPACK_map()で必要な時にマップ)
+    //-------------------------------------------------------------
+    PackHeader    header;
+    PackHeader    expected;
+    DWORD         read_size = 0;
+    LARGE_INTEGER file_size{};
+
+    bool result = GetFileSizeEx(file, &file_size) != FALSE;
+    result      = result && ReadFile(file, &header, sizeof(header), &read_size, nullptr) != FALSE && read_size == sizeof(header);
+    result      = result && memcmp(header.magic_, expected.magic_, sizeof(header.magic_)) == 0;
+    result      = result && header.version_ == PACK_VERSION;
+    result      = result && sizeof(header) + sizeof(PackEntry) * u64(header.entry_count_) <= u64(file_size.QuadPart);
+    if(result) {
+        entries.resize(header.entry_count_);
+        DWORD toc_size = static_cast<DWORD>(entries.size() * sizeof(PackEntry));
+        result         = ReadFile(file, entries.data(), toc_size, &read_size, nullptr) != FALSE && read_size == toc_size;
+    }
+
+    // 壊れた目次で範囲外をマップしないように確認
+    for(auto& entry : entries) {
+        entry.name_[NAME_SIZE - 1] = '\0';
+        result                     = result && (entry.offset_ % PACK_ALIGNMENT) == 0;
+        result                     = result && entry.offset_ <= u64(file_size.QuadPart);
+        result                     = result && entry.size_ <= u64(file_size.QuadPart) - entry.offset_;   // 加算の桁あふれを避ける
+    }
+    result = result && std::is_sorted(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) {
+                 return strcmp(a.name_, b.name_) < 0;
+             });
+
+    //-------------------------------------------------------------
+    // ファイル全体のマッピングを作成 (アドレス空間への割り当てはPACK_map()で項目ごとに行う)
+    //-------------------------------------------------------------
+    if(result) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        result  = mapping != nullptr;
+    }
+
+    if(!result) {
+        PACK_close();
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! アセットパックを閉じる
+//---------------------------------------------------------------------------
+void PACK_close()
+{
+    if(mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if(file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+    entries.clear();
+    entries.shrink_to_fit();
+}
+
+//---------------------------------------------------------------------------
+//! アセットパックを開いているかどうか
+//---------------------------------------------------------------------------
+bool PACK_isOpen()
+{
+    return mapping != nullptr;
+}
+
+//---------------------------------------------------------------------------
+//! 項目を検索
+//---------------------------------------------------------------------------
+s32 PACK_find(const char* name)
+{
+    char key[NAME_SIZE];
+    if(entries.empty() || !normalizeName(name, key)) {
+        return -1;
+    }
+
+    // 目次は項目名の順に並んでいるため二分探索
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const PackEntry& entry, const char* key) {
+        return strcmp(entry.name_, key) < 0;
+    });
+    if(it == entries.end() || strcmp(it->name_, key) != 0) {
+        return -1;
+    }
+    return static_cast<s32>(it - entries.begin());
+}
+
+//---------------------------------------------------------------------------
+//! 項目が元ファイルより古いかどうか
+//---------------------------------------------------------------------------
+bool PACK_isStale(s32 entry)
+{
+    assert(entry >= 0 && entry < static_cast<s32>(entries.size()));
+    const PackEntry& item = entries[entry];
+
+    // 元ファイルがない場合 (パックのみで配布) はパックを使う
+    u64 size = 0;
+    u64 time = 0;
+    if(!getSourceStamp(item.name_, size, time)) {
+        return false;
+    }
+    return size != item.source_size_ || time != item.source_time_;
+}
+
+//---------------------------------------------------------------------------
+//! 項目の種類を取得
+//---------------------------------------------------------------------------
+PackType PACK_getType(s32 entry)
+{
+    assert(entry >= 0 && entry < static_cast<s32>(entries.size()));
+    return static_cast<PackType>(entries[entry].type_);
+}
+
+//---------------------------------------------------------------------------
+//! 項目のデータをマップ
+//---------------------------------------------------------------------------
+PackView PACK_map(s32 entry)
+{
+    PackView view;
+    if(mapping == nullptr || entry < 0 || entry >= static_cast<s32>(entries.size())) {
+        return view;
+    }
+
+    // サイズ0を指定するとファイルの末尾までマップされるため空の項目はマップしない
+    const PackEntry& item = entries[entry];
+    if(item.size_ == 0) {
+        return view;
+    }
+
+    void* data = MapViewOfFile(mapping,
+                               FILE_MAP_READ,
+                               static_cast<DWORD>(item.offset_ >> 32),
+                               static_cast<DWORD>(item.offset_ & 0xffffffffull),
+                               static_cast<SIZE_T>(item.size_));
+    if(data) {
+        view.data_ = static_cast<const u8*>(data);
+        view.size_ = static_cast<size_t>(item.size_);
+    }
+    return view;
+}
@@ -0,0 +1,121 @@
+﻿//===========================================================================
+//!	@file	pack.h
+//!	@brief	アセットパック (展開済みのアセットを1ファイルにまとめて読み込む)
+//!
+//!	起動時のファイルごとのオープンと画像の展開を省くため、アセットを事前に
+//!	展開して1つのパックファイルにまとめます。パックは目次 (名前・位置・サイズ) と
+//!	64KB境界に揃えたデータ部からなります。実行時は目次だけを読み込み、
+//!	データ部は必要になった時点で項目ごとにメモリマップします
+//!	(64KBはMapViewOfFile()のオフセットの単位)。
+//!	パックにないアセットと、元ファイルがパック作成時からサイズ・更新日時が
+//!	変わっているアセット (PACK_isStale()) は従来通りファイルから読み込みます。
+//!
+//! @code
+//!     PACK_build("data/assets.pak", "data");      // 事前に作成 (コマンドライン: -pack)
+//!
+//!     PACK_open("data/assets.pak");               // 起動時 (目次のみ読み込む)
+//!     s32 entry = PACK_find("data/sample.tga");
+//!     if(entry >= 0 && !PACK_isStale(entry)) {
+//!         PackView view = PACK_map(entry);        // 項目のデータをマップ
+//!         ...
+//!     }
+//!     PACK_close();
+//! @endcode
+//===========================================================================
+#pragma once
+
+constexpr u64 PACK_ALIGNMENT = 64 * 1024;   //!< 各項目のデータの配置単位 (MapViewOfFile()のオフセットの単位)
+
+//! 項目の種類
+enum class PackType : u32
+{
+    Texture,   //!< テクスチャ (TEXTURE_cook()の出力)
+};
+
+//===========================================================================
+//! マップした項目のデータ (破棄するとマップを解除)
+//===========================================================================
+class PackView
+{
+public:
+    //! コンストラクタ
+    PackView() = default;
+
+    //! デストラクタ
+    ~PackView() { reset(); }
+
+    PackView(PackView&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    PackView& operator=(PackView&& other) noexcept
+    {
+        if(this != &other) {
+            reset();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    PackView(const PackView&)            = delete;
+    PackView& operator=(const PackView&) = delete;
+
+    //! データの先頭を取得 (PACK_ALIGNMENT境界)
+    const u8* data() const { return data_; }
+
+    //! データのバイト数を取得
+    size_t size() const { return size_; }
+
+    //! 空かどうか (マップに失敗した)
+    bool empty() const { return data_ == nullptr; }
+
+    //! マップを解除
+    void reset();
+
+private:
+    friend PackView PACK_map(s32 entry);
+
+    const u8* data_ = nullptr;   //!< マップした先頭 (MapViewOfFile()の戻り値)
+    size_t    size_ = 0;         //!< データのバイト数
+};
+
+//! アセットパックを作成 (ディレクトリ以下の画像ファイルを全て展開して格納)
+//! @param  [in]    path        パックのファイル名
+//! @param  [in]    directory   アセットのディレクトリ (項目名は "ディレクトリ/ファイル名")
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(書き込み・展開に失敗)
+bool PACK_build(const char* path, const char* directory);
+
+//! アセットパックを開く (目次のみ読み込む)
+//! @param  [in]    path    パックのファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(ファイルがない・形式が異なる)
+bool PACK_open(const char* path);
+
+//! アセットパックを閉じる (PackViewを全て破棄してから呼び出してください)
+void PACK_close();
+
+//! アセットパックを開いているかどうか
+bool PACK_isOpen();
+
+//! 項目を検索
+//! @param  [in]    name    項目名 (ファイル名、大文字小文字と'\\'・'/'を区別しない)
+//! @return 項目番号 (見つからない・パックを開いていない場合は-1)
+s32 PACK_find(const char* name);
+
+//! 項目が元ファイルより古いかどうか (元ファイルのサイズ・更新日時がパック作成時と異なる)
+//! @param  [in]    entry   項目番号
+//! @retval true    古い (元ファイルから読み込むべき)
+//! @retval false   最新、または元ファイルがない (パックのみで配布)
+bool PACK_isStale(s32 entry);
+
+//! 項目の種類を取得
+PackType PACK_getType(s32 entry);
+
+//! 項目のデータをマップ
+//! @param  [in]    entry   項目番号
+//! @return マップしたデータ (失敗時は空)
+PackView PACK_map(s32 entry);
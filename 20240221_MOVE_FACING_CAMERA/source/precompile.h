@@ -20,15 +20,24 @@
 #define NOMINMAX
 //#define WIN32_LEAN_AND_MEAN	※texture.cppでgdiplus利用時に定義するとエラーになる
 #include <windows.h>
+#include <intrin.h>   // __rdtsc()
 
 //--------------------------------------------------------------
 // STL
 //--------------------------------------------------------------
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cassert>
 #include <cmath>   // 算術演算
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <semaphore>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <numbers>	// PI
 
@@ -53,7 +62,29 @@ using namespace hlslpp;
 #include "typedef.h"
 
 #include "opengl.h"
+#include "timer.h"
+#include "memory.h"
+#include "input.h"
+#include "profile.h"
+#include "gltrace.h"
+#include "job.h"
+#include "arena.h"
 #include "vectormath.h"
+#include "bounds.h"
+#include "frustum.h"
+#include "bvh.h"
+#include "grid.h"
+#include "entity.h"
+#include "transform.h"
+#include "lod.h"
+#include "sampler.h"
 #include "texture.h"
+#include "pack.h"
+#include "rasterizer.h"
+#include "render.h"
+#include "occlusion.h"
+#include "scene.h"
+#include "hud.h"
 #include "main.h"
 #include "game.h"
+#include "benchmark.h"
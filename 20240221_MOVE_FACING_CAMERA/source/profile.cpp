@@ -0,0 +1,408 @@
+﻿//===========================================================================
+//!	@file	profile.cpp
+//!	@brief	CPUプロファイラー (スコープ単位の計測・Chromeトレース出力)
+//===========================================================================
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+constexpr s32 MAX_THREAD_COUNT   = 64;        //!< 計測するスレッドの最大数
+constexpr u32 RING_CAPACITY      = 1 << 16;   //!< 1スレッドのリングバッファの記録数 (2のべき乗)
+constexpr s32 STATS_WINDOW       = 120;       //!< 統計を集計するフレーム数
+constexpr u64 MAX_CAPTURE_EVENTS = 1 << 21;   //!< キャプチャで保持する最大の記録数
+
+//! 1回分の記録
+struct Event
+{
+    const char* name_;    //!< ゾーン名
+    u64         begin_;   //!< 開始時のTSC
+    u64         end_;     //!< 終了時のTSC
+};
+
+//! キャプチャした記録
+struct CaptureEvent
+{
+    Event event_;    //!< 記録
+    s32   thread_;   //!< スレッド番号
+};
+
+//===========================================================================
+//! スレッドごとのリングバッファ (書き込みは所有スレッド、読み出しはPROFILE_endFrame()のみ)
+//===========================================================================
+struct ThreadBuffer
+{
+    alignas(64) std::atomic<u32> write_{0};   //!< 書き込み位置 (所有スレッドのみ更新)
+    alignas(64) std::atomic<u32> read_{0};    //!< 読み出し位置 (PROFILE_endFrame()のみ更新)
+    std::atomic<u32> dropped_count_{0};       //!< あふれて捨てた記録数
+
+    std::string name_;                    //!< スレッド名 (registry_mutexで保護)
+    Event       events_[RING_CAPACITY];   //!< 記録
+};
+
+//! ゾーンの直近のフレームの記録
+struct ZoneHistory
+{
+    f64 frame_ms_[STATS_WINDOW]    = {};    //!< フレームごとの合計時間 (単位:ミリ秒)
+    u32 frame_calls_[STATS_WINDOW] = {};    //!< フレームごとの呼び出し回数
+    s32 count_                     = 0;     //!< 記録したフレーム数 (STATS_WINDOWまで)
+    s32 next_                      = 0;     //!< 次に書き込む位置
+    f64 current_ms_                = 0.0;   //!< 今フレームの合計時間
+    u32 current_calls_             = 0;     //!< 今フレームの呼び出し回数
+};
+
+std::unique_ptr<ThreadBuffer> thread_buffers[MAX_THREAD_COUNT];   //!< スレッドごとのリングバッファ
+std::vector<s32>              free_slots;                         //!< 空いているスロット番号
+s32                           slot_count = 0;                     //!< 使用したスロット数
+std::mutex                    registry_mutex;                     //!< スロット割り当て・回収・集計用
+
+u64 base_ticks       = 0;     //!< PROFILE_setup()時のTSC
+f64 base_time        = 0.0;   //!< PROFILE_setup()時のTIMER_now()
+f64 ticks_per_second = 1.0;   //!< TSCの周波数
+
+std::unordered_map<std::string_view, ZoneHistory> zones;   //!< ゾーンごとの記録 (名前で集計)
+
+std::atomic<bool>         capturing{false};      //!< キャプチャ中かどうか
+std::vector<CaptureEvent> capture_events;        //!< キャプチャした記録
+u64                       capture_dropped = 0;   //!< キャプチャしきれなかった記録数
+
+//===========================================================================
+//! スレッド終了時にスロットを返却する
+//===========================================================================
+struct ThreadSlot
+{
+    s32 index_ = -1;
+
+    ~ThreadSlot()
+    {
+        if(index_ >= 0) {
+            std::lock_guard lock(registry_mutex);
+            free_slots.push_back(index_);
+        }
+    }
+};
+
+thread_local ThreadSlot thread_slot;   //!< このスレッドのスロット
+
+//---------------------------------------------------------------------------
+//! 呼び出し元スレッドのリングバッファを取得
+//! @return リングバッファ (スレッド数が多すぎる場合はnullptr)
+//---------------------------------------------------------------------------
+ThreadBuffer* getThreadBuffer()
+{
+    if(thread_slot.index_ >= 0) {
+        // 所有スレッドが生きている間はスロットが解放されないためロック不要
+        ThreadBuffer* buffer = thread_buffers[thread_slot.index_].get();
+        if(buffer) {
+            return buffer;
+        }
+    }
+
+    std::lock_guard lock(registry_mutex);
+    if(thread_slot.index_ < 0) {
+        if(!free_slots.empty()) {
+            thread_slot.index_ = free_slots.back();
+            free_slots.pop_back();
+        }
+        else {
+            if(slot_count >= MAX_THREAD_COUNT) {
+                return nullptr;   // 計測しない
+            }
+            thread_slot.index_ = slot_count++;
+        }
+    }
+
+    auto& buffer = thread_buffers[thread_slot.index_];
+    if(!buffer) {
+        buffer = std::make_unique<ThreadBuffer>();
+    }
+    buffer->name_ = "thread " + std::to_string(thread_slot.index_);
+    return buffer.get();
+}
+
+//---------------------------------------------------------------------------
+//! TSCの周波数を更新 (PROFILE_setup()からの経過時間で平均する)
+//---------------------------------------------------------------------------
+void calibrate()
+{
+    f64 elapsed = TIMER_now() - base_time;
+    if(elapsed > 0.0) {
+        ticks_per_second = static_cast<f64>(__rdtsc() - base_ticks) / elapsed;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! TSCの差をマイクロ秒に変換
+//---------------------------------------------------------------------------
+f64 toMicroseconds(u64 ticks)
+{
+    return static_cast<f64>(ticks) * 1.0e6 / ticks_per_second;
+}
+
+//---------------------------------------------------------------------------
+//! JSONの文字列を出力 (引用符とエスケープ付き)
+//---------------------------------------------------------------------------
+void writeJsonString(FILE* file, const char* s)
+{
+    fputc('"', file);
+    for(; *s; ++s) {
+        if(*s == '"' || *s == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+void PROFILE_setup()
+{
+    base_ticks = __rdtsc();
+    base_time  = TIMER_now();
+
+    // 最初のフレームから変換できるように短時間で仮の周波数を求めておく
+    while(TIMER_now() - base_time < 0.005) {
+    }
+    calibrate();
+}
+
+//---------------------------------------------------------------------------
+//! 解放 (計測するスレッドが全て終了してから呼び出す)
+//---------------------------------------------------------------------------
+void PROFILE_cleanup()
+{
+    std::lock_guard lock(registry_mutex);
+    for(auto& buffer : thread_buffers) {
+        buffer.reset();
+    }
+    zones.clear();
+    capturing = false;
+    capture_events.clear();
+    capture_events.shrink_to_fit();
+}
+
+//---------------------------------------------------------------------------
+//! 呼び出し元スレッドの名前を設定
+//---------------------------------------------------------------------------
+void PROFILE_setThreadName(const char* name)
+{
+    if(ThreadBuffer* buffer = getThreadBuffer()) {
+        std::lock_guard lock(registry_mutex);
+        buffer->name_ = name;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! TSCの差をミリ秒に変換
+//---------------------------------------------------------------------------
+f64 PROFILE_toMilliseconds(u64 ticks)
+{
+    return toMicroseconds(ticks) * 1.0e-3;
+}
+
+//---------------------------------------------------------------------------
+//! ゾーンを記録
+//---------------------------------------------------------------------------
+void PROFILE_record(const char* name, u64 begin, u64 end)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    if(!buffer) {
+        return;
+    }
+
+    // 回収が追いつかずに一杯の場合は捨てる (待たない)
+    u32 write = buffer->write_.load(std::memory_order_relaxed);
+    if(write - buffer->read_.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        buffer->dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events_[write & (RING_CAPACITY - 1)] = Event{name, begin, end};
+    buffer->write_.store(write + 1, std::memory_order_release);
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void PROFILE_endFrame()
+{
+    std::lock_guard lock(registry_mutex);
+    calibrate();
+
+    //---- 全スレッドの記録を回収
+    bool is_capturing = capturing.load(std::memory_order_relaxed);
+    for(s32 thread = 0; thread < slot_count; ++thread) {
+        ThreadBuffer* buffer = thread_buffers[thread].get();
+        if(!buffer) {
+            continue;
+        }
+
+        u32 read  = buffer->read_.load(std::memory_order_relaxed);
+        u32 write = buffer->write_.load(std::memory_order_acquire);
+        for(; read != write; ++read) {
+            const Event& event = buffer->events_[read & (RING_CAPACITY - 1)];
+
+            ZoneHistory& zone = zones[event.name_];
+            zone.current_ms_ += toMicroseconds(event.end_ - event.begin_) * 1.0e-3;
+            zone.current_calls_++;
+
+            if(is_capturing) {
+                if(capture_events.size() < MAX_CAPTURE_EVENTS) {
+                    capture_events.push_back(CaptureEvent{event, thread});
+                }
+                else {
+                    capture_dropped++;
+                }
+            }
+        }
+        buffer->read_.store(write, std::memory_order_release);
+    }
+
+    //---- 今フレームの合計を直近のフレームの記録に追加
+    for(auto& [name, zone] : zones) {
+        if(zone.current_calls_ == 0) {
+            continue;
+        }
+        zone.frame_ms_[zone.next_]    = zone.current_ms_;
+        zone.frame_calls_[zone.next_] = zone.current_calls_;
+        zone.next_                    = (zone.next_ + 1) % STATS_WINDOW;
+        zone.count_                   = std::min(zone.count_ + 1, STATS_WINDOW);
+        zone.current_ms_              = 0.0;
+        zone.current_calls_           = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+//! ゾーンごとの統計を取得
+//---------------------------------------------------------------------------
+std::vector<ProfileStats> PROFILE_getStats()
+{
+    std::vector<ProfileStats> result;
+
+    std::lock_guard lock(registry_mutex);
+    result.reserve(zones.size());
+    for(const auto& [name, zone] : zones) {
+        if(zone.count_ == 0) {
+            continue;
+        }
+
+        ProfileStats stats;
+        stats.name_        = name.data();
+        stats.min_ms_      = DBL_MAX;
+        stats.frame_count_ = zone.count_;
+
+        f64 total_calls = 0.0;
+        for(s32 i = 0; i < zone.count_; ++i) {
+            stats.min_ms_ = std::min(stats.min_ms_, zone.frame_ms_[i]);
+            stats.max_ms_ = std::max(stats.max_ms_, zone.frame_ms_[i]);
+            stats.avg_ms_ += zone.frame_ms_[i];
+            total_calls += zone.frame_calls_[i];
+        }
+        stats.avg_ms_ /= zone.count_;
+        stats.calls_ = total_calls / zone.count_;
+        result.push_back(stats);
+    }
+
+    std::sort(result.begin(), result.end(), [](const ProfileStats& a, const ProfileStats& b) { return a.avg_ms_ > b.avg_ms_; });
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! 統計を表形式のテキストで出力
+//---------------------------------------------------------------------------
+void PROFILE_printStats(FILE* file)
+{
+    fprintf(file, "%-40s %9s %9s %9s %9s\n", "zone", "min ms", "avg ms", "max ms", "calls");
+    for(const ProfileStats& stats : PROFILE_getStats()) {
+        fprintf(file, "%-40s %9.3f %9.3f %9.3f %9.1f\n", stats.name_, stats.min_ms_, stats.avg_ms_, stats.max_ms_, stats.calls_);
+    }
+
+    // リングバッファがあふれた場合は集計が欠けている
+    u64 dropped_count = 0;
+    {
+        std::lock_guard lock(registry_mutex);
+        for(s32 thread = 0; thread < slot_count; ++thread) {
+            if(thread_buffers[thread]) {
+                dropped_count += thread_buffers[thread]->dropped_count_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    if(dropped_count > 0) {
+        fprintf(file, "dropped events: %llu\n", static_cast<unsigned long long>(dropped_count));
+    }
+}
+
+//---------------------------------------------------------------------------
+//! トレースのキャプチャを開始
+//---------------------------------------------------------------------------
+void PROFILE_beginCapture()
+{
+    std::lock_guard lock(registry_mutex);
+    capture_events.clear();
+    capture_dropped = 0;
+    capturing       = true;
+}
+
+//---------------------------------------------------------------------------
+//! トレースのキャプチャを終了してChromeのtrace_event形式で保存
+//---------------------------------------------------------------------------
+bool PROFILE_endCapture(const char* path)
+{
+    std::lock_guard lock(registry_mutex);
+    capturing = false;
+
+    FILE* file = nullptr;
+    if(fopen_s(&file, path, "w") != 0 || file == nullptr) {
+        return false;
+    }
+
+    fprintf(file,
+            "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":%llu},\"traceEvents\":[\n",
+            static_cast<unsigned long long>(capture_dropped));
+
+    //---- スレッド名
+    bool first = true;
+    for(s32 thread = 0; thread < slot_count; ++thread) {
+        if(!thread_buffers[thread]) {
+            continue;
+        }
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", thread);
+        writeJsonString(file, thread_buffers[thread]->name_.c_str());
+        fprintf(file, "}}");
+        first = false;
+    }
+
+    //---- ゾーン (完了イベント、時刻はマイクロ秒でナノ秒まで出力)
+    for(const CaptureEvent& capture : capture_events) {
+        const Event& event = capture.event_;
+        fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        writeJsonString(file, event.name_);
+        fprintf(file,
+                ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                capture.thread_,
+                toMicroseconds(event.begin_ - base_ticks),
+                toMicroseconds(event.end_ - event.begin_));
+        first = false;
+    }
+    fprintf(file, "\n]}\n");
+
+    bool result = (ferror(file) == 0);
+    fclose(file);
+
+    capture_events.clear();
+    capture_events.shrink_to_fit();
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! キャプチャ中かどうか
+//---------------------------------------------------------------------------
+bool PROFILE_isCapturing()
+{
+    return capturing.load(std::memory_order_relaxed);
+}
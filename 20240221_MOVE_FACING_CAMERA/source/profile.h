@@ -0,0 +1,137 @@
+﻿//===========================================================================
+//!	@file	profile.h
+//!	@brief	CPUプロファイラー (スコープ単位の計測・Chromeトレース出力)
+//!
+//!	PROFILE_ZONE()を置いたスコープの開始・終了時刻をTSC(__rdtsc)で記録します。
+//!	記録はスレッドごとのリングバッファに書き込むだけでロックしません。
+//!	PROFILE_endFrame()で全スレッドの記録を回収し、ゾーンごとの直近のフレームの
+//!	最小・平均・最大時間を集計します。キャプチャ中の記録はChromeの
+//!	trace_event形式(JSON)で保存でき、chrome://tracing や Perfetto で表示できます。
+//!
+//! @code
+//!     void update()
+//!     {
+//!         PROFILE_FUNCTION();               // 関数全体
+//!         {
+//!             PROFILE_ZONE("collision");    // 名前は文字列リテラル (ポインタを保持するため)
+//!             ...
+//!         }
+//!     }
+//!
+//!     PROFILE_beginCapture();
+//!     ...
+//!     PROFILE_endCapture("trace.json");
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! 0にするとPROFILE_ZONE()・PROFILE_FUNCTION()を空のマクロにする (計測コードが残らない)
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 1
+#endif
+
+//! ゾーンの統計 (直近のフレームでの1フレームあたりの合計時間)
+struct ProfileStats
+{
+    const char* name_        = nullptr;   //!< ゾーン名
+    f64         min_ms_      = 0.0;       //!< 最小 (単位:ミリ秒)
+    f64         avg_ms_      = 0.0;       //!< 平均 (単位:ミリ秒)
+    f64         max_ms_      = 0.0;       //!< 最大 (単位:ミリ秒)
+    f64         calls_       = 0.0;       //!< 1フレームあたりの平均呼び出し回数
+    s32         frame_count_ = 0;         //!< 集計したフレーム数 (ゾーンを通ったフレームのみ)
+};
+
+//===========================================================================
+//! @name 計測
+//===========================================================================
+//!@{
+
+//! 初期化 (TSCの周波数を計測開始)
+void PROFILE_setup();
+
+//! 解放
+void PROFILE_cleanup();
+
+//! 呼び出し元スレッドの名前を設定 (トレースの表示名)
+void PROFILE_setThreadName(const char* name);
+
+//! TSCの現在値を取得
+inline u64 PROFILE_now() { return __rdtsc(); }
+
+//! TSCの差をミリ秒に変換
+//! @param  [in]    ticks   PROFILE_now()の差
+f64 PROFILE_toMilliseconds(u64 ticks);
+
+//! ゾーンを記録 (通常はPROFILE_ZONE()を使用)
+//! @param  [in]    name    ゾーン名 (文字列リテラル)
+//! @param  [in]    begin   開始時のPROFILE_now()
+//! @param  [in]    end     終了時のPROFILE_now()
+void PROFILE_record(const char* name, u64 begin, u64 end);
+
+//! フレーム終了 (全スレッドの記録を回収して集計、メインスレッドから呼び出す)
+void PROFILE_endFrame();
+
+//!@}
+//===========================================================================
+//! @name 参照・出力
+//===========================================================================
+//!@{
+
+//! ゾーンごとの統計を取得 (平均時間の大きい順)
+std::vector<ProfileStats> PROFILE_getStats();
+
+//! 統計を表形式のテキストで出力
+//! @param  [in]    file    出力先 (stdoutなど)
+void PROFILE_printStats(FILE* file);
+
+//! トレースのキャプチャを開始 (以降のPROFILE_endFrame()で回収した記録を保持)
+void PROFILE_beginCapture();
+
+//! トレースのキャプチャを終了してChromeのtrace_event形式で保存
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool PROFILE_endCapture(const char* path);
+
+//! キャプチャ中かどうか
+bool PROFILE_isCapturing();
+
+//!@}
+
+//===========================================================================
+//! スコープの計測 (コンストラクタからデストラクタまで)
+//===========================================================================
+class ProfileZone
+{
+public:
+    //! コンストラクタ
+    //! @param  [in]    name    ゾーン名 (文字列リテラル)
+    explicit ProfileZone(const char* name)
+        : name_(name)
+        , begin_(PROFILE_now())
+    {
+    }
+
+    //! デストラクタ
+    ~ProfileZone() { PROFILE_record(name_, begin_, PROFILE_now()); }
+
+    ProfileZone(const ProfileZone&)            = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name_;    //!< ゾーン名
+    u64         begin_;   //!< 開始時のTSC
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+
+#if PROFILE_ENABLE
+//! スコープを計測
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+//! 関数全体を計測
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#endif
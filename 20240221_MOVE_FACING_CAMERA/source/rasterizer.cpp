@@ -0,0 +1,635 @@
+﻿//===========================================================================
+//!	@file	rasterizer.cpp
+//!	@brief	ソフトウェアラスタライザー (タイル分割・マルチスレッド)
+//===========================================================================
+#include <emmintrin.h>   // SSE2
+
+namespace
+{
+constexpr s32 ATTRIBUTE_COUNT = 6;   //!< 頂点属性の数 (u, v, r, g, b, a)
+constexpr s32 MAX_CLIP_VERTEX = 12;  //!< クリッピング後の最大頂点数
+
+//! ガードバンド (画面の何倍の範囲までクリッピングしないか)
+//! エッジ関数の精度を保つため、画面外に大きくはみ出す三角形は切り取る
+constexpr f32 GUARD_BAND = 2.0f;
+
+//! クリッピング平面 (dot(plane, position) >= 0 が内側)
+constexpr f32 CLIP_PLANES[][4]{
+    { 0.0f,  0.0f, +1.0f,       1.0f},   // 近クリップ面
+    { 0.0f,  0.0f, -1.0f,       1.0f},   // 遠クリップ面
+    {+1.0f,  0.0f,  0.0f, GUARD_BAND},   // 左
+    {-1.0f,  0.0f,  0.0f, GUARD_BAND},   // 右
+    { 0.0f, +1.0f,  0.0f, GUARD_BAND},   // 下
+    { 0.0f, -1.0f,  0.0f, GUARD_BAND},   // 上
+};
+
+//! クリッピング用の頂点
+struct ClipVertex
+{
+    f32 position_[4];                  //!< クリップ座標
+    f32 attributes_[ATTRIBUTE_COUNT];  //!< 頂点属性
+};
+
+//---------------------------------------------------------------------------
+//! 入力頂点をクリッピング用の頂点に変換
+//---------------------------------------------------------------------------
+ClipVertex toClipVertex(const RasterVertex& v)
+{
+    return ClipVertex{
+        {v.x_, v.y_, v.z_, v.w_},
+        {v.u_,
+          v.v_,
+          static_cast<f32>(v.color_.r_),
+          static_cast<f32>(v.color_.g_),
+          static_cast<f32>(v.color_.b_),
+          static_cast<f32>(v.color_.a_)}
+    };
+}
+
+//---------------------------------------------------------------------------
+//! 平面との距離
+//---------------------------------------------------------------------------
+f32 planeDistance(const f32 plane[4], const ClipVertex& v)
+{
+    return plane[0] * v.position_[0] + plane[1] * v.position_[1] + plane[2] * v.position_[2] +
+           plane[3] * v.position_[3];
+}
+
+//---------------------------------------------------------------------------
+//! 頂点を線形補間
+//---------------------------------------------------------------------------
+ClipVertex lerpVertex(const ClipVertex& a, const ClipVertex& b, f32 t)
+{
+    ClipVertex v;
+    for(s32 i = 0; i < 4; ++i) {
+        v.position_[i] = a.position_[i] + (b.position_[i] - a.position_[i]) * t;
+    }
+    for(s32 i = 0; i < ATTRIBUTE_COUNT; ++i) {
+        v.attributes_[i] = a.attributes_[i] + (b.attributes_[i] - a.attributes_[i]) * t;
+    }
+    return v;
+}
+
+//---------------------------------------------------------------------------
+//! 多角形を1枚の平面でクリッピング (Sutherland-Hodgman)
+//! @return クリッピング後の頂点数
+//---------------------------------------------------------------------------
+s32 clipPolygon(const ClipVertex* in, s32 count, ClipVertex* out, const f32 plane[4])
+{
+    s32 out_count = 0;
+    for(s32 i = 0; i < count; ++i) {
+        const ClipVertex& a = in[i];
+        const ClipVertex& b = in[(i + 1) % count];
+
+        f32 da = planeDistance(plane, a);
+        f32 db = planeDistance(plane, b);
+
+        if(da >= 0.0f) {
+            out[out_count++] = a;
+        }
+        if((da >= 0.0f) != (db >= 0.0f)) {
+            out[out_count++] = lerpVertex(a, b, da / (da - db));
+        }
+    }
+    return out_count;
+}
+
+//---------------------------------------------------------------------------
+//! 4ピクセル分の補間平面を計算
+//---------------------------------------------------------------------------
+__m128 evaluatePlane(const f32 plane[3], __m128 x, f32 y)
+{
+    __m128 row = _mm_set1_ps(plane[1] * y + plane[2]);
+    return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x), row);
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 初期化
+//---------------------------------------------------------------------------
+bool SoftwareRasterizer::setup(s32 width, s32 height)
+{
+    if(width <= 0 || height <= 0) {
+        return false;
+    }
+
+    width_        = width;
+    height_       = height;
+    pitch_        = (width + 3) & ~3;   // 4ピクセル単位で読み書きするため
+    tile_count_x_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tile_count_y_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    color_buffer_.assign(pitch_ * height_, clear_color_);
+    depth_buffer_.assign(pitch_ * height_, 1.0f);
+
+    triangles_.clear();
+    bins_.clear();
+    bins_.resize(tile_count_x_ * tile_count_y_);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::cleanup()
+{
+    color_buffer_ = {};
+    depth_buffer_ = {};
+    triangles_    = {};
+    bins_         = {};
+    width_        = 0;
+    height_       = 0;
+}
+
+//---------------------------------------------------------------------------
+//! 画面クリア
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::clear(const Color& color)
+{
+    // 登録済みの三角形はクリアで見えなくなるため破棄する
+    triangles_.clear();
+    for(auto& bin : bins_) {
+        bin.clear();
+    }
+
+    clear_color_   = color;
+    clear_pending_ = true;
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャを設定
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::setTexture(const Texture* texture)
+{
+    texture_ = texture ? texture->getSampledTexture() : nullptr;
+}
+
+//---------------------------------------------------------------------------
+//! 三角形を登録
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::drawTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+    const RasterVertex* v[3]{&v0, &v1, &v2};
+    addClipTriangle(v);
+}
+
+//---------------------------------------------------------------------------
+//! クリップ座標の三角形をクリッピングして登録
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::addClipTriangle(const RasterVertex* v[3])
+{
+    ClipVertex buffer[2][MAX_CLIP_VERTEX];
+    s32        count = 3;
+    for(s32 i = 0; i < 3; ++i) {
+        buffer[0][i] = toClipVertex(*v[i]);
+    }
+
+    // 全頂点が内側にある平面はクリッピング不要 (ほとんどの三角形はここで終わる)
+    s32 current = 0;
+    for(const auto& plane : CLIP_PLANES) {
+        bool inside = true;
+        for(s32 i = 0; i < count; ++i) {
+            inside &= planeDistance(plane, buffer[current][i]) >= 0.0f;
+        }
+        if(inside) {
+            continue;
+        }
+
+        count   = clipPolygon(buffer[current], count, buffer[current ^ 1], plane);
+        current = current ^ 1;
+        if(count < 3) {
+            return;
+        }
+    }
+
+    // スクリーン座標へ変換 (属性は1/wを掛けて透視補正)
+    ScreenVertex screen[MAX_CLIP_VERTEX];
+    for(s32 i = 0; i < count; ++i) {
+        const ClipVertex& c  = buffer[current][i];
+        f32               rw = 1.0f / c.position_[3];
+
+        ScreenVertex& s = screen[i];
+        s.x_            = (c.position_[0] * rw * 0.5f + 0.5f) * static_cast<f32>(width_);
+        s.y_            = (c.position_[1] * rw * 0.5f + 0.5f) * static_cast<f32>(height_);
+
+        s.values_[PLANE_Z]  = c.position_[2] * rw * 0.5f + 0.5f;
+        s.values_[PLANE_RW] = rw;
+        for(s32 a = 0; a < ATTRIBUTE_COUNT; ++a) {
+            s.values_[PLANE_U + a] = c.attributes_[a] * rw;
+        }
+    }
+
+    // 凸多角形を扇状に三角形分割
+    for(s32 i = 1; i + 1 < count; ++i) {
+        addScreenTriangle(screen[0], screen[i], screen[i + 1]);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 線を登録
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::drawLine(const RasterVertex& v0, const RasterVertex& v1)
+{
+    ClipVertex a = toClipVertex(v0);
+    ClipVertex b = toClipVertex(v1);
+
+    // 線分をクリッピング
+    for(const auto& plane : CLIP_PLANES) {
+        f32 da = planeDistance(plane, a);
+        f32 db = planeDistance(plane, b);
+        if(da < 0.0f && db < 0.0f) {
+            return;
+        }
+        if(da < 0.0f) {
+            a = lerpVertex(a, b, da / (da - db));
+        }
+        else if(db < 0.0f) {
+            b = lerpVertex(a, b, da / (da - db));
+        }
+    }
+
+    // スクリーン座標へ変換
+    ScreenVertex s[2];
+    for(s32 i = 0; i < 2; ++i) {
+        const ClipVertex& c  = (i == 0) ? a : b;
+        f32               rw = 1.0f / c.position_[3];
+
+        s[i].x_                = (c.position_[0] * rw * 0.5f + 0.5f) * static_cast<f32>(width_);
+        s[i].y_                = (c.position_[1] * rw * 0.5f + 0.5f) * static_cast<f32>(height_);
+        s[i].values_[PLANE_Z]  = c.position_[2] * rw * 0.5f + 0.5f;
+        s[i].values_[PLANE_RW] = rw;
+        for(s32 n = 0; n < ATTRIBUTE_COUNT; ++n) {
+            s[i].values_[PLANE_U + n] = c.attributes_[n] * rw;
+        }
+    }
+
+    // 線の法線方向に±0.5ピクセル広げた四角形として描画
+    f32 dx     = s[1].x_ - s[0].x_;
+    f32 dy     = s[1].y_ - s[0].y_;
+    f32 length = std::sqrt(dx * dx + dy * dy);
+    if(length < 1e-6f) {
+        return;
+    }
+    f32 nx = -dy / length * 0.5f;
+    f32 ny = dx / length * 0.5f;
+
+    ScreenVertex q[4]{s[0], s[0], s[1], s[1]};
+    q[0].x_ += nx;
+    q[0].y_ += ny;
+    q[1].x_ -= nx;
+    q[1].y_ -= ny;
+    q[2].x_ -= nx;
+    q[2].y_ -= ny;
+    q[3].x_ += nx;
+    q[3].y_ += ny;
+
+    addScreenTriangle(q[0], q[1], q[2]);
+    addScreenTriangle(q[0], q[2], q[3]);
+}
+
+//---------------------------------------------------------------------------
+//! スクリーン座標の三角形をセットアップしてタイルに振り分け
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::addScreenTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2)
+{
+    // 面積 (符号で向きが分かる)
+    f32 area = (v1.x_ - v0.x_) * (v2.y_ - v0.y_) - (v2.x_ - v0.x_) * (v1.y_ - v0.y_);
+    if(std::abs(area) < 1e-8f) {
+        return;   // 縮退
+    }
+
+    // カリングはしないため、反時計回りにそろえる
+    const ScreenVertex* p[3]{&v0, &v1, &v2};
+    if(area < 0.0f) {
+        std::swap(p[1], p[2]);
+        area = -area;
+    }
+
+    //---- 範囲 (画面内に制限)
+    f32 min_x = std::min({p[0]->x_, p[1]->x_, p[2]->x_});
+    f32 min_y = std::min({p[0]->y_, p[1]->y_, p[2]->y_});
+    f32 max_x = std::max({p[0]->x_, p[1]->x_, p[2]->x_});
+    f32 max_y = std::max({p[0]->y_, p[1]->y_, p[2]->y_});
+
+    Triangle tri;
+    tri.min_x_ = std::max(static_cast<s32>(std::floor(min_x)), 0);
+    tri.min_y_ = std::max(static_cast<s32>(std::floor(min_y)), 0);
+    tri.max_x_ = std::min(static_cast<s32>(std::ceil(max_x)), width_);
+    tri.max_y_ = std::min(static_cast<s32>(std::ceil(max_y)), height_);
+    if(tri.min_x_ >= tri.max_x_ || tri.min_y_ >= tri.max_y_) {
+        return;   // 画面外
+    }
+
+    //---- エッジ関数 (辺 a→b の左側が正)
+    tri.top_left_mask_ = 0;
+    for(s32 i = 0; i < 3; ++i) {
+        const ScreenVertex& a = *p[(i + 1) % 3];
+        const ScreenVertex& b = *p[(i + 2) % 3];
+
+        f32 ea = a.y_ - b.y_;
+        f32 eb = b.x_ - a.x_;
+
+        tri.edges_[i][0] = ea;
+        tri.edges_[i][1] = eb;
+        tri.edges_[i][2] = -(ea * a.x_ + eb * a.y_);
+
+        // 隣接する三角形の共有辺は向きが逆になるため、片方だけが辺上のピクセルを含む
+        if(ea > 0.0f || (ea == 0.0f && eb > 0.0f)) {
+            tri.top_left_mask_ |= 1u << i;
+        }
+    }
+
+    //---- 補間平面
+    f32 rcp_area = 1.0f / area;
+    f32 x10      = p[1]->x_ - p[0]->x_;
+    f32 y10      = p[1]->y_ - p[0]->y_;
+    f32 x20      = p[2]->x_ - p[0]->x_;
+    f32 y20      = p[2]->y_ - p[0]->y_;
+    for(s32 i = 0; i < PLANE_COUNT; ++i) {
+        f32 f0  = p[0]->values_[i];
+        f32 f10 = p[1]->values_[i] - f0;
+        f32 f20 = p[2]->values_[i] - f0;
+
+        f32 dx = (f10 * y20 - f20 * y10) * rcp_area;
+        f32 dy = (f20 * x10 - f10 * x20) * rcp_area;
+
+        tri.planes_[i][0] = dx;
+        tri.planes_[i][1] = dy;
+        tri.planes_[i][2] = f0 - dx * p[0]->x_ - dy * p[0]->y_;
+    }
+
+    tri.texture_ = texture_;
+
+    //---- 登録 (タイルへの振り分けはflush()でまとめて行う)
+    // 三角形リストは毎フレーム作り直す一時メモリ。メモリタグは拡張する時だけ切り替える
+    if(triangles_.size() == triangles_.capacity()) {
+        MEMORY_TAG(MemoryTag::Frame);
+        triangles_.reserve(std::max<size_t>(triangles_.capacity() * 2, 1024));
+    }
+    triangles_.push_back(tri);
+}
+
+//---------------------------------------------------------------------------
+//! 登録された三角形をタイルに振り分け
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::binTriangles()
+{
+    // タイルごとの三角形番号は毎フレーム作り直す一時メモリ
+    MEMORY_TAG(MemoryTag::Frame);
+
+    for(u32 index = 0; index < static_cast<u32>(triangles_.size()); ++index) {
+        const Triangle& tri = triangles_[index];
+
+        s32 tile_x0 = tri.min_x_ / TILE_SIZE;
+        s32 tile_y0 = tri.min_y_ / TILE_SIZE;
+        s32 tile_x1 = (tri.max_x_ - 1) / TILE_SIZE;
+        s32 tile_y1 = (tri.max_y_ - 1) / TILE_SIZE;
+        for(s32 ty = tile_y0; ty <= tile_y1; ++ty) {
+            for(s32 tx = tile_x0; tx <= tile_x1; ++tx) {
+                bins_[ty * tile_count_x_ + tx].push_back(index);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 登録された三角形を全て描画
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::flush()
+{
+    binTriangles();
+
+    // タイルごとに独立して描画できるため、タイル単位で並列化
+    JOB_parallelFor(tile_count_x_ * tile_count_y_, 1, [&](s32 begin, s32 end) {
+        for(s32 i = begin; i < end; ++i) {
+            rasterizeTile(i);
+        }
+    });
+
+    triangle_count_ = static_cast<s32>(triangles_.size());
+    clear_pending_  = false;
+
+    triangles_.clear();
+    for(auto& bin : bins_) {
+        bin.clear();
+    }
+}
+
+//---------------------------------------------------------------------------
+//! ピクセル位置のテクスチャ座標を計算 (透視補正)
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::textureCoord(const Triangle& tri, f32 x, f32 y, f32& u, f32& v)
+{
+    auto evaluate = [&](s32 plane) { return tri.planes_[plane][0] * x + tri.planes_[plane][1] * y + tri.planes_[plane][2]; };
+
+    f32 w = 1.0f / evaluate(PLANE_RW);
+    u     = evaluate(PLANE_U) * w;
+    v     = evaluate(PLANE_V) * w;
+}
+
+//---------------------------------------------------------------------------
+//! タイルを描画
+//---------------------------------------------------------------------------
+void SoftwareRasterizer::rasterizeTile(s32 tile_index)
+{
+    s32 tile_x0 = (tile_index % tile_count_x_) * TILE_SIZE;
+    s32 tile_y0 = (tile_index / tile_count_x_) * TILE_SIZE;
+    s32 tile_x1 = std::min(tile_x0 + TILE_SIZE, width_);
+    s32 tile_y1 = std::min(tile_y0 + TILE_SIZE, height_);
+
+    //---- クリア
+    if(clear_pending_) {
+        for(s32 y = tile_y0; y < tile_y1; ++y) {
+            std::fill_n(&color_buffer_[y * pitch_ + tile_x0], tile_x1 - tile_x0, clear_color_);
+            std::fill_n(&depth_buffer_[y * pitch_ + tile_x0], tile_x1 - tile_x0, 1.0f);
+        }
+    }
+
+    const __m128  lane_offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);   // ピクセル中心
+    const __m128  tile_end    = _mm_set1_ps(static_cast<f32>(tile_x1));
+    const __m128  zero        = _mm_setzero_ps();
+    const __m128  max_color   = _mm_set1_ps(255.0f);
+    const __m128i byte_mask   = _mm_set1_epi32(0xff);
+
+    for(u32 index : bins_[tile_index]) {
+        const Triangle& tri = triangles_[index];
+
+        // タイルとの重なり (4ピクセル単位に揃える)
+        s32 x0 = std::max(tri.min_x_, tile_x0) & ~3;
+        s32 x1 = std::min(tri.max_x_, tile_x1);
+        s32 y0 = std::max(tri.min_y_, tile_y0);
+        s32 y1 = std::min(tri.max_y_, tile_y1);
+
+        for(s32 y = y0; y < y1; ++y) {
+            f32 fy = static_cast<f32>(y) + 0.5f;
+
+            Color* color_row = &color_buffer_[y * pitch_];
+            f32*   depth_row = &depth_buffer_[y * pitch_];
+
+            for(s32 x = x0; x < x1; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<f32>(x)), lane_offset);
+
+                //---- エッジ関数で内外判定 (4ピクセル同時)
+                __m128 mask = _mm_cmplt_ps(px, tile_end);
+                for(s32 e = 0; e < 3; ++e) {
+                    __m128 value  = evaluatePlane(tri.edges_[e], px, fy);
+                    __m128 inside = _mm_cmpgt_ps(value, zero);
+                    if(tri.top_left_mask_ & (1u << e)) {
+                        inside = _mm_or_ps(inside, _mm_cmpeq_ps(value, zero));
+                    }
+                    mask = _mm_and_ps(mask, inside);
+                }
+                if(_mm_movemask_ps(mask) == 0) {
+                    continue;
+                }
+
+                //---- 深度テスト
+                __m128 z     = evaluatePlane(tri.planes_[PLANE_Z], px, fy);
+                __m128 depth = _mm_loadu_ps(&depth_row[x]);
+                mask         = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+
+                s32 lanes = _mm_movemask_ps(mask);
+                if(lanes == 0) {
+                    continue;
+                }
+                depth = _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, depth));
+                _mm_storeu_ps(&depth_row[x], depth);
+
+                //---- 透視補正した頂点カラー
+                __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), evaluatePlane(tri.planes_[PLANE_RW], px, fy));
+                __m128 r = _mm_mul_ps(evaluatePlane(tri.planes_[PLANE_R], px, fy), w);
+                __m128 g = _mm_mul_ps(evaluatePlane(tri.planes_[PLANE_G], px, fy), w);
+                __m128 b = _mm_mul_ps(evaluatePlane(tri.planes_[PLANE_B], px, fy), w);
+                __m128 a = _mm_mul_ps(evaluatePlane(tri.planes_[PLANE_A], px, fy), w);
+
+                //---- テクスチャ (GL_MODULATE)
+                if(tri.texture_) {
+                    __m128 u = _mm_mul_ps(evaluatePlane(tri.planes_[PLANE_U], px, fy), w);
+                    __m128 v = _mm_mul_ps(evaluatePlane(tri.planes_[PLANE_V], px, fy), w);
+
+                    // ミップマップ段数は4ピクセルの先頭で隣のピクセルとの差分から選ぶ
+                    f32 sx = static_cast<f32>(x) + 0.5f;
+                    f32 u0, v0, u1, v1, u2, v2;
+                    textureCoord(tri, sx, fy, u0, v0);
+                    textureCoord(tri, sx + 1.0f, fy, u1, v1);
+                    textureCoord(tri, sx, fy + 1.0f, u2, v2);
+                    s32 level = tri.texture_->selectLevel(u1 - u0, v1 - v0, u2 - u0, v2 - v0);
+
+                    __m128i texel = tri.texture_->sample4(u, v, level, AddressMode::Wrap);
+
+                    const __m128 rcp_255 = _mm_set1_ps(1.0f / 255.0f);
+                    __m128       tr      = _mm_cvtepi32_ps(_mm_and_si128(texel, byte_mask));
+                    __m128       tg      = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texel, 8), byte_mask));
+                    __m128       tb      = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texel, 16), byte_mask));
+                    __m128       ta      = _mm_cvtepi32_ps(_mm_srli_epi32(texel, 24));
+                    r                    = _mm_mul_ps(r, _mm_mul_ps(tr, rcp_255));
+                    g                    = _mm_mul_ps(g, _mm_mul_ps(tg, rcp_255));
+                    b                    = _mm_mul_ps(b, _mm_mul_ps(tb, rcp_255));
+                    a                    = _mm_mul_ps(a, _mm_mul_ps(ta, rcp_255));
+                }
+
+                //---- RGBA8に変換して書き込み
+                __m128i ri = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(r, zero), max_color));
+                __m128i gi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(g, zero), max_color));
+                __m128i bi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, zero), max_color));
+                __m128i ai = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, zero), max_color));
+
+                __m128i rgba = _mm_or_si128(_mm_or_si128(_mm_and_si128(ri, byte_mask),
+                                                         _mm_slli_epi32(_mm_and_si128(gi, byte_mask), 8)),
+                                            _mm_or_si128(_mm_slli_epi32(_mm_and_si128(bi, byte_mask), 16),
+                                                         _mm_slli_epi32(ai, 24)));
+
+                __m128i* dst      = reinterpret_cast<__m128i*>(&color_row[x]);
+                __m128i  mask_i   = _mm_castps_si128(mask);
+                __m128i  previous = _mm_loadu_si128(dst);
+                _mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(mask_i, rgba), _mm_andnot_si128(mask_i, previous)));
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! カラーバッファをTGAファイルに保存
+//---------------------------------------------------------------------------
+bool SoftwareRasterizer::saveTGA(const char* path) const
+{
+    // 書き込み・クローズの失敗も検出する (ベンチマークで基準画像と比較するため)
+    FILE* file = fopen(path, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    // 非圧縮フルカラー32bit、左下原点 (カラーバッファと同じ並び)
+    u8 header[18]{};
+    header[2]  = 2;                       // フルカラー
+    header[12] = static_cast<u8>(width_);
+    header[13] = static_cast<u8>(width_ >> 8);
+    header[14] = static_cast<u8>(height_);
+    header[15] = static_cast<u8>(height_ >> 8);
+    header[16] = 32;                      // 色深度
+    header[17] = 8;                       // αのビット数
+    fwrite(header, sizeof(header), 1, file);
+
+    std::vector<u8> row(width_ * 4);
+    for(s32 y = 0; y < height_; ++y) {
+        const Color* src = &color_buffer_[y * pitch_];
+        for(s32 x = 0; x < width_; ++x) {
+            row[x * 4 + 0] = src[x].b_;   // TGAはBGRAの順
+            row[x * 4 + 1] = src[x].g_;
+            row[x * 4 + 2] = src[x].r_;
+            row[x * 4 + 3] = src[x].a_;
+        }
+        fwrite(row.data(), row.size(), 1, file);
+    }
+
+    bool succeeded = ferror(file) == 0;
+    succeeded      = fclose(file) == 0 && succeeded;
+    return succeeded;
+}
+
+//---------------------------------------------------------------------------
+//! カラーバッファをTGAファイルと比較
+//---------------------------------------------------------------------------
+s32 SoftwareRasterizer::compareTGA(const char* path, s32 tolerance) const
+{
+    FILE* file = fopen(path, "rb");
+    if(file == nullptr) {
+        return -1;
+    }
+
+    // saveTGA()と同じ形式 (非圧縮フルカラー32bit、左下原点、IDなし) のみ対応
+    u8   header[18]{};
+    bool valid = fread(header, sizeof(header), 1, file) == 1 &&
+                 header[0] == 0 && header[1] == 0 && header[2] == 2 && header[16] == 32 && (header[17] & 0x20) == 0 &&
+                 (header[12] | (header[13] << 8)) == width_ && (header[14] | (header[15] << 8)) == height_;
+    if(!valid) {
+        fclose(file);
+        return -1;
+    }
+
+    s32             mismatch_count = 0;
+    std::vector<u8> row(width_ * 4);
+    for(s32 y = 0; y < height_; ++y) {
+        if(fread(row.data(), row.size(), 1, file) != 1) {
+            fclose(file);
+            return -1;
+        }
+
+        const Color* src = &color_buffer_[y * pitch_];
+        for(s32 x = 0; x < width_; ++x) {
+            const u8* pixel = &row[x * 4];   // TGAはBGRAの順
+            s32 diff = std::max({std::abs(src[x].b_ - pixel[0]),
+                                 std::abs(src[x].g_ - pixel[1]),
+                                 std::abs(src[x].r_ - pixel[2]),
+                                 std::abs(src[x].a_ - pixel[3])});
+            if(diff > tolerance) {
+                mismatch_count++;
+            }
+        }
+    }
+
+    fclose(file);
+    return mismatch_count;
+}
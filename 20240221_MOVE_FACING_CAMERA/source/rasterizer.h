@@ -0,0 +1,179 @@
+﻿//===========================================================================
+//!	@file	rasterizer.h
+//!	@brief	ソフトウェアラスタライザー (タイル分割・マルチスレッド)
+//!
+//!	OpenGLを使わずにCPUだけで三角形と線を描画します。
+//!	登録された三角形をflush()で画面のタイルごとに振り分け、タイル単位に
+//!	ジョブシステムへ分散して、4ピクセル単位のSIMDエッジ関数で塗りつぶします。
+//!	各タイルは登録順に描画するため、スレッド数に関係なく同じ画像になります。
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! ラスタライザーの入力頂点
+//===========================================================================
+struct RasterVertex
+{
+    f32   x_, y_, z_, w_;                  //!< クリップ座標 (投影行列で変換後)
+    f32   u_ = 0.0f, v_ = 0.0f;            //!< テクスチャ座標
+    Color color_ = Color(255, 255, 255);   //!< 頂点カラー
+};
+
+//===========================================================================
+//! ソフトウェアラスタライザー
+//!
+//! - 深度テスト (GL_LESS相当、深度0.0～1.0)
+//! - テクスチャ × 頂点カラー (GL_MODULATE相当、バイリニア・ミップマップ・リピート)
+//! - カラーバッファはRGBA8。OpenGLと同じく最下行が先頭
+//===========================================================================
+class SoftwareRasterizer
+{
+public:
+    static constexpr s32 TILE_SIZE = 64;   //!< タイルの大きさ (ピクセル)
+
+    //! コンストラクタ
+    SoftwareRasterizer() = default;
+
+    //! デストラクタ
+    ~SoftwareRasterizer() = default;
+
+    //! 初期化
+    //! @param  [in]    width   幅
+    //! @param  [in]    height  高さ
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(失敗)
+    bool setup(s32 width, s32 height);
+
+    //! 解放
+    void cleanup();
+
+    //! 画面クリア (実際のクリアはflush()時にタイルごとに行う)
+    //! @param  [in]    color   クリアカラー
+    void clear(const Color& color);
+
+    //! テクスチャを設定
+    //! @param  [in]    texture テクスチャ (nullptrでテクスチャなし)
+    void setTexture(const Texture* texture);
+
+    //! テクスチャを設定 (Textureを介さずに作成したもの)
+    //! @param  [in]    texture テクスチャ (nullptrでテクスチャなし)
+    void setTexture(const SampledTexture* texture) { texture_ = texture; }
+
+    //! 三角形を登録
+    void drawTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2);
+
+    //! 線を登録 (幅1ピクセル)
+    void drawLine(const RasterVertex& v0, const RasterVertex& v1);
+
+    //! 登録された三角形を全て描画
+    void flush();
+
+    //! カラーバッファをTGAファイルに保存
+    //! @param  [in]    path    ファイル名
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(失敗)
+    bool saveTGA(const char* path) const;
+
+    //! カラーバッファをTGAファイル (saveTGA()の形式) と比較
+    //! @param  [in]    path        比較するファイル名 (基準画像)
+    //! @param  [in]    tolerance   各チャンネルで許容する差
+    //! @return 差が許容値を超えたピクセル数 (ファイルが読めない・形式や大きさが異なる場合は-1)
+    s32 compareTGA(const char* path, s32 tolerance) const;
+
+    //----------------------------------------------------------
+    //! @name 参照
+    //----------------------------------------------------------
+    //!@{
+
+    //! 幅を取得
+    s32 getWidth() const { return width_; }
+
+    //! 高さを取得
+    s32 getHeight() const { return height_; }
+
+    //! 1行のピクセル数を取得 (4の倍数)
+    s32 getPitch() const { return pitch_; }
+
+    //! カラーバッファを取得
+    const Color* getColorBuffer() const { return color_buffer_.data(); }
+
+    //! 深度バッファを取得
+    const f32* getDepthBuffer() const { return depth_buffer_.data(); }
+
+    //! 前回のflush()で描画した三角形数を取得 (線は2個の三角形)
+    s32 getTriangleCount() const { return triangle_count_; }
+
+    //!@}
+
+private:
+    // コピー禁止
+    SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+    void operator=(const SoftwareRasterizer&)     = delete;
+
+    //! 補間する値の番号
+    enum Plane
+    {
+        PLANE_Z,     //!< 深度
+        PLANE_RW,    //!< 1/w
+        PLANE_U,     //!< u/w
+        PLANE_V,     //!< v/w
+        PLANE_R,     //!< r/w
+        PLANE_G,     //!< g/w
+        PLANE_B,     //!< b/w
+        PLANE_A,     //!< a/w
+        PLANE_COUNT,
+    };
+
+    //! スクリーン座標の頂点
+    struct ScreenVertex
+    {
+        f32 x_, y_;                 //!< スクリーン座標 (ピクセル)
+        f32 values_[PLANE_COUNT];   //!< 補間する値
+    };
+
+    //! セットアップ済みの三角形
+    struct Triangle
+    {
+        f32 edges_[3][3];                //!< エッジ関数 a*x + b*y + c (内側が正)
+        u32 top_left_mask_;              //!< エッジ上のピクセルを含むエッジ (bit0-2)
+        f32 planes_[PLANE_COUNT][3];     //!< 補間平面 dx*x + dy*y + c
+        s32 min_x_, min_y_;              //!< 範囲 (ピクセル)
+        s32 max_x_, max_y_;              //!< 範囲 (ピクセル、この値は含まない)
+
+        const SampledTexture* texture_;  //!< テクスチャ (nullptrでなし)
+    };
+
+    //! クリップ座標の三角形をクリッピングして登録
+    void addClipTriangle(const RasterVertex* v[3]);
+
+    //! スクリーン座標の三角形をセットアップして登録
+    void addScreenTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+
+    //! 登録された三角形をタイルに振り分け (登録順)
+    void binTriangles();
+
+    //! ピクセル位置のテクスチャ座標を計算 (透視補正)
+    static void textureCoord(const Triangle& tri, f32 x, f32 y, f32& u, f32& v);
+
+    //! タイルを描画
+    void rasterizeTile(s32 tile_index);
+
+private:
+    s32 width_        = 0;   //!< 幅
+    s32 height_       = 0;   //!< 高さ
+    s32 pitch_        = 0;   //!< 1行のピクセル数
+    s32 tile_count_x_ = 0;   //!< 横方向のタイル数
+    s32 tile_count_y_ = 0;   //!< 縦方向のタイル数
+
+    std::vector<Color> color_buffer_;   //!< カラーバッファ
+    std::vector<f32>   depth_buffer_;   //!< 深度バッファ
+
+    std::vector<Triangle>         triangles_;   //!< 登録された三角形
+    std::vector<std::vector<u32>> bins_;        //!< タイルごとの三角形番号 (登録順)
+
+    Color clear_color_   = Color(0, 0, 0, 255);   //!< クリアカラー
+    bool  clear_pending_ = false;                 //!< flush()時にクリアするかどうか
+    s32   triangle_count_ = 0;                    //!< 前回描画した三角形数
+
+    const SampledTexture* texture_ = nullptr;   //!< 現在のテクスチャ
+};
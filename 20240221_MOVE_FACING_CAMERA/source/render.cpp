@@ -0,0 +1,328 @@
+﻿//===========================================================================
+//!	@file	render.cpp
+//!	@brief	描画API (OpenGL / ソフトウェアラスタライザー切り替え)
+//===========================================================================
+
+namespace
+{
+RenderBackend backend = RenderBackend::OpenGL;   //!< 描画先
+
+SoftwareRasterizer rasterizer;   //!< ソフトウェアラスタライザー
+
+matrix mat_proj  = matrix::identity();   //!< 投影行列
+matrix mat_view  = matrix::identity();   //!< ビュー行列
+matrix mat_world = matrix::identity();   //!< ワールド行列
+matrix mat_wvp   = matrix::identity();   //!< ワールド×ビュー×投影 (ソフトウェア描画用)
+
+PrimitiveType primitive_type = PrimitiveType::Triangles;   //!< 登録中のプリミティブ
+Color         current_color  = Color(255, 255, 255);       //!< 頂点カラー
+f32           current_u      = 0.0f;                       //!< テクスチャ座標U
+f32           current_v      = 0.0f;                       //!< テクスチャ座標V
+
+RasterVertex vertices[3];        //!< 組み立て中のプリミティブの頂点
+s32          vertex_count = 0;   //!< 組み立て中の頂点数
+s32          strip_index  = 0;   //!< 三角形ストリップの三角形番号 (向きの交互切り替え用)
+
+RenderStats frame_stats;   //!< 集計中のフレームの描画統計
+RenderStats last_stats;    //!< 直前のフレームの描画統計
+
+//---------------------------------------------------------------------------
+//! OpenGLの行列を更新
+//---------------------------------------------------------------------------
+void updateMatrix()
+{
+    if(backend == RenderBackend::OpenGL) {
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf((GLfloat*)&mat_proj);
+
+        matrix mat_world_view = mul(mat_world, mat_view);
+        glMatrixMode(GL_MODELVIEW);
+        glLoadMatrixf((GLfloat*)&mat_world_view);
+    }
+    else {
+        mat_wvp = mul(mul(mat_world, mat_view), mat_proj);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! ソフトウェア描画の頂点を登録
+//---------------------------------------------------------------------------
+void addSoftwareVertex(const float3& position)
+{
+    float4 p = mul(float4(position, 1.0f), mat_wvp);
+
+    RasterVertex& v = vertices[vertex_count++];
+    v.x_            = p.x;
+    v.y_            = p.y;
+    v.z_            = p.z;
+    v.w_            = p.w;
+    v.u_            = current_u;
+    v.v_            = current_v;
+    v.color_        = current_color;
+
+    switch(primitive_type) {
+    case PrimitiveType::Lines:
+        if(vertex_count == 2) {
+            rasterizer.drawLine(vertices[0], vertices[1]);
+            vertex_count = 0;
+        }
+        break;
+    case PrimitiveType::Triangles:
+        if(vertex_count == 3) {
+            rasterizer.drawTriangle(vertices[0], vertices[1], vertices[2]);
+            vertex_count = 0;
+        }
+        break;
+    case PrimitiveType::TriangleStrip:
+        if(vertex_count == 3) {
+            // OpenGLと同じく奇数番目の三角形は頂点順を入れ替えて向きをそろえる
+            if(strip_index & 1) {
+                rasterizer.drawTriangle(vertices[1], vertices[0], vertices[2]);
+            }
+            else {
+                rasterizer.drawTriangle(vertices[0], vertices[1], vertices[2]);
+            }
+            strip_index++;
+
+            vertices[0]  = vertices[1];
+            vertices[1]  = vertices[2];
+            vertex_count = 2;
+        }
+        break;
+    }
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 描画を初期化
+//---------------------------------------------------------------------------
+bool RENDER_setup(RenderBackend render_backend, s32 width, s32 height)
+{
+    backend = render_backend;
+
+    if(backend != RenderBackend::OpenGL) {
+        if(!rasterizer.setup(width, height)) {
+            MessageBox(nullptr, "ソフトウェアラスタライザーの初期化に失敗しました.", "RENDER", MB_OK);
+            return false;
+        }
+    }
+    else {
+        glEnable(GL_DEPTH_TEST);   // Ｚバッファを有効にする
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 描画を解放
+//---------------------------------------------------------------------------
+void RENDER_cleanup()
+{
+    rasterizer.cleanup();
+}
+
+//---------------------------------------------------------------------------
+//! 描画先を取得
+//---------------------------------------------------------------------------
+RenderBackend RENDER_getBackend()
+{
+    return backend;
+}
+
+//---------------------------------------------------------------------------
+//! 画面クリア
+//---------------------------------------------------------------------------
+void RENDER_clear(const Color& color)
+{
+    if(backend == RenderBackend::OpenGL) {
+        glClearColor(color.r_ / 255.0f, color.g_ / 255.0f, color.b_ / 255.0f, color.a_ / 255.0f);
+        glClearDepth(1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    else {
+        rasterizer.clear(color);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 描画結果を画面に反映
+//---------------------------------------------------------------------------
+void RENDER_present()
+{
+    last_stats  = frame_stats;
+    frame_stats = RenderStats();
+
+    if(backend == RenderBackend::OpenGL) {
+        return;
+    }
+
+    rasterizer.flush();
+    if(backend == RenderBackend::Offscreen) {
+        return;
+    }
+
+    //---- 描画結果をウィンドウに転送
+    // カラーバッファはOpenGLと同じく最下行から並んでいるためそのまま転送できる
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rasterizer.getPitch());
+    glRasterPos2f(-1.0f, -1.0f);
+    glDrawPixels(rasterizer.getWidth(),
+                 rasterizer.getHeight(),
+                 GL_RGBA,
+                 GL_UNSIGNED_BYTE,
+                 rasterizer.getColorBuffer());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+//---------------------------------------------------------------------------
+//! 描画結果をTGAファイルに保存
+//---------------------------------------------------------------------------
+bool RENDER_saveImage(const char* path)
+{
+    if(backend == RenderBackend::OpenGL) {
+        return false;
+    }
+    return rasterizer.saveTGA(path);
+}
+
+//---------------------------------------------------------------------------
+//! 描画統計を取得
+//---------------------------------------------------------------------------
+const RenderStats& RENDER_getStats()
+{
+    return last_stats;
+}
+
+//---------------------------------------------------------------------------
+//! 投影行列を設定
+//---------------------------------------------------------------------------
+void RENDER_setProjectionMatrix(const matrix& m)
+{
+    mat_proj = m;
+    updateMatrix();
+    frame_stats.state_change_count_++;
+}
+
+//---------------------------------------------------------------------------
+//! ビュー行列を設定
+//---------------------------------------------------------------------------
+void RENDER_setViewMatrix(const matrix& m)
+{
+    mat_view = m;
+    updateMatrix();
+    frame_stats.state_change_count_++;
+}
+
+//---------------------------------------------------------------------------
+//! ワールド行列を設定
+//---------------------------------------------------------------------------
+void RENDER_setWorldMatrix(const matrix& m)
+{
+    mat_world = m;
+    updateMatrix();
+    frame_stats.state_change_count_++;
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャを設定
+//---------------------------------------------------------------------------
+void RENDER_setTexture(TextureHandle texture)
+{
+    frame_stats.state_change_count_++;
+
+    if(backend == RenderBackend::OpenGL) {
+        SetTexture(texture);
+    }
+    else {
+        rasterizer.setTexture(GetTexture(texture));
+    }
+}
+
+//---------------------------------------------------------------------------
+//! プリミティブの登録開始
+//---------------------------------------------------------------------------
+void RENDER_begin(PrimitiveType type)
+{
+    primitive_type = type;
+    vertex_count   = 0;
+    strip_index    = 0;
+    frame_stats.draw_count_++;
+
+    if(backend == RenderBackend::OpenGL) {
+        switch(type) {
+        case PrimitiveType::Lines:
+            glBegin(GL_LINES);
+            break;
+        case PrimitiveType::Triangles:
+            glBegin(GL_TRIANGLES);
+            break;
+        case PrimitiveType::TriangleStrip:
+            glBegin(GL_TRIANGLE_STRIP);
+            break;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 頂点カラーを設定
+//---------------------------------------------------------------------------
+void RENDER_color(const Color& color)
+{
+    current_color = color;
+
+    if(backend == RenderBackend::OpenGL) {
+        glColor4ubv((GLubyte*)&color);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャ座標を設定
+//---------------------------------------------------------------------------
+void RENDER_texCoord(f32 u, f32 v)
+{
+    current_u = u;
+    current_v = v;
+
+    if(backend == RenderBackend::OpenGL) {
+        glTexCoord2f(u, v);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 頂点を登録
+//---------------------------------------------------------------------------
+void RENDER_vertex(const float3& position)
+{
+    frame_stats.vertex_count_++;
+
+    if(backend == RenderBackend::OpenGL) {
+        glVertex3fv((GLfloat*)&position);
+    }
+    else {
+        addSoftwareVertex(position);
+    }
+}
+
+//---------------------------------------------------------------------------
+//! 頂点を登録
+//---------------------------------------------------------------------------
+void RENDER_vertex(f32 x, f32 y, f32 z)
+{
+    RENDER_vertex(float3(x, y, z));
+}
+
+//---------------------------------------------------------------------------
+//! プリミティブの登録終了
+//---------------------------------------------------------------------------
+void RENDER_end()
+{
+    if(backend == RenderBackend::OpenGL) {
+        glEnd();
+    }
+}
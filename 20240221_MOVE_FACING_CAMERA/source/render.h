@@ -0,0 +1,116 @@
+﻿//===========================================================================
+//!	@file	render.h
+//!	@brief	描画API (OpenGL / ソフトウェアラスタライザー切り替え)
+//!
+//!	glBegin()/glEnd()と同じ書き方で描画し、実際の描画先を切り替えます。
+//!	ソフトウェア描画はOpenGLを使わずにCPUで描画し、結果をウィンドウに転送します。
+//!
+//! @code
+//!     RENDER_setTexture(texture);
+//!     RENDER_begin(PrimitiveType::Triangles);
+//!     RENDER_color(Color(255, 255, 255));
+//!     RENDER_texCoord(0.0f, 0.0f);
+//!     RENDER_vertex(float3(-1.0f, 1.0f, 0.0f));
+//!     ...
+//!     RENDER_end();
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! 描画先
+enum class RenderBackend
+{
+    OpenGL,      //!< OpenGL (固定機能)
+    Software,    //!< ソフトウェアラスタライザー
+    Offscreen,   //!< ソフトウェアラスタライザー (画面に転送しない、OpenGL不要)
+};
+
+//! プリミティブの種類
+enum class PrimitiveType
+{
+    Lines,           //!< 線 (2頂点ずつ)
+    Triangles,       //!< 三角形 (3頂点ずつ)
+    TriangleStrip,   //!< 三角形ストリップ
+};
+
+//! 描画統計 (1フレーム分)
+struct RenderStats
+{
+    u32 draw_count_         = 0;   //!< RENDER_begin()～RENDER_end()の回数
+    u32 vertex_count_       = 0;   //!< 登録した頂点数
+    u32 state_change_count_ = 0;   //!< 行列・テクスチャの設定回数
+};
+
+//! 描画を初期化
+//! @param  [in]    backend 描画先
+//! @param  [in]    width   画面の幅
+//! @param  [in]    height  画面の高さ
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool RENDER_setup(RenderBackend backend, s32 width, s32 height);
+
+//! 描画を解放
+void RENDER_cleanup();
+
+//! 描画先を取得
+RenderBackend RENDER_getBackend();
+
+//! 画面クリア (カラーとZバッファ)
+//! @param  [in]    color   クリアカラー
+void RENDER_clear(const Color& color);
+
+//! 描画結果を画面に反映 (ソフトウェア描画の場合はここで描画を実行)
+void RENDER_present();
+
+//! 描画結果をTGAファイルに保存 (ソフトウェア描画・オフスクリーンのみ)
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool RENDER_saveImage(const char* path);
+
+//! 描画統計を取得 (直前のRENDER_present()までの1フレーム分)
+const RenderStats& RENDER_getStats();
+
+//----------------------------------------------------------
+//! @name 描画設定
+//----------------------------------------------------------
+//!@{
+
+//! 投影行列を設定
+void RENDER_setProjectionMatrix(const matrix& m);
+
+//! ビュー行列を設定
+void RENDER_setViewMatrix(const matrix& m);
+
+//! ワールド行列を設定
+void RENDER_setWorldMatrix(const matrix& m);
+
+//! テクスチャを設定 (無効なハンドルでOFF)
+//! @attention RENDER_begin()～RENDER_end()の外側でのみ変更可
+void RENDER_setTexture(TextureHandle texture);
+
+//!@}
+//----------------------------------------------------------
+//! @name 頂点の登録
+//----------------------------------------------------------
+//!@{
+
+//! プリミティブの登録開始
+void RENDER_begin(PrimitiveType type);
+
+//! 頂点カラーを設定
+void RENDER_color(const Color& color);
+
+//! テクスチャ座標を設定
+void RENDER_texCoord(f32 u, f32 v);
+
+//! 頂点を登録 (直前に設定したカラーとテクスチャ座標を使用)
+void RENDER_vertex(const float3& position);
+
+//! 頂点を登録
+void RENDER_vertex(f32 x, f32 y, f32 z);
+
+//! プリミティブの登録終了
+void RENDER_end();
+
+//!@}
@@ -0,0 +1,313 @@
+﻿//===========================================================================
+//!	@file	sampler.cpp
+//!	@brief	テクスチャサンプラー (ソフトウェア描画用)
+//===========================================================================
+#include <emmintrin.h>   // SSE2
+
+namespace
+{
+//---------------------------------------------------------------------------
+//! 座標を範囲内に収める
+//---------------------------------------------------------------------------
+s32 wrapCoord(s32 x, s32 size)
+{
+    // 2のべき乗はマスクだけで済む
+    if((size & (size - 1)) == 0) {
+        return x & (size - 1);
+    }
+    x %= size;
+    return (x < 0) ? x + size : x;
+}
+
+s32 clampCoord(s32 x, s32 size)
+{
+    return std::clamp(x, 0, size - 1);
+}
+
+//---------------------------------------------------------------------------
+//! 16bit×8要素の線形補間 (重みは0～256)
+//---------------------------------------------------------------------------
+__m128i lerp16(__m128i a, __m128i b, __m128i weight)
+{
+    // 255×256 = 65280 のため16bitに収まる
+    __m128i inv_weight = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, inv_weight), _mm_mullo_epi16(b, weight)), 8);
+}
+
+//---------------------------------------------------------------------------
+//! 4要素の重みを各ピクセルのRGBA 4成分に展開
+//! @param  [out]   lo  ピクセル0,1分
+//! @param  [out]   hi  ピクセル2,3分
+//---------------------------------------------------------------------------
+void expandWeight(__m128i weight, __m128i& lo, __m128i& hi)
+{
+    __m128i w16 = _mm_packs_epi32(weight, weight);   // a b c d a b c d
+    __m128i w2  = _mm_unpacklo_epi16(w16, w16);      // a a b b c c d d
+    lo          = _mm_unpacklo_epi32(w2, w2);        // a a a a b b b b
+    hi          = _mm_unpackhi_epi32(w2, w2);        // c c c c d d d d
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 画像からミップマップとタイル配置を作成
+//---------------------------------------------------------------------------
+bool SampledTexture::build(const Color* image, s32 width, s32 height)
+{
+    MEMORY_TAG(MemoryTag::Texture);
+
+    clear();
+    if(image == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    texels_.assign(layoutLevels(width, height), Color(0, 0, 0, 0));
+
+    //---- 0段目をタイル配置でコピー
+    for(s32 y = 0; y < height; ++y) {
+        for(s32 x = 0; x < width; ++x) {
+            texels_[texelIndex(levels_[0], x, y)] = image[y * width + x];
+        }
+    }
+
+    //---- 縮小 (2x2の平均)
+    for(s32 i = 1; i < level_count_; ++i) {
+        const Level& src = levels_[i - 1];
+        const Level& dst = levels_[i];
+
+        for(s32 y = 0; y < dst.height_; ++y) {
+            for(s32 x = 0; x < dst.width_; ++x) {
+                s32 x0 = std::min(x * 2, src.width_ - 1);
+                s32 x1 = std::min(x * 2 + 1, src.width_ - 1);
+                s32 y0 = std::min(y * 2, src.height_ - 1);
+                s32 y1 = std::min(y * 2 + 1, src.height_ - 1);
+
+                const Color& c00 = texels_[texelIndex(src, x0, y0)];
+                const Color& c10 = texels_[texelIndex(src, x1, y0)];
+                const Color& c01 = texels_[texelIndex(src, x0, y1)];
+                const Color& c11 = texels_[texelIndex(src, x1, y1)];
+
+                texels_[texelIndex(dst, x, y)] = Color(static_cast<u8>((c00.r_ + c10.r_ + c01.r_ + c11.r_ + 2) >> 2),
+                                                       static_cast<u8>((c00.g_ + c10.g_ + c01.g_ + c11.g_ + 2) >> 2),
+                                                       static_cast<u8>((c00.b_ + c10.b_ + c01.b_ + c11.b_ + 2) >> 2),
+                                                       static_cast<u8>((c00.a_ + c10.a_ + c01.a_ + c11.a_ + 2) >> 2));
+            }
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 作成済みのタイル配置のテクセルから復元
+//---------------------------------------------------------------------------
+bool SampledTexture::assign(std::span<const Color> texels, s32 width, s32 height)
+{
+    MEMORY_TAG(MemoryTag::Texture);
+
+    clear();
+    if(width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // 配置はbuild()と同じ計算で決まるため、テクセル数が一致すればそのまま使える
+    if(static_cast<size_t>(layoutLevels(width, height)) != texels.size()) {
+        clear();
+        return false;
+    }
+    texels_.assign(texels.begin(), texels.end());
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 指定した大きさの全段のテクセル数を取得
+//---------------------------------------------------------------------------
+size_t SampledTexture::getTexelCount(s32 width, s32 height)
+{
+    if(width <= 0 || height <= 0) {
+        return 0;
+    }
+    SampledTexture layout;
+    return static_cast<size_t>(layout.layoutLevels(width, height));
+}
+
+//---------------------------------------------------------------------------
+//! 各段の大きさと配置を決める
+//---------------------------------------------------------------------------
+s32 SampledTexture::layoutLevels(s32 width, s32 height)
+{
+    s32 total = 0;
+    for(s32 w = width, h = height; level_count_ < MAX_LEVEL_COUNT; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+        Level& level    = levels_[level_count_++];
+        level.offset_   = total;
+        level.width_    = w;
+        level.height_   = h;
+        level.blocks_x_ = (w + 3) / 4;
+        total += level.blocks_x_ * ((h + 3) / 4) * 16;
+
+        if(w == 1 && h == 1) {
+            break;
+        }
+    }
+    return total;
+}
+
+//---------------------------------------------------------------------------
+//! 解放
+//---------------------------------------------------------------------------
+void SampledTexture::clear()
+{
+    texels_ = std::vector<Color>();   // clear()では容量が残るため空の配列と入れ替えて解放
+    for(auto& level : levels_) {
+        level = Level();
+    }
+    level_count_ = 0;
+}
+
+//---------------------------------------------------------------------------
+//! UV微分値からミップマップ段数を選択
+//---------------------------------------------------------------------------
+s32 SampledTexture::selectLevel(f32 dudx, f32 dvdx, f32 dudy, f32 dvdy) const
+{
+    // 1ピクセルあたりのテクセル数 (大きい方向を採用)
+    f32 w  = static_cast<f32>(getWidth());
+    f32 h  = static_cast<f32>(getHeight());
+    f32 dx = (dudx * w) * (dudx * w) + (dvdx * h) * (dvdx * h);
+    f32 dy = (dudy * w) * (dudy * w) + (dvdy * h) * (dvdy * h);
+    f32 d  = std::max(dx, dy);
+
+    if(!(d > 1.0f)) {
+        return 0;   // 拡大 (NaNもここ)
+    }
+
+    // log2(√d) を四捨五入 (GL_LINEAR_MIPMAP_NEAREST相当)
+    s32 level = static_cast<s32>(0.5f * std::log2(d) + 0.5f);
+    return std::min(level, level_count_ - 1);
+}
+
+//---------------------------------------------------------------------------
+//! テクセルを取得
+//---------------------------------------------------------------------------
+Color SampledTexture::getTexel(s32 level, s32 x, s32 y) const
+{
+    return texels_[texelIndex(levels_[level], x, y)];
+}
+
+//---------------------------------------------------------------------------
+//! バイリニアフィルタの4テクセルの位置を計算
+//! @param  [in]    fx      テクセル座標X (1/256単位、テクセル中心補正済)
+//! @param  [in]    fy      テクセル座標Y (1/256単位、テクセル中心補正済)
+//! @param  [out]   index   [0]左上 [1]右上 [2]左下 [3]右下
+//---------------------------------------------------------------------------
+void SampledTexture::computeAddress(const Level& level, AddressMode mode, s32 fx, s32 fy, s32 index[4]) const
+{
+    s32 x0 = fx >> 8;   // 算術シフトで負の値も切り捨て
+    s32 y0 = fy >> 8;
+    s32 x1 = x0 + 1;
+    s32 y1 = y0 + 1;
+
+    if(mode == AddressMode::Wrap) {
+        x0 = wrapCoord(x0, level.width_);
+        x1 = wrapCoord(x1, level.width_);
+        y0 = wrapCoord(y0, level.height_);
+        y1 = wrapCoord(y1, level.height_);
+    }
+    else {
+        x0 = clampCoord(x0, level.width_);
+        x1 = clampCoord(x1, level.width_);
+        y0 = clampCoord(y0, level.height_);
+        y1 = clampCoord(y1, level.height_);
+    }
+
+    index[0] = texelIndex(level, x0, y0);
+    index[1] = texelIndex(level, x1, y0);
+    index[2] = texelIndex(level, x0, y1);
+    index[3] = texelIndex(level, x1, y1);
+}
+
+//---------------------------------------------------------------------------
+//! 1ピクセル読み取り
+//---------------------------------------------------------------------------
+Color SampledTexture::sample(f32 u, f32 v, s32 level_index, AddressMode mode) const
+{
+    const Level& level = levels_[level_index];
+
+    // sample4()と同じ固定小数点で計算 (テクセル中心が整数座標になるよう0.5ずらす)
+    s32 fx = static_cast<s32>(std::nearbyint(u * static_cast<f32>(level.width_ * 256))) - 128;
+    s32 fy = static_cast<s32>(std::nearbyint(v * static_cast<f32>(level.height_ * 256))) - 128;
+    s32 wx = fx & 255;
+    s32 wy = fy & 255;
+
+    s32 index[4];
+    computeAddress(level, mode, fx, fy, index);
+
+    const u8* c00 = &texels_[index[0]].r_;
+    const u8* c10 = &texels_[index[1]].r_;
+    const u8* c01 = &texels_[index[2]].r_;
+    const u8* c11 = &texels_[index[3]].r_;
+
+    u8 result[4];
+    for(s32 i = 0; i < 4; ++i) {
+        s32 top    = (c00[i] * (256 - wx) + c10[i] * wx) >> 8;
+        s32 bottom = (c01[i] * (256 - wx) + c11[i] * wx) >> 8;
+        result[i]  = static_cast<u8>((top * (256 - wy) + bottom * wy) >> 8);
+    }
+    return Color(result[0], result[1], result[2], result[3]);
+}
+
+//---------------------------------------------------------------------------
+//! 4ピクセル同時に読み取り
+//---------------------------------------------------------------------------
+__m128i SampledTexture::sample4(__m128 u, __m128 v, s32 level_index, AddressMode mode) const
+{
+    const Level& level = levels_[level_index];
+
+    //---- テクセル座標を1/256単位の固定小数点に変換
+    __m128  scale_x = _mm_set1_ps(static_cast<f32>(level.width_ * 256));
+    __m128  scale_y = _mm_set1_ps(static_cast<f32>(level.height_ * 256));
+    __m128i half    = _mm_set1_epi32(128);
+    __m128i fx      = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(u, scale_x)), half);
+    __m128i fy      = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(v, scale_y)), half);
+
+    __m128i byte_mask = _mm_set1_epi32(255);
+    __m128i wx        = _mm_and_si128(fx, byte_mask);
+    __m128i wy        = _mm_and_si128(fy, byte_mask);
+
+    //---- 4ピクセル×4テクセルを集める (アドレス計算はピクセルごと)
+    alignas(16) s32 x[4];
+    alignas(16) s32 y[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(x), fx);
+    _mm_store_si128(reinterpret_cast<__m128i*>(y), fy);
+
+    alignas(16) Color t00[4];
+    alignas(16) Color t10[4];
+    alignas(16) Color t01[4];
+    alignas(16) Color t11[4];
+    for(s32 i = 0; i < 4; ++i) {
+        s32 index[4];
+        computeAddress(level, mode, x[i], y[i], index);
+        t00[i] = texels_[index[0]];
+        t10[i] = texels_[index[1]];
+        t01[i] = texels_[index[2]];
+        t11[i] = texels_[index[3]];
+    }
+
+    //---- バイリニアフィルタ (8bit → 16bitに展開して計算)
+    __m128i zero = _mm_setzero_si128();
+    __m128i c00  = _mm_load_si128(reinterpret_cast<const __m128i*>(t00));
+    __m128i c10  = _mm_load_si128(reinterpret_cast<const __m128i*>(t10));
+    __m128i c01  = _mm_load_si128(reinterpret_cast<const __m128i*>(t01));
+    __m128i c11  = _mm_load_si128(reinterpret_cast<const __m128i*>(t11));
+
+    __m128i wx_lo, wx_hi, wy_lo, wy_hi;
+    expandWeight(wx, wx_lo, wx_hi);
+    expandWeight(wy, wy_lo, wy_hi);
+
+    __m128i top_lo    = lerp16(_mm_unpacklo_epi8(c00, zero), _mm_unpacklo_epi8(c10, zero), wx_lo);
+    __m128i top_hi    = lerp16(_mm_unpackhi_epi8(c00, zero), _mm_unpackhi_epi8(c10, zero), wx_hi);
+    __m128i bottom_lo = lerp16(_mm_unpacklo_epi8(c01, zero), _mm_unpacklo_epi8(c11, zero), wx_lo);
+    __m128i bottom_hi = lerp16(_mm_unpackhi_epi8(c01, zero), _mm_unpackhi_epi8(c11, zero), wx_hi);
+
+    __m128i lo = lerp16(top_lo, bottom_lo, wy_lo);
+    __m128i hi = lerp16(top_hi, bottom_hi, wy_hi);
+    return _mm_packus_epi16(lo, hi);
+}
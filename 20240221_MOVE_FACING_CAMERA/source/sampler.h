@@ -0,0 +1,138 @@
+﻿//===========================================================================
+//!	@file	sampler.h
+//!	@brief	テクスチャサンプラー (ソフトウェア描画用)
+//!
+//!	Image::fetch()と同じバイリニアフィルタを4ピクセル同時にSIMDで計算します。
+//!	- 重みは8bit固定小数点 (1/256単位)
+//!	- 4x4テクセルのブロック単位で並べたタイル配置 (1ブロック=64byte=キャッシュライン1本)
+//!	- ミップマップ (UV微分値から段数を選択)
+//===========================================================================
+#pragma once
+
+//! テクスチャ座標の範囲外の扱い
+enum class AddressMode
+{
+    Wrap,    //!< 繰り返し (GL_REPEAT)
+    Clamp,   //!< 端のテクセルを延長 (GL_CLAMP_TO_EDGE)
+};
+
+//===========================================================================
+//! サンプリング用テクスチャ
+//===========================================================================
+class SampledTexture
+{
+public:
+    static constexpr s32 MAX_LEVEL_COUNT = 16;   //!< ミップマップの最大段数
+
+    //! コンストラクタ
+    SampledTexture() = default;
+
+    //! 画像からミップマップとタイル配置を作成
+    //! @param  [in]    image   画像 (上の行から順、幅×高さ)
+    //! @param  [in]    width   幅
+    //! @param  [in]    height  高さ
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(失敗)
+    bool build(const Color* image, s32 width, s32 height);
+
+    //! 作成済みのタイル配置のテクセルから復元 (アセットパックの読み込み用)
+    //! @param  [in]    texels  全段のテクセル (getTexels()の内容)
+    //! @param  [in]    width   幅
+    //! @param  [in]    height  高さ
+    //!	@retval	true	正常終了	(成功)
+    //!	@retval	false	エラー終了	(テクセル数が大きさと一致しない)
+    bool assign(std::span<const Color> texels, s32 width, s32 height);
+
+    //! 指定した大きさの全段のテクセル数を取得 (テクセルを保持せずに検証する場合用)
+    //! @param  [in]    width   幅
+    //! @param  [in]    height  高さ
+    static size_t getTexelCount(s32 width, s32 height);
+
+    //! 解放
+    void clear();
+
+    //! 空かどうか
+    bool empty() const { return level_count_ == 0; }
+
+    //! 全段のテクセルのメモリサイズを取得 (単位:byte)
+    u64 getMemorySize() const { return texels_.size() * sizeof(Color); }
+
+    //! UV微分値からミップマップ段数を選択
+    //! @param  [in]    dudx    画面X方向1ピクセルあたりのUの変化量
+    //! @param  [in]    dvdx    画面X方向1ピクセルあたりのVの変化量
+    //! @param  [in]    dudy    画面Y方向1ピクセルあたりのUの変化量
+    //! @param  [in]    dvdy    画面Y方向1ピクセルあたりのVの変化量
+    s32 selectLevel(f32 dudx, f32 dvdx, f32 dudy, f32 dvdy) const;
+
+    //! 1ピクセル読み取り (SIMD版の検証用)
+    //! @param  [in]    u       テクスチャ座標U
+    //! @param  [in]    v       テクスチャ座標V
+    //! @param  [in]    level   ミップマップ段数
+    //! @param  [in]    mode    範囲外の扱い
+    Color sample(f32 u, f32 v, s32 level, AddressMode mode) const;
+
+    //! 4ピクセル同時に読み取り
+    //! @param  [in]    u       テクスチャ座標U ×4
+    //! @param  [in]    v       テクスチャ座標V ×4
+    //! @param  [in]    level   ミップマップ段数
+    //! @param  [in]    mode    範囲外の扱い
+    //! @return RGBA8 ×4 (Colorと同じ並び)
+    __m128i sample4(__m128 u, __m128 v, s32 level, AddressMode mode) const;
+
+    //----------------------------------------------------------
+    //! @name 参照
+    //----------------------------------------------------------
+    //!@{
+
+    //! 幅を取得
+    s32 getWidth() const { return levels_[0].width_; }
+
+    //! 高さを取得
+    s32 getHeight() const { return levels_[0].height_; }
+
+    //! ミップマップ段数を取得
+    s32 getLevelCount() const { return level_count_; }
+
+    //! テクセルを取得
+    //! @param  [in]    level   ミップマップ段数
+    //! @param  [in]    x       X座標 (範囲内であること)
+    //! @param  [in]    y       Y座標 (範囲内であること)
+    Color getTexel(s32 level, s32 x, s32 y) const;
+
+    //! 全段のテクセルを取得 (タイル配置)
+    std::span<const Color> getTexels() const { return texels_; }
+
+    //!@}
+
+private:
+    //! ミップマップ1段分
+    struct Level
+    {
+        s32 offset_   = 0;   //!< texels_内の先頭位置
+        s32 width_    = 0;   //!< 幅
+        s32 height_   = 0;   //!< 高さ
+        s32 blocks_x_ = 0;   //!< 横方向のブロック数
+    };
+
+    //! タイル配置でのテクセル位置
+    static s32 texelIndex(const Level& level, s32 x, s32 y)
+    {
+        return level.offset_ + (((y >> 2) * level.blocks_x_ + (x >> 2)) << 4) + ((y & 3) << 2) + (x & 3);
+    }
+
+    //! 各段の大きさと配置を決める
+    //! @return 全段のテクセル数
+    s32 layoutLevels(s32 width, s32 height);
+
+    //! バイリニアフィルタの4テクセルの位置を計算
+    void computeAddress(const Level& level,
+                        AddressMode  mode,
+                        s32          fx,
+                        s32          fy,
+                        s32          index[4]) const;
+
+private:
+    Level              levels_[MAX_LEVEL_COUNT];   //!< ミップマップ
+    s32                level_count_ = 0;           //!< ミップマップ段数
+    std::vector<Color> texels_;                    //!< 全段のテクセル (タイル配置)
+};
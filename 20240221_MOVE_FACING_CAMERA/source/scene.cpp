@@ -0,0 +1,556 @@
+﻿//===========================================================================
+//!	@file	scene.cpp
+//!	@brief	計測用シーン (規模を変えて更新・描画を計測)
+//===========================================================================
+#include <random>
+#include <string_view>
+
+namespace
+{
+constexpr f32 DELTA_TIME = 1.0f / 60.0f;   //!< 1フレームの更新時間 (固定)
+constexpr f32 MOVE_SPEED = 6.0f;           //!< 移動速度 (m/s、ゲームと同じ)
+constexpr f32 TURN_RATE  = 0.1f;           //!< 向きの追従率 (ゲームと同じ)
+constexpr f32 GRAVITY    = 9.80665f;       //!< 重力加速度 (m/s^2)
+constexpr f32 CELL_SIZE  = 4.0f;           //!< 空間グリッドのセルの大きさ
+
+constexpr f32 MAX_GRID_SIZE = 2048.0f;   //!< グリッドの大きさの上限 (空間グリッドの1辺は1024セルまで: 2048 × 2 / CELL_SIZE)
+
+const char* TEXTURE_PATH = "scene_texture.tga";   //!< 生成したテクスチャの一時ファイル
+
+//! ピラミッドのAABB (ローカル座標)
+const AABB pyramid_bounds{float3(-1.0f, 0.0f, -1.0f), float3(+1.0f, 1.0f, +1.0f)};
+
+//! デバッグ矢印 (フレームアリーナ上)
+struct SceneArrow
+{
+    float3 p0;      //!< 始点
+    float3 p1;      //!< 終点
+    Color  color;   //!< 色
+};
+
+//---------------------------------------------------------------------------
+//! 市松模様の32bit TGAファイルを作成 (LoadTexture()で読み込む)
+//---------------------------------------------------------------------------
+bool writeTextureFile(const char* path, s32 size)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, path, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    // 非圧縮フルカラー、上から下へ格納
+    u8 header[18]{};
+    header[2]  = 2;
+    header[12] = static_cast<u8>(size & 0xff);
+    header[13] = static_cast<u8>(size >> 8);
+    header[14] = static_cast<u8>(size & 0xff);
+    header[15] = static_cast<u8>(size >> 8);
+    header[16] = 32;
+    header[17] = 1 << 5;
+
+    std::vector<u8> pixels(static_cast<size_t>(size) * size * 4);
+    for(s32 y = 0; y < size; ++y) {
+        for(s32 x = 0; x < size; ++x) {
+            u8* p = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+            p[0]  = ((x / 16 + y / 16) & 1) ? 255 : 64;   // B
+            p[1]  = static_cast<u8>(x * 255 / size);      // G
+            p[2]  = static_cast<u8>(y * 255 / size);      // R
+            p[3]  = 255;                                  // A
+        }
+    }
+
+    bool result = fwrite(header, sizeof(header), 1, file) == 1 &&
+                  fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+    fclose(file);
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! ピラミッドを描画 (ゲームと同じ形状・色)
+//---------------------------------------------------------------------------
+void drawPyramid()
+{
+    RENDER_begin(PrimitiveType::Triangles);
+    {
+        // 底面
+        RENDER_color(Color(255, 255, 0));
+        RENDER_vertex(-1, 0, -1);
+        RENDER_vertex(+1, 0, -1);
+        RENDER_vertex(-1, 0, +1);
+        RENDER_vertex(+1, 0, -1);
+        RENDER_vertex(-1, 0, +1);
+        RENDER_vertex(+1, 0, +1);
+
+        // 奥側面
+        RENDER_color(Color(255, 255, 255));
+        RENDER_vertex(-1, 0, -1);
+        RENDER_vertex(+1, 0, -1);
+        RENDER_vertex(0, 1, 0);
+
+        // 左側面
+        RENDER_color(Color(0, 0, 255));
+        RENDER_vertex(-1, 0, -1);
+        RENDER_vertex(-1, 0, +1);
+        RENDER_vertex(0, 1, 0);
+
+        // 右側面
+        RENDER_color(Color(0, 255, 0));
+        RENDER_vertex(+1, 0, +1);
+        RENDER_vertex(+1, 0, -1);
+        RENDER_vertex(0, 1, 0);
+
+        // 手前側面
+        RENDER_color(Color(255, 0, 0));
+        RENDER_vertex(-1, 0, +1);
+        RENDER_vertex(+1, 0, +1);
+        RENDER_vertex(0, 1, 0);
+    }
+    RENDER_end();
+}
+
+//---------------------------------------------------------------------------
+//! 昇順に並べた配列のパーセンタイル (nearest-rank)
+//---------------------------------------------------------------------------
+f64 percentile(const std::vector<f64>& sorted, s32 percent)
+{
+    if(sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+//---------------------------------------------------------------------------
+//! 範囲を確認して設定
+//---------------------------------------------------------------------------
+template<typename T>
+bool setValue(T& target, f64 value, f64 min, f64 max)
+{
+    if(value < min || value > max) {
+        return false;
+    }
+    target = static_cast<T>(value);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 名前に対応する項目を設定
+//---------------------------------------------------------------------------
+bool setConfig(SceneConfig& config, std::string_view name, f64 value)
+{
+    if(name == "characters") {
+        return setValue(config.character_count_, value, 0, EntityStore::MAX_ENTITY_COUNT);
+    }
+    if(name == "grid") {
+        return setValue(config.grid_size_, value, 1, MAX_GRID_SIZE);
+    }
+    if(name == "arrows") {
+        return setValue(config.arrow_count_, value, 0, 1 << 20);
+    }
+    if(name == "textures") {
+        return setValue(config.texture_count_, value, 0, 4096);
+    }
+    if(name == "texture_size") {
+        return setValue(config.texture_size_, value, 1, 4096);
+    }
+    if(name == "frames") {
+        return setValue(config.frame_count_, value, 1, 1 << 20);
+    }
+    if(name == "width") {
+        return setValue(config.width_, value, 16, 8192);
+    }
+    if(name == "height") {
+        return setValue(config.height_, value, 16, 8192);
+    }
+    return false;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 規模を文字列から設定
+//---------------------------------------------------------------------------
+bool SCENE_parseConfig(const char* text, SceneConfig& config)
+{
+    SceneConfig result = config;
+
+    const char* p = text;
+    for(;;) {
+        while(*p == ' ') {
+            p++;
+        }
+        if(*p == '\0') {
+            break;
+        }
+
+        const char* equal = strchr(p, '=');
+        if(equal == nullptr) {
+            return false;
+        }
+
+        char* end   = nullptr;
+        f64   value = strtod(equal + 1, &end);
+        if(end == equal + 1 || (*end != ' ' && *end != '\0')) {
+            return false;
+        }
+        if(!setConfig(result, std::string_view(p, equal - p), value)) {
+            return false;
+        }
+        p = end;
+    }
+
+    config = result;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! シーンを実行して計測
+//---------------------------------------------------------------------------
+bool SCENE_run(const SceneConfig& config, SceneResult& result)
+{
+    PROFILE_FUNCTION();
+
+    result         = SceneResult();
+    result.config_ = config;
+
+    const s32 count     = config.character_count_;
+    const f32 grid_size = config.grid_size_;
+
+    // テクスチャの読み込みより先に描画先を設定 (ソフトウェア描画用のテクスチャを保持するかどうかが決まる)
+    if(!RENDER_setup(RenderBackend::Offscreen, config.width_, config.height_)) {
+        return false;
+    }
+
+    //----------------------------------------------------------
+    // テクスチャ (同じ画像を枚数分読み込む)
+    // ウィンドウを作らないためOpenGLのコンテキストがなく、GPUへの転送は行われない。
+    // 計測するのはファイル読み込み・展開・ソフトウェア描画用のミップマップ作成まで
+    //----------------------------------------------------------
+    std::vector<TextureHandle> textures;
+    if(config.texture_count_ > 0) {
+        if(!writeTextureFile(TEXTURE_PATH, config.texture_size_)) {
+            RENDER_cleanup();
+            return false;
+        }
+        f64 start = TIMER_now();
+        for(s32 i = 0; i < config.texture_count_; ++i) {
+            TextureHandle texture = LoadTexture(TEXTURE_PATH);
+            if(!texture) {
+                break;
+            }
+            textures.push_back(texture);
+        }
+        result.texture_decode_ms_ = (TIMER_now() - start) * 1000.0;
+        remove(TEXTURE_PATH);
+
+        if(static_cast<s32>(textures.size()) != config.texture_count_) {
+            RENDER_cleanup();
+            TEXTURE_cleanup();
+            return false;
+        }
+    }
+
+    //----------------------------------------------------------
+    // キャラクター (配置範囲内に乱数で配置、位置は実行ごとに同じ)
+    //----------------------------------------------------------
+    std::mt19937                        random(12345);
+    std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+
+    EntityStore entities;
+    SpatialGrid grid;
+    if(!grid.setup(grid_size, CELL_SIZE)) {
+        RENDER_cleanup();
+        for(TextureHandle& texture : textures) {
+            ReleaseTexture(texture);
+        }
+        TEXTURE_cleanup();
+        return false;
+    }
+
+    std::vector<f32> phases(count);   // 移動方向の回転の位相
+    for(s32 i = 0; i < count; ++i) {
+        float3 position = float3(distribution(random) * grid_size, 0.0f, distribution(random) * grid_size);
+        entities.create(position);
+        grid.insert(static_cast<u32>(i), position, 1.0f);
+        phases[i] = distribution(random) * std::numbers::pi_v<f32>;
+    }
+    std::vector<SpatialMove> moves(count);
+
+    //----------------------------------------------------------
+    // カメラ (斜め上から配置範囲全体を見下ろす)
+    //----------------------------------------------------------
+    float3 eye    = float3(0.0f, grid_size * 0.75f, grid_size * 1.5f);
+    float3 axis_z = normalize(eye);
+    float3 axis_x = normalize(cross(float3(0.0f, 1.0f, 0.0f), axis_z));
+    float3 axis_y = cross(axis_z, axis_x);
+    matrix world  = matrix(float4(axis_x, 0.0f), float4(axis_y, 0.0f), float4(axis_z, 0.0f), float4(eye, 1.0f));
+    matrix view   = inverse(world);
+    matrix proj   = matrix::perspectiveFovRH(std::numbers::pi_v<f32> * 0.25f,
+                                           static_cast<f32>(config.width_) / static_cast<f32>(config.height_),
+                                           0.1f,
+                                           grid_size * 8.0f);
+    Frustum frustum(mul(view, proj));
+
+    //----------------------------------------------------------
+    // フレームループ
+    //----------------------------------------------------------
+    result.frames_.resize(config.frame_count_);
+    MEMORY_endFrame();   // 読み込み中の確保回数を1フレーム目に含めない
+
+    for(s32 frame = 0; frame < config.frame_count_; ++frame) {
+        PROFILE_ZONE("scene frame");
+        SceneFrameStats& stats = result.frames_[frame];
+
+        //---- 更新 (キャラクターはそれぞれ円を描くように移動)
+        f64 update_start = TIMER_now();
+        {
+            PROFILE_ZONE("scene update");
+            ENTITY_savePrevious(entities);
+
+            f32  time   = static_cast<f32>(frame) * DELTA_TIME;
+            f32* move_x = entities.getColumn(EntityStore::COLUMN_MOVE, 0);
+            f32* move_z = entities.getColumn(EntityStore::COLUMN_MOVE, 2);
+            for(s32 i = 0; i < count; ++i) {
+                move_x[i] = std::cos(phases[i] + time);
+                move_z[i] = std::sin(phases[i] + time);
+            }
+            ENTITY_updateMovement(entities, MOVE_SPEED, DELTA_TIME);
+            ENTITY_updateGravity(entities, GRAVITY, DELTA_TIME);
+            ENTITY_updateFacing(entities, TURN_RATE, DELTA_TIME);
+
+            const f32* position[3]{
+                entities.getColumn(EntityStore::COLUMN_POSITION, 0),
+                entities.getColumn(EntityStore::COLUMN_POSITION, 1),
+                entities.getColumn(EntityStore::COLUMN_POSITION, 2),
+            };
+            for(s32 i = 0; i < count; ++i) {
+                moves[i] = {static_cast<u32>(i), float3(position[0][i], position[1][i], position[2][i])};
+            }
+            grid.moveBatch(moves);
+        }
+
+        // デバッグ矢印 (キャラクターの向き、キャラクターがいなければ原点)
+        SceneArrow* arrows = ARENA_frameAllocArray<SceneArrow>(config.arrow_count_);
+        for(s32 i = 0; i < config.arrow_count_; ++i) {
+            float3 p0  = count > 0 ? entities.get(EntityStore::COLUMN_POSITION, i % count) : float3(0.0f, 0.0f, 0.0f);
+            float3 dir = count > 0 ? entities.get(EntityStore::COLUMN_APPEARANCE, i % count) : float3(0.0f, 1.0f, 0.0f);
+            arrows[i]  = {p0, p0 + dir * 2.0f, Color(255, 0, 255)};
+        }
+        stats.update_ms_ = (TIMER_now() - update_start) * 1000.0;
+
+        //---- 描画
+        f64 render_start = TIMER_now();
+        {
+            PROFILE_ZONE("scene render");
+            RENDER_setProjectionMatrix(proj);
+            RENDER_setViewMatrix(view);
+            RENDER_setWorldMatrix(matrix::identity());
+            RENDER_clear(Color(64, 64, 64));
+
+            // テクスチャつき四角形 (奥の辺に並べる)
+            for(size_t i = 0; i < textures.size(); ++i) {
+                f32 x = (static_cast<f32>(i) + 0.5f) / static_cast<f32>(textures.size()) * 2.0f - 1.0f;
+                f32 w = grid_size / static_cast<f32>(textures.size());
+                x *= grid_size;
+
+                RENDER_setTexture(textures[i]);
+                RENDER_begin(PrimitiveType::TriangleStrip);
+                RENDER_color(Color(255, 255, 255));
+                RENDER_texCoord(0.0f, 0.0f);
+                RENDER_vertex(x - w, w * 2.0f, -grid_size);
+                RENDER_texCoord(1.0f, 0.0f);
+                RENDER_vertex(x + w, w * 2.0f, -grid_size);
+                RENDER_texCoord(0.0f, 1.0f);
+                RENDER_vertex(x - w, 0.0f, -grid_size);
+                RENDER_texCoord(1.0f, 1.0f);
+                RENDER_vertex(x + w, 0.0f, -grid_size);
+                RENDER_end();
+            }
+            RENDER_setTexture(TextureHandle{});
+
+            // キャラクター (視錐台の外は描画しない)
+            for(s32 i = 0; i < count; ++i) {
+                matrix m = ENTITY_makeTransform(entities.get(EntityStore::COLUMN_APPEARANCE, i),
+                                                entities.get(EntityStore::COLUMN_POSITION, i));
+                if(!frustum.testAABB(pyramid_bounds.transform(m))) {
+                    continue;
+                }
+                RENDER_setWorldMatrix(m);
+                drawPyramid();
+                stats.visible_count_++;
+            }
+            RENDER_setWorldMatrix(matrix::identity());
+
+            // デバッグ矢印
+            if(config.arrow_count_ > 0) {
+                RENDER_begin(PrimitiveType::Lines);
+                for(s32 i = 0; i < config.arrow_count_; ++i) {
+                    RENDER_color(arrows[i].color);
+                    RENDER_vertex(arrows[i].p0);
+                    RENDER_vertex(arrows[i].p1);
+                }
+                RENDER_end();
+            }
+
+            // グリッド (1m間隔)
+            s32 line_count = static_cast<s32>(grid_size);
+            RENDER_begin(PrimitiveType::Lines);
+            RENDER_color(Color(255, 255, 255));
+            for(s32 i = -line_count; i <= line_count; ++i) {
+                f32 f = static_cast<f32>(i);
+                RENDER_vertex(f, 0.0f, -grid_size);
+                RENDER_vertex(f, 0.0f, +grid_size);
+                RENDER_vertex(-grid_size, 0.0f, f);
+                RENDER_vertex(+grid_size, 0.0f, f);
+            }
+            RENDER_end();
+
+            RENDER_present();
+        }
+        stats.render_ms_ = (TIMER_now() - render_start) * 1000.0;
+
+        const RenderStats& render_stats = RENDER_getStats();
+        stats.draw_count_               = render_stats.draw_count_;
+        stats.vertex_count_             = render_stats.vertex_count_;
+        stats.arena_bytes_              = ARENA_getFrameArena().getUsedSize();
+
+        ARENA_endFrame();
+        TEXTURE_endFrame();
+
+        MEMORY_endFrame();
+        MemoryStats heap   = MEMORY_getTotalStats();
+        stats.heap_allocs_ = heap.frame_count_;
+        stats.heap_bytes_  = heap.live_bytes_;
+    }
+
+    //---- 最後のフレームを画像で確認できるように保存
+    RENDER_saveImage("scene.tga");
+
+    RENDER_cleanup();
+    grid.cleanup();
+    for(TextureHandle& texture : textures) {
+        ReleaseTexture(texture);
+    }
+    TEXTURE_cleanup();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! フレームごとの計測結果をCSVで保存
+//---------------------------------------------------------------------------
+bool SCENE_writeCSV(const char* path, std::span<const SceneResult> results)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, path, "w");
+    if(file == nullptr) {
+        return false;
+    }
+
+    fprintf(file,
+            "characters,grid,arrows,textures,texture_size,frame,"
+            "update_ms,render_ms,frame_ms,draw_count,vertex_count,visible_count,arena_bytes,heap_allocs,heap_bytes\n");
+    for(const SceneResult& result : results) {
+        const SceneConfig& config = result.config_;
+        for(size_t i = 0; i < result.frames_.size(); ++i) {
+            const SceneFrameStats& frame = result.frames_[i];
+            fprintf(file,
+                    "%d,%g,%d,%d,%d,%zu,%.4f,%.4f,%.4f,%u,%u,%d,%llu,%u,%llu\n",
+                    config.character_count_,
+                    config.grid_size_,
+                    config.arrow_count_,
+                    config.texture_count_,
+                    config.texture_size_,
+                    i,
+                    frame.update_ms_,
+                    frame.render_ms_,
+                    frame.update_ms_ + frame.render_ms_,
+                    frame.draw_count_,
+                    frame.vertex_count_,
+                    frame.visible_count_,
+                    static_cast<unsigned long long>(frame.arena_bytes_),
+                    frame.heap_allocs_,
+                    static_cast<unsigned long long>(frame.heap_bytes_));
+        }
+    }
+
+    // 書き込みエラー (ディスク不足など) も失敗にする
+    bool succeeded = ferror(file) == 0;
+    succeeded      = fclose(file) == 0 && succeeded;
+    return succeeded;
+}
+
+//---------------------------------------------------------------------------
+//! 規模と集計をJSONで保存
+//---------------------------------------------------------------------------
+bool SCENE_writeJSON(const char* path, std::span<const SceneResult> results)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, path, "w");
+    if(file == nullptr) {
+        return false;
+    }
+
+    fprintf(file, "[\n");
+    for(size_t r = 0; r < results.size(); ++r) {
+        const SceneResult& result = results[r];
+        const SceneConfig& config = result.config_;
+
+        std::vector<f64> frame_ms;
+        f64              update_total = 0.0;
+        f64              render_total = 0.0;
+        u64              arena_peak   = 0;
+        u64              heap_allocs  = 0;
+        u64              heap_peak    = 0;
+        for(const SceneFrameStats& frame : result.frames_) {
+            frame_ms.push_back(frame.update_ms_ + frame.render_ms_);
+            update_total += frame.update_ms_;
+            render_total += frame.render_ms_;
+            arena_peak = std::max(arena_peak, frame.arena_bytes_);
+            heap_allocs += frame.heap_allocs_;
+            heap_peak = std::max(heap_peak, frame.heap_bytes_);
+        }
+        std::sort(frame_ms.begin(), frame_ms.end());
+
+        f64 frame_count = static_cast<f64>(std::max<size_t>(result.frames_.size(), 1));
+        SceneFrameStats last = result.frames_.empty() ? SceneFrameStats() : result.frames_.back();
+
+        fprintf(file, "  {\n");
+        fprintf(file,
+                "    \"config\": {\"characters\": %d, \"grid\": %g, \"arrows\": %d, \"textures\": %d, "
+                "\"texture_size\": %d, \"frames\": %d, \"width\": %d, \"height\": %d},\n",
+                config.character_count_,
+                config.grid_size_,
+                config.arrow_count_,
+                config.texture_count_,
+                config.texture_size_,
+                config.frame_count_,
+                config.width_,
+                config.height_);
+        fprintf(file, "    \"texture_decode_ms\": %.4f,\n", result.texture_decode_ms_);
+        fprintf(file,
+                "    \"frame_ms\": {\"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+                (update_total + render_total) / frame_count,
+                percentile(frame_ms, 50),
+                percentile(frame_ms, 95),
+                percentile(frame_ms, 99),
+                frame_ms.empty() ? 0.0 : frame_ms.back());
+        fprintf(file, "    \"update_ms\": %.4f,\n", update_total / frame_count);
+        fprintf(file, "    \"render_ms\": %.4f,\n", render_total / frame_count);
+        fprintf(file,
+                "    \"draw_count\": %u,\n    \"vertex_count\": %u,\n    \"visible_count\": %d,\n",
+                last.draw_count_,
+                last.vertex_count_,
+                last.visible_count_);
+        fprintf(file, "    \"arena_peak_bytes\": %llu,\n", static_cast<unsigned long long>(arena_peak));
+        fprintf(file, "    \"heap_allocs_per_frame\": %.2f,\n", heap_allocs / frame_count);
+        fprintf(file, "    \"heap_peak_bytes\": %llu\n", static_cast<unsigned long long>(heap_peak));
+        fprintf(file, "  }%s\n", r + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "]\n");
+
+    // 書き込みエラー (ディスク不足など) も失敗にする
+    bool succeeded = ferror(file) == 0;
+    succeeded      = fclose(file) == 0 && succeeded;
+    return succeeded;
+}
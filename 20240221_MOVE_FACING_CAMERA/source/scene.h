@@ -0,0 +1,82 @@
+﻿//===========================================================================
+//!	@file	scene.h
+//!	@brief	計測用シーン (規模を変えて更新・描画を計測)
+//!
+//!	ゲームと同じ更新 (エンティティ・空間グリッド・フレームアリーナ上の
+//!	デバッグ矢印) と描画 (視錐台カリング・ピラミッド・テクスチャつき四角形・
+//!	グリッド) を、キャラクター数などの規模を指定してウィンドウなしで実行し、
+//!	フレームごとの処理時間・描画数・フレームアリーナとヒープの使用量を記録します。
+//!	描画はソフトウェアラスタライザーで行い、画面には転送しません。
+//!
+//! @code
+//!     SceneConfig config;
+//!     SCENE_parseConfig("characters=10000 textures=8", config);
+//!     SceneResult result;
+//!     SCENE_run(config, result);                      // JOB_setup()・ARENA_setup()の後
+//!     SCENE_writeCSV("scene.csv", {&result, 1});      // フレームごと
+//!     SCENE_writeJSON("scene.json", {&result, 1});    // 規模と集計
+//! @endcode
+//===========================================================================
+#pragma once
+
+//! シーンの規模
+struct SceneConfig
+{
+    s32 character_count_ = 1;       //!< キャラクター (ピラミッド) 数
+    f32 grid_size_       = 64.0f;   //!< グリッドの大きさ (±m、配置範囲・空間グリッド・グリッド線)
+    s32 arrow_count_     = 2;       //!< デバッグ矢印の数 (毎フレームフレームアリーナに確保)
+    s32 texture_count_   = 1;       //!< テクスチャ数 (1枚ずつ四角形に貼って描画)
+    s32 texture_size_    = 256;     //!< テクスチャの幅と高さ
+    s32 frame_count_     = 120;     //!< 実行するフレーム数
+    s32 width_           = 1280;    //!< 描画の幅
+    s32 height_          = 720;     //!< 描画の高さ
+};
+
+//! 1フレーム分の計測結果
+struct SceneFrameStats
+{
+    f64 update_ms_     = 0.0;   //!< 更新時間 (単位:ミリ秒)
+    f64 render_ms_     = 0.0;   //!< 描画時間 (単位:ミリ秒、ラスタライズを含む)
+    u32 draw_count_    = 0;     //!< RENDER_begin()～RENDER_end()の回数
+    u32 vertex_count_  = 0;     //!< 登録した頂点数
+    s32 visible_count_ = 0;     //!< 視錐台カリング後のキャラクター数
+    u64 arena_bytes_   = 0;     //!< フレームアリーナの使用量 (単位:byte)
+    u32 heap_allocs_   = 0;     //!< ヒープの確保回数
+    u64 heap_bytes_    = 0;     //!< フレーム終了時のヒープの使用量 (単位:byte)
+};
+
+//! 計測結果
+struct SceneResult
+{
+    SceneConfig                  config_;                    //!< シーンの規模
+    f64                          texture_decode_ms_ = 0.0;   //!< テクスチャの読み込み時間 (単位:ミリ秒、展開まで。GPU転送は含まない)
+    std::vector<SceneFrameStats> frames_;                    //!< フレームごとの計測結果
+};
+
+//! 規模を文字列から設定 ("characters=1000 grid=64 arrows=2 textures=1 texture_size=256 frames=120 width=1280 height=720")
+//! @param  [in]    text    空白区切りの 名前=値 (指定しなかった項目は変更しない)
+//! @param  [inout] config  設定先
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(不明な名前・範囲外の値)
+bool SCENE_parseConfig(const char* text, SceneConfig& config);
+
+//! シーンを実行して計測 (JOB_setup()・ARENA_setup()の後に呼び出す)
+//! @param  [in]    config  シーンの規模
+//! @param  [out]   result  計測結果
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(テクスチャ・描画の初期化に失敗)
+bool SCENE_run(const SceneConfig& config, SceneResult& result);
+
+//! フレームごとの計測結果をCSVで保存 (1行1フレーム、規模の列つき)
+//! @param  [in]    path    ファイル名
+//! @param  [in]    results 計測結果
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool SCENE_writeCSV(const char* path, std::span<const SceneResult> results);
+
+//! 規模と集計 (平均・パーセンタイル) をJSONで保存
+//! @param  [in]    path    ファイル名
+//! @param  [in]    results 計測結果
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool SCENE_writeJSON(const char* path, std::span<const SceneResult> results);
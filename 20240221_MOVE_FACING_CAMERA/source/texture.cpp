@@ -8,6 +8,8 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
+#include <deque>
 
 #define min std::min
 #define max std::max
@@ -58,7 +60,11 @@ class Image
 {
 public:
     //! コンストラクタ
-    Image() = default;
+    //! @param  [in]    arena   イメージ配列の確保先
+    explicit Image(LinearArena& arena)
+        : image_(ArenaAllocator<Color>(arena))
+    {
+    }
 
     //! 初期化
     bool resize(s32 w, s32 h);
@@ -70,7 +76,7 @@ public:
     Color fetch(f32 u, f32 v);
 
 private:
-    std::vector<Color> image_;        //!< イメージ配列(幅×高さ の配列)
+    ArenaVector<Color> image_;        //!< イメージ配列(幅×高さ の配列)
     s32                width_  = 0;   //!< 幅
     s32                height_ = 0;   //!< 高さ
 };
@@ -159,17 +165,44 @@ s32 nextPowerOf2(u32 x)
     return x;
 }
 
+//===========================================================================
+//! TGAの画素データストリーム (メモリに読み込んだファイルの内容から展開)
+//===========================================================================
 class TGAStream
 {
 public:
     //! コンストラクタ
-    TGAStream() {}
+    //! @param  [in]    data    画素データの先頭
+    //! @param  [in]    end     ファイルの末尾
+    TGAStream(const u8* data, const u8* end)
+        : data_(data)
+        , end_(end)
+    {
+    }
 
     //! デストラクタ
     virtual ~TGAStream() {}
 
     //! 1ピクセル読み込み
     virtual Color read() = 0;
+
+protected:
+    //! 1バイト読み込み (ファイルの末尾を超えた場合は0)
+    u8 readByte() { return (data_ < end_) ? *data_++ : 0; }
+
+    //! 1ピクセル分の色を読み込み (B,G,R,Aの順)
+    Color readColor()
+    {
+        u8 b = readByte();
+        u8 g = readByte();
+        u8 r = readByte();
+        u8 a = readByte();
+        return Color(r, g, b, a);
+    }
+
+private:
+    const u8* data_;   //!< 次に読み込む位置
+    const u8* end_;    //!< ファイルの末尾
 };
 
 //===========================================================================
@@ -178,25 +211,13 @@ public:
 class TGAStreamRAW : public TGAStream
 {
 public:
-    TGAStreamRAW(std::ifstream& file)
-        : file_(file)
+    TGAStreamRAW(const u8* data, const u8* end)
+        : TGAStream(data, end)
     {
     }
 
     //! 1ピクセル読み込み
-    virtual Color read()
-    {
-        u8 r, g, b, a;
-        file_.read(reinterpret_cast<char*>(&b), 1);
-        file_.read(reinterpret_cast<char*>(&g), 1);
-        file_.read(reinterpret_cast<char*>(&r), 1);
-        file_.read(reinterpret_cast<char*>(&a), 1);
-
-        return Color(r, g, b, a);
-    }
-
-public:
-    std::ifstream& file_;
+    virtual Color read() { return readColor(); }
 };
 
 //===========================================================================
@@ -212,8 +233,8 @@ public:
         Uncompressed
     };
 
-    TGAStreamRLE(std::ifstream& file)
-        : file_(file)
+    TGAStreamRLE(const u8* data, const u8* end)
+        : TGAStream(data, end)
     {
     }
 
@@ -222,21 +243,13 @@ public:
     {
         // 繰り返しフラグ
         if(count_ == 0) {
-            u8 flagCount;
-            file_.read(reinterpret_cast<char*>(&flagCount), 1);
+            u8 flagCount = readByte();
 
             // 最上位ビットがセット(1のとき)の場合→「連続するデータの数」
             // 最上位ビットがセット(0のとき)の場合→「連続しないデータの数」
             if(flagCount & 0x80) {
                 state_ = State::Compressed;
-
-                u8 r, g, b, a;
-                file_.read(reinterpret_cast<char*>(&b), 1);
-                file_.read(reinterpret_cast<char*>(&g), 1);
-                file_.read(reinterpret_cast<char*>(&r), 1);
-                file_.read(reinterpret_cast<char*>(&a), 1);
-
-                color_ = Color(r, g, b, a);
+                color_ = readColor();
             }
             else {
                 state_ = State::Uncompressed;
@@ -245,13 +258,7 @@ public:
         }
 
         if(state_ == State::Uncompressed) {
-            u8 r, g, b, a;
-            file_.read(reinterpret_cast<char*>(&b), 1);
-            file_.read(reinterpret_cast<char*>(&g), 1);
-            file_.read(reinterpret_cast<char*>(&r), 1);
-            file_.read(reinterpret_cast<char*>(&a), 1);
-
-            color_ = Color(r, g, b, a);
+            color_ = readColor();
         }
 
         count_--;
@@ -263,12 +270,240 @@ public:
     s32   count_ = 0;
     State state_ = State::Unknown;
     Color color_ = Color(0, 0, 0, 0);
+};
+
+//===========================================================================
+//! パック・キャッシュに格納するテクスチャのヘッダー
+//!
+//! 後にGPUに転送する画像 (幅×高さ) とソフトウェア描画用のテクセル (タイル配置の全段) が続く。
+//===========================================================================
+struct PackedTexture
+{
+    s32 width_          = 0;   //!< GPUに転送する画像の幅 (ソフトウェア描画用のテクスチャも同じ)
+    s32 height_         = 0;   //!< GPUに転送する画像の高さ
+    s32 texture_width_  = 0;   //!< Texture::getWidth()の値
+    s32 texture_height_ = 0;   //!< Texture::getHeight()の値
+    s32 source_width_   = 0;   //!< 元画像の幅 (計測結果用)
+    s32 source_height_  = 0;   //!< 元画像の高さ (計測結果用)
+    u32 texel_count_    = 0;   //!< ソフトウェア描画用のテクセル数
+    u32 reserved_       = 0;
+};
 
-    std::ifstream& file_;
+namespace
+{
+constexpr u32 CACHE_VERSION = 1;   //!< キャッシュの形式と展開処理のバージョン (展開・拡大・ミップマップの処理を変えたら上げる)
+
+//! 展開処理の設定 (キャッシュのキーに含める)
+struct CookParams
+{
+    u32 version_         = CACHE_VERSION;                     //!< 処理のバージョン
+    u32 decoder_         = 0;                                 //!< 展開方法 (0:TGA 1:GDI+)
+    u32 power_of_two_    = 0;                                 //!< 2の乗数のサイズに拡大するかどうか
+    u32 texel_size_      = sizeof(Color);                     //!< 1テクセルのバイト数 (RGBA8)
+    u32 max_level_count_ = SampledTexture::MAX_LEVEL_COUNT;   //!< ミップマップの最大段数
+};
+
+//! キャッシュファイルのヘッダー (後にPackedTextureの形式のデータが続く)
+struct CacheHeader
+{
+    char magic_[4]     = {'T', 'X', 'C', 'H'};   //!< 識別子
+    u32  version_      = CACHE_VERSION;          //!< バージョン
+    u64  source_hash_  = 0;                      //!< 元ファイルの内容のハッシュ値
+    u64  params_hash_  = 0;                      //!< 展開処理の設定のハッシュ値
+    u64  source_size_  = 0;                      //!< 元ファイルのバイト数
+    u64  payload_size_ = 0;                      //!< データのバイト数
 };
 
+//! キャッシュのキー
+struct CacheKey
+{
+    u64 source_hash_ = 0;   //!< 元ファイルの内容のハッシュ値
+    u64 params_hash_ = 0;   //!< 展開処理の設定のハッシュ値
+    u64 source_size_ = 0;   //!< 元ファイルのバイト数
+};
+
+std::string cache_directory;   //!< キャッシュのディレクトリ (空で無効)
+
+//---------------------------------------------------------------------------
+//! 工程の計測結果を記録 (開始時刻を現在時刻に進めて次の工程の開始とする)
+//! 同じ工程を複数回行った場合は加算する (キャッシュの読み込みなど)
+//! @param  [inout] stats   計測結果
+//! @param  [in]    stage   工程
+//! @param  [inout] time    工程の開始時刻
+//! @param  [in]    bytes   工程の出力のバイト数
+//---------------------------------------------------------------------------
+void recordStage(TextureLoadStats& stats, TextureLoadStage stage, f64& time, u64 bytes)
+{
+    f64 now = TIMER_now();
+
+    stats.ms_[static_cast<s32>(stage)] += (now - time) * 1000.0;
+    stats.bytes_[static_cast<s32>(stage)] += bytes;
+    time = now;
+}
+
+//---------------------------------------------------------------------------
+//! 拡張子が一致するかどうか (大文字小文字を区別しない)
+//---------------------------------------------------------------------------
+bool hasExtension(const char fileName[], const char* extension)
+{
+    const char* dot = strrchr(fileName, '.');
+    return dot && _stricmp(dot, extension) == 0;
+}
+
+//---------------------------------------------------------------------------
+//! ソフトウェア描画用のテクスチャをCPU側に保持するかどうか
+//! OpenGLで描画する場合は参照されないため保持しない (RENDER_setup()の後に判定すること)
+//---------------------------------------------------------------------------
+bool keepsSampledTexture()
+{
+    return RENDER_getBackend() != RenderBackend::OpenGL;
+}
+
+//---------------------------------------------------------------------------
+//! ファイル全体を読み込む
+//! @param  [in]    fileName    ファイル名
+//! @param  [out]   data        ファイルの内容
+//---------------------------------------------------------------------------
+bool readFile(const char fileName[], ArenaVector<u8>& data)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if(!file.is_open()) {
+        return false;
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    return file.read(reinterpret_cast<char*>(data.data()), data.size()).good();
+}
+
+//---------------------------------------------------------------------------
+//! ハッシュ値を計算 (8バイト単位のFNV-1a)
+//! 元ファイル全体を毎回計算するため、1バイト単位より速い8バイト単位で計算する
+//---------------------------------------------------------------------------
+u64 hashBytes(const void* data, size_t size, u64 hash = 14695981039346656037ull)
+{
+    constexpr u64 PRIME = 1099511628211ull;
+
+    const u8* bytes = static_cast<const u8*>(data);
+    for(; size >= sizeof(u64); bytes += sizeof(u64), size -= sizeof(u64)) {
+        u64 word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ word) * PRIME;
+    }
+    for(; size > 0; ++bytes, --size) {
+        hash = (hash ^ *bytes) * PRIME;
+    }
+    return hash;
+}
+
+//---------------------------------------------------------------------------
+//! キャッシュのキーを作成
+//! @param  [in]    fileName    ファイル名 (展開方法の判定)
+//! @param  [in]    source      ファイルの内容
+//---------------------------------------------------------------------------
+CacheKey makeCacheKey(const char fileName[], std::span<const u8> source)
+{
+    CookParams params;
+    params.decoder_      = hasExtension(fileName, ".tga") ? 0 : 1;
+    params.power_of_two_ = (params.decoder_ == 0) ? 1 : 0;
+
+    CacheKey key;
+    key.source_hash_ = hashBytes(source.data(), source.size());
+    key.params_hash_ = hashBytes(&params, sizeof(params));
+    key.source_size_ = source.size();
+    return key;
+}
+
+//---------------------------------------------------------------------------
+//! キャッシュファイル名を取得
+//---------------------------------------------------------------------------
+std::filesystem::path getCachePath(const CacheKey& key)
+{
+    char name[32];
+    sprintf_s(name, "%016llx.tex", static_cast<unsigned long long>(hashBytes(&key, sizeof(key))));
+    return std::filesystem::path(cache_directory) / name;
+}
+
+//---------------------------------------------------------------------------
+//! キャッシュファイルを読み込み (キーとサイズが一致しなければ失敗)
+//! @param  [in]    key     キャッシュのキー
+//! @param  [out]   data    PackedTextureの形式のデータ
+//---------------------------------------------------------------------------
+bool readCache(const CacheKey& key, ArenaVector<u8>& data)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, getCachePath(key).string().c_str(), "rb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    // ヘッダーだけで判定できるため、データのハッシュ値は計算しない
+    CacheHeader header;
+    CacheHeader expected;
+    bool        result = fread(&header, sizeof(header), 1, file) == 1;
+    result             = result && memcmp(header.magic_, expected.magic_, sizeof(header.magic_)) == 0;
+    result             = result && header.version_ == CACHE_VERSION;
+    result             = result && header.source_hash_ == key.source_hash_;
+    result             = result && header.params_hash_ == key.params_hash_;
+    result             = result && header.source_size_ == key.source_size_;
+    result             = result && _fseeki64(file, 0, SEEK_END) == 0 && u64(_ftelli64(file)) == sizeof(header) + header.payload_size_;
+    if(result) {
+        data.resize(static_cast<size_t>(header.payload_size_));
+        result = _fseeki64(file, sizeof(header), SEEK_SET) == 0 && fread(data.data(), 1, data.size(), file) == data.size();
+    }
+    fclose(file);
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//! キャッシュファイルを書き込み
+//! 書き込み途中のファイルを読まないように一時ファイルに書いてから名前を変える
+//! (一時ファイル名はスレッドごとに変えて、同時に同じキーを書き込んでも壊れないようにする)
+//! @param  [in]    key     キャッシュのキー
+//! @param  [in]    data    PackedTextureの形式のデータ
+//---------------------------------------------------------------------------
+bool writeCache(const CacheKey& key, std::span<const u8> data)
+{
+    std::error_code       error;
+    std::filesystem::path path      = getCachePath(key);
+    std::filesystem::path temporary = path;
+
+    char suffix[32];
+    sprintf_s(suffix, ".%lu.tmp", static_cast<unsigned long>(GetCurrentThreadId()));
+    temporary += suffix;
+
+    std::filesystem::create_directories(cache_directory, error);
+
+    FILE* file = nullptr;
+    fopen_s(&file, temporary.string().c_str(), "wb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    CacheHeader header;
+    header.source_hash_  = key.source_hash_;
+    header.params_hash_  = key.params_hash_;
+    header.source_size_  = key.source_size_;
+    header.payload_size_ = data.size();
+
+    bool result = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+
+    if(result) {
+        std::filesystem::rename(temporary, path, error);
+        result = !error;
+    }
+    if(!result) {
+        std::filesystem::remove(temporary, error);
+    }
+    return result;
+}
+
+}   // namespace
+
 //===========================================================================
-//! テクスチャ実装部
+//! テクスチャ実装部 (読み込み処理)
+//!
+//! データはTextureが持ち、読み込み後はTextureとしてプールにコピーされる。
 //===========================================================================
 class TextureImpl final : public Texture
 {
@@ -276,43 +511,78 @@ public:
     //! コンストラクタ
     TextureImpl() = default;
 
-    //! 読み込み
-    bool load(const char fileName[]);
-
-    //! OpenGLのテクスチャIDを取得
-    virtual GLuint getTextureID() const override;
-
-    //! 幅を取得
-    virtual s32 getWidth() const override;
-
-    //! 高さを取得
-    virtual s32 getHeight() const override;
-
-    //! TGAファイルを読み込み
-    bool loadTGA(const char fileName[]);
+    //! 読み込み (キャッシュが有効ならキャッシュを使用・作成)
+    //! @param  [in]    fileName    ファイル名
+    //! @param  [out]   stats       工程ごとの計測結果
+    bool load(const char fileName[], TextureLoadStats& stats);
+
+    //! アセットパックから読み込み (展開・拡大・ミップマップ作成済み)
+    //! @param  [in]    entry       パックの項目番号
+    //! @param  [out]   stats       工程ごとの計測結果
+    bool loadPacked(s32 entry, TextureLoadStats& stats);
+
+    //! 展開済みのデータを作成 (キャッシュが有効ならキャッシュを使用・作成)
+    //! OpenGLは使用しないためワーカースレッドから呼び出せる (パックの作成・ホットリロード用)
+    //! @param  [in]    fileName    ファイル名
+    //! @param  [out]   stats       工程ごとの計測結果
+    //! @param  [out]   data        PackedTextureの形式のデータ
+    //! @param  [in]    quiet       trueならエラーをダイアログではなくデバッグ出力に表示 (ワーカースレッド用)
+    bool prepare(const char fileName[], TextureLoadStats& stats, std::vector<u8>& data, bool quiet = false);
+
+    //! 展開済みのデータから読み込み (パック・キャッシュ・ホットリロード共通)
+    //! @param  [in]    data        PackedTextureの形式のデータ
+    //! @param  [out]   stats       工程ごとの計測結果
+    bool loadCooked(std::span<const u8> data, TextureLoadStats& stats);
 
 private:
-    bool loadFromFile(const char fileName[]);
+    //! 画像を展開してGPUに転送する形 (2の乗数のサイズ) にする
+    //! 作業用のメモリは呼び出し側のスクラッチアリーナのスコープで解放する
+    //! @param  [in]    fileName    ファイル名
+    //! @param  [in]    source      ファイルの内容
+    //! @param  [out]   stats       工程ごとの計測結果
+    //! @param  [out]   image       画像 (スクラッチアリーナから確保)
+    //! @param  [out]   width       画像の幅
+    //! @param  [out]   height      画像の高さ
+    //! @param  [in]    quiet       trueならエラーをダイアログではなくデバッグ出力に表示
+    bool decode(const char fileName[], std::span<const u8> source, TextureLoadStats& stats, ArenaVector<Color>& image, s32& width, s32& height, bool quiet);
+
+    //! TGAファイルを展開
+    bool decodeTGA(const char fileName[], std::span<const u8> source, TextureLoadStats& stats, ArenaVector<Color>& image, s32& width, s32& height, bool quiet);
+
+    //! GDI+で画像ファイルを展開
+    bool decodeFromFile(const char fileName[], TextureLoadStats& stats, ArenaVector<Color>& image, s32& width, s32& height);
+
+    //! テクスチャIDを作成して画像をGPUに転送
+    void upload(const Color* image, s32 width, s32 height, TextureLoadStats& stats);
+
+    //! パック・キャッシュに格納するデータを作成 (decode()とsampled_の作成の後)
+    //! @param  [in]    image       GPUに転送する画像
+    //! @param  [in]    width       画像の幅
+    //! @param  [in]    height      画像の高さ
+    //! @param  [in]    stats       工程ごとの計測結果 (元画像の大きさ)
+    //! @param  [out]   data        PackedTextureの形式のデータ
+    void serialize(const Color* image, s32 width, s32 height, const TextureLoadStats& stats, std::vector<u8>& data) const;
 
     // 代入禁止 / move禁止
     TextureImpl(const Texture&)        = delete;
     TextureImpl(Texture&&)             = delete;
     void operator=(const TextureImpl&) = delete;
     void operator=(TextureImpl&&)      = delete;
-
-private:
-    s32    width_  = 0;              //!< 幅
-    s32    height_ = 0;              //!< 高さ
-    GLuint id_     = 0xfffffffful;   //!< テクスチャID
 };
 
+// プールにはTextureとしてコピーするためデータを追加しないこと
+static_assert(sizeof(TextureImpl) == sizeof(Texture));
+
 //---------------------------------------------------------------------------
-//! TGAファイルを読み込み
+//! TGAファイルを展開
 //---------------------------------------------------------------------------
-bool TextureImpl::loadTGA(const char fileName[])
+bool TextureImpl::decodeTGA(const char fileName[], std::span<const u8> source, TextureLoadStats& stats, ArenaVector<Color>& image, s32& width, s32& height, bool quiet)
 {
-    std::ifstream file(fileName, std::ios::binary);
-    if(!file.is_open()) {
+    PROFILE_FUNCTION();
+
+    f64 time = TIMER_now();
+
+    if(source.size() < sizeof(HeaderTGA)) {
         return false;
     }
 
@@ -320,86 +590,104 @@ bool TextureImpl::loadTGA(const char fileName[])
     // ヘッダーを読み込む
     //-------------------------------------------------------------
     HeaderTGA header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    memcpy(&header, source.data(), sizeof(header));
 
     if(header.bpp_ != 32) {
-        MessageBox(nullptr, fileName, "32bitカラー形式ではありません.現時点ではサポートしていない形式です.", MB_OK);
+        // ワーカースレッドからダイアログを出すと終了時に応答待ちで止まるためデバッグ出力にする
+        if(quiet) {
+            char text[512];
+            sprintf_s(text, "[TEXTURE] 32bitカラー形式ではありません : %s\n", fileName);
+            OutputDebugStringA(text);
+        }
+        else {
+            MessageBox(nullptr, fileName, "32bitカラー形式ではありません.現時点ではサポートしていない形式です.", MB_OK);
+        }
         return false;
     }
 
-    s32 width  = header.width_;
-    s32 height = header.height_;
+    s32 source_width  = header.width_;
+    s32 source_height = header.height_;
+
+    stats.width_  = source_width;
+    stats.height_ = source_height;
 
     //-------------------------------------------------------------
     // 圧縮モード判定
     //-------------------------------------------------------------
+    // 画素データはヘッダーとID(id_バイト)の後から始まる
+    const u8* pixels = source.data() + std::min(sizeof(header) + header.id_, source.size());
+    const u8* end    = source.data() + source.size();
+
     std::unique_ptr<TGAStream> stream;
 
     if(header.type_ & (1 << 3)) {
         // RLE圧縮
-        stream = std::make_unique<TGAStreamRLE>(file);
+        stream = std::make_unique<TGAStreamRLE>(pixels, end);
     }
     else {
         // 非圧縮
-        stream = std::make_unique<TGAStreamRAW>(file);
+        stream = std::make_unique<TGAStreamRAW>(pixels, end);
     }
 
     //-------------------------------------------------------------
     // TGAファイルからイメージを取り出す
     //-------------------------------------------------------------
-    Image image;
-    image.resize(width, height);
+    // 作業用のメモリはスクラッチアリーナから確保 (呼び出し側のスコープを抜けるとまとめて解放)
+    Image decoded(ARENA_getScratchArena());
+    decoded.resize(source_width, source_height);
 
     if(header.attribute_ & (1 << 5)) {
         // 通常
-        for(s32 y = 0; y < height; y++) {
-            for(s32 x = 0; x < width; x++) {
-                image.pixel(x, y) = stream->read();
+        for(s32 y = 0; y < source_height; y++) {
+            for(s32 x = 0; x < source_width; x++) {
+                decoded.pixel(x, y) = stream->read();
             }
         }
     }
     else {
         // 上下反転
-        for(s32 y = height - 1; y >= 0; y--) {
-            for(s32 x = 0; x < width; x++) {
-                image.pixel(x, y) = stream->read();
+        for(s32 y = source_height - 1; y >= 0; y--) {
+            for(s32 x = 0; x < source_width; x++) {
+                decoded.pixel(x, y) = stream->read();
             }
         }
     }
+    recordStage(stats, TextureLoadStage::Decode, time, static_cast<u64>(source_width) * source_height * sizeof(Color));
 
-    //---- OpenGLで画像の転送
     // OpenGLでは2の乗数のサイズではないテクスチャをサポートしていないため
     // リサイズを行う
-    s32 alignedW = nextPowerOf2(width);
-    s32 alignedH = nextPowerOf2(height);
+    s32 alignedW = nextPowerOf2(source_width);
+    s32 alignedH = nextPowerOf2(source_height);
 
-    std::vector<Color> alignedImage(alignedW * alignedH);
+    image.resize(alignedW * alignedH);
 
-    for(s32 y = 0; y < alignedH; y++) {
-        for(s32 x = 0; x < alignedW; x++) {
-            f32 u = (f32)x / (f32)alignedW;
-            f32 v = (f32)y / (f32)alignedH;
+    // 行単位でジョブシステムに分割して並列実行
+    JOB_parallelFor(alignedH, 16, [&](s32 begin, s32 end) {
+        for(s32 y = begin; y < end; y++) {
+            for(s32 x = 0; x < alignedW; x++) {
+                f32 u = (f32)x / (f32)alignedW;
+                f32 v = (f32)y / (f32)alignedH;
 
-            alignedImage[y * alignedW + x] = image.fetch(u, v);
+                image[y * alignedW + x] = decoded.fetch(u, v);
+            }
         }
-    }
-
-    // 画像転送
-    glTexImage2D(GL_TEXTURE_2D,       // テクスチャタイプ
-                 0,                   // ミップマップ段数 (0で無効)
-                 GL_RGBA,             // 透明度あり
-                 alignedW,            // 幅
-                 alignedH,            // 高さ
-                 0,                   // テクスチャボーダーON/OFF
-                 GL_RGBA,             // テクスチャのピクセル形式
-                 GL_UNSIGNED_BYTE,    // ピクセル1要素のサイズ
-                 &alignedImage[0]);   // 画像の場所
+    });
+    recordStage(stats, TextureLoadStage::Resample, time, image.size() * sizeof(Color));
 
+    width  = alignedW;
+    height = alignedH;
     return true;
 }
 
-bool TextureImpl::loadFromFile(const char fileName[])
+//---------------------------------------------------------------------------
+//! GDI+で画像ファイルを展開
+//---------------------------------------------------------------------------
+bool TextureImpl::decodeFromFile(const char fileName[], TextureLoadStats& stats, ArenaVector<Color>& image, s32& width, s32& height)
 {
+    PROFILE_FUNCTION();
+
+    f64 time = TIMER_now();
+
     // 文字コードをワイド文字列に変換
     // 【注意】本来はこの箇所は文字列バッファ長の考慮の他に文字列終端コードを処理するよりセキュアな対応が好ましいです。
     wchar_t path[MAX_PATH];
@@ -429,6 +717,8 @@ bool TextureImpl::loadFromFile(const char fileName[])
 
     //--- 画像ファイルを開く
     //  【対応画像形式】  BMP, JPEG, PNG, GIF, TIFF, WMF, EMF
+    //  内容は呼び出し側で読み込み済み (ハッシュ計算用)。GDI+は開き直すが
+    //  OSのキャッシュから読まれるため展開の時間に含める
     std::unique_ptr<Gdiplus::Bitmap> bitmap(Gdiplus::Bitmap::FromFile(path));
 
     if(!bitmap)
@@ -437,17 +727,20 @@ bool TextureImpl::loadFromFile(const char fileName[])
         return false;
 
     //---- 画像サイズ分の領域確保
-    u32 width  = bitmap->GetWidth();    // 画像の幅
-    u32 height = bitmap->GetHeight();   // 画像の高さ
+    u32 bitmapW = bitmap->GetWidth();    // 画像の幅
+    u32 bitmapH = bitmap->GetHeight();   // 画像の高さ
 
     // サイズを保存しておく
-    width_  = width;
-    height_ = height;
+    width_  = bitmapW;
+    height_ = bitmapH;
+
+    stats.width_  = bitmapW;
+    stats.height_ = bitmapH;
 
     //---- 画像イメージ読み込み
-    std::vector<u8> image(width * height * 4);   // 幅*高さ*RGBA
-    for(u32 y = 0; y < height; y++) {
-        for(u32 x = 0; x < width; x++) {
+    image.resize(bitmapW * bitmapH);   // 幅*高さ*RGBA
+    for(u32 y = 0; y < bitmapH; y++) {
+        for(u32 x = 0; x < bitmapW; x++) {
             Gdiplus::Color srcColor;
             bitmap->GetPixel(x, y, &srcColor);
 
@@ -456,36 +749,38 @@ bool TextureImpl::loadFromFile(const char fileName[])
             u8 b = srcColor.GetB();
             u8 a = srcColor.GetA();
 
-            image[(y * width + x) * 4 + 0] = r;
-            image[(y * width + x) * 4 + 1] = g;
-            image[(y * width + x) * 4 + 2] = b;
-            image[(y * width + x) * 4 + 3] = a;
+            image[y * bitmapW + x] = Color(r, g, b, a);
         }
     }
-
-    //---- OpenGLで画像の転送
-    glTexImage2D(GL_TEXTURE_2D,      // テクスチャタイプ
-                 0,                  // ミップマップ段数 (0で無効)
-                 GL_RGBA,            // 透明度あり
-                 width,              // 幅
-                 height,             // 高さ
-                 0,                  // テクスチャボーダーON/OFF
-                 GL_RGBA,            // テクスチャのピクセル形式
-                 GL_UNSIGNED_BYTE,   // ピクセル1要素のサイズ
-                 image.data());      // 画像の場所
+    recordStage(stats, TextureLoadStage::Decode, time, image.size() * sizeof(Color));
 
     //---- GDI+の解放
+    bitmap.reset();
     Gdiplus::GdiplusShutdown(gdiplusToken);
 
+    width  = bitmapW;
+    height = bitmapH;
     return true;
 }
 
 //---------------------------------------------------------------------------
-//! 読み込み
-//!	@param	[in]	fileName	画像ファイル名
+//! 画像を展開してGPUに転送する形にする
+//---------------------------------------------------------------------------
+bool TextureImpl::decode(const char fileName[], std::span<const u8> source, TextureLoadStats& stats, ArenaVector<Color>& image, s32& width, s32& height, bool quiet)
+{
+    if(hasExtension(fileName, ".tga")) {
+        return decodeTGA(fileName, source, stats, image, width, height, quiet);
+    }
+    return decodeFromFile(fileName, stats, image, width, height);
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャIDを作成して画像をGPUに転送
 //---------------------------------------------------------------------------
-bool TextureImpl::load(const char fileName[])
+void TextureImpl::upload(const Color* image, s32 width, s32 height, TextureLoadStats& stats)
 {
+    f64 time = TIMER_now();
+
     //-------------------------------------------------------------
     // (1) テクスチャIDを作成
     //-------------------------------------------------------------
@@ -524,47 +819,655 @@ bool TextureImpl::load(const char fileName[])
 	}
 #endif
 
-    if(strstr(fileName, ".tga") || strstr(fileName, ".TGA")) {
-        return loadTGA(fileName);
+    glTexImage2D(GL_TEXTURE_2D,      // テクスチャタイプ
+                 0,                  // ミップマップ段数 (0で無効)
+                 GL_RGBA,            // 透明度あり
+                 width,              // 幅
+                 height,             // 高さ
+                 0,                  // テクスチャボーダーON/OFF
+                 GL_RGBA,            // テクスチャのピクセル形式
+                 GL_UNSIGNED_BYTE,   // ピクセル1要素のサイズ
+                 image);             // 画像の場所
+    gpu_memory_size_ = static_cast<u64>(width) * height * sizeof(Color);
+    recordStage(stats, TextureLoadStage::Upload, time, gpu_memory_size_);
+}
+
+//---------------------------------------------------------------------------
+//! 読み込み
+//!	@param	[in]	fileName	画像ファイル名
+//!	@param	[out]	stats		工程ごとの計測結果
+//---------------------------------------------------------------------------
+bool TextureImpl::load(const char fileName[], TextureLoadStats& stats)
+{
+    MEMORY_TAG(MemoryTag::Texture);
+
+    LinearArena& scratch = ARENA_getScratchArena();
+    ArenaScope   scratch_scope(scratch);
+
+    //-------------------------------------------------------------
+    // ファイル全体を読み込む (展開はメモリ上で行う)
+    //-------------------------------------------------------------
+    f64 time = TIMER_now();
+
+    ArenaVector<u8> source{ArenaAllocator<u8>(scratch)};
+    if(!readFile(fileName, source)) {
+        return false;
+    }
+    recordStage(stats, TextureLoadStage::Read, time, source.size());
+
+    //-------------------------------------------------------------
+    // キャッシュを確認 (元ファイルの内容と展開処理の設定が同じなら展開を省略)
+    //-------------------------------------------------------------
+    bool     use_cache = !cache_directory.empty();
+    CacheKey key;
+    if(use_cache) {
+        key = makeCacheKey(fileName, source);
+        recordStage(stats, TextureLoadStage::Hash, time, source.size());
+
+        ArenaVector<u8> cached{ArenaAllocator<u8>(scratch)};
+        if(readCache(key, cached)) {
+            recordStage(stats, TextureLoadStage::Read, time, cached.size());
+
+            if(loadCooked(cached, stats)) {
+                stats.source_ = TextureLoadSource::Cache;
+                return true;
+            }
+        }
+        // キャッシュがない・壊れている場合は展開して作り直す
+    }
+
+    //-------------------------------------------------------------
+    // 展開してGPUに転送
+    //-------------------------------------------------------------
+    ArenaVector<Color> image{ArenaAllocator<Color>(scratch)};
+    s32                width  = 0;
+    s32                height = 0;
+    if(!decode(fileName, source, stats, image, width, height, false)) {
+        return false;
+    }
+
+    upload(image.data(), width, height, stats);
+
+    // ソフトウェア描画用にCPU側にも保持
+    // (キャッシュには描画先に関係なく格納するため、OpenGLでも保存する場合は作成して保存後に解放)
+    bool keep_sampled = keepsSampledTexture();
+    if(keep_sampled || use_cache) {
+        time = TIMER_now();
+        sampled_.build(image.data(), width, height);
+        recordStage(stats, TextureLoadStage::Build, time, sampled_.getMemorySize());
+    }
+
+    //---- 次回のためにキャッシュに保存
+    if(use_cache) {
+        std::vector<u8> data;
+        serialize(image.data(), width, height, stats, data);
+        writeCache(key, data);
+    }
+    if(!keep_sampled) {
+        sampled_.clear();
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 展開済みのデータから読み込み
+//---------------------------------------------------------------------------
+bool TextureImpl::loadCooked(std::span<const u8> data, TextureLoadStats& stats)
+{
+    if(data.size() < sizeof(PackedTexture)) {
+        return false;
+    }
+    PackedTexture header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    u64 image_bytes = static_cast<u64>(header.width_) * header.height_ * sizeof(Color);
+    u64 texel_bytes = static_cast<u64>(header.texel_count_) * sizeof(Color);
+    if(header.width_ <= 0 || header.height_ <= 0 || sizeof(header) + image_bytes + texel_bytes > data.size()) {
+        return false;
+    }
+
+    // Colorはu8×4のため、画像・テクセルはデータ上のままで参照できる
+    const Color* image  = reinterpret_cast<const Color*>(data.data() + sizeof(header));
+    const Color* texels = image + static_cast<size_t>(header.width_) * header.height_;
+
+    // テクセル数が合わなければ転送前に失敗させる (ファイルからの読み込みに切り替えられるように)
+    // OpenGLで描画する場合はCPU側に保持せず、テクセル数の検証だけを行う
+    f64 time = TIMER_now();
+    if(keepsSampledTexture()) {
+        if(!sampled_.assign({texels, header.texel_count_}, header.width_, header.height_)) {
+            return false;
+        }
+    }
+    else if(SampledTexture::getTexelCount(header.width_, header.height_) != header.texel_count_) {
+        return false;
+    }
+    recordStage(stats, TextureLoadStage::Build, time, sampled_.getMemorySize());
+
+    width_        = header.texture_width_;
+    height_       = header.texture_height_;
+    stats.width_  = header.source_width_;
+    stats.height_ = header.source_height_;
+
+    upload(image, header.width_, header.height_, stats);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! アセットパックから読み込み
+//---------------------------------------------------------------------------
+bool TextureImpl::loadPacked(s32 entry, TextureLoadStats& stats)
+{
+    MEMORY_TAG(MemoryTag::Texture);
+    PROFILE_FUNCTION();
+
+    f64 time = TIMER_now();
+
+    // 項目のセクションだけをマップ (画像はページ単位で必要になった時点で読み込まれる)
+    PackView view = PACK_map(entry);
+    if(PACK_getType(entry) != PackType::Texture || view.empty()) {
+        return false;
+    }
+    recordStage(stats, TextureLoadStage::Read, time, view.size());
+
+    if(!loadCooked({view.data(), view.size()}, stats)) {
+        return false;
+    }
+    stats.source_ = TextureLoadSource::Pack;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! パック・キャッシュに格納するデータを作成
+//---------------------------------------------------------------------------
+void TextureImpl::serialize(const Color* image, s32 width, s32 height, const TextureLoadStats& stats, std::vector<u8>& data) const
+{
+    std::span<const Color> texels = sampled_.getTexels();
+
+    PackedTexture header;
+    header.width_          = width;
+    header.height_         = height;
+    header.texture_width_  = width_;
+    header.texture_height_ = height_;
+    header.source_width_   = stats.width_;
+    header.source_height_  = stats.height_;
+    header.texel_count_    = static_cast<u32>(texels.size());
+
+    size_t image_bytes = static_cast<size_t>(width) * height * sizeof(Color);
+    size_t texel_bytes = texels.size_bytes();
+
+    data.resize(sizeof(header) + image_bytes + texel_bytes);
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + sizeof(header), image, image_bytes);
+    memcpy(data.data() + sizeof(header) + image_bytes, texels.data(), texel_bytes);
+}
+
+//---------------------------------------------------------------------------
+//! 展開済みのデータを作成
+//---------------------------------------------------------------------------
+bool TextureImpl::prepare(const char fileName[], TextureLoadStats& stats, std::vector<u8>& data, bool quiet)
+{
+    MEMORY_TAG(MemoryTag::Texture);
+    PROFILE_FUNCTION();
+
+    LinearArena& scratch = ARENA_getScratchArena();
+    ArenaScope   scratch_scope(scratch);
+
+    f64 time = TIMER_now();
+
+    ArenaVector<u8> source{ArenaAllocator<u8>(scratch)};
+    if(!readFile(fileName, source)) {
+        return false;
+    }
+    recordStage(stats, TextureLoadStage::Read, time, source.size());
+
+    //---- キャッシュがあればそのまま使用
+    bool     use_cache = !cache_directory.empty();
+    CacheKey key;
+    if(use_cache) {
+        key = makeCacheKey(fileName, source);
+        recordStage(stats, TextureLoadStage::Hash, time, source.size());
+
+        ArenaVector<u8> cached{ArenaAllocator<u8>(scratch)};
+        if(readCache(key, cached)) {
+            recordStage(stats, TextureLoadStage::Read, time, cached.size());
+
+            data.assign(cached.begin(), cached.end());
+            stats.source_ = TextureLoadSource::Cache;
+            return true;
+        }
+    }
+
+    //---- 展開してミップマップを作成
+    ArenaVector<Color> image{ArenaAllocator<Color>(scratch)};
+    s32                width  = 0;
+    s32                height = 0;
+    if(!decode(fileName, source, stats, image, width, height, quiet)) {
+        return false;
+    }
+
+    time = TIMER_now();
+    if(!sampled_.build(image.data(), width, height)) {
+        return false;
+    }
+    recordStage(stats, TextureLoadStage::Build, time, sampled_.getMemorySize());
+
+    serialize(image.data(), width, height, stats, data);
+    if(use_cache) {
+        writeCache(key, data);
+    }
+    return true;
+}
+
+//===========================================================================
+// テクスチャプール
+//===========================================================================
+namespace
+{
+constexpr u32 HANDLE_INDEX_BITS      = 20;                                     //!< ハンドルのプール番号のビット数
+constexpr u32 HANDLE_INDEX_MASK      = (1u << HANDLE_INDEX_BITS) - 1;          //!< プール番号のマスク
+constexpr u32 HANDLE_GENERATION_MASK = (1u << (32 - HANDLE_INDEX_BITS)) - 1;   //!< 世代のマスク
+
+constexpr u64 RELEASE_DELAY_FRAMES = 2;   //!< GPUリソースを削除するまでのフレーム数 (描画が1フレーム遅れるため)
+
+//! 解放待ちのGPUリソース
+struct PendingRelease
+{
+    GLuint id_;      //!< テクスチャID
+    u64    frame_;   //!< 解放要求したフレーム
+};
+
+std::deque<Texture>           textures;           //!< テクスチャ (プール番号で参照、追加しても既存の要素は移動しない)
+std::vector<u32>              generations;        //!< プール番号ごとの現在の世代 (1～)
+std::vector<u32>              free_indices;       //!< 空いているプール番号
+std::vector<PendingRelease>   pending_releases;   //!< 解放待ちのGPUリソース
+std::vector<std::string>      source_keys;        //!< プール番号ごとの元ファイル (ホットリロードの照合用、makeSourceKey()の形式)
+std::vector<TextureLoadStats> load_stats;         //!< 読み込みの計測結果 (読み込み順)
+u64                           frame_count = 0;    //!< TEXTURE_endFrame()の呼び出し回数
+std::thread::id               pool_thread;        //!< プールを操作するスレッド (最初に登録したスレッド)
+
+//---------------------------------------------------------------------------
+//! プールを操作してよいスレッドかどうか (プールはロックしていないためメインスレッドのみ)
+//---------------------------------------------------------------------------
+bool isPoolThread()
+{
+    return pool_thread == std::thread::id() || pool_thread == std::this_thread::get_id();
+}
+
+//---------------------------------------------------------------------------
+//! 元ファイルの照合用の名前を作成 (絶対パス、英字は小文字、'/'区切り)
+//! 読み込み時の相対パスと変更通知のパスを同じ形にして比較する
+//! マルチバイト文字の2バイト目を変えないようにASCIIの英字だけを変換する
+//---------------------------------------------------------------------------
+std::string makeSourceKey(const std::filesystem::path& path)
+{
+    std::error_code error;
+    std::string     key = std::filesystem::absolute(path, error).lexically_normal().generic_string();
+    for(char& c : key) {
+        if(c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return key;
+}
+
+//---------------------------------------------------------------------------
+//! ハンドルからプール番号を取得
+//! @return プール番号 (無効なハンドルの場合は-1)
+//---------------------------------------------------------------------------
+s32 getIndex(TextureHandle handle)
+{
+    assert(isPoolThread());
+
+    u32 index      = handle.value_ & HANDLE_INDEX_MASK;
+    u32 generation = handle.value_ >> HANDLE_INDEX_BITS;
+
+    if(index >= generations.size() || generations[index] != generation) {
+        return -1;
     }
-    return loadFromFile(fileName);
+    return static_cast<s32>(index);
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャをプールに登録
+//! @param  [in]    texture     テクスチャ
+//! @param  [in]    source_key  元ファイルの照合用の名前
+//---------------------------------------------------------------------------
+TextureHandle addTexture(Texture&& texture, std::string&& source_key)
+{
+    assert(isPoolThread());
+    pool_thread = std::this_thread::get_id();
+
+    u32 index;
+    if(!free_indices.empty()) {
+        index = free_indices.back();
+        free_indices.pop_back();
+        textures[index]    = std::move(texture);
+        source_keys[index] = std::move(source_key);
+    }
+    else {
+        index = static_cast<u32>(textures.size());
+        assert(index <= HANDLE_INDEX_MASK);
+        textures.push_back(std::move(texture));
+        source_keys.push_back(std::move(source_key));
+        generations.push_back(1);
+    }
+    return TextureHandle{(generations[index] << HANDLE_INDEX_BITS) | index};
+}
+
+//---------------------------------------------------------------------------
+//! GPUリソースを削除
+//---------------------------------------------------------------------------
+void deleteTexture(GLuint id)
+{
+    if(id != 0xfffffffful) {
+        glDeleteTextures(1, &id);
+    }
+}
+}   // namespace
+
+//===========================================================================
+// ホットリロード
+//
+// 監視スレッドがReadDirectoryChangesW()で元ファイルの変更を検出し、メインスレッドが
+// 変更が落ち着いたものを読み込み直すよう要求します。展開・ミップマップ作成は監視スレッドで
+// 行い (TextureImpl::prepare())、OpenGLのコンテキストを持つメインスレッドが
+// TEXTURE_endFrame()でGPUに転送してプールの中身を差し替えます。
+// ハンドルはそのままなので呼び出し側の変更は不要です。古いGPUリソースは遅延削除します。
+//===========================================================================
+namespace
+{
+constexpr f64   RELOAD_DELAY      = 0.2;         //!< 最後の変更から読み込み直すまでの時間 (単位:秒、保存途中のファイルを読まないため)
+constexpr DWORD WATCH_BUFFER_SIZE = 16 * 1024;   //!< 変更通知のバッファのバイト数
+
+//! 読み込み直した結果
+struct ReloadResult
+{
+    std::string      key_;                 //!< 元ファイルの照合用の名前
+    std::vector<u8>  data_;                //!< PackedTextureの形式のデータ
+    TextureLoadStats stats_;               //!< 工程ごとの計測結果
+    bool             succeeded_ = false;   //!< 展開に成功したかどうか
+};
+
+//! 変更されたファイル (メインスレッドのみ)
+struct PendingChange
+{
+    std::string key_;    //!< 元ファイルの照合用の名前
+    f64         time_;   //!< 最後に変更を検出した時刻
+};
+
+std::thread           watch_thread;                             //!< 監視スレッド
+std::atomic<bool>     watch_quit      = false;                  //!< 監視スレッドの終了要求
+HANDLE                watch_directory = INVALID_HANDLE_VALUE;   //!< 監視するディレクトリ
+HANDLE                watch_events[2] = {};                     //!< [0] 変更通知 [1] 読み込み直す要求・終了要求
+std::filesystem::path watch_root;                               //!< 監視するディレクトリ (絶対パス)
+
+std::mutex                 reload_mutex;      //!< 以下の3つの受け渡し用
+std::vector<std::string>   changed_keys;      //!< 変更されたファイル (監視スレッド → メインスレッド)
+std::vector<std::string>   reload_requests;   //!< 読み込み直すファイル (メインスレッド → 監視スレッド)
+std::vector<ReloadResult>  reload_results;    //!< 読み込み直した結果 (監視スレッド → メインスレッド)
+std::vector<PendingChange> pending_changes;   //!< 変更が落ち着くのを待っているファイル (メインスレッドのみ)
+
+//---------------------------------------------------------------------------
+//! 変更通知を要求
+//---------------------------------------------------------------------------
+bool requestChanges(void* buffer, OVERLAPPED& overlapped)
+{
+    return ReadDirectoryChangesW(watch_directory,
+                                 buffer,
+                                 WATCH_BUFFER_SIZE,
+                                 TRUE,   // サブディレクトリも監視
+                                 FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                 nullptr,
+                                 &overlapped,
+                                 nullptr) != FALSE;
 }
 
 //---------------------------------------------------------------------------
-//! OpenGLのテクスチャIDを取得
+//! 変更通知を変更されたファイルのリストに追加
+//! 保存時に一時ファイルから名前を変えるエディタもあるため、追加と名前の変更先も対象にする
 //---------------------------------------------------------------------------
-GLuint TextureImpl::getTextureID() const
+void collectChanges(const u8* buffer)
 {
-    return id_;
+    std::lock_guard lock(reload_mutex);
+
+    for(const u8* p = buffer;;) {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+        if(info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+            std::wstring_view name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            changed_keys.push_back(makeSourceKey(watch_root / name));
+        }
+        if(info->NextEntryOffset == 0) {
+            break;
+        }
+        p += info->NextEntryOffset;
+    }
 }
 
 //---------------------------------------------------------------------------
-//! 幅を取得
+//! 監視スレッド
+//! 変更通知を受け取り、要求されたファイルを展開する (OpenGLは使用しない)
 //---------------------------------------------------------------------------
-s32 TextureImpl::getWidth() const
+void watchThread()
 {
-    return width_;
+    PROFILE_setThreadName("Texture Watch");
+
+    alignas(DWORD) static u8 buffer[WATCH_BUFFER_SIZE];   // 監視スレッドは1つだけ
+
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = watch_events[0];
+    bool watching     = requestChanges(buffer, overlapped);
+
+    while(!watch_quit) {
+        DWORD wait = WaitForMultipleObjects(2, watch_events, FALSE, INFINITE);
+
+        //---- 変更されたファイルをメインスレッドに渡して次の変更通知を要求
+        //     (サイズ0はバッファが溢れた場合。取りこぼした変更は次に保存した時に検出する)
+        if(wait == WAIT_OBJECT_0 && watching) {
+            DWORD size = 0;
+            if(GetOverlappedResult(watch_directory, &overlapped, &size, FALSE) && size > 0) {
+                collectChanges(buffer);
+            }
+            ResetEvent(watch_events[0]);
+            watching = requestChanges(buffer, overlapped);
+        }
+
+        //---- 要求されたファイルを展開
+        std::vector<std::string> requests;
+        {
+            std::lock_guard lock(reload_mutex);
+            requests.swap(reload_requests);
+        }
+        for(auto& key : requests) {
+            if(watch_quit) {
+                break;
+            }
+            ReloadResult result;
+            result.stats_.path_ = key;
+            f64 start           = TIMER_now();
+
+            TextureImpl texture;
+            result.succeeded_       = texture.prepare(key.c_str(), result.stats_, result.data_, true);
+            result.stats_.total_ms_ = (TIMER_now() - start) * 1000.0;
+            result.key_             = std::move(key);
+
+            std::lock_guard lock(reload_mutex);
+            reload_results.push_back(std::move(result));
+        }
+    }
+
+    // 要求中の変更通知を取り消して完了を待つ (バッファを解放する前に)
+    if(watching) {
+        DWORD size = 0;
+        CancelIoEx(watch_directory, &overlapped);
+        GetOverlappedResult(watch_directory, &overlapped, &size, TRUE);
+    }
 }
 
 //---------------------------------------------------------------------------
-//! 高さを取得
+//! 変更されたファイルを読み込み直してプールの中身を差し替え (メインスレッド)
 //---------------------------------------------------------------------------
-s32 TextureImpl::getHeight() const
+void processReload()
 {
-    return height_;
+    if(!watch_thread.joinable()) {
+        return;
+    }
+
+    std::vector<std::string>  changed;
+    std::vector<ReloadResult> results;
+    {
+        std::lock_guard lock(reload_mutex);
+        changed.swap(changed_keys);
+        results.swap(reload_results);
+    }
+
+    //-------------------------------------------------------------
+    // 変更を記録 (保存中は通知が続くため最後の通知の時刻を残す)
+    //-------------------------------------------------------------
+    f64 now = TIMER_now();
+    for(auto& key : changed) {
+        auto it = std::find_if(pending_changes.begin(), pending_changes.end(), [&](const PendingChange& pending) {
+            return pending.key_ == key;
+        });
+        if(it != pending_changes.end()) {
+            it->time_ = now;
+        }
+        else {
+            pending_changes.push_back({std::move(key), now});
+        }
+    }
+
+    //-------------------------------------------------------------
+    // 変更が落ち着いたファイルのうち、読み込み済みのテクスチャの元ファイルを読み込み直す
+    //-------------------------------------------------------------
+    bool requested = false;
+    for(auto it = pending_changes.begin(); it != pending_changes.end();) {
+        if(now - it->time_ < RELOAD_DELAY) {
+            ++it;
+            continue;
+        }
+        if(std::find(source_keys.begin(), source_keys.end(), it->key_) != source_keys.end()) {
+            std::lock_guard lock(reload_mutex);
+            reload_requests.push_back(std::move(it->key_));
+            requested = true;
+        }
+        it = pending_changes.erase(it);
+    }
+    if(requested) {
+        SetEvent(watch_events[1]);
+    }
+
+    //-------------------------------------------------------------
+    // 展開したデータをGPUに転送して差し替え (同じファイルを使う全てのテクスチャ)
+    // 全ての差し替え先を先に作成し、一つでも失敗した場合は全て元のテクスチャを使い続ける
+    //-------------------------------------------------------------
+    char                 text[512];
+    std::vector<size_t>  indices;        // 差し替えるプール番号
+    std::vector<Texture> replacements;   // 差し替え先のテクスチャ
+    for(auto& result : results) {
+        bool succeeded = result.succeeded_;
+        indices.clear();
+        replacements.clear();
+        for(size_t i = 0; succeeded && i < source_keys.size(); ++i) {
+            if(source_keys[i] != result.key_) {
+                continue;
+            }
+            TextureImpl texture;
+            succeeded = texture.loadCooked(result.data_, result.stats_);
+            indices.push_back(i);
+            replacements.push_back(std::move(texture));
+        }
+
+        if(succeeded) {
+            for(size_t n = 0; n < indices.size(); ++n) {
+                // 描画中のフレームが参照している可能性があるため古いGPUリソースは遅延削除
+                pending_releases.push_back({textures[indices[n]].getTextureID(), frame_count});
+                textures[indices[n]] = std::move(replacements[n]);
+            }
+        }
+        else {
+            // 作成済みの差し替え先はまだ描画に使用していないため即座に削除
+            for(auto& texture : replacements) {
+                deleteTexture(texture.getTextureID());
+            }
+        }
+
+        if(succeeded) {
+            sprintf_s(text, "[TEXTURE] reloaded %s (%.2f ms)\n", result.key_.c_str(), result.stats_.total_ms_);
+        }
+        else {
+            sprintf_s(text, "[TEXTURE] reload failed : %s\n", result.key_.c_str());
+        }
+        OutputDebugStringA(text);
+    }
 }
+}   // namespace
 
 //---------------------------------------------------------------------------
 //! テクスチャを読み込み
 //---------------------------------------------------------------------------
-std::shared_ptr<Texture> LoadTexture(const char fileName[])
+TextureHandle LoadTexture(const char fileName[])
 {
-    auto p = std::make_shared<TextureImpl>();
+    PROFILE_FUNCTION();
+
+    TextureLoadStats stats;
+    stats.path_ = fileName;
+    f64 start   = TIMER_now();
+
+    TextureImpl texture;
+
+    // パックにあれば展開済みのデータを使用 (ファイルのオープン・展開・ミップマップ作成を省略)
+    // 元ファイルが更新されていればパックは古いためファイルから読み込む
+    s32 entry = PACK_find(fileName);
+    if(entry >= 0 && PACK_isStale(entry)) {
+        char text[256];
+        sprintf_s(text, "[PACK] stale, loading from file : %s\n", fileName);
+        OutputDebugStringA(text);
+        entry = -1;
+    }
+    bool loaded = (entry >= 0) ? texture.loadPacked(entry, stats) : texture.load(fileName, stats);
+    if(!loaded) {
+        deleteTexture(texture.getTextureID());
+        return TextureHandle{};
+    }
+    stats.total_ms_ = (TIMER_now() - start) * 1000.0;
+    load_stats.push_back(std::move(stats));
+
+    return addTexture(std::move(texture), makeSourceKey(fileName));
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャを解放
+//---------------------------------------------------------------------------
+void ReleaseTexture(TextureHandle& handle)
+{
+    s32 index = getIndex(handle);
+    handle    = TextureHandle{};
+
+    if(index < 0) {
+        return;
+    }
 
-    if(!p->load(fileName)) {
-        p.reset();
+    // 世代を進めて古いハンドルを無効化 (0は無効なハンドルになるため1に戻す)
+    u32& generation = generations[index];
+    generation      = (generation + 1) & HANDLE_GENERATION_MASK;
+    if(generation == 0) {
+        generation = 1;
     }
-    return p;
+
+    // 描画中のフレームが参照している可能性があるためGPUリソースは遅延削除
+    pending_releases.push_back({textures[index].getTextureID(), frame_count});
+    textures[index] = Texture();
+    source_keys[index].clear();
+    free_indices.push_back(index);
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャを取得
+//---------------------------------------------------------------------------
+const Texture* GetTexture(TextureHandle handle)
+{
+    s32 index = getIndex(handle);
+    return (index >= 0) ? &textures[index] : nullptr;
 }
 
 //---------------------------------------------------------------------------
@@ -572,6 +1475,8 @@ std::shared_ptr<Texture> LoadTexture(const char fileName[])
 //---------------------------------------------------------------------------
 void SetTexture(const Texture* texture)
 {
+    PROFILE_FUNCTION();
+
     if(texture) {
         //---- テクスチャがある場合はテクスチャマッピングを有効にして設定
         glEnable(GL_TEXTURE_2D);
@@ -586,7 +1491,259 @@ void SetTexture(const Texture* texture)
 //---------------------------------------------------------------------------
 //!	テクスチャを設定
 //---------------------------------------------------------------------------
-void SetTexture(std::shared_ptr<Texture>& texture)
+void SetTexture(TextureHandle handle)
+{
+    SetTexture(GetTexture(handle));
+}
+
+//---------------------------------------------------------------------------
+//! テクスチャのメモリ使用量を取得
+//---------------------------------------------------------------------------
+TextureMemoryStats TEXTURE_getMemoryStats()
+{
+    TextureMemoryStats stats;
+    for(const Texture& texture : textures) {
+        if(texture.getTextureID() == 0xfffffffful) {
+            continue;   // 空き番号
+        }
+        stats.texture_count_++;
+        stats.gpu_bytes_ += texture.getGpuMemorySize();
+        if(const SampledTexture* sampled = texture.getSampledTexture()) {
+            stats.cpu_bytes_ += sampled->getMemorySize();
+        }
+    }
+    return stats;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void TEXTURE_endFrame()
+{
+    PROFILE_FUNCTION();
+
+    frame_count++;
+
+    // 変更された元ファイルを読み込み直して差し替え (古いGPUリソースは解放待ちに追加)
+    processReload();
+
+    // 解放要求から一定フレーム経過したものを削除 (要求順に並んでいる)
+    auto it = pending_releases.begin();
+    for(; it != pending_releases.end(); ++it) {
+        if(frame_count - it->frame_ < RELEASE_DELAY_FRAMES) {
+            break;
+        }
+        deleteTexture(it->id_);
+    }
+    pending_releases.erase(pending_releases.begin(), it);
+}
+
+//---------------------------------------------------------------------------
+//! 全テクスチャを解放
+//---------------------------------------------------------------------------
+void TEXTURE_cleanup()
+{
+    TEXTURE_endWatch();
+
+    for(auto& pending : pending_releases) {
+        deleteTexture(pending.id_);
+    }
+    pending_releases.clear();
+
+    for(auto& texture : textures) {
+        deleteTexture(texture.getTextureID());
+    }
+    textures.clear();
+    source_keys.clear();
+    generations.clear();
+    free_indices.clear();
+    load_stats.clear();
+    pool_thread = std::thread::id();
+}
+
+//---------------------------------------------------------------------------
+//! 元ファイルの監視を開始
+//---------------------------------------------------------------------------
+bool TEXTURE_beginWatch(const char* directory)
+{
+    TEXTURE_endWatch();
+
+    std::error_code error;
+    watch_root = std::filesystem::absolute(directory, error);
+
+    watch_directory = CreateFileA(directory,
+                                  FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,   // 監視中もファイルの保存・削除を妨げない
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,   // ディレクトリを開く・非同期で通知を受け取る
+                                  nullptr);
+    watch_events[0] = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    watch_events[1] = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    if(error || watch_directory == INVALID_HANDLE_VALUE || watch_events[0] == nullptr || watch_events[1] == nullptr) {
+        TEXTURE_endWatch();
+        return false;
+    }
+
+    watch_quit   = false;
+    watch_thread = std::thread(watchThread);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! 元ファイルの監視を終了
+//---------------------------------------------------------------------------
+void TEXTURE_endWatch()
+{
+    if(watch_thread.joinable()) {
+        watch_quit = true;
+        SetEvent(watch_events[1]);
+        watch_thread.join();
+    }
+
+    if(watch_directory != INVALID_HANDLE_VALUE) {
+        CloseHandle(watch_directory);
+        watch_directory = INVALID_HANDLE_VALUE;
+    }
+    for(HANDLE& event : watch_events) {
+        if(event) {
+            CloseHandle(event);
+            event = nullptr;
+        }
+    }
+    changed_keys.clear();
+    reload_requests.clear();
+    reload_results.clear();
+    pending_changes.clear();
+}
+
+//---------------------------------------------------------------------------
+//! 展開済みのテクスチャのキャッシュを設定
+//---------------------------------------------------------------------------
+void TEXTURE_setCacheDirectory(const char* directory)
+{
+    cache_directory = directory ? directory : "";
+}
+
+//---------------------------------------------------------------------------
+//! アセットパックに格納するテクスチャのデータを作成
+//---------------------------------------------------------------------------
+bool TEXTURE_cook(const char fileName[], std::vector<u8>& data)
+{
+    TextureImpl      texture;
+    TextureLoadStats stats;
+    return texture.prepare(fileName, stats, data);
+}
+
+//---------------------------------------------------------------------------
+//! 工程名を取得
+//---------------------------------------------------------------------------
+const char* TEXTURE_getLoadStageName(TextureLoadStage stage)
+{
+    constexpr const char* names[TextureLoadStats::STAGE_COUNT]{"read", "hash", "decode", "resample", "upload", "build"};
+    return names[static_cast<s32>(stage)];
+}
+
+//---------------------------------------------------------------------------
+//! 読み込み元の名前を取得
+//---------------------------------------------------------------------------
+const char* TEXTURE_getLoadSourceName(TextureLoadSource source)
+{
+    constexpr const char* names[static_cast<s32>(TextureLoadSource::Count)]{"file", "pack", "cache"};
+    return names[static_cast<s32>(source)];
+}
+
+//---------------------------------------------------------------------------
+//! 読み込んだテクスチャごとの計測結果を取得
+//---------------------------------------------------------------------------
+std::span<const TextureLoadStats> TEXTURE_getLoadStats()
 {
-    SetTexture(texture.get());
+    return load_stats;
+}
+
+//---------------------------------------------------------------------------
+//! 工程ごとの合計・転送速度と時間のかかったテクスチャをテキストで出力
+//---------------------------------------------------------------------------
+void TEXTURE_printLoadStats(FILE* file, s32 slowest_count)
+{
+    constexpr s32 STAGE_COUNT  = TextureLoadStats::STAGE_COUNT;
+    constexpr s32 SOURCE_COUNT = static_cast<s32>(TextureLoadSource::Count);
+
+    //---- 工程ごとの合計
+    f64 stage_ms[STAGE_COUNT]      = {};
+    u64 stage_bytes[STAGE_COUNT]   = {};
+    s32 source_count[SOURCE_COUNT] = {};
+    f64 total_ms                   = 0.0;
+    for(const TextureLoadStats& stats : load_stats) {
+        for(s32 i = 0; i < STAGE_COUNT; ++i) {
+            stage_ms[i] += stats.ms_[i];
+            stage_bytes[i] += stats.bytes_[i];
+        }
+        total_ms += stats.total_ms_;
+        source_count[static_cast<s32>(stats.source_)]++;
+    }
+
+    fprintf(file,
+            "texture load: %zu textures  %.2f ms  (file %d, pack %d, cache %d)\n",
+            load_stats.size(),
+            total_ms,
+            source_count[static_cast<s32>(TextureLoadSource::File)],
+            source_count[static_cast<s32>(TextureLoadSource::Pack)],
+            source_count[static_cast<s32>(TextureLoadSource::Cache)]);
+    fprintf(file, "  %-10s %10s %10s %10s %7s\n", "stage", "ms", "MB", "MB/s", "share");
+    for(s32 i = 0; i < STAGE_COUNT; ++i) {
+        f64 mb = stage_bytes[i] / (1024.0 * 1024.0);
+        fprintf(file,
+                "  %-10s %10.2f %10.2f %10.1f %6.1f%%\n",
+                TEXTURE_getLoadStageName(static_cast<TextureLoadStage>(i)),
+                stage_ms[i],
+                mb,
+                (stage_ms[i] > 0.0) ? mb / (stage_ms[i] / 1000.0) : 0.0,
+                (total_ms > 0.0) ? stage_ms[i] / total_ms * 100.0 : 0.0);
+    }
+
+    //---- 時間のかかったテクスチャ
+    std::vector<const TextureLoadStats*> sorted;
+    sorted.reserve(load_stats.size());
+    for(const TextureLoadStats& stats : load_stats) {
+        sorted.push_back(&stats);
+    }
+    s32 count = std::clamp(slowest_count, 0, static_cast<s32>(sorted.size()));
+    std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(), [](const TextureLoadStats* a, const TextureLoadStats* b) {
+        return a->total_ms_ > b->total_ms_;
+    });
+
+    if(count > 0) {
+        fprintf(file, "slowest:\n");
+    }
+    for(s32 i = 0; i < count; ++i) {
+        const TextureLoadStats& stats = *sorted[i];
+        fprintf(file,
+                "  %8.2f ms  %5dx%-5d %-5s %s\n",
+                stats.total_ms_,
+                stats.width_,
+                stats.height_,
+                TEXTURE_getLoadSourceName(stats.source_),
+                stats.path_.c_str());
+        fprintf(file, "             ");
+        for(s32 stage = 0; stage < STAGE_COUNT; ++stage) {
+            fprintf(file, " %s %.2f", TEXTURE_getLoadStageName(static_cast<TextureLoadStage>(stage)), stats.ms_[stage]);
+        }
+        fprintf(file, "\n");
+    }
+}
+
+//---------------------------------------------------------------------------
+//! TEXTURE_printLoadStats()の内容をファイルに保存
+//---------------------------------------------------------------------------
+bool TEXTURE_dumpLoadStats(const char* path)
+{
+    FILE* file = nullptr;
+    fopen_s(&file, path, "w");
+    if(file == nullptr) {
+        return false;
+    }
+    TEXTURE_printLoadStats(file);
+    fclose(file);
+    return true;
 }
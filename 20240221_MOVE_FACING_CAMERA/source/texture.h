@@ -1,6 +1,10 @@
 ﻿//===========================================================================
 //!	@file	texture.h
 //!	@brief	テクスチャ
+//!
+//!	テクスチャはプールで一括管理し、ハンドル(番号+世代)で参照します。
+//!	解放済みのハンドルは世代が一致しなくなるため安全に無効判定できます。
+//!	GPUリソースの削除は描画中のフレームが参照し終わるまで遅延します。
 //===========================================================================
 #pragma once
 
@@ -14,23 +18,175 @@ public:
     Texture() = default;
 
     //! OpenGLのテクスチャIDを取得
-    virtual GLuint getTextureID() const = 0;
+    GLuint getTextureID() const { return id_; }
 
     //! 幅を取得
-    virtual s32 getWidth() const = 0;
+    s32 getWidth() const { return width_; }
 
     //! 高さを取得
-    virtual s32 getHeight() const = 0;
+    s32 getHeight() const { return height_; }
+
+    //! GPUに転送した画像のメモリサイズを取得 (単位:byte)
+    u64 getGpuMemorySize() const { return gpu_memory_size_; }
+
+    //! ソフトウェア描画用のテクスチャを取得 (GPUに転送した画像と同じ内容、OpenGLで描画する場合はnullptr)
+    const SampledTexture* getSampledTexture() const { return sampled_.empty() ? nullptr : &sampled_; }
+
+protected:
+    s32    width_  = 0;              //!< 幅
+    s32    height_ = 0;              //!< 高さ
+    GLuint id_     = 0xfffffffful;   //!< テクスチャID
+
+    u64 gpu_memory_size_ = 0;   //!< GPUに転送した画像のメモリサイズ (2の乗数への拡大後)
+
+    SampledTexture sampled_;   //!< ソフトウェア描画用 (ミップマップ・タイル配置)
+};
+
+//===========================================================================
+//! テクスチャハンドル
+//!
+//! 下位20bitがプール番号、上位12bitが世代。0は無効なハンドル。
+//===========================================================================
+struct TextureHandle
+{
+    u32 value_ = 0;   //!< ハンドル値
+
+    //! 有効なハンドルかどうか (解放済みかどうかはGetTexture()で判定)
+    bool isValid() const { return value_ != 0; }
+
+    explicit operator bool() const { return isValid(); }
+
+    bool operator==(const TextureHandle&) const = default;
 };
 
-//! テクスチャを読み込み
+//! テクスチャを読み込み (アセットパックにあればパックの展開済みのデータを使用)
 //! @param  [in]    fileName    ファイル名
-std::shared_ptr<Texture> LoadTexture(const char fileName[]);
+//! @return テクスチャハンドル (失敗時は無効なハンドル)
+TextureHandle LoadTexture(const char fileName[]);
+
+//! テクスチャを解放 (GPUリソースの削除は数フレーム後)
+//!	@param	[inout]	handle	テクスチャハンドル (無効なハンドルに書き換えます)
+void ReleaseTexture(TextureHandle& handle);
+
+//! テクスチャを取得
+//! ポインタはReleaseTexture()まで有効です (他のテクスチャを読み込んでも移動しません)。
+//! ホットリロードではTEXTURE_endFrame()で同じアドレスのまま中身が差し替わります。
+//!	@param	[in]	handle	テクスチャハンドル
+//! @return テクスチャ (解放済みまたは無効なハンドルの場合はnullptr)
+//! @attention テクスチャプールはロックしていないため、LoadTexture()・ReleaseTexture()・GetTexture()は
+//!            メインスレッドから呼び出してください。
+const Texture* GetTexture(TextureHandle handle);
 
 //! テクスチャを設定
 //!	@param	[in]	texture	テクスチャのポインタ(nullptr指定でOFF)
 void SetTexture(const Texture* texture);
 
 //!	テクスチャを設定
-//!	@param	[in]	texture	テクスチャのポインタ
-void SetTexture(std::shared_ptr<Texture>& texture);
+//!	@param	[in]	handle	テクスチャハンドル (無効なハンドルでOFF)
+void SetTexture(TextureHandle handle);
+
+//! テクスチャのメモリ使用量
+struct TextureMemoryStats
+{
+    s32 texture_count_ = 0;   //!< 読み込み済みのテクスチャ数
+    u64 gpu_bytes_     = 0;   //!< GPUに転送した画像の合計 (単位:byte)
+    u64 cpu_bytes_     = 0;   //!< ソフトウェア描画用の画像の合計 (単位:byte)
+};
+
+//! テクスチャのメモリ使用量を取得 (ミップマップを作らないためGPU側は1段分)
+TextureMemoryStats TEXTURE_getMemoryStats();
+
+//! フレーム終了 (解放待ちのGPUリソースを削除・監視中なら変更されたテクスチャを差し替え)
+//! @attention 画面更新後にメインスレッドから呼び出してください。
+void TEXTURE_endFrame();
+
+//! 全テクスチャを解放 (OpenGL解放前に呼び出してください)
+void TEXTURE_cleanup();
+
+//! 元ファイルの監視を開始 (ホットリロード)
+//! 読み込み済みのテクスチャの元ファイルが変更されると、監視スレッドで展開し直し、
+//! TEXTURE_endFrame()でGPUに転送して差し替えます。ハンドルはそのまま使えます。
+//! 読み込みに失敗した場合は元のテクスチャを使い続けます。
+//! @param  [in]    directory   監視するディレクトリ (サブディレクトリも含む)
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(ディレクトリを開けない)
+bool TEXTURE_beginWatch(const char* directory);
+
+//! 元ファイルの監視を終了 (TEXTURE_cleanup()からも呼び出されます)
+void TEXTURE_endWatch();
+
+//! 展開済みのテクスチャのキャッシュを設定
+//! 元ファイルの内容と展開処理の設定 (拡大・ミップマップ・テクセル形式) のハッシュ値をキーに、
+//! GPUに転送する画像とミップマップをファイルに保存し、次回から展開を省略します。
+//! 元ファイルを変更するとキーが変わるため、古いキャッシュは使われません。
+//! @param  [in]    directory   キャッシュのディレクトリ (nullptrまたは空文字列で無効)
+void TEXTURE_setCacheDirectory(const char* directory);
+
+//! アセットパックに格納するデータを作成 (展開・2の乗数への拡大・ミップマップ作成まで行い、OpenGLは使用しない)
+//! @param  [in]    fileName    画像ファイル名
+//! @param  [out]   data        パックに格納するデータ
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool TEXTURE_cook(const char fileName[], std::vector<u8>& data);
+
+//===========================================================================
+//! @name 読み込みの工程別の計測
+//===========================================================================
+//!@{
+
+//! 読み込みの工程
+enum class TextureLoadStage : u8
+{
+    Read,       //!< ファイル読み込み (キャッシュはキャッシュファイルも含む、パックはセクションのマップ)
+    Hash,       //!< 元ファイルの内容のハッシュ計算 (キャッシュのキー)
+    Decode,     //!< 展開 (RLE・非圧縮の画素を画像に書き込む、GDI+は画像ファイルを開くところから)
+    Resample,   //!< 2の乗数のサイズへの拡大
+    Upload,     //!< GPUへの転送 (glTexImage2D)
+    Build,      //!< ソフトウェア描画用のミップマップ作成
+    Count,
+};
+
+//! 読み込み元
+enum class TextureLoadSource : u8
+{
+    File,    //!< 画像ファイルを展開
+    Pack,    //!< アセットパックの展開済みのデータ
+    Cache,   //!< キャッシュの展開済みのデータ
+    Count,
+};
+
+//! 1枚分の読み込みの計測結果
+struct TextureLoadStats
+{
+    static constexpr s32 STAGE_COUNT = static_cast<s32>(TextureLoadStage::Count);
+
+    std::string       path_;                                       //!< ファイル名
+    TextureLoadSource source_             = TextureLoadSource::File;   //!< 読み込み元
+    s32               width_              = 0;                         //!< 幅
+    s32               height_             = 0;                         //!< 高さ
+    f64               ms_[STAGE_COUNT]    = {};                        //!< 工程ごとの時間 (単位:ミリ秒、行わなかった工程は0)
+    u64               bytes_[STAGE_COUNT] = {};                        //!< 工程ごとの処理したバイト数 (読み込みはファイルサイズ)
+    f64               total_ms_           = 0.0;                       //!< LoadTexture()全体の時間 (単位:ミリ秒)
+};
+
+//! 工程名を取得
+const char* TEXTURE_getLoadStageName(TextureLoadStage stage);
+
+//! 読み込み元の名前を取得
+const char* TEXTURE_getLoadSourceName(TextureLoadSource source);
+
+//! 読み込んだテクスチャごとの計測結果を取得 (読み込み順、TEXTURE_cleanup()で消去)
+std::span<const TextureLoadStats> TEXTURE_getLoadStats();
+
+//! 工程ごとの合計・転送速度と時間のかかったテクスチャをテキストで出力
+//! @param  [in]    file            出力先
+//! @param  [in]    slowest_count   個別に出力するテクスチャの数 (時間のかかった順)
+void TEXTURE_printLoadStats(FILE* file, s32 slowest_count = 10);
+
+//! TEXTURE_printLoadStats()の内容をファイルに保存
+//! @param  [in]    path    ファイル名
+//!	@retval	true	正常終了	(成功)
+//!	@retval	false	エラー終了	(失敗)
+bool TEXTURE_dumpLoadStats(const char* path);
+
+//!@}
@@ -0,0 +1,119 @@
+﻿//===========================================================================
+//!	@file	timer.cpp
+//!	@brief	フレームタイマー (固定タイムステップ・フレームレート制御)
+//===========================================================================
+#pragma comment(lib, "winmm.lib")   // timeBeginPeriod()用ライブラリをリンク
+
+namespace
+{
+constexpr f64 MAX_FRAME_DELTA_TIME = 0.25;   //!< 1フレームで受け付ける最大経過時間 (デバッガ停止などの対策)
+constexpr s32 MAX_STEP_COUNT       = 8;      //!< 1フレームで実行する最大更新回数
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 高精度タイマーの現在値を取得
+//---------------------------------------------------------------------------
+f64 TIMER_now()
+{
+    static const f64 frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return static_cast<f64>(f.QuadPart);
+    }();
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<f64>(counter.QuadPart) / frequency;
+}
+
+//---------------------------------------------------------------------------
+//! コンストラクタ
+//---------------------------------------------------------------------------
+FrameTimer::FrameTimer()
+{
+    // Sleep()の分解能を1msに上げる (フレームレート制限の精度向上)
+    timeBeginPeriod(1);
+
+    reset();
+}
+
+//---------------------------------------------------------------------------
+//! デストラクタ
+//---------------------------------------------------------------------------
+FrameTimer::~FrameTimer()
+{
+    timeEndPeriod(1);
+}
+
+//---------------------------------------------------------------------------
+//! 計測をリセット
+//---------------------------------------------------------------------------
+void FrameTimer::reset()
+{
+    accumulator_      = 0.0;
+    frame_delta_time_ = 0.0f;
+    step_count_       = 0;
+    last_time_        = TIMER_now();
+    frame_start_      = last_time_;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム開始
+//---------------------------------------------------------------------------
+void FrameTimer::beginFrame()
+{
+    frame_start_ = TIMER_now();
+
+    f64 delta_time = std::min(frame_start_ - last_time_, MAX_FRAME_DELTA_TIME);
+    last_time_     = frame_start_;
+
+    frame_delta_time_ = static_cast<f32>(delta_time);
+    accumulator_ += delta_time;
+    step_count_ = 0;
+}
+
+//---------------------------------------------------------------------------
+//! 固定タイムステップを1回分消費
+//---------------------------------------------------------------------------
+bool FrameTimer::step()
+{
+    if(accumulator_ < fixed_delta_time_) {
+        return false;
+    }
+
+    // 処理落ちで更新が追いつかない場合は時間を切り捨てる
+    if(step_count_ >= MAX_STEP_COUNT) {
+        accumulator_ = std::fmod(accumulator_, static_cast<f64>(fixed_delta_time_));
+        return false;
+    }
+
+    accumulator_ -= fixed_delta_time_;
+    step_count_++;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//! フレーム終了
+//---------------------------------------------------------------------------
+void FrameTimer::endFrame()
+{
+    if(frame_limit_ <= 0) {
+        return;
+    }
+
+    f64 target_time = frame_start_ + 1.0 / static_cast<f64>(frame_limit_);
+
+    // 大部分はSleep()で待機してCPUを解放し、残り僅かな時間だけ空回りで合わせる
+    for(;;) {
+        f64 remain = target_time - TIMER_now();
+        if(remain <= 0.0) {
+            break;
+        }
+        if(remain > 0.002) {
+            Sleep(static_cast<DWORD>((remain - 0.002) * 1000.0));
+        }
+        else {
+            Sleep(0);
+        }
+    }
+}
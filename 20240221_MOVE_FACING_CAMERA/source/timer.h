@@ -0,0 +1,91 @@
+﻿//===========================================================================
+//!	@file	timer.h
+//!	@brief	フレームタイマー (固定タイムステップ・フレームレート制御)
+//===========================================================================
+#pragma once
+
+//! 高精度タイマーの現在値を取得
+//! @return 経過時間 (単位:秒)
+f64 TIMER_now();
+
+//===========================================================================
+//! フレームタイマー
+//!
+//! 経過時間をアキュムレーターに蓄積し、固定タイムステップ単位で
+//! シミュレーション更新を消費します。余った時間は描画時の補間係数になります。
+//!
+//! @code
+//!     timer.beginFrame();
+//!     while(timer.step()) {
+//!         update(timer.getFixedDeltaTime());
+//!     }
+//!     render(timer.getAlpha());
+//!     timer.endFrame();
+//! @endcode
+//===========================================================================
+class FrameTimer
+{
+public:
+    //! コンストラクタ
+    FrameTimer();
+
+    //! デストラクタ
+    ~FrameTimer();
+
+    //! 計測をリセット
+    void reset();
+
+    //! フレーム開始 (前回からの経過時間をアキュムレーターに加算)
+    void beginFrame();
+
+    //! 固定タイムステップを1回分消費
+    //! @retval true    更新処理を1回実行する
+    //! @retval false   今フレームの更新は終了
+    bool step();
+
+    //! フレーム終了 (フレームレート制限が有効な場合は待機)
+    void endFrame();
+
+    //----------------------------------------------------------
+    //! @name 設定
+    //----------------------------------------------------------
+    //!@{
+
+    //! 固定タイムステップを設定
+    //! @param  [in]    delta_time  1回の更新時間 (単位:秒)
+    void setFixedDeltaTime(f32 delta_time) { fixed_delta_time_ = delta_time; }
+
+    //! フレームレート上限を設定
+    //! @param  [in]    fps     上限フレームレート (0で無制限)
+    void setFrameLimit(s32 fps) { frame_limit_ = fps; }
+
+    //!@}
+    //----------------------------------------------------------
+    //! @name 参照
+    //----------------------------------------------------------
+    //!@{
+
+    //! 固定タイムステップを取得 (単位:秒)
+    f32 getFixedDeltaTime() const { return fixed_delta_time_; }
+
+    //! 前フレームからの経過時間を取得 (単位:秒)
+    f32 getFrameDeltaTime() const { return frame_delta_time_; }
+
+    //! 描画用の補間係数を取得 (0.0f～1.0f)
+    f32 getAlpha() const { return static_cast<f32>(accumulator_ / fixed_delta_time_); }
+
+    //! フレームレート上限を取得 (0で無制限)
+    s32 getFrameLimit() const { return frame_limit_; }
+
+    //!@}
+
+private:
+    f32 fixed_delta_time_ = 1.0f / 60.0f;   //!< 固定タイムステップ (単位:秒)
+    f32 frame_delta_time_ = 0.0f;           //!< 前フレームからの経過時間 (単位:秒)
+    s32 frame_limit_      = 0;              //!< フレームレート上限 (0で無制限)
+    s32 step_count_       = 0;              //!< 今フレームで実行した更新回数
+
+    f64 accumulator_ = 0.0;   //!< 未消費の経過時間 (単位:秒)
+    f64 last_time_   = 0.0;   //!< 前フレームの開始時刻
+    f64 frame_start_ = 0.0;   //!< 今フレームの開始時刻
+};
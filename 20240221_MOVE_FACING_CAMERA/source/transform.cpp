@@ -0,0 +1,500 @@
+﻿//===========================================================================
+//!	@file	transform.cpp
+//!	@brief	トランスフォーム階層 (親子関係のあるワールド行列)
+//===========================================================================
+
+namespace
+{
+constexpr u32 HANDLE_INDEX_BITS      = 20;                                     //!< ハンドルのスロット番号のビット数
+constexpr u32 HANDLE_INDEX_MASK      = (1u << HANDLE_INDEX_BITS) - 1;          //!< スロット番号のマスク
+constexpr u32 HANDLE_GENERATION_MASK = (1u << (32 - HANDLE_INDEX_BITS)) - 1;   //!< 世代のマスク
+
+constexpr s32 PARALLEL_GRAIN = 1024;   //!< 1ジョブで更新するノード数の目安
+
+static_assert(TransformHierarchy::MAX_NODE_COUNT == HANDLE_INDEX_MASK + 1);
+
+//---------------------------------------------------------------------------
+//! 単位行列 (削除済みのハンドルの行列として参照を返すため)
+//---------------------------------------------------------------------------
+const matrix& identityMatrix()
+{
+    static const matrix identity = matrix::identity();
+    return identity;
+}
+
+}   // namespace
+
+//---------------------------------------------------------------------------
+//! 作成
+//---------------------------------------------------------------------------
+TransformHandle TransformHierarchy::create(TransformHandle parent)
+{
+    MEMORY_TAG(MemoryTag::Math);
+
+    if(node_count_ >= MAX_NODE_COUNT) {
+        return TransformHandle{};
+    }
+
+    u32 parent_slot = INVALID;
+    if(parent) {
+        if(!isAlive(parent)) {
+            return TransformHandle{};   // 削除済みの親
+        }
+        parent_slot = parent.value_ & HANDLE_INDEX_MASK;
+    }
+
+    //---- スロットを割り当て (解放済みのスロットを優先して再利用)
+    u32 slot;
+    if(!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    else {
+        slot = static_cast<u32>(slots_.size());
+        slots_.emplace_back();
+    }
+    link(slot, parent_slot);
+
+    //---- 末尾に追加 (親は必ず前にあるため、並べ直すまでも更新順は正しい)
+    u32 index          = static_cast<u32>(node_slots_.size());
+    slots_[slot].index_ = index;
+
+    node_slots_.push_back(slot);
+    parents_.push_back(parent_slot == INVALID ? -1 : static_cast<s32>(slots_[parent_slot].index_));
+    subtree_ends_.push_back(index + 1);
+    positions_.push_back(float3(0.0f, 0.0f, 0.0f));
+    rotations_.push_back(float3(0.0f, 0.0f, 0.0f));
+    scales_.push_back(float3(1.0f, 1.0f, 1.0f));
+    locals_.push_back(matrix::identity());
+    worlds_.push_back(matrix::identity());
+    flags_.push_back(FLAG_LOCAL_DIRTY);
+
+    node_count_++;
+    order_dirty_ = true;   // 親の部分木が連続しなくなる
+
+    return TransformHandle{(slots_[slot].generation_ << HANDLE_INDEX_BITS) | slot};
+}
+
+//---------------------------------------------------------------------------
+//! 削除
+//---------------------------------------------------------------------------
+void TransformHierarchy::destroy(TransformHandle handle)
+{
+    MEMORY_TAG(MemoryTag::Math);
+
+    if(!isAlive(handle)) {
+        return;
+    }
+
+    u32 root = handle.value_ & HANDLE_INDEX_MASK;
+    unlink(root);
+
+    //---- 子孫を含めてスロットを解放 (配列上のノードは次の更新で詰める)
+    std::vector<u32> stack{root};
+    while(!stack.empty()) {
+        u32 slot = stack.back();
+        stack.pop_back();
+
+        Slot& s = slots_[slot];
+        for(u32 child = s.first_child_; child != INVALID; child = slots_[child].next_sibling_) {
+            stack.push_back(child);
+        }
+
+        node_slots_[s.index_] = INVALID;
+
+        // 世代を進めて古いハンドルを無効にする
+        s.generation_ = (s.generation_ + 1) & HANDLE_GENERATION_MASK;
+        if(s.generation_ == 0) {
+            s.generation_ = 1;
+        }
+        s.index_       = INVALID;
+        s.parent_      = INVALID;
+        s.first_child_ = INVALID;
+        free_slots_.push_back(slot);
+        node_count_--;
+    }
+    order_dirty_ = true;
+}
+
+//---------------------------------------------------------------------------
+//! 全て削除
+//---------------------------------------------------------------------------
+void TransformHierarchy::clear()
+{
+    while(first_root_ != INVALID) {
+        const Slot& root = slots_[first_root_];
+        destroy(TransformHandle{(root.generation_ << HANDLE_INDEX_BITS) | first_root_});
+    }
+    rebuild();
+}
+
+//---------------------------------------------------------------------------
+//! 親を変更
+//---------------------------------------------------------------------------
+void TransformHierarchy::setParent(TransformHandle handle, TransformHandle parent)
+{
+    if(!isAlive(handle) || (parent && !isAlive(parent))) {
+        return;
+    }
+    u32 slot        = handle.value_ & HANDLE_INDEX_MASK;
+    u32 parent_slot = parent ? (parent.value_ & HANDLE_INDEX_MASK) : INVALID;
+
+    // 自分の子孫を親にすると循環してしまう
+    for(u32 s = parent_slot; s != INVALID; s = slots_[s].parent_) {
+        if(s == slot) {
+            assert(!"自分の子孫は親にできません");
+            return;
+        }
+    }
+
+    unlink(slot);
+    link(slot, parent_slot);
+
+    // 子が親より前に並ぶ場合があるため、更新前に並べ直す
+    flags_[slots_[slot].index_] |= FLAG_LOCAL_DIRTY;
+    order_dirty_ = true;
+}
+
+//---------------------------------------------------------------------------
+//! 位置を設定
+//---------------------------------------------------------------------------
+void TransformHierarchy::setPosition(TransformHandle handle, const float3& position)
+{
+    u32 index = getIndex(handle);
+    if(index == INVALID) {
+        return;
+    }
+    positions_[index] = position;
+    flags_[index] |= FLAG_LOCAL_DIRTY;
+}
+
+//---------------------------------------------------------------------------
+//! 回転を設定
+//---------------------------------------------------------------------------
+void TransformHierarchy::setRotation(TransformHandle handle, const float3& rotation)
+{
+    u32 index = getIndex(handle);
+    if(index == INVALID) {
+        return;
+    }
+    rotations_[index] = rotation;
+    flags_[index] |= FLAG_LOCAL_DIRTY;
+}
+
+//---------------------------------------------------------------------------
+//! スケールを設定
+//---------------------------------------------------------------------------
+void TransformHierarchy::setScale(TransformHandle handle, const float3& scale)
+{
+    u32 index = getIndex(handle);
+    if(index == INVALID) {
+        return;
+    }
+    scales_[index] = scale;
+    flags_[index] |= FLAG_LOCAL_DIRTY;
+}
+
+//---------------------------------------------------------------------------
+//! 位置を取得
+//---------------------------------------------------------------------------
+float3 TransformHierarchy::getPosition(TransformHandle handle) const
+{
+    u32 index = getIndex(handle);
+    return (index != INVALID) ? positions_[index] : float3(0.0f, 0.0f, 0.0f);
+}
+
+//---------------------------------------------------------------------------
+//! 回転を取得
+//---------------------------------------------------------------------------
+float3 TransformHierarchy::getRotation(TransformHandle handle) const
+{
+    u32 index = getIndex(handle);
+    return (index != INVALID) ? rotations_[index] : float3(0.0f, 0.0f, 0.0f);
+}
+
+//---------------------------------------------------------------------------
+//! スケールを取得
+//---------------------------------------------------------------------------
+float3 TransformHierarchy::getScale(TransformHandle handle) const
+{
+    u32 index = getIndex(handle);
+    return (index != INVALID) ? scales_[index] : float3(1.0f, 1.0f, 1.0f);
+}
+
+//---------------------------------------------------------------------------
+//! ローカル行列を取得
+//---------------------------------------------------------------------------
+const matrix& TransformHierarchy::getLocalMatrix(TransformHandle handle) const
+{
+    u32 index = getIndex(handle);
+    return (index != INVALID) ? locals_[index] : identityMatrix();
+}
+
+//---------------------------------------------------------------------------
+//! ワールド行列を取得
+//---------------------------------------------------------------------------
+const matrix& TransformHierarchy::getWorldMatrix(TransformHandle handle) const
+{
+    u32 index = getIndex(handle);
+    return (index != INVALID) ? worlds_[index] : identityMatrix();
+}
+
+//---------------------------------------------------------------------------
+//! ワールド行列を更新
+//---------------------------------------------------------------------------
+void TransformHierarchy::update()
+{
+    if(order_dirty_) {
+        rebuild();
+    }
+    updated_count_ = updateRange(0, static_cast<s32>(node_slots_.size()));
+}
+
+//---------------------------------------------------------------------------
+//! ワールド行列を部分木ごとに並列に更新
+//---------------------------------------------------------------------------
+void TransformHierarchy::updateParallel()
+{
+    // 部分木が連続した並びになっている必要がある
+    if(order_dirty_) {
+        rebuild();
+    }
+
+    s32 count = static_cast<s32>(node_slots_.size());
+    if(count <= PARALLEL_GRAIN || JOB_getThreadCount() <= 1) {
+        update();
+        return;
+    }
+    updated_count_ = 0;
+
+    UpdateTask task{this, 0, count};
+    Job*       job = JOB_create(&updateJob, &task, sizeof(task));
+    JOB_run(job);
+    JOB_wait(job);
+}
+
+//---------------------------------------------------------------------------
+//! スロットを取得
+//---------------------------------------------------------------------------
+const TransformHierarchy::Slot* TransformHierarchy::getSlot(TransformHandle handle) const
+{
+    u32 slot       = handle.value_ & HANDLE_INDEX_MASK;
+    u32 generation = handle.value_ >> HANDLE_INDEX_BITS;
+
+    if(slot >= slots_.size() || slots_[slot].generation_ != generation || slots_[slot].index_ == INVALID) {
+        return nullptr;
+    }
+    return &slots_[slot];
+}
+
+//---------------------------------------------------------------------------
+//! 配列上の番号を取得
+//---------------------------------------------------------------------------
+u32 TransformHierarchy::getIndex(TransformHandle handle) const
+{
+    const Slot* slot = getSlot(handle);
+    return slot ? slot->index_ : INVALID;
+}
+
+//---------------------------------------------------------------------------
+//! 兄弟のリストにつなぐ (先頭に追加)
+//---------------------------------------------------------------------------
+void TransformHierarchy::link(u32 slot, u32 parent)
+{
+    u32& first = (parent == INVALID) ? first_root_ : slots_[parent].first_child_;
+
+    Slot& s         = slots_[slot];
+    s.parent_       = parent;
+    s.prev_sibling_ = INVALID;
+    s.next_sibling_ = first;
+    if(first != INVALID) {
+        slots_[first].prev_sibling_ = slot;
+    }
+    first = slot;
+}
+
+//---------------------------------------------------------------------------
+//! 兄弟のリストから外す
+//---------------------------------------------------------------------------
+void TransformHierarchy::unlink(u32 slot)
+{
+    Slot& s = slots_[slot];
+    if(s.prev_sibling_ != INVALID) {
+        slots_[s.prev_sibling_].next_sibling_ = s.next_sibling_;
+    }
+    else if(s.parent_ != INVALID) {
+        slots_[s.parent_].first_child_ = s.next_sibling_;
+    }
+    else {
+        first_root_ = s.next_sibling_;
+    }
+    if(s.next_sibling_ != INVALID) {
+        slots_[s.next_sibling_].prev_sibling_ = s.prev_sibling_;
+    }
+    s.prev_sibling_ = INVALID;
+    s.next_sibling_ = INVALID;
+}
+
+//---------------------------------------------------------------------------
+//! 配列を深さ優先順に並べ直す
+//---------------------------------------------------------------------------
+void TransformHierarchy::rebuild()
+{
+    MEMORY_TAG(MemoryTag::Math);
+
+    //---- ルートから深さ優先でたどった順番 (削除済みのノードはたどれない)
+    std::vector<u32> order;
+    order.reserve(node_count_);
+
+    std::vector<u32> stack;
+    for(u32 root = first_root_; root != INVALID; root = slots_[root].next_sibling_) {
+        stack.push_back(root);
+        while(!stack.empty()) {
+            u32 slot = stack.back();
+            stack.pop_back();
+            order.push_back(slot);
+
+            for(u32 child = slots_[slot].first_child_; child != INVALID; child = slots_[child].next_sibling_) {
+                stack.push_back(child);
+            }
+        }
+    }
+
+    //---- 新しい順番に並べ替え
+    s32 count = static_cast<s32>(order.size());
+
+    std::vector<s32>    parents(count);
+    std::vector<s32>    subtree_ends(count);
+    std::vector<float3> positions(count);
+    std::vector<float3> rotations(count);
+    std::vector<float3> scales(count);
+    std::vector<matrix> locals(count);
+    std::vector<matrix> worlds(count);
+    std::vector<u8>     flags(count);
+
+    for(s32 i = 0; i < count; ++i) {
+        u32 old_index = slots_[order[i]].index_;
+        positions[i]  = positions_[old_index];
+        rotations[i]  = rotations_[old_index];
+        scales[i]     = scales_[old_index];
+        locals[i]     = locals_[old_index];
+        worlds[i]     = worlds_[old_index];
+        flags[i]      = flags_[old_index];
+    }
+    for(s32 i = 0; i < count; ++i) {
+        slots_[order[i]].index_ = i;
+    }
+
+    // 親の番号を付け替え、子の数を後ろから親に足し込んで部分木の範囲を求める
+    for(s32 i = 0; i < count; ++i) {
+        u32 parent      = slots_[order[i]].parent_;
+        parents[i]      = (parent == INVALID) ? -1 : static_cast<s32>(slots_[parent].index_);
+        subtree_ends[i] = 1;   // 部分木のノード数
+    }
+    for(s32 i = count - 1; i > 0; --i) {
+        if(parents[i] >= 0) {
+            subtree_ends[parents[i]] += subtree_ends[i];
+        }
+    }
+    for(s32 i = 0; i < count; ++i) {
+        subtree_ends[i] += i;
+    }
+
+    node_slots_   = std::move(order);
+    parents_      = std::move(parents);
+    subtree_ends_ = std::move(subtree_ends);
+    positions_    = std::move(positions);
+    rotations_    = std::move(rotations);
+    scales_       = std::move(scales);
+    locals_       = std::move(locals);
+    worlds_       = std::move(worlds);
+    flags_        = std::move(flags);
+    order_dirty_  = false;
+}
+
+//---------------------------------------------------------------------------
+//! 範囲内のノードを更新
+//---------------------------------------------------------------------------
+s32 TransformHierarchy::updateRange(s32 begin, s32 end)
+{
+    s32 updated_count = 0;
+    for(s32 i = begin; i < end; ++i) {
+        u8 flags = flags_[i];
+        if(node_slots_[i] == INVALID) {
+            flags_[i] = 0;   // 削除済み (並べ直しで詰める)
+            continue;
+        }
+
+        //---- 変更されたノードだけローカル行列を作り直す
+        bool changed = (flags & FLAG_LOCAL_DIRTY) != 0;
+        if(changed) {
+            const float3& r = rotations_[i];
+
+            matrix m  = matrix::scale(scales_[i]);
+            m         = mul(m, matrix::rotateZ(r.z));
+            m         = mul(m, matrix::rotateX(r.x));
+            m         = mul(m, matrix::rotateY(r.y));
+            m         = mul(m, matrix::translate(positions_[i]));
+            locals_[i] = m;
+        }
+
+        //---- 自分か親が変わった場合だけワールド行列を計算
+        s32 parent = parents_[i];
+        if(parent >= 0) {
+            changed |= (flags_[parent] & FLAG_WORLD_CHANGED) != 0;
+        }
+        if(changed) {
+            worlds_[i] = (parent >= 0) ? mul(locals_[i], worlds_[parent]) : locals_[i];
+            updated_count++;
+        }
+        flags_[i] = changed ? FLAG_WORLD_CHANGED : 0;
+    }
+    return updated_count;
+}
+
+//---------------------------------------------------------------------------
+//! 並列更新のジョブ関数
+//---------------------------------------------------------------------------
+void TransformHierarchy::updateJob(Job* job, const void* data)
+{
+    const auto& task = *static_cast<const UpdateTask*>(data);
+    task.hierarchy_->splitRange(job, task.begin_, task.end_);
+}
+
+//---------------------------------------------------------------------------
+//! 兄弟の部分木が並んだ範囲を分割してジョブを作成
+//---------------------------------------------------------------------------
+void TransformHierarchy::splitRange(Job* job, s32 begin, s32 end)
+{
+    if(end - begin <= PARALLEL_GRAIN) {
+        updated_count_ += updateRange(begin, end);
+        return;
+    }
+
+    // 範囲の親は更新済みなので、隣り合う部分木をPARALLEL_GRAIN個程度ずつまとめて子ジョブにする
+    auto spawn = [&](s32 range_begin, s32 range_end) {
+        if(range_begin < range_end) {
+            UpdateTask task{this, range_begin, range_end};
+            JOB_run(JOB_create(&updateJob, &task, sizeof(task), job));
+        }
+    };
+
+    s32 chunk_begin = begin;
+    for(s32 i = begin; i < end;) {
+        s32 next = subtree_ends_[i];
+
+        if(next - i > PARALLEL_GRAIN) {
+            // 大きな部分木は根だけ先に更新して、子の部分木の並びを分割する
+            spawn(chunk_begin, i);
+            updated_count_ += updateRange(i, i + 1);
+            spawn(i + 1, next);
+            chunk_begin = next;
+        }
+        else if(next - chunk_begin > PARALLEL_GRAIN) {
+            spawn(chunk_begin, i);
+            chunk_begin = i;
+        }
+        i = next;
+    }
+    spawn(chunk_begin, end);
+}
@@ -0,0 +1,198 @@
+﻿//===========================================================================
+//!	@file	transform.h
+//!	@brief	トランスフォーム階層 (親子関係のあるワールド行列)
+//!
+//!	ノードは親が必ず子より前に並ぶ深さ優先順の配列で保持し、先頭から1回
+//!	なめるだけで全てのワールド行列を更新します。位置・回転・スケールを変更した
+//!	ノードだけローカル行列を作り直し、ワールド行列はそのノードと子孫だけ再計算します。
+//!	部分木は配列上で連続しているため、部分木ごとに並列に更新できます。
+//!
+//! @code
+//!     TransformHierarchy transforms;
+//!     TransformHandle body  = transforms.create();
+//!     TransformHandle prop  = transforms.create(body);   // bodyに取り付け
+//!     transforms.setPosition(prop, float3(0.0f, 1.0f, 0.0f));
+//!     ...
+//!     transforms.setPosition(body, position);            // 毎フレーム
+//!     transforms.update();                               // propも一緒に移動
+//!     RENDER_setWorldMatrix(transforms.getWorldMatrix(prop));
+//! @endcode
+//===========================================================================
+#pragma once
+
+//===========================================================================
+//! トランスフォームハンドル
+//!
+//! 下位20bitがスロット番号、上位12bitが世代。0は無効なハンドル。
+//===========================================================================
+struct TransformHandle
+{
+    u32 value_ = 0;   //!< ハンドル値
+
+    //! 有効なハンドルかどうか (削除済みかどうかはTransformHierarchy::isAlive()で判定)
+    bool isValid() const { return value_ != 0; }
+
+    explicit operator bool() const { return isValid(); }
+
+    bool operator==(const TransformHandle&) const = default;
+};
+
+//===========================================================================
+//! トランスフォーム階層
+//!
+//! ローカル行列 = スケール × 回転(Z→X→Y) × 平行移動
+//! ワールド行列 = ローカル行列 × 親のワールド行列
+//===========================================================================
+class TransformHierarchy
+{
+public:
+    static constexpr s32 MAX_NODE_COUNT = 1 << 20;   //!< 最大ノード数
+
+    //! コンストラクタ
+    TransformHierarchy() = default;
+
+    //! 作成
+    //! @param  [in]    parent  親 (無効なハンドルの場合はルート)
+    //! @return ハンドル (最大数を超えた・親が削除済みの場合は無効なハンドル)
+    TransformHandle create(TransformHandle parent = {});
+
+    //! 削除 (子孫も全て削除)
+    void destroy(TransformHandle handle);
+
+    //! 全て削除
+    void clear();
+
+    //! 親を変更 (ローカルの値はそのまま)
+    //! @param  [in]    parent  新しい親 (無効なハンドルの場合はルート、自分の子孫は指定不可)
+    //! 削除済みのハンドルを指定した場合は何もしません。
+    void setParent(TransformHandle handle, TransformHandle parent);
+
+    //! 生存しているかどうか
+    bool isAlive(TransformHandle handle) const { return getSlot(handle) != nullptr; }
+
+    //----------------------------------------------------------
+    //! @name ローカルの値 (変更したノードは次の更新で再計算)
+    //! 削除済みのハンドルの場合、設定は何もせず、取得は単位変換の値を返します。
+    //----------------------------------------------------------
+    //!@{
+
+    //! 位置を設定
+    void setPosition(TransformHandle handle, const float3& position);
+
+    //! 回転を設定
+    //! @param  [in]    rotation    X軸・Y軸・Z軸中心の回転角度 (単位:radian)
+    void setRotation(TransformHandle handle, const float3& rotation);
+
+    //! スケールを設定
+    void setScale(TransformHandle handle, const float3& scale);
+
+    //! 位置を取得
+    float3 getPosition(TransformHandle handle) const;
+
+    //! 回転を取得
+    float3 getRotation(TransformHandle handle) const;
+
+    //! スケールを取得
+    float3 getScale(TransformHandle handle) const;
+
+    //!@}
+    //----------------------------------------------------------
+    //! @name 更新
+    //----------------------------------------------------------
+    //!@{
+
+    //! ワールド行列を更新 (配列の先頭から1回で更新)
+    void update();
+
+    //! ワールド行列を部分木ごとに並列に更新 (JOB_setup()済みの場合)
+    void updateParallel();
+
+    //! ローカル行列を取得 (update()後に有効、削除済みのハンドルの場合は単位行列)
+    const matrix& getLocalMatrix(TransformHandle handle) const;
+
+    //! ワールド行列を取得 (update()後に有効、削除済みのハンドルの場合は単位行列)
+    const matrix& getWorldMatrix(TransformHandle handle) const;
+
+    //! 直前の更新でワールド行列を再計算したノード数を取得
+    s32 getUpdatedCount() const { return updated_count_.load(std::memory_order_relaxed); }
+
+    //! ノード数を取得
+    s32 size() const { return node_count_; }
+
+    //!@}
+
+private:
+    static constexpr u32 INVALID = 0xfffffffful;   //!< 無効なスロット番号
+
+    //! ノードの状態フラグ
+    enum Flag : u8
+    {
+        FLAG_LOCAL_DIRTY   = 1 << 0,   //!< ローカルの値が変更された
+        FLAG_WORLD_CHANGED = 1 << 1,   //!< 直前の更新でワールド行列が変わった
+    };
+
+    //! スロット (ハンドルから参照する情報と親子のリンク)
+    struct Slot
+    {
+        u32 generation_   = 1;         //!< 世代 (1～)
+        u32 index_        = INVALID;   //!< 配列上の番号 (INVALID:未使用)
+        u32 parent_       = INVALID;   //!< 親のスロット番号
+        u32 first_child_  = INVALID;   //!< 最初の子のスロット番号
+        u32 prev_sibling_ = INVALID;   //!< 前の兄弟のスロット番号
+        u32 next_sibling_ = INVALID;   //!< 次の兄弟のスロット番号
+    };
+
+    //! 並列更新のジョブ
+    struct UpdateTask
+    {
+        TransformHierarchy* hierarchy_;   //!< 更新する階層
+        s32                 begin_;       //!< 先頭の番号
+        s32                 end_;         //!< 末尾の番号 (この番号は含まない)
+    };
+
+    //! スロットを取得 (無効なハンドルの場合はnullptr)
+    const Slot* getSlot(TransformHandle handle) const;
+
+    //! 配列上の番号を取得 (削除済み・無効なハンドルの場合はINVALID)
+    u32 getIndex(TransformHandle handle) const;
+
+    //! 兄弟のリストにつなぐ
+    void link(u32 slot, u32 parent);
+
+    //! 兄弟のリストから外す
+    void unlink(u32 slot);
+
+    //! 配列を深さ優先順に並べ直す (削除したノードも詰める)
+    void rebuild();
+
+    //! 範囲内のノードを更新 (範囲外の親は更新済みであること)
+    //! @return ワールド行列を再計算した数
+    s32 updateRange(s32 begin, s32 end);
+
+    //! 並列更新のジョブ関数
+    static void updateJob(Job* job, const void* data);
+
+    //! 兄弟の部分木が並んだ範囲を分割してジョブを作成
+    void splitRange(Job* job, s32 begin, s32 end);
+
+private:
+    //---- スロット (ハンドルで参照)
+    std::vector<Slot> slots_;                  //!< スロット
+    std::vector<u32>  free_slots_;             //!< 空いているスロット番号
+    u32               first_root_ = INVALID;   //!< 最初のルートのスロット番号
+
+    //---- ノード (親が必ず子より前に並ぶ)
+    std::vector<u32>    node_slots_;     //!< スロット番号 (INVALID:削除済み)
+    std::vector<s32>    parents_;        //!< 親の番号 (-1:ルート)
+    std::vector<s32>    subtree_ends_;   //!< 部分木の末尾の番号 (この番号は含まない)
+    std::vector<float3> positions_;      //!< 位置
+    std::vector<float3> rotations_;      //!< 回転 (radian)
+    std::vector<float3> scales_;         //!< スケール
+    std::vector<matrix> locals_;         //!< ローカル行列
+    std::vector<matrix> worlds_;         //!< ワールド行列
+    std::vector<u8>     flags_;          //!< 状態フラグ (Flag)
+
+    s32              node_count_    = 0;       //!< 生存しているノード数
+    std::atomic<s32> updated_count_ = 0;       //!< 直前の更新でワールド行列を再計算したノード数
+    bool             order_dirty_   = false;   //!< 並べ直しが必要かどうか
+};
@@ -178,6 +178,27 @@ matrix matrix::perspectiveFovLH(f32 fovy, f32 aspect_ratio, f32 near_z, f32 far_
     return matrix(m[0], m[1], m[2], m[3]);
 }
 
+//---------------------------------------------------------------------------
+//! [右手座標系] 投影行列 (OpenGL互換 gluPerspective相当)
+//---------------------------------------------------------------------------
+matrix matrix::perspectiveFovRH(f32 fovy, f32 aspect_ratio, f32 near_z, f32 far_z)
+{
+    f32 s = std::sinf(fovy * 0.5f);
+    f32 c = std::cosf(fovy * 0.5f);
+
+    f32 height = c / s;
+    f32 width  = height / aspect_ratio;
+    f32 range  = 1.0f / (near_z - far_z);
+
+    float4 m[4]{
+        {width,   0.0f,                            0.0f,  0.0f},
+        { 0.0f, height,                            0.0f,  0.0f},
+        { 0.0f,   0.0f,        (far_z + near_z) * range, -1.0f},
+        { 0.0f,   0.0f, 2.0f * far_z * near_z * range,  0.0f}
+    };
+    return matrix(m[0], m[1], m[2], m[3]);
+}
+
 //---------------------------------------------------------------------------
 //! [左手座標系] 無限遠投影行列
 //---------------------------------------------------------------------------
@@ -251,3 +272,23 @@ float3 matrix::translate() const
 {
     return _41_42_43;
 }
+
+//===========================================================================
+//  配列演算
+//===========================================================================
+
+//---------------------------------------------------------------------------
+//! 座標配列を行列で一括変換
+//---------------------------------------------------------------------------
+void transformCoordArray(float3 out[], const float3 in[], s32 count, const matrix& m)
+{
+    PROFILE_FUNCTION();
+
+    constexpr s32 GRAIN_SIZE = 4096;   // 1ジョブあたりの処理数
+
+    JOB_parallelFor(count, GRAIN_SIZE, [&](s32 begin, s32 end) {
+        for(s32 i = begin; i < end; ++i) {
+            out[i] = mul(float4(in[i], 1.0f), m).xyz;
+        }
+    });
+}
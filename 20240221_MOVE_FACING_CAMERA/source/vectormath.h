@@ -83,6 +83,14 @@ public:
     //! @note InverseZにしたい場合はnearZの値とfarZの値を交換して指定。
     static [[nodiscard]] matrix perspectiveFovLH(f32 fovy, f32 aspect_ratio, f32 near_z, f32 far_z);
 
+    // [右手座標系] 投影行列 (OpenGL互換 gluPerspective相当)
+    //! @param  [in]    fovy            画角(単位:radian)
+    //! @param  [in]    aspect_ratio    アスペクト比
+    //! @param  [in]    near_z          近クリップZ値
+    //! @param  [in]    far_z           遠クリップZ値
+    //! @note 変換後のZ値は-1.0～+1.0
+    static [[nodiscard]] matrix perspectiveFovRH(f32 fovy, f32 aspect_ratio, f32 near_z, f32 far_z);
+
     // [左手座標系] 無限遠投影行列
     //!
     //! 遠クリップ面を廃止して無限遠まで描画可能にする行列。
@@ -146,3 +154,17 @@ public:
 
     //@}
 };
+
+//===========================================================================
+//! @name   配列演算
+//===========================================================================
+//@{
+
+//! 座標配列を行列で一括変換 (ジョブシステムで並列実行)
+//! @param  [out]   out     変換後の座標 (inと同じ配列を指定可能)
+//! @param  [in]    in      変換前の座標
+//! @param  [in]    count   要素数
+//! @param  [in]    m       変換行列
+void transformCoordArray(float3 out[], const float3 in[], s32 count, const matrix& m);
+
+//@}